@@ -0,0 +1,238 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+// Throughput of the shared state sequence lock with one writer and several concurrent readers, Linux only.
+// The writer publishes controller 0 as fast as it can, like FDS5WSharedStateExport does per report, and
+// every reader thread maps the region through its own FDS5WSharedStateReader and copies the state in a
+// loop. Every field of a published state is derived from its report count, so a reader spots any copy
+// the sequence lock let through torn. Exits with 1 if there was one.
+//
+// Build and run from this directory:
+//   g++ -std=c++11 -O2 -pthread DS5WSharedStateBenchmark.cpp DS5WSharedStateReader.cpp -o DS5WSharedStateBenchmark -lrt
+//   ./DS5WSharedStateBenchmark [seconds per run, default 1] [reader counts, default 0 1 2 4 8]
+//
+// Readers only stay concurrent with as many cores as threads, runs with more readers than cores
+// measure the scheduler instead.
+
+#include "DS5WSharedStateReader.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+	/** What the writer publishes as report Count */
+	void MakeState(uint64_t Count, FDS5WSharedControllerState& OutState)
+	{
+		memset(&OutState, 0, sizeof(OutState));
+		OutState.Flags = DS5W_SHARED_STATE_FLAG_CONNECTED;
+		OutState.NumReports = Count;
+		OutState.SensorTimestamp = (uint32_t)Count;
+		OutState.CaptureTime = (double)Count;
+		for (int Axis = 0; Axis < 4; ++Axis)
+		{
+			OutState.Sticks[Axis] = (int8_t)(Count + Axis);
+			OutState.Orientation[Axis] = (float)(Count & 0xFFFF) + Axis;
+		}
+		OutState.TouchX[1] = (uint16_t)Count;
+		OutState.Accel[2] = (float)(Count & 0xFFFF);
+	}
+
+	/** True if every field matches the report count, the first and last fields of the slot included */
+	bool IsConsistent(const FDS5WSharedControllerState& State)
+	{
+		FDS5WSharedControllerState Expected;
+		MakeState(State.NumReports, Expected);
+		return memcmp(&State, &Expected, sizeof(State)) == 0;
+	}
+
+	struct FReaderResult
+	{
+		uint64_t NumReads = 0;
+		uint64_t NumOverlapped = 0;
+		uint64_t NumTorn = 0;
+		uint64_t NumBackwards = 0;
+	};
+
+	struct FRunResult
+	{
+		int NumReaders = 0;
+		double Seconds = 0.0;
+		uint64_t NumWrites = 0;
+		FReaderResult Readers;
+	};
+
+	bool Run(const char* Name, FDS5WSharedStateRegion& Region, int NumReaders, double Seconds, FRunResult& OutResult)
+	{
+		std::atomic<bool> bStarted(false);
+		std::atomic<bool> bStopped(false);
+		std::atomic<int> NumReady(0);
+		std::vector<FReaderResult> Results(NumReaders);
+		std::vector<std::thread> Threads;
+
+		for (int ReaderIndex = 0; ReaderIndex < NumReaders; ++ReaderIndex)
+		{
+			Threads.emplace_back([&, ReaderIndex]()
+			{
+				FDS5WSharedStateReader Reader;
+				const bool bOpen = Reader.Open(Name);
+				NumReady.fetch_add(1);
+				if (!bOpen)
+				{
+					return;
+				}
+
+				while (!bStarted.load(std::memory_order_acquire))
+				{
+				}
+
+				// One attempt per read, so overlapped copies are counted instead of retried
+				FReaderResult& Result = Results[ReaderIndex];
+				FDS5WSharedControllerState State;
+				uint64_t LastReport = 0;
+				while (!bStopped.load(std::memory_order_relaxed))
+				{
+					if (!Reader.Read(0, State, 1))
+					{
+						++Result.NumOverlapped;
+						continue;
+					}
+
+					++Result.NumReads;
+					Result.NumTorn += IsConsistent(State) ? 0 : 1;
+					Result.NumBackwards += State.NumReports < LastReport ? 1 : 0;
+					LastReport = State.NumReports;
+				}
+			});
+		}
+
+		while (NumReady.load() < NumReaders)
+		{
+			std::this_thread::yield();
+		}
+
+		FDS5WSharedControllerSlot& Slot = Region.Controllers[0];
+		FDS5WSharedControllerState State;
+		uint64_t Count = Slot.State.NumReports;
+
+		bStarted.store(true, std::memory_order_release);
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::duration Elapsed;
+		uint64_t NumWrites = 0;
+		do
+		{
+			// Check the clock every so often only, it costs more than a write
+			for (int Write = 0; Write < 1024; ++Write)
+			{
+				MakeState(++Count, State);
+				DS5WWriteSharedControllerState(Slot, State);
+			}
+			NumWrites += 1024;
+			Elapsed = std::chrono::steady_clock::now() - Start;
+		}
+		while (Elapsed < std::chrono::duration<double>(Seconds));
+
+		bStopped.store(true, std::memory_order_relaxed);
+		for (std::thread& Thread : Threads)
+		{
+			Thread.join();
+		}
+
+		OutResult = FRunResult();
+		OutResult.NumReaders = NumReaders;
+		OutResult.Seconds = std::chrono::duration<double>(Elapsed).count();
+		OutResult.NumWrites = NumWrites;
+		for (const FReaderResult& Result : Results)
+		{
+			OutResult.Readers.NumReads += Result.NumReads;
+			OutResult.Readers.NumOverlapped += Result.NumOverlapped;
+			OutResult.Readers.NumTorn += Result.NumTorn;
+			OutResult.Readers.NumBackwards += Result.NumBackwards;
+		}
+
+		return NumReady.load() == NumReaders;
+	}
+}
+
+int main(int ArgC, char** ArgV)
+{
+	const double Seconds = ArgC > 1 ? atof(ArgV[1]) : 1.0;
+	std::vector<int> ReaderCounts;
+	for (int Arg = 2; Arg < ArgC; ++Arg)
+	{
+		ReaderCounts.push_back(atoi(ArgV[Arg]));
+	}
+	if (ReaderCounts.empty())
+	{
+		ReaderCounts = { 0, 1, 2, 4, 8 };
+	}
+
+	// A region of its own, a running game keeps the default one
+	const std::string Name = "DS5W_UE4_SharedStateBenchmark_" + std::to_string(getpid());
+	const std::string PosixName = "/" + Name;
+
+	const int File = shm_open(PosixName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (File < 0 || ftruncate(File, sizeof(FDS5WSharedStateRegion)) != 0)
+	{
+		fprintf(stderr, "Failed to create shared memory region %s.\n", PosixName.c_str());
+		return 2;
+	}
+
+	void* Address = mmap(nullptr, sizeof(FDS5WSharedStateRegion), PROT_READ | PROT_WRITE, MAP_SHARED, File, 0);
+	close(File);
+	if (Address == MAP_FAILED)
+	{
+		fprintf(stderr, "Failed to map shared memory region %s.\n", PosixName.c_str());
+		shm_unlink(PosixName.c_str());
+		return 2;
+	}
+
+	// Same header as FDS5WSharedStateExport::Open writes
+	FDS5WSharedStateRegion& Region = *(FDS5WSharedStateRegion*)Address;
+	memset((void*)&Region, 0, sizeof(Region));
+	Region.Header.Version = DS5W_SHARED_STATE_VERSION;
+	Region.Header.RegionSize = sizeof(FDS5WSharedStateRegion);
+	Region.Header.SlotSize = sizeof(FDS5WSharedControllerSlot);
+	Region.Header.NumControllers = DS5W_SHARED_STATE_MAX_CONTROLLERS;
+	Region.Header.WriterProcessId = (uint32_t)getpid();
+
+	FDS5WSharedControllerState First;
+	MakeState(0, First);
+	DS5WWriteSharedControllerState(Region.Controllers[0], First);
+	Region.Header.Magic.store(DS5W_SHARED_STATE_MAGIC, std::memory_order_release);
+
+	printf("%u hardware threads, %.2f s per run\n", std::thread::hardware_concurrency(), Seconds);
+
+	bool bFailed = false;
+	for (const int NumReaders : ReaderCounts)
+	{
+		FRunResult Result;
+		if (!Run(Name.c_str(), Region, NumReaders, Seconds, Result))
+		{
+			fprintf(stderr, "A reader failed to open %s.\n", Name.c_str());
+			bFailed = true;
+			break;
+		}
+
+		const FReaderResult& Readers = Result.Readers;
+		const uint64_t NumAttempts = Readers.NumReads + Readers.NumOverlapped;
+		printf("%d readers: %7.2f M writes/s, %7.2f M reads/s (%.2f%% of attempts overlapped a write), %llu torn, %llu out of order\n",
+			NumReaders, Result.NumWrites / Result.Seconds * 1.e-6, Readers.NumReads / Result.Seconds * 1.e-6,
+			NumAttempts ? 100.0 * Readers.NumOverlapped / NumAttempts : 0.0, (unsigned long long)Readers.NumTorn, (unsigned long long)Readers.NumBackwards);
+
+		bFailed |= Readers.NumTorn > 0 || Readers.NumBackwards > 0;
+	}
+
+	Region.Header.Magic.store(0, std::memory_order_relaxed);
+	munmap(Address, sizeof(FDS5WSharedStateRegion));
+	shm_unlink(PosixName.c_str());
+
+	return bFailed ? 1 : 0;
+}
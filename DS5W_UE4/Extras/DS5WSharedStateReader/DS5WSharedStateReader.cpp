@@ -0,0 +1,155 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WSharedStateReader.h"
+
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FDS5WSharedStateReader::FDS5WSharedStateReader()
+	: Region(nullptr)
+	, MappedSize(0)
+#ifdef _WIN32
+	, Mapping(nullptr)
+#endif
+{
+}
+
+FDS5WSharedStateReader::~FDS5WSharedStateReader()
+{
+	Close();
+}
+
+bool FDS5WSharedStateReader::Open(const char* Name)
+{
+	Close();
+
+	const void* Address = nullptr;
+	const size_t Size = sizeof(FDS5WSharedStateRegion);
+
+#ifdef _WIN32
+	Mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, Name);
+	if (!Mapping)
+	{
+		return false;
+	}
+
+	Address = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, Size);
+	if (!Address)
+	{
+		CloseHandle(Mapping);
+		Mapping = nullptr;
+		return false;
+	}
+#else
+	const std::string PosixName = std::string("/") + Name;
+	const int File = shm_open(PosixName.c_str(), O_RDONLY, 0);
+	if (File < 0)
+	{
+		return false;
+	}
+
+	// The writer may not have sized it yet
+	struct stat FileStat;
+	if (fstat(File, &FileStat) != 0 || (size_t)FileStat.st_size < Size)
+	{
+		close(File);
+		return false;
+	}
+
+	Address = mmap(nullptr, Size, PROT_READ, MAP_SHARED, File, 0);
+	close(File);
+	if (Address == MAP_FAILED)
+	{
+		return false;
+	}
+#endif
+
+	Region = (const FDS5WSharedStateRegion*)Address;
+	MappedSize = Size;
+
+	// The magic is written last, the rest of the header is valid once it is there
+	const FDS5WSharedStateHeader& Header = Region->Header;
+	if (Header.Magic.load(std::memory_order_acquire) != DS5W_SHARED_STATE_MAGIC || Header.Version != DS5W_SHARED_STATE_VERSION || Header.RegionSize != sizeof(FDS5WSharedStateRegion)
+		|| Header.SlotSize != sizeof(FDS5WSharedControllerSlot) || Header.NumControllers > DS5W_SHARED_STATE_MAX_CONTROLLERS)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void FDS5WSharedStateReader::Close()
+{
+	if (Region)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(Region);
+#else
+		munmap((void*)Region, MappedSize);
+#endif
+		Region = nullptr;
+		MappedSize = 0;
+	}
+
+#ifdef _WIN32
+	if (Mapping)
+	{
+		CloseHandle(Mapping);
+		Mapping = nullptr;
+	}
+#endif
+}
+
+bool FDS5WSharedStateReader::IsWriterAlive() const
+{
+	return Region && Region->Header.Magic.load(std::memory_order_relaxed) == DS5W_SHARED_STATE_MAGIC;
+}
+
+int FDS5WSharedStateReader::GetNumControllers() const
+{
+	return Region ? (int)Region->Header.NumControllers : 0;
+}
+
+unsigned int FDS5WSharedStateReader::GetWriterProcessId() const
+{
+	return Region ? Region->Header.WriterProcessId : 0;
+}
+
+bool FDS5WSharedStateReader::Read(int ControllerId, FDS5WSharedControllerState& OutState, int MaxAttempts) const
+{
+	if (!Region || ControllerId < 0 || ControllerId >= GetNumControllers())
+	{
+		return false;
+	}
+
+	const FDS5WSharedControllerSlot& Slot = Region->Controllers[ControllerId];
+	for (int Attempt = 0; Attempt < MaxAttempts; ++Attempt)
+	{
+		if (DS5WTryReadSharedControllerState(Slot, OutState))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+uint32_t FDS5WSharedStateReader::GetSequence(int ControllerId) const
+{
+	if (!Region || ControllerId < 0 || ControllerId >= GetNumControllers())
+	{
+		return 0;
+	}
+
+	return Region->Controllers[ControllerId].Sequence.load(std::memory_order_acquire);
+}
@@ -0,0 +1,63 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// Standalone reader of the live controller state the DS5W_UE4 plugin publishes to shared memory.
+// No engine dependencies: build DS5WSharedStateReader.cpp into the tool (C++11 or later, link -lrt on older glibc).
+
+#include "../../Source/DS5W_UE4/Public/DS5WSharedStateLayout.h"
+
+#include <stddef.h>
+
+/**
+ * Maps the plugin's region read only and copies controller states out of it. Reads never block the game,
+ * a copy the writer overlapped is retried. Any number of readers, in any number of processes, may read
+ * at once. One reader object is not meant to be shared between threads while opening or closing.
+ */
+class FDS5WSharedStateReader
+{
+public:
+
+	FDS5WSharedStateReader();
+	~FDS5WSharedStateReader();
+
+	FDS5WSharedStateReader(const FDS5WSharedStateReader&) = delete;
+	FDS5WSharedStateReader& operator=(const FDS5WSharedStateReader&) = delete;
+
+	/**
+	 * Map the region. Fails while the game hasn't created it, with the export turned off, or if its layout
+	 * doesn't match this reader's. Retry later in that case.
+	 */
+	bool Open(const char* Name = DS5W_SHARED_STATE_NAME);
+	void Close();
+
+	bool IsOpen() const { return Region != nullptr; }
+
+	/** False once the game closed the region, reopen to pick up a new game session */
+	bool IsWriterAlive() const;
+
+	int GetNumControllers() const;
+
+	/** Process id of the game publishing the region */
+	unsigned int GetWriterProcessId() const;
+
+	/**
+	 * Copy the latest state of a controller. Check DS5W_SHARED_STATE_FLAG_CONNECTED in its Flags.
+	 * @param MaxAttempts copies tried while the writer keeps overlapping them, at report rate one retry
+	 * practically always succeeds
+	 * @return false if not open, ControllerId is out of range or every attempt overlapped a write
+	 */
+	bool Read(int ControllerId, FDS5WSharedControllerState& OutState, int MaxAttempts = 64) const;
+
+	/** Sequence of a controller's slot, changes with every write. Cheap check for new data before a Read */
+	uint32_t GetSequence(int ControllerId) const;
+
+private:
+
+	const FDS5WSharedStateRegion* Region;
+	size_t MappedSize;
+
+#ifdef _WIN32
+	void* Mapping;
+#endif
+};
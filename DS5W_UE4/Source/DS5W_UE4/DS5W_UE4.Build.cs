@@ -42,6 +42,8 @@ public class DS5W_UE4 : ModuleRules
 		PrivateDependencyModuleNames.AddRange(
 			new string[]
 			{
+				"Sockets",
+				"Json",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -0,0 +1,126 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WAllocationTracker.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/UnrealMemory.h"
+#include "CoreGlobals.h"
+#include "Logging/LogMacros.h"
+
+std::atomic<uint64> FDS5WAllocationTracker::NumViolations(0);
+std::atomic<bool> FDS5WAllocationTracker::bEnabled(false);
+
+namespace
+{
+	/** Counter of the innermost scope of this thread, null outside scopes */
+	thread_local uint64* CurrentCounter = nullptr;
+
+	/** Forwards everything to the allocator it wraps and counts allocations made inside scopes */
+	class FDS5WCountingMalloc : public FMalloc
+	{
+	public:
+
+		FDS5WCountingMalloc(FMalloc* InInnerMalloc)
+			: InnerMalloc(InInnerMalloc)
+		{
+		}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return InnerMalloc->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return InnerMalloc->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count)
+			{
+				CountAllocation();
+			}
+			return InnerMalloc->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count)
+			{
+				CountAllocation();
+			}
+			return InnerMalloc->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override { InnerMalloc->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return InnerMalloc->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return InnerMalloc->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { InnerMalloc->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { InnerMalloc->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { InnerMalloc->InitializeStatsMetadata(); }
+		virtual void UpdateStats() override { InnerMalloc->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { InnerMalloc->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { InnerMalloc->DumpAllocatorStats(Ar); }
+		virtual bool IsInternallyThreadSafe() const override { return InnerMalloc->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return InnerMalloc->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return InnerMalloc->GetDescriptiveName(); }
+
+	private:
+
+		static void CountAllocation()
+		{
+			if (CurrentCounter && FDS5WAllocationTracker::IsEnabled())
+			{
+				++*CurrentCounter;
+			}
+		}
+
+		FMalloc* InnerMalloc;
+	};
+
+	FDS5WCountingMalloc* CountingMalloc = nullptr;
+}
+
+void FDS5WAllocationTracker::Install()
+{
+	if (!CountingMalloc)
+	{
+		// Never freed, blocks allocated through the proxy may outlive the module
+		CountingMalloc = new FDS5WCountingMalloc(GMalloc);
+		GMalloc = CountingMalloc;
+	}
+
+	SetEnabled(true);
+}
+
+bool FDS5WAllocationTracker::IsInstalled()
+{
+	return CountingMalloc != nullptr;
+}
+
+FDS5WAllocationScope::FDS5WAllocationScope(const TCHAR* InName, bool bInSteadyState)
+	: Name(InName)
+	, bSteadyState(bInSteadyState)
+	, NumAllocations(0)
+	, OuterCounter(CurrentCounter)
+{
+	CurrentCounter = &NumAllocations;
+}
+
+FDS5WAllocationScope::~FDS5WAllocationScope()
+{
+	CurrentCounter = OuterCounter;
+	if (OuterCounter)
+	{
+		*OuterCounter += NumAllocations;
+	}
+
+	if (bSteadyState && NumAllocations > 0)
+	{
+		FDS5WAllocationTracker::NumViolations.fetch_add(1, std::memory_order_relaxed);
+		UE_LOG(LogTemp, Warning, TEXT("%s allocated %llu times after warm-up."), Name, NumAllocations);
+	}
+}
@@ -0,0 +1,124 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WAnalog.h"
+#include "Math/UnrealMathUtility.h"
+#include "Math/VectorRegister.h"
+#include "Misc/ConfigCacheIni.h"
+
+namespace
+{
+	void InitResponse(FDS5WAnalogResponse& Response, float InnerDeadzone)
+	{
+		Response.InnerDeadzone = InnerDeadzone;
+		Response.OuterDeadzone = 1.f;
+		Response.AntiDeadzone = 0.f;
+		Response.Curvature = 0.f;
+	}
+
+	void LoadResponse(const TCHAR* Prefix, FDS5WAnalogResponse& Response)
+	{
+		const FString Name(Prefix);
+		GConfig->GetFloat(DS5W_ANALOG_CONFIG_SECTION, *(Name + TEXT("InnerDeadzone")), Response.InnerDeadzone, GInputIni);
+		GConfig->GetFloat(DS5W_ANALOG_CONFIG_SECTION, *(Name + TEXT("OuterDeadzone")), Response.OuterDeadzone, GInputIni);
+		GConfig->GetFloat(DS5W_ANALOG_CONFIG_SECTION, *(Name + TEXT("AntiDeadzone")), Response.AntiDeadzone, GInputIni);
+		GConfig->GetFloat(DS5W_ANALOG_CONFIG_SECTION, *(Name + TEXT("Curvature")), Response.Curvature, GInputIni);
+	}
+}
+
+FDS5WAnalogSettings::FDS5WAnalogSettings()
+{
+	// No deadzone unless configured, the engine applies its own to the axes
+	InitResponse(LeftStick, 0.f);
+	InitResponse(RightStick, 0.f);
+	InitResponse(LeftTrigger, 0.f);
+	InitResponse(RightTrigger, 0.f);
+
+	// Releasing a bit below the press point stops a stick resting on the threshold from chattering
+	StickPressThreshold = DS5W_LEFT_THUMB_DEADZONE / 127.f;
+	StickReleaseThreshold = StickPressThreshold * 0.75f;
+	TriggerPressThreshold = DS5W_TRIGGER_THRESHOLD / 255.f;
+	TriggerReleaseThreshold = TriggerPressThreshold * 0.75f;
+}
+
+void FDS5WAnalogSettings::LoadConfig()
+{
+	LoadResponse(TEXT("LeftStick"), LeftStick);
+	LoadResponse(TEXT("RightStick"), RightStick);
+	LoadResponse(TEXT("LeftTrigger"), LeftTrigger);
+	LoadResponse(TEXT("RightTrigger"), RightTrigger);
+
+	GConfig->GetFloat(DS5W_ANALOG_CONFIG_SECTION, TEXT("StickPressThreshold"), StickPressThreshold, GInputIni);
+	GConfig->GetFloat(DS5W_ANALOG_CONFIG_SECTION, TEXT("StickReleaseThreshold"), StickReleaseThreshold, GInputIni);
+	GConfig->GetFloat(DS5W_ANALOG_CONFIG_SECTION, TEXT("TriggerPressThreshold"), TriggerPressThreshold, GInputIni);
+	GConfig->GetFloat(DS5W_ANALOG_CONFIG_SECTION, TEXT("TriggerReleaseThreshold"), TriggerReleaseThreshold, GInputIni);
+
+	// A release above the press point would never release
+	StickReleaseThreshold = FMath::Min(StickReleaseThreshold, StickPressThreshold);
+	TriggerReleaseThreshold = FMath::Min(TriggerReleaseThreshold, TriggerPressThreshold);
+}
+
+void FDS5WAnalogProcessor::Init(const FDS5WAnalogSettings& Settings)
+{
+	const FDS5WAnalogResponse* Responses[4] = { &Settings.LeftStick, &Settings.RightStick, &Settings.LeftTrigger, &Settings.RightTrigger };
+
+	for (int32 Lane = 0; Lane < 4; ++Lane)
+	{
+		const FDS5WAnalogResponse& Response = *Responses[Lane];
+		InnerDeadzone[Lane] = FMath::Clamp(Response.InnerDeadzone, 0.f, 1.f);
+		InvRange[Lane] = 1.f / FMath::Max(Response.OuterDeadzone - InnerDeadzone[Lane], KINDA_SMALL_NUMBER);
+		AntiDeadzone[Lane] = FMath::Clamp(Response.AntiDeadzone, 0.f, 1.f);
+		Curvature[Lane] = FMath::Clamp(Response.Curvature, 0.f, 1.f);
+	}
+}
+
+void FDS5WAnalogProcessor::Process(const DS5W::DS5InputState& State, float* OutValues) const
+{
+	const VectorRegister Sticks = VectorMultiply(
+		MakeVectorRegister((float)State.leftStick.x, (float)State.leftStick.y, (float)State.rightStick.x, (float)State.rightStick.y),
+		VectorSetFloat1(1.f / 127.f));
+	const VectorRegister Triggers = VectorMultiply(
+		MakeVectorRegister(0.f, 0.f, (float)State.leftTrigger, (float)State.rightTrigger),
+		VectorSetFloat1(1.f / 255.f));
+
+	// Stick lengths next to the triggers: |left|, |right|, left trigger, right trigger
+	const VectorRegister Squares = VectorMultiply(Sticks, Sticks);
+	const VectorRegister LengthSquares = VectorAdd(Squares, VectorSwizzle(Squares, 1, 0, 3, 2));
+	const VectorRegister Lengths = VectorMultiply(LengthSquares, VectorReciprocalSqrtAccurate(VectorMax(LengthSquares, VectorSetFloat1(SMALL_NUMBER))));
+	const VectorRegister Input = VectorShuffle(Lengths, Triggers, 0, 2, 2, 3);
+
+	// Deadzones
+	VectorRegister Value = VectorMultiply(VectorSubtract(Input, VectorLoadAligned(InnerDeadzone)), VectorLoadAligned(InvRange));
+	Value = VectorMax(Value, VectorZero());
+	const VectorRegister bActive = VectorCompareGT(Value, VectorZero());
+
+	// Past the outer deadzone the value goes on linearly and only the axes are clamped at the end, so stick
+	// diagonals keep the square range of the raw axes and the default response is the plain mapping
+	const VectorRegister Excess = VectorMax(VectorSubtract(Value, VectorOne()), VectorZero());
+	Value = VectorMin(Value, VectorOne());
+
+	// Curve, x + Curvature * (x^3 - x)
+	const VectorRegister Cube = VectorMultiply(VectorMultiply(Value, Value), Value);
+	Value = VectorMultiplyAdd(VectorLoadAligned(Curvature), VectorSubtract(Cube, Value), Value);
+
+	// Anti-deadzone, only once past the inner deadzone so the rest position stays zero
+	const VectorRegister AntiDeadzoneValues = VectorLoadAligned(AntiDeadzone);
+	Value = VectorMultiplyAdd(VectorSubtract(VectorOne(), AntiDeadzoneValues), Value, AntiDeadzoneValues);
+	Value = VectorAdd(VectorSelect(bActive, Value, VectorZero()), Excess);
+
+	// Sticks keep their direction and take the new length
+	const VectorRegister Scales = VectorMultiply(Value, VectorReciprocalAccurate(VectorMax(Input, VectorSetFloat1(SMALL_NUMBER))));
+	const VectorRegister ScaledSticks = VectorMin(VectorMax(VectorMultiply(Sticks, VectorSwizzle(Scales, 0, 0, 1, 1)), VectorSetFloat1(-1.f)), VectorOne());
+	Value = VectorMin(Value, VectorOne());
+
+	alignas(16) float StickValues[4];
+	alignas(16) float TriggerValues[4];
+	VectorStoreAligned(ScaledSticks, StickValues);
+	VectorStoreAligned(Value, TriggerValues);
+
+	OutValues[0] = StickValues[0];
+	OutValues[1] = StickValues[1];
+	OutValues[2] = StickValues[2];
+	OutValues[3] = StickValues[3];
+	OutValues[4] = TriggerValues[2];
+	OutValues[5] = TriggerValues[3];
+}
@@ -0,0 +1,170 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WButtons.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/UnrealMathUtility.h"
+#include "Misc/ConfigCacheIni.h"
+
+void FDS5WButtonMap::Build(const FDS5WAnalogSettings& Settings)
+{
+	// DS5W button index, the byte of the report it lives in (buttonsAndDpad, buttonsA, buttonsB) and its bit
+	struct FDigitalButton
+	{
+		int32 ButtonIndex;
+		int32 Byte;
+		uint8 Mask;
+	};
+	static const FDigitalButton DigitalButtons[] =
+	{
+		{ 0, 0, DS5W_ISTATE_BTX_CROSS },
+		{ 1, 0, DS5W_ISTATE_BTX_CIRCLE },
+		{ 2, 0, DS5W_ISTATE_BTX_SQUARE },
+		{ 3, 0, DS5W_ISTATE_BTX_TRIANGLE },
+		{ 4, 1, DS5W_ISTATE_BTN_A_LEFT_BUMPER },
+		{ 5, 1, DS5W_ISTATE_BTN_A_RIGHT_BUMPER },
+		{ 6, 1, DS5W_ISTATE_BTN_A_SELECT },
+		{ 7, 1, DS5W_ISTATE_BTN_A_MENU },
+		{ 8, 1, DS5W_ISTATE_BTN_A_LEFT_STICK },
+		{ 9, 1, DS5W_ISTATE_BTN_A_RIGHT_STICK },
+		{ 12, 0, DS5W_ISTATE_DPAD_UP },
+		{ 13, 0, DS5W_ISTATE_DPAD_DOWN },
+		{ 14, 0, DS5W_ISTATE_DPAD_LEFT },
+		{ 15, 0, DS5W_ISTATE_DPAD_RIGHT },
+		{ 24, 2, DS5W_ISTATE_BTN_B_PLAYSTATION_LOGO },
+		{ 25, 2, DS5W_ISTATE_BTN_B_PAD_BUTTON },
+		{ 26, 2, DS5W_ISTATE_BTN_B_MIC_BUTTON },
+	};
+
+	static_assert(MAX_NUM_CONTROLLER_BUTTONS <= 32, "Button states are packed into one 32 bit word");
+
+	StickPressThreshold = FMath::RoundToInt(Settings.StickPressThreshold * 127.f);
+	StickReleaseThreshold = FMath::RoundToInt(Settings.StickReleaseThreshold * 127.f);
+	TriggerPressThreshold = FMath::RoundToInt(Settings.TriggerPressThreshold * 255.f);
+	TriggerReleaseThreshold = FMath::RoundToInt(Settings.TriggerReleaseThreshold * 255.f);
+
+	FMemory::Memzero(LUT, sizeof(LUT));
+	for (int32 Value = 0; Value < 256; ++Value)
+	{
+		for (const FDigitalButton& Button : DigitalButtons)
+		{
+			if (Value & Button.Mask)
+			{
+				LUT[Button.Byte][Value] |= 1u << Button.ButtonIndex;
+			}
+		}
+	}
+}
+
+uint32 FDS5WButtonMap::GetButtonWord(const DS5W::DS5InputState& State, uint32 PreviousWord) const
+{
+	uint32 Word = LUT[0][State.buttonsAndDpad] | LUT[1][State.buttonsA] | LUT[2][State.buttonsB];
+
+	// Buttons derived from analog values, a held button only releases below the lower threshold
+	auto AnalogButton = [this, PreviousWord](int32 Value, int32 PressThreshold, int32 ReleaseThreshold, int32 ButtonIndex)
+	{
+		const uint32 Mask = 1u << ButtonIndex;
+		return Value > ((PreviousWord & Mask) ? ReleaseThreshold : PressThreshold) ? Mask : 0u;
+	};
+
+	Word |= AnalogButton(State.leftTrigger, TriggerPressThreshold, TriggerReleaseThreshold, 10);
+	Word |= AnalogButton(State.rightTrigger, TriggerPressThreshold, TriggerReleaseThreshold, 11);
+	Word |= AnalogButton(State.leftStick.y, StickPressThreshold, StickReleaseThreshold, 16);
+	Word |= AnalogButton(-State.leftStick.y, StickPressThreshold, StickReleaseThreshold, 17);
+	Word |= AnalogButton(-State.leftStick.x, StickPressThreshold, StickReleaseThreshold, 18);
+	Word |= AnalogButton(State.leftStick.x, StickPressThreshold, StickReleaseThreshold, 19);
+	Word |= AnalogButton(State.rightStick.y, StickPressThreshold, StickReleaseThreshold, 20);
+	Word |= AnalogButton(-State.rightStick.y, StickPressThreshold, StickReleaseThreshold, 21);
+	Word |= AnalogButton(-State.rightStick.x, StickPressThreshold, StickReleaseThreshold, 22);
+	Word |= AnalogButton(State.rightStick.x, StickPressThreshold, StickReleaseThreshold, 23);
+
+	return Word;
+}
+
+FDS5WButtonProfile::FDS5WButtonProfile()
+{
+	FMemory::Memzero(LUT, sizeof(LUT));
+}
+
+void FDS5WButtonProfile::Compile(FName InName, const int32* Targets)
+{
+	Name = InName;
+
+	FMemory::Memzero(LUT, sizeof(LUT));
+	for (int32 ButtonIndex = 0; ButtonIndex < MAX_NUM_CONTROLLER_BUTTONS; ++ButtonIndex)
+	{
+		if (Targets[ButtonIndex] < 0 || Targets[ButtonIndex] >= MAX_NUM_CONTROLLER_BUTTONS)
+		{
+			continue;
+		}
+
+		// Every byte value with this button's bit set drives the target
+		const int32 Byte = ButtonIndex / 8;
+		const uint32 Bit = 1u << (ButtonIndex % 8);
+		for (uint32 Value = 0; Value < 256; ++Value)
+		{
+			if (Value & Bit)
+			{
+				LUT[Byte][Value] |= 1u << Targets[ButtonIndex];
+			}
+		}
+	}
+}
+
+bool FDS5WButtonProfile::LoadConfig(FName InName, const int32* DefaultTargets)
+{
+	const FString Section = FString::Printf(TEXT("DS5WButtonProfile %s"), *InName.ToString());
+	if (!GConfig->DoesSectionExist(*Section, GInputIni))
+	{
+		return false;
+	}
+
+	int32 Targets[MAX_NUM_CONTROLLER_BUTTONS];
+	for (int32 ButtonIndex = 0; ButtonIndex < MAX_NUM_CONTROLLER_BUTTONS; ++ButtonIndex)
+	{
+		Targets[ButtonIndex] = DefaultTargets[ButtonIndex];
+
+		FString Target;
+		if (!GConfig->GetString(*Section, GetButtonName(ButtonIndex), Target, GInputIni))
+		{
+			continue;
+		}
+
+		if (Target == TEXT("None"))
+		{
+			Targets[ButtonIndex] = INDEX_NONE;
+			continue;
+		}
+
+		int32 SourceIndex = 0;
+		while (SourceIndex < MAX_NUM_CONTROLLER_BUTTONS && Target != GetButtonName(SourceIndex))
+		{
+			++SourceIndex;
+		}
+
+		if (SourceIndex == MAX_NUM_CONTROLLER_BUTTONS)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FDS5WButtonProfile::LoadConfig: Unknown button %s in %s."), *Target, *Section);
+			continue;
+		}
+
+		Targets[ButtonIndex] = DefaultTargets[SourceIndex];
+	}
+
+	Compile(InName, Targets);
+	return true;
+}
+
+const TCHAR* FDS5WButtonProfile::GetButtonName(int32 ButtonIndex)
+{
+	static const TCHAR* ButtonNames[MAX_NUM_CONTROLLER_BUTTONS] =
+	{
+		TEXT("Cross"), TEXT("Circle"), TEXT("Square"), TEXT("Triangle"),
+		TEXT("L1"), TEXT("R1"), TEXT("Create"), TEXT("Options"), TEXT("L3"), TEXT("R3"), TEXT("L2"), TEXT("R2"),
+		TEXT("DPadUp"), TEXT("DPadDown"), TEXT("DPadLeft"), TEXT("DPadRight"),
+		TEXT("LeftStickUp"), TEXT("LeftStickDown"), TEXT("LeftStickLeft"), TEXT("LeftStickRight"),
+		TEXT("RightStickUp"), TEXT("RightStickDown"), TEXT("RightStickLeft"), TEXT("RightStickRight"),
+		TEXT("PS"), TEXT("Touchpad"), TEXT("Mic"),
+	};
+
+	return ButtonNames[ButtonIndex];
+}
@@ -0,0 +1,133 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WClockSync.h"
+#include "Math/UnrealMathUtility.h"
+
+// Largest drift between the two clocks we accept from the fit (1000 ppm)
+#define DS5W_CLOCK_SYNC_MAX_DRIFT 0.001
+
+// Device time may run ahead of host time by this much before we assume the counter restarted
+#define DS5W_CLOCK_SYNC_MAX_GAP   1.0
+
+void FDS5WClockSync::Reset()
+{
+	bHasSample = false;
+
+	LastRawTimestamp = 0;
+	UnwrappedTicks = 0;
+
+	LastDeviceTime = 0.0;
+	LastDeviceDelta = 0.0;
+	LastHostTime = 0.0;
+	LastCaptureTime = 0.0;
+
+	Current.DeviceTime = 0.0;
+	Current.MinOffset = 0.0;
+	CurrentWindowStart = 0.0;
+
+	NumWindows = 0;
+	NextWindow = 0;
+
+	Offset = 0.0;
+	Drift = 0.0;
+	FitOrigin = 0.0;
+}
+
+double FDS5WClockSync::AddSample(uint32 DeviceTimestamp, double HostArrivalTime)
+{
+	if (bHasSample)
+	{
+		// Unsigned subtraction takes care of the counter wrapping around
+		const uint32 DeltaTicks = DeviceTimestamp - LastRawTimestamp;
+		const double DeltaDevice = DeltaTicks / DeviceTicksPerSecond;
+		const double DeltaHost = HostArrivalTime - LastHostTime;
+
+		// A jump the host clock can't explain means the device restarted its counter
+		if (DeltaDevice > DeltaHost + DS5W_CLOCK_SYNC_MAX_GAP)
+		{
+			Reset();
+		}
+		else
+		{
+			UnwrappedTicks += DeltaTicks;
+			LastDeviceDelta = DeltaDevice;
+		}
+	}
+
+	if (!bHasSample)
+	{
+		bHasSample = true;
+		UnwrappedTicks = DeviceTimestamp;
+		LastDeviceDelta = 0.0;
+		CurrentWindowStart = UnwrappedTicks / DeviceTicksPerSecond;
+		Current.DeviceTime = CurrentWindowStart;
+		Current.MinOffset = HostArrivalTime - CurrentWindowStart;
+	}
+
+	LastRawTimestamp = DeviceTimestamp;
+	LastHostTime = HostArrivalTime;
+	LastDeviceTime = UnwrappedTicks / DeviceTicksPerSecond;
+
+	// Track the fastest sample of the current window
+	const double SampleOffset = HostArrivalTime - LastDeviceTime;
+	if (SampleOffset < Current.MinOffset)
+	{
+		Current.DeviceTime = LastDeviceTime;
+		Current.MinOffset = SampleOffset;
+	}
+
+	if (LastDeviceTime - CurrentWindowStart >= WindowLength)
+	{
+		Windows[NextWindow] = Current;
+		NextWindow = (NextWindow + 1) % DS5W_CLOCK_SYNC_WINDOWS;
+		NumWindows = FMath::Min(NumWindows + 1, DS5W_CLOCK_SYNC_WINDOWS);
+		FitWindows();
+
+		CurrentWindowStart = LastDeviceTime;
+		Current.DeviceTime = LastDeviceTime;
+		Current.MinOffset = SampleOffset;
+	}
+	else if (NumWindows == 0)
+	{
+		// No complete window yet, use the best offset seen so far
+		Offset = Current.MinOffset;
+		FitOrigin = LastDeviceTime;
+	}
+
+	// A sample can't have been captured after it arrived, nor before the previous one. The offset drops
+	// whenever a faster sample shows up and jumps with every fit, which would otherwise move capture back
+	LastCaptureTime = FMath::Max(FMath::Min(DeviceToHost(LastDeviceTime), HostArrivalTime), LastCaptureTime);
+	return LastCaptureTime;
+}
+
+double FDS5WClockSync::DeviceToHost(double DeviceSeconds) const
+{
+	return DeviceSeconds + Offset + Drift * (DeviceSeconds - FitOrigin);
+}
+
+void FDS5WClockSync::FitWindows()
+{
+	// Least squares line through the window minima
+	double MeanTime = 0.0;
+	double MeanOffset = 0.0;
+	for (int32 WindowIndex = 0; WindowIndex < NumWindows; ++WindowIndex)
+	{
+		MeanTime += Windows[WindowIndex].DeviceTime;
+		MeanOffset += Windows[WindowIndex].MinOffset;
+	}
+	MeanTime /= NumWindows;
+	MeanOffset /= NumWindows;
+
+	double Sxx = 0.0;
+	double Sxy = 0.0;
+	for (int32 WindowIndex = 0; WindowIndex < NumWindows; ++WindowIndex)
+	{
+		const double X = Windows[WindowIndex].DeviceTime - MeanTime;
+		Sxx += X * X;
+		Sxy += X * (Windows[WindowIndex].MinOffset - MeanOffset);
+	}
+
+	FitOrigin = MeanTime;
+	Offset = MeanOffset;
+	Drift = Sxx > 0.0 ? FMath::Clamp(Sxy / Sxx, -DS5W_CLOCK_SYNC_MAX_DRIFT, DS5W_CLOCK_SYNC_MAX_DRIFT) : 0.0;
+}
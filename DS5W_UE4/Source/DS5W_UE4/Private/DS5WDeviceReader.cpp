@@ -0,0 +1,402 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WDeviceReader.h"
+#include "DS5WAllocationTracker.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Math/UnrealMathUtility.h"
+
+// Time between reconnection attempts of a removed device
+#define DS5W_RECONNECT_INTERVAL 0.5f
+
+FDS5WReportBacklog::FDS5WReportBacklog()
+{
+	Batch.capacity = DS5W_READ_BACKLOG_SIZE - 1;
+	Batch.count = 0;
+	Batch.leftStickX = (signed char*)LeftStickX;
+	Batch.leftStickY = (signed char*)LeftStickY;
+	Batch.rightStickX = (signed char*)RightStickX;
+	Batch.rightStickY = (signed char*)RightStickY;
+	Batch.leftTrigger = LeftTrigger;
+	Batch.rightTrigger = RightTrigger;
+	Batch.buttons = Buttons;
+	Batch.gyroX = GyroX;
+	Batch.gyroY = GyroY;
+	Batch.gyroZ = GyroZ;
+	Batch.accelX = AccelX;
+	Batch.accelY = AccelY;
+	Batch.accelZ = AccelZ;
+	Batch.sensorTimestamp = SensorTimestamp;
+}
+
+void FDS5WReportBacklog::GetInputState(uint32 Index, DS5W::DS5InputState& OutState) const
+{
+	check(Index < Batch.count);
+
+	OutState.leftStick.x = LeftStickX[Index];
+	OutState.leftStick.y = LeftStickY[Index];
+	OutState.rightStick.x = RightStickX[Index];
+	OutState.rightStick.y = RightStickY[Index];
+	OutState.leftTrigger = LeftTrigger[Index];
+	OutState.rightTrigger = RightTrigger[Index];
+	OutState.buttonsAndDpad = (uint8)Buttons[Index];
+	OutState.buttonsA = (uint8)(Buttons[Index] >> 8);
+	OutState.buttonsB = (uint8)(Buttons[Index] >> 16);
+	OutState.imuState.gyroX = GyroX[Index];
+	OutState.imuState.gyroY = GyroY[Index];
+	OutState.imuState.gyroZ = GyroZ[Index];
+	OutState.imuState.accelX = AccelX[Index];
+	OutState.imuState.accelY = AccelY[Index];
+	OutState.imuState.accelZ = AccelZ[Index];
+	OutState.sensorTimestamp = SensorTimestamp[Index];
+}
+
+FDS5WDeviceReader::FDS5WDeviceReader(int32 InControllerId, const FDS5WButtonMap& InButtonMap, FDS5WButtonEventQueue& InButtonEvents, FDS5WInputHistory& InInputHistory, FDS5WMotionLatch& InMotionLatch, FDS5WControllerStats& InStats, FDS5WTrace& InTrace, FDS5WSharedStateExport& InSharedState, FDS5WReportSubscribers& InReportSubscribers)
+	: ControllerId(InControllerId)
+	, ButtonMap(InButtonMap)
+	, ButtonEvents(InButtonEvents)
+	, InputHistory(InInputHistory)
+	, MotionLatch(InMotionLatch)
+	, Stats(InStats)
+	, Trace(InTrace)
+	, SharedState(InSharedState)
+	, ReportSubscribers(InReportSubscribers)
+	, LastButtons(0)
+	, NumReports(0)
+	, bSimulated(false)
+	, Thread(nullptr)
+	, bStopRequested(false)
+	, bConnected(false)
+	, DecodeFlags(DS5W_DECODE_ALL)
+	, Samples(DS5W_INPUT_QUEUE_SIZE + 1)
+{
+	FMemory::Memzero(&Context, sizeof(DS5W::DeviceContext));
+	Context._internal.connection = DS5W::DeviceConnection::USB;
+
+	ClockSync.Reset();
+}
+
+FDS5WDeviceReader::~FDS5WDeviceReader()
+{
+	Shutdown();
+}
+
+bool FDS5WDeviceReader::Start(DS5W::DeviceEnumInfo& EnumInfo)
+{
+	if (DS5W_FAILED(DS5W::initDeviceContext(&EnumInfo, &Context)))
+	{
+		DS5W::freeDeviceContext(&Context);
+		return false;
+	}
+
+	bStopRequested = false;
+	bConnected = true;
+
+	Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("DS5WReader%d"), ControllerId), 0, TPri_AboveNormal);
+	if (!Thread)
+	{
+		bConnected = false;
+		DS5W::freeDeviceContext(&Context);
+		return false;
+	}
+
+	return true;
+}
+
+void FDS5WDeviceReader::Shutdown()
+{
+	if (Thread)
+	{
+		// Kill calls Stop and waits, the pending read returns with the next report
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	bConnected = false;
+	DS5W::freeDeviceContext(&Context);
+}
+
+void FDS5WDeviceReader::Stop()
+{
+	bStopRequested = true;
+}
+
+uint32 FDS5WDeviceReader::Run()
+{
+	FDS5WInputSample Sample;
+	DS5W::DS5InputState NewestState;
+	FMemory::Memzero(Sample.State);
+	FMemory::Memzero(NewestState);
+	NumReports = 0;
+
+	while (!bStopRequested)
+	{
+		if (!Context._internal.connected)
+		{
+			HandleDisconnect(FPlatformTime::Seconds());
+
+			if (DS5W_FAILED(DS5W::reconnectDevice(&Context)))
+			{
+				FPlatformProcess::Sleep(DS5W_RECONNECT_INTERVAL);
+				continue;
+			}
+
+			// The device clock restarted and any touch in progress is gone
+			ClockSync.Reset();
+			Touch.Reset();
+			NumReports = 0;
+		}
+
+		// Reading, decoding and queueing a report must not allocate once running
+		DS5W_ALLOCATION_SCOPE("FDS5WDeviceReader::Run", NumReports >= DS5W_ALLOCATION_WARMUP);
+
+		// Pick up changed demand before decoding the next report
+		const uint32 RequestedDecodeFlags = DecodeFlags.load(std::memory_order_relaxed);
+		if (RequestedDecodeFlags != Context._internal.decodeFlags)
+		{
+			if (!(RequestedDecodeFlags & DS5W_DECODE_TOUCH))
+			{
+				Touch.Reset();
+			}
+			DS5W::setDeviceInputDecodeFlags(&Context, RequestedDecodeFlags);
+		}
+
+		// Normally one report, after this thread was held up also the ones queued behind it
+		const uint64 ReadStartCycles = FPlatformTime::Cycles64();
+		if (DS5W_FAILED(DS5W::readDeviceInputReports(&Context, Backlog.Reports, DS5W_READ_BACKLOG_SIZE, &Backlog.Batch, &NewestState)))
+		{
+			continue;
+		}
+
+		const double ReadCompletionTime = FPlatformTime::Seconds();
+
+		// The library stamps the report's arrival with the performance counter the cycle counter reads
+		const uint64 ReadEndCycles = FPlatformTime::Cycles64();
+		const uint64 ArrivalCycles = FMath::Clamp<uint64>((uint64)Context._internal.readCompletionTicks, ReadStartCycles, ReadEndCycles);
+		Stats.ReadWait.RecordCycles(ArrivalCycles - ReadStartCycles);
+		Stats.Parse.RecordCycles(ReadEndCycles - ArrivalCycles);
+
+		bConnected = true;
+
+		// Oldest first, all of them arrived together
+		const uint32 NumRead = Backlog.Batch.count + 1;
+		for (uint32 Index = 0; Index < NumRead; ++Index)
+		{
+			const bool bNewest = Index + 1 == NumRead;
+			if (bNewest)
+			{
+				Sample.State = NewestState;
+			}
+			else
+			{
+				// Touch and status stay at the previous report's until the newest one
+				Backlog.GetInputState(Index, Sample.State);
+				FDS5WControllerStats::Increment(Stats.NumBacklogReports);
+			}
+			++NumReports;
+
+			Sample.CaptureTime = ClockSync.AddSample(Sample.State.sensorTimestamp, ReadCompletionTime);
+			Sample.DeviceTime = ClockSync.GetLastDeviceTime();
+			Sample.ArrivalCycles = ArrivalCycles;
+
+			ProcessSample(Sample);
+
+			if (bNewest && Trace.IsEnabled())
+			{
+				Trace.Record(EDS5WTraceStage::Read, ControllerId, ReadStartCycles, ArrivalCycles);
+				Trace.Record(EDS5WTraceStage::Parse, ControllerId, ArrivalCycles, ReadEndCycles);
+				Trace.Record(EDS5WTraceStage::Queue, ControllerId, ReadEndCycles, FPlatformTime::Cycles64());
+			}
+
+			// After the game thread has the report, the callbacks only hold up this device
+			DeliverToSubscribers(Sample, Backlog.GetReport(Index, IsBluetooth()));
+		}
+
+		// Write the latest output state between two reads
+		if (OutputState.IsDirty())
+		{
+			OutputState.SwapReadBuffers();
+			DS5W::DS5OutputState Output = OutputState.Read();
+
+			const uint64 WriteStartCycles = FPlatformTime::Cycles64();
+			DS5W::setDeviceOutputState(&Context, &Output);
+			const uint64 WriteEndCycles = FPlatformTime::Cycles64();
+
+			Stats.OutputWrite.RecordCycles(WriteEndCycles - WriteStartCycles);
+			if (Trace.IsEnabled())
+			{
+				Trace.Record(EDS5WTraceStage::OutputWrite, ControllerId, WriteStartCycles, WriteEndCycles);
+			}
+			FDS5WControllerStats::Increment(Stats.NumOutputsSent);
+		}
+	}
+
+	return 0;
+}
+
+bool FDS5WDeviceReader::StartSimulated()
+{
+	if (Thread)
+	{
+		return false;
+	}
+
+	bSimulated = true;
+	bConnected = true;
+	ClockSync.Reset();
+	return true;
+}
+
+void FDS5WDeviceReader::SubmitSimulatedReport(const DS5W::DS5InputState& State, double CaptureTime)
+{
+	SubmitSimulated(State, CaptureTime, false);
+}
+
+void FDS5WDeviceReader::SubmitSimulatedArrival(const DS5W::DS5InputState& State, double ArrivalTime)
+{
+	SubmitSimulated(State, ArrivalTime, true);
+}
+
+void FDS5WDeviceReader::SubmitSimulated(const DS5W::DS5InputState& State, double Time, bool bMapDeviceTime)
+{
+	check(bSimulated);
+
+	if (!bConnected)
+	{
+		// Like a reconnect, the device clock and touch restart
+		ClockSync.Reset();
+		Touch.Reset();
+		NumReports = 0;
+		bConnected = true;
+	}
+
+	// Same expectation as for device reports, checked by the allocation test
+	DS5W_ALLOCATION_SCOPE("FDS5WDeviceReader::SubmitSimulated", NumReports >= DS5W_ALLOCATION_WARMUP);
+	++NumReports;
+
+	DS5W::setDeviceInputDecodeFlags(&Context, DecodeFlags.load(std::memory_order_relaxed));
+
+	FDS5WInputSample Sample;
+	Sample.State = State;
+	const double MappedCaptureTime = ClockSync.AddSample(State.sensorTimestamp, Time);
+	Sample.CaptureTime = bMapDeviceTime ? MappedCaptureTime : Time;
+	Sample.DeviceTime = ClockSync.GetLastDeviceTime();
+	Sample.ArrivalCycles = FPlatformTime::Cycles64();
+
+	ProcessSample(Sample);
+	DeliverToSubscribers(Sample, nullptr);
+}
+
+void FDS5WDeviceReader::DisconnectSimulated(double Time)
+{
+	check(bSimulated);
+
+	HandleDisconnect(Time);
+}
+
+void FDS5WDeviceReader::ProcessSample(FDS5WInputSample& Sample)
+{
+	// Edges go out before the sample so the game thread never sees a state without its events
+	EmitButtonEvents(ButtonMap.GetButtonWord(Sample.State, LastButtons), Sample.CaptureTime);
+
+	if (Context._internal.decodeFlags & DS5W_DECODE_TOUCH)
+	{
+		Touch.AddSample(Sample.State, Sample.CaptureTime);
+	}
+
+	if (Context._internal.decodeFlags & DS5W_DECODE_MOTION)
+	{
+		const DS5W::IMUState& IMU = Sample.State.imuState;
+		Sample.GyroAccumulator = MotionLatch.AddReport(FVector(IMU.gyroX, IMU.gyroY, IMU.gyroZ), Sample.DeviceTime, Sample.CaptureTime);
+	}
+	else
+	{
+		MotionLatch.Restart();
+		Sample.GyroAccumulator = MotionLatch.GetAccumulator();
+	}
+
+	InputHistory.Push(Sample.State, Sample.CaptureTime);
+
+	if (SharedState.IsOpen())
+	{
+		// The orientation the game fused last, advanced to this report
+		FQuat Orientation;
+		double OrientationTime;
+		const bool bHasOrientation = (Context._internal.decodeFlags & DS5W_DECODE_MOTION) && MotionLatch.GetLatestOrientation(Orientation, OrientationTime);
+		SharedState.Publish(ControllerId, Sample.State, Sample.CaptureTime, IsBluetooth(), bHasOrientation ? &Orientation : nullptr);
+	}
+
+	FDS5WControllerStats::Increment(Stats.NumReports);
+	if (!Samples.Enqueue(Sample))
+	{
+		FDS5WControllerStats::Increment(Stats.NumDroppedReports);
+	}
+}
+
+void FDS5WDeviceReader::DeliverToSubscribers(const FDS5WInputSample& Sample, const uint8* Data)
+{
+	if (!ReportSubscribers.HasSubscribers())
+	{
+		return;
+	}
+
+	// The next read reuses the buffer, but only after this
+	FDS5WRawReportView Report;
+	Report.ControllerId = ControllerId;
+	Report.bBluetooth = IsBluetooth();
+	Report.Data = Data;
+	Report.NumBytes = !Data ? 0 : (Report.bBluetooth ? DS5W_RAW_REPORT_BT_BYTES : DS5W_RAW_REPORT_USB_BYTES);
+	Report.State = &Sample.State;
+	Report.CaptureTime = Sample.CaptureTime;
+	Report.DeviceTime = Sample.DeviceTime;
+	ReportSubscribers.Deliver(Report);
+}
+
+void FDS5WDeviceReader::HandleDisconnect(double Time)
+{
+	// Release whatever was held before the game thread sees the disconnect
+	EmitButtonEvents(0, Time);
+
+	MotionLatch.Restart();
+
+	// Reconnection attempts come back here, only the first one is recorded
+	if (bConnected)
+	{
+		InputHistory.PushDisconnect(Time);
+		if (SharedState.IsOpen())
+		{
+			SharedState.PublishDisconnect(ControllerId);
+		}
+		bConnected = false;
+	}
+}
+
+void FDS5WDeviceReader::EmitButtonEvents(uint32 Buttons, double CaptureTime)
+{
+	FDS5WButtonEvent Event;
+	Event.CaptureTime = CaptureTime;
+	Event.ControllerId = ControllerId;
+
+	for (uint32 ChangedButtons = Buttons ^ LastButtons; ChangedButtons; ChangedButtons &= ChangedButtons - 1)
+	{
+		const int32 ButtonIndex = FMath::CountTrailingZeros(ChangedButtons);
+		const uint32 ButtonMask = 1u << ButtonIndex;
+
+		Event.ButtonIndex = (uint8)ButtonIndex;
+		Event.bPressed = (Buttons & ButtonMask) != 0;
+
+		// A full queue keeps the old bit, the edge is retried with the next report
+		if (ButtonEvents.Enqueue(Event))
+		{
+			LastButtons ^= ButtonMask;
+		}
+	}
+}
+
+void FDS5WDeviceReader::SetOutputState(const DS5W::DS5OutputState& InOutputState)
+{
+	OutputState.GetWriteBuffer() = InOutputState;
+	OutputState.SwapWriteBuffers();
+}
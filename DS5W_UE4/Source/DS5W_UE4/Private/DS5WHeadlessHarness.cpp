@@ -0,0 +1,301 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WHeadlessHarness.h"
+#include "DS5WClockSync.h"
+#include "DS5WInterface.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#if PLATFORM_WINDOWS
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace
+{
+	const TCHAR* EventTypeNames[] = { TEXT("Pressed"), TEXT("Released"), TEXT("Analog") };
+
+	/** Time stamp counter (cycles at the nominal clock) where there is one, FPlatformTime::Cycles64 may tick much slower */
+	uint64 ReadCpuCycles()
+	{
+#if PLATFORM_CPU_X86_FAMILY
+		return __rdtsc();
+#else
+		return FPlatformTime::Cycles64();
+#endif
+	}
+}
+
+FString FDS5WRecordedEvent::ToString() const
+{
+	return FString::Printf(TEXT("%u %s %s %d %.6f %d %.6f"), Frame, EventTypeNames[(uint8)Type], *Key.ToString(), ControllerId, Value, bIsRepeat ? 1 : 0, InputTime);
+}
+
+bool FDS5WRecordedEvent::FromString(const FString& Line, FDS5WRecordedEvent& OutEvent)
+{
+	TArray<FString> Fields;
+	if (Line.ParseIntoArrayWS(Fields) != 7)
+	{
+		return false;
+	}
+
+	int32 TypeIndex = 0;
+	while (TypeIndex < UE_ARRAY_COUNT(EventTypeNames) && Fields[1] != EventTypeNames[TypeIndex])
+	{
+		++TypeIndex;
+	}
+	if (TypeIndex == UE_ARRAY_COUNT(EventTypeNames))
+	{
+		return false;
+	}
+
+	OutEvent.Frame = (uint32)FCString::Atoi64(*Fields[0]);
+	OutEvent.Type = (EDS5WRecordedEventType)TypeIndex;
+	OutEvent.Key = *Fields[2];
+	OutEvent.ControllerId = FCString::Atoi(*Fields[3]);
+	OutEvent.Value = FCString::Atof(*Fields[4]);
+	OutEvent.bIsRepeat = FCString::Atoi(*Fields[5]) != 0;
+	OutEvent.InputTime = FCString::Atod(*Fields[6]);
+	return true;
+}
+
+FDS5WRecordingMessageHandler::FDS5WRecordingMessageHandler(int32 NumReservedEvents)
+	: Interface(nullptr)
+	, Frame(0)
+{
+	Events.Reserve(NumReservedEvents);
+}
+
+bool FDS5WRecordingMessageHandler::OnControllerAnalog(FGamepadKeyNames::Type KeyName, int32 ControllerId, float AnalogValue)
+{
+	Record(EDS5WRecordedEventType::Analog, KeyName, ControllerId, AnalogValue, false);
+	return true;
+}
+
+bool FDS5WRecordingMessageHandler::OnControllerButtonPressed(FGamepadKeyNames::Type KeyName, int32 ControllerId, bool IsRepeat)
+{
+	Record(EDS5WRecordedEventType::Pressed, KeyName, ControllerId, 0.f, IsRepeat);
+	return true;
+}
+
+bool FDS5WRecordingMessageHandler::OnControllerButtonReleased(FGamepadKeyNames::Type KeyName, int32 ControllerId, bool IsRepeat)
+{
+	Record(EDS5WRecordedEventType::Released, KeyName, ControllerId, 0.f, IsRepeat);
+	return true;
+}
+
+void FDS5WRecordingMessageHandler::Record(EDS5WRecordedEventType Type, FGamepadKeyNames::Type KeyName, int32 ControllerId, float Value, bool bIsRepeat)
+{
+	FDS5WRecordedEvent& Event = Events.AddDefaulted_GetRef();
+	Event.Frame = Frame;
+	Event.Type = Type;
+	Event.Key = KeyName;
+	Event.ControllerId = ControllerId;
+	Event.Value = Value;
+	Event.bIsRepeat = bIsRepeat;
+	Event.InputTime = Interface ? Interface->GetCurrentInputEventTime() : 0.0;
+}
+
+FDS5WHeadlessHarness::FDS5WHeadlessHarness(int32 InNumControllers, double InFrameInterval, double InReportInterval)
+	: NumControllers(FMath::Clamp(InNumControllers, 0, MAX_NUM_DS5W_CONTROLLERS))
+	, FrameInterval(InFrameInterval)
+	, ReportInterval(InReportInterval)
+	, Time(1.0)
+	, Frame(0)
+	, Handler(MakeShared<FDS5WRecordingMessageHandler>())
+{
+	Interface = MakeUnique<FDS5WInterface>(Handler, false);
+	Interface->SetSimulatedTime(Time);
+	Handler->SetInterface(Interface.Get());
+
+	for (int32 ControllerId = 0; ControllerId < NumControllers; ++ControllerId)
+	{
+		Interface->AddSimulatedController(ControllerId);
+	}
+}
+
+FDS5WHeadlessHarness::~FDS5WHeadlessHarness()
+{
+	Emulators.Reset();
+	Interface.Reset();
+}
+
+void FDS5WHeadlessHarness::SubmitReport(int32 ControllerId, const DS5W::DS5InputState& State, double CaptureTime)
+{
+	Interface->SubmitSimulatedReport(ControllerId, State, CaptureTime);
+}
+
+void FDS5WHeadlessHarness::Disconnect(int32 ControllerId)
+{
+	Interface->DisconnectSimulatedController(ControllerId, Time);
+}
+
+FDS5WPadEmulator& FDS5WHeadlessHarness::EmulatePad(int32 ControllerId, const FDS5WPadEmulatorSettings& Settings)
+{
+	check(ControllerId >= 0 && ControllerId < NumControllers);
+
+	return *Emulators.Add_GetRef(MakeUnique<FDS5WPadEmulator>(*Interface, ControllerId, Settings, Time));
+}
+
+const FDS5WHarnessFrameStats& FDS5WHeadlessHarness::RunFrame()
+{
+	Time += FrameInterval;
+	Interface->SetSimulatedTime(Time);
+	Handler->SetFrame(Frame++);
+
+	for (const TUniquePtr<FDS5WPadEmulator>& Emulator : Emulators)
+	{
+		Emulator->Advance(Time);
+	}
+
+	const int32 NumEventsBefore = Handler->GetEvents().Num();
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const uint64 StartCpuCycles = ReadCpuCycles();
+
+	Interface->SendControllerEvents();
+
+	const uint64 EndCpuCycles = ReadCpuCycles();
+	FDS5WHarnessFrameStats& Stats = FrameStats.AddDefaulted_GetRef();
+	Stats.Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+	Stats.Cycles = EndCpuCycles - StartCpuCycles;
+	Stats.NumEvents = Handler->GetEvents().Num() - NumEventsBefore;
+	return Stats;
+}
+
+const FDS5WHarnessFrameStats& FDS5WHeadlessHarness::RunFrame(const DS5W::DS5InputState* const* States)
+{
+	// Reports of the coming frame, the last one captured right at the frame time
+	const int32 NumReports = FMath::Max(1, FMath::RoundToInt(FrameInterval / ReportInterval));
+	for (int32 Report = 1; Report <= NumReports; ++Report)
+	{
+		const double CaptureTime = Time + FrameInterval * Report / NumReports;
+		for (int32 ControllerId = 0; ControllerId < NumControllers; ++ControllerId)
+		{
+			if (States[ControllerId])
+			{
+				DS5W::DS5InputState State = *States[ControllerId];
+				State.sensorTimestamp = (uint32)(uint64)(CaptureTime * FDS5WClockSync::DeviceTicksPerSecond);
+				SubmitReport(ControllerId, State, CaptureTime);
+			}
+		}
+	}
+
+	return RunFrame();
+}
+
+FString FDS5WHeadlessHarness::GetSummary() const
+{
+	int32 TotalEvents = 0;
+	int32 MaxEvents = 0;
+	double TotalSeconds = 0.0;
+	double MaxSeconds = 0.0;
+	for (const FDS5WHarnessFrameStats& Stats : FrameStats)
+	{
+		TotalEvents += Stats.NumEvents;
+		MaxEvents = FMath::Max(MaxEvents, Stats.NumEvents);
+		TotalSeconds += Stats.Seconds;
+		MaxSeconds = FMath::Max(MaxSeconds, Stats.Seconds);
+	}
+
+	const int32 NumFrames = FMath::Max(FrameStats.Num(), 1);
+	return FString::Printf(TEXT("%d frames, %d events (%.2f / frame, max %d), %.2f us / frame (max %.2f us)"),
+		FrameStats.Num(), TotalEvents, (double)TotalEvents / NumFrames, MaxEvents, TotalSeconds / NumFrames * 1.e6, MaxSeconds * 1.e6);
+}
+
+void FDS5WHeadlessHarness::GetInputAgeSummary(TArray<FString>& OutLines) const
+{
+	OutLines.Reset();
+	for (int32 ControllerId = 0; ControllerId < NumControllers; ++ControllerId)
+	{
+		const FDS5WControllerStats* Stats = Interface->GetControllerStats(ControllerId);
+		for (const bool bBluetooth : { false, true })
+		{
+			const FDS5WHistogram& InputAge = Stats->GetInputAge(bBluetooth);
+			if (InputAge.GetCount())
+			{
+				OutLines.Add(FString::Printf(TEXT("Controller %d (%s): input age min %.2f ms, p50 %.2f ms, p99 %.2f ms over %llu frames"),
+					ControllerId, bBluetooth ? TEXT("BT") : TEXT("USB"),
+					InputAge.GetMin() / 1.e6, InputAge.GetPercentile(0.5) / 1.e6, InputAge.GetPercentile(0.99) / 1.e6, InputAge.GetCount()));
+			}
+		}
+	}
+}
+
+bool FDS5WHeadlessHarness::CompareWithGolden(const TArray<FDS5WRecordedEvent>& Golden, TArray<FString>& OutDiff, float Tolerance, int32 MaxDiffLines) const
+{
+	const TArray<FDS5WRecordedEvent>& Events = GetEvents();
+	OutDiff.Reset();
+
+	auto Matches = [Tolerance](const FDS5WRecordedEvent& A, const FDS5WRecordedEvent& B)
+	{
+		return A.Frame == B.Frame && A.Type == B.Type && A.Key == B.Key && A.ControllerId == B.ControllerId && A.bIsRepeat == B.bIsRepeat
+			&& FMath::Abs(A.Value - B.Value) <= Tolerance && FMath::Abs(A.InputTime - B.InputTime) <= Tolerance;
+	};
+
+	int32 NumDifferences = 0;
+	for (int32 Index = 0; Index < FMath::Max(Events.Num(), Golden.Num()); ++Index)
+	{
+		const FDS5WRecordedEvent* Expected = Golden.IsValidIndex(Index) ? &Golden[Index] : nullptr;
+		const FDS5WRecordedEvent* Actual = Events.IsValidIndex(Index) ? &Events[Index] : nullptr;
+		if (Expected && Actual && Matches(*Expected, *Actual))
+		{
+			continue;
+		}
+
+		if (NumDifferences++ < MaxDiffLines)
+		{
+			OutDiff.Add(FString::Printf(TEXT("#%d - %s"), Index, Expected ? *Expected->ToString() : TEXT("(none)")));
+			OutDiff.Add(FString::Printf(TEXT("#%d + %s"), Index, Actual ? *Actual->ToString() : TEXT("(none)")));
+		}
+	}
+
+	if (NumDifferences > MaxDiffLines)
+	{
+		OutDiff.Add(FString::Printf(TEXT("... %d more differences"), NumDifferences - MaxDiffLines));
+	}
+
+	return NumDifferences == 0;
+}
+
+bool FDS5WHeadlessHarness::SaveGolden(const FString& Filename) const
+{
+	TArray<FString> Lines;
+	Lines.Reserve(GetEvents().Num());
+	for (const FDS5WRecordedEvent& Event : GetEvents())
+	{
+		Lines.Add(Event.ToString());
+	}
+
+	return FFileHelper::SaveStringArrayToFile(Lines, *Filename);
+}
+
+bool FDS5WHeadlessHarness::LoadGolden(const FString& Filename, TArray<FDS5WRecordedEvent>& OutGolden)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+	{
+		return false;
+	}
+
+	OutGolden.Reset(Lines.Num());
+	for (const FString& Line : Lines)
+	{
+		if (Line.IsEmpty())
+		{
+			continue;
+		}
+
+		FDS5WRecordedEvent Event;
+		if (!FDS5WRecordedEvent::FromString(Line, Event))
+		{
+			UE_LOG(LogTemp, Error, TEXT("FDS5WHeadlessHarness::LoadGolden: Invalid line \"%s\" in %s."), *Line, *Filename);
+			return false;
+		}
+		OutGolden.Add(Event);
+	}
+
+	return true;
+}
@@ -0,0 +1,158 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WInputHistory.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/UnrealMathUtility.h"
+#include "Misc/ConfigCacheIni.h"
+
+FDS5WInputHistory::FDS5WInputHistory()
+	: Mask(0)
+	, NumWritten(0)
+{
+}
+
+void FDS5WInputHistory::Init(int32 InCapacity)
+{
+	int32 Capacity = InCapacity;
+	if (Capacity <= 0)
+	{
+		Capacity = DS5W_INPUT_HISTORY_CAPACITY;
+		GConfig->GetInt(DS5W_INPUT_HISTORY_CONFIG_SECTION, TEXT("Capacity"), Capacity, GInputIni);
+	}
+
+	Capacity = FMath::RoundUpToPowerOfTwo(FMath::Clamp(Capacity, DS5W_INPUT_HISTORY_MIN_CAPACITY, DS5W_INPUT_HISTORY_MAX_CAPACITY));
+
+	Slots = MakeUnique<FSlot[]>(Capacity);
+	Mask = Capacity - 1;
+	NumWritten.store(0, std::memory_order_relaxed);
+}
+
+void FDS5WInputHistory::Push(const DS5W::DS5InputState& State, double CaptureTime)
+{
+	FDS5WInputHistoryEntry Entry;
+	Entry.CaptureTime = CaptureTime;
+	Entry.Snapshot.FromInputState(State);
+	Entry.bConnected = true;
+	Write(Entry);
+}
+
+void FDS5WInputHistory::PushDisconnect(double Time)
+{
+	FDS5WInputHistoryEntry Entry;
+	FMemory::Memzero(Entry);
+	Entry.CaptureTime = Time;
+	Entry.bConnected = false;
+	Write(Entry);
+}
+
+void FDS5WInputHistory::Write(const FDS5WInputHistoryEntry& Entry)
+{
+	checkSlow(Slots);
+
+	// Only this thread writes, the count needs no read-modify-write
+	const uint64 Index = NumWritten.load(std::memory_order_relaxed);
+	FSlot& Slot = Slots[Index & Mask];
+
+	// The binary searches need capture times in order
+	checkSlow(Index == 0 || Entry.CaptureTime >= Slots[(Index - 1) & Mask].Entry.CaptureTime);
+
+	// Readers that copy the slot from here on see an odd or newer sequence and drop the copy
+	Slot.Sequence.store((uint32)(2 * Index + 1), std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	FMemory::Memcpy(&Slot.Entry, &Entry, sizeof(FDS5WInputHistoryEntry));
+
+	Slot.Sequence.store((uint32)(2 * Index + 2), std::memory_order_release);
+	NumWritten.store(Index + 1, std::memory_order_release);
+}
+
+bool FDS5WInputHistory::GetEntry(uint64 Index, FDS5WInputHistoryEntry& OutEntry) const
+{
+	if (!Slots || Index >= GetNumWritten())
+	{
+		return false;
+	}
+
+	// Report Index was complete when NumWritten passed it, any other sequence means it was overwritten
+	const FSlot& Slot = Slots[Index & Mask];
+	const uint32 Expected = (uint32)(2 * Index + 2);
+	if (Slot.Sequence.load(std::memory_order_acquire) != Expected)
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(&OutEntry, &Slot.Entry, sizeof(FDS5WInputHistoryEntry));
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return Slot.Sequence.load(std::memory_order_relaxed) == Expected;
+}
+
+uint64 FDS5WInputHistory::FindFirstAfter(double Time, uint64 Oldest, uint64 End) const
+{
+	FDS5WInputHistoryEntry Entry;
+	uint64 Low = Oldest;
+	uint64 High = End;
+
+	while (Low < High)
+	{
+		const uint64 Middle = Low + (High - Low) / 2;
+
+		// An overwritten report is older than anything still held
+		if (!GetEntry(Middle, Entry) || Entry.CaptureTime <= Time)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+
+	return Low;
+}
+
+uint64 FDS5WInputHistory::FindFirstAfter(double Time) const
+{
+	const uint64 End = GetNumWritten();
+	return FindFirstAfter(Time, End > Mask + 1 ? End - (Mask + 1) : 0, End);
+}
+
+bool FDS5WInputHistory::GetEntryAtTime(double Time, FDS5WInputHistoryEntry& OutEntry) const
+{
+	const uint64 End = GetNumWritten();
+	const uint64 Oldest = End > Mask + 1 ? End - (Mask + 1) : 0;
+
+	const uint64 First = FindFirstAfter(Time, Oldest, End);
+	if (First == Oldest)
+	{
+		return false;
+	}
+
+	// Fails if the writer wrapped onto the report while searching
+	return GetEntry(First - 1, OutEntry);
+}
+
+int32 FDS5WInputHistory::GetEntriesInRange(double StartTime, double EndTime, FDS5WInputHistoryEntry* OutEntries, int32 MaxEntries) const
+{
+	const uint64 End = GetNumWritten();
+	const uint64 Oldest = End > Mask + 1 ? End - (Mask + 1) : 0;
+
+	int32 NumEntries = 0;
+	for (uint64 Index = FindFirstAfter(StartTime, Oldest, End); Index < End && NumEntries < MaxEntries; ++Index)
+	{
+		// Reports overwritten while copying are skipped
+		if (!GetEntry(Index, OutEntries[NumEntries]))
+		{
+			continue;
+		}
+
+		if (OutEntries[NumEntries].CaptureTime > EndTime)
+		{
+			break;
+		}
+
+		++NumEntries;
+	}
+
+	return NumEntries;
+}
@@ -0,0 +1,105 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WInputResampler.h"
+#include "DS5WInputHistory.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/UnrealMathUtility.h"
+
+namespace
+{
+	/** Add the gyro of a report over Seconds */
+	void IntegrateGyro(const FDS5WInputHistoryEntry& Entry, double Seconds, FVector& Rotation)
+	{
+		if (Seconds <= 0.0)
+		{
+			return;
+		}
+
+		float Gyro[3];
+		Entry.Snapshot.GetGyro(Gyro);
+		Rotation.X += Gyro[0] * (float)Seconds;
+		Rotation.Y += Gyro[1] * (float)Seconds;
+		Rotation.Z += Gyro[2] * (float)Seconds;
+	}
+
+	void GetAnalog(const FDS5WInputHistoryEntry& Entry, float* OutSticks, float* OutTriggers)
+	{
+		const FDS5WSnapshot& Snapshot = Entry.Snapshot;
+		OutSticks[0] = FMath::Max(Snapshot.LeftStick[0] / 127.f, -1.f);
+		OutSticks[1] = FMath::Max(Snapshot.LeftStick[1] / 127.f, -1.f);
+		OutSticks[2] = FMath::Max(Snapshot.RightStick[0] / 127.f, -1.f);
+		OutSticks[3] = FMath::Max(Snapshot.RightStick[1] / 127.f, -1.f);
+		OutTriggers[0] = Snapshot.Triggers[0] / 255.f;
+		OutTriggers[1] = Snapshot.Triggers[1] / 255.f;
+	}
+}
+
+bool FDS5WInputResampler::Resample(const FDS5WInputHistory& History, double TickStart, double TickEnd, FDS5WTickInput& OutInput)
+{
+	FMemory::Memzero(OutInput);
+
+	// Latest report at or before the time reached so far, starting with the state the tick begins in
+	FDS5WInputHistoryEntry Last;
+	const uint64 First = History.FindFirstAfter(TickStart);
+	bool bHasLast = First > 0 && History.GetEntry(First - 1, Last);
+
+	FDS5WInputHistoryEntry Next;
+	bool bHasNext = false;
+
+	uint32 Buttons = bHasLast ? Last.Snapshot.Buttons : 0;
+	const uint64 End = History.GetNumWritten();
+	for (uint64 Index = First; Index < End; ++Index)
+	{
+		FDS5WInputHistoryEntry Entry;
+		if (!History.GetEntry(Index, Entry))
+		{
+			// Overwritten while reading, the history is too short for this tick
+			continue;
+		}
+
+		if (Entry.CaptureTime > TickEnd)
+		{
+			Next = Entry;
+			bHasNext = true;
+			break;
+		}
+
+		IntegrateGyro(Entry, Entry.CaptureTime - (bHasLast ? FMath::Max(Last.CaptureTime, TickStart) : TickStart), OutInput.GyroRotation);
+
+		OutInput.PressedButtons |= Entry.Snapshot.Buttons & ~Buttons;
+		OutInput.ReleasedButtons |= Buttons & ~Entry.Snapshot.Buttons;
+		Buttons = Entry.Snapshot.Buttons;
+		++OutInput.NumReports;
+
+		Last = Entry;
+		bHasLast = true;
+	}
+
+	if (!bHasLast)
+	{
+		return false;
+	}
+
+	// The rest of the tick belongs to the next report, or is extrapolated with the last one
+	IntegrateGyro(bHasNext ? Next : Last, TickEnd - FMath::Max(Last.CaptureTime, TickStart), OutInput.GyroRotation);
+
+	GetAnalog(Last, OutInput.Sticks, OutInput.Triggers);
+	if (bHasNext && Next.CaptureTime > Last.CaptureTime)
+	{
+		float NextSticks[4];
+		float NextTriggers[2];
+		GetAnalog(Next, NextSticks, NextTriggers);
+
+		const float Alpha = (float)((TickEnd - Last.CaptureTime) / (Next.CaptureTime - Last.CaptureTime));
+		for (int32 Axis = 0; Axis < 4; ++Axis)
+		{
+			OutInput.Sticks[Axis] = FMath::Lerp(OutInput.Sticks[Axis], NextSticks[Axis], Alpha);
+		}
+		OutInput.Triggers[0] = FMath::Lerp(OutInput.Triggers[0], NextTriggers[0], Alpha);
+		OutInput.Triggers[1] = FMath::Lerp(OutInput.Triggers[1], NextTriggers[1], Alpha);
+	}
+
+	OutInput.Buttons = Buttons;
+	OutInput.bConnected = Last.bConnected;
+	return true;
+}
@@ -2,18 +2,25 @@
 
 #include "DS5WInterface.h"
 #include "IDS5W_UE4.h"
+#include "DS5WAllocationTracker.h"
 #include "HAL/PlatformTime.h"
 #include "Math/UnrealMathUtility.h"
 #include "Misc/App.h"
 #include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
 #include "Misc/ConfigCacheIni.h"
+#include "Misc/OutputDevice.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "GameFramework/InputSettings.h"
 #include "..\Public\DS5WInterface.h"
 
-#define DS5W_LEFT_THUMB_DEADZONE  30
-#define DS5W_RIGHT_THUMB_DEADZONE 30
-#define DS5W_TRIGGER_THRESHOLD    30
 #define DS5W_GYROSCOPE_THRESHOLD  0.f
 
+// How often key bindings are scanned for DS5W keys, and how long a query keeps its input decoded
+#define DS5W_BINDING_REFRESH_INTERVAL 1.0
+#define DS5W_QUERY_DEMAND_TIMEOUT     2.0
+
 // There are gyroscope axices sensitivity params. It should be configurable by game options
 static float gyroscope_axis_x_sens = 1.0f;
 static float gyroscope_axis_y_sens = 1.0f;
@@ -29,8 +36,11 @@ void FDS5WInterface::FGyroscopeSensor::Init(int ID) {
 
 	LastTime = FPlatformTime::Seconds();
 
-	InputBufferSize = 10;
-	InputBuffer.Init(FVector2D(), InputBufferSize);
+	for (FVector2D& Sample : InputBuffer)
+	{
+		Sample.Set(0.f, 0.f);
+	}
+	CurrentInputIndex = 0;
 
 	Id = ID;
 }
@@ -110,30 +120,39 @@ FVector2D FDS5WInterface::FGyroscopeSensor::GyroCameraWorld(FVector gyro, FVecto
 	return Camera;
 }
 
-FDS5WInterface::FDS5WInterface(const TSharedRef<FGenericApplicationMessageHandler>& InMessageHandler) : MessageHandler(InMessageHandler)
+FDS5WInterface::FDS5WInterface(const TSharedRef<FGenericApplicationMessageHandler>& InMessageHandler, bool bOpenDevices) : MessageHandler(InMessageHandler)
 {
-	con._internal.connected = false;
-	con._internal.connection = DS5W::DeviceConnection::USB;
-	con._internal.deviceHandle = nullptr;
-	con._internal.devicePath[0] = 0x0;
-
 	for (int32 ControllerIndex = 0; ControllerIndex < MAX_NUM_DS5W_CONTROLLERS; ++ControllerIndex)
 	{
+		FControllerHotState& HotState = HotStates[ControllerIndex];
 		FControllerState& ControllerState = ControllerStates[ControllerIndex];
+		FControllerConfig& ControllerConfig = ControllerConfigs[ControllerIndex];
+		FMemory::Memzero(&HotState, sizeof(FControllerHotState));
 		FMemory::Memzero(&ControllerState, sizeof(FControllerState));
+		FMemory::Memzero(&ControllerConfig, sizeof(FControllerConfig));
 
 		ControllerState.ControllerId = ControllerIndex;
-		ControllerState.CueMotionReset = false;
-		ControllerState.UseContinuousCalibration = false;
+		ControllerState.GyroAccumulator = FQuat::Identity;
+		ControllerConfig.CueMotionReset = false;
+		ControllerConfig.UseContinuousCalibration = false;
 
-		ControllerState.DeltaTime = 0.0;
-		ControllerState.LastMeasurementTime = FPlatformTime::Seconds();
+		HotState.LastMeasurementTime = FPlatformTime::Seconds();
+		MotionBatches[ControllerIndex].Reset(-1.0);
 
 		ControllerState.GyroscopeAxises.Init(ControllerState.ControllerId);
 	}
 
+	FMemory::Memzero(InputConsumerCounts, sizeof(InputConsumerCounts));
+	BoundInputDemand = 0;
+	NextBindingRefreshTime = 0.0;
+	for (std::atomic<double>& QueryTime : LastQueryTimes)
+	{
+		QueryTime = -DS5W_QUERY_DEMAND_TIMEOUT;
+	}
+
 	bIsGamepadAttached = true;
 	bNeedsControllerStateUpdate = true;
+	NumFrames = 0;
 	InitialButtonRepeatDelay = 0.2f;
 	ButtonRepeatDelay = 0.1f;
 
@@ -194,10 +213,55 @@ FDS5WInterface::FDS5WInterface(const TSharedRef<FGenericApplicationMessageHandle
 	Buttons[22] = FGamepadKeyNames::RightStickLeft;
 	Buttons[23] = FGamepadKeyNames::RightStickRight;
 
-	//TODO: These buttons aren't named in Gamepad keys. That should probably be fixed at some point.
-	Buttons[24] = FGamepadKeyNames::Invalid;
-	Buttons[25] = FGamepadKeyNames::Invalid;
-	Buttons[26] = FGamepadKeyNames::Invalid;
+	// These buttons aren't named in Gamepad keys, the plugin registers its own
+	Buttons[24] = FDS5WKeyNames::DS5W_PS_Button;
+	Buttons[25] = FDS5WKeyNames::DS5W_Touchpad_Button;
+	Buttons[26] = FDS5WKeyNames::DS5W_Mic_Button;
+
+	LoadButtonProfiles();
+
+	for (FDS5WInputHistory& InputHistory : InputHistories)
+	{
+		InputHistory.Init();
+	}
+
+	PredictionSettings.LoadConfig();
+	for (FDS5WPredictor& Predictor : Predictors)
+	{
+		Predictor.Init(PredictionSettings);
+	}
+
+	AnalogSettings.LoadConfig();
+	AnalogProcessor.Init(AnalogSettings);
+	ButtonMap.Build(AnalogSettings);
+	SimulatedTime = -1.0;
+	StatsResetTime = GetTime();
+	Trace.Init();
+	CurrentInputEventTime = FPlatformTime::Seconds();
+
+	// Headless, controllers are added with AddSimulatedController
+	if (!bOpenDevices)
+	{
+		bIsGamepadAttached = false;
+		return;
+	}
+
+	// External tools get motion and touch as well, so they are decoded while the export is on
+	if (SharedState.Open())
+	{
+		AddInputConsumer(DS5W_DECODE_MOTION | DS5W_DECODE_TOUCH);
+	}
+
+	// Streamed snapshots carry motion and touch too
+	StreamServer = MakeUnique<FDS5WStreamServer>(InputHistories, MAX_NUM_DS5W_CONTROLLERS);
+	if (StreamServer->Start())
+	{
+		AddInputConsumer(DS5W_DECODE_MOTION | DS5W_DECODE_TOUCH);
+	}
+	else
+	{
+		StreamServer.Reset();
+	}
 
 	DS5W::DeviceEnumInfo infos[16];
 	unsigned int controllersCount = 0;
@@ -226,106 +290,174 @@ FDS5WInterface::FDS5WInterface(const TSharedRef<FGenericApplicationMessageHandle
 		UE_LOG(LogTemp, Warning, TEXT("FDS5WInterface::FDS5WInterface: Found more DS5 controllers than we can account for. Not all of them will work as intended!"));
 	}
 
-	if (DS5W_FAILED(DS5W::initDeviceContext(&infos[0], &con))) 
+	bIsGamepadAttached = false;
+	for (int32 ControllerIndex = 0; ControllerIndex < (int32)FMath::Min<unsigned int>(controllersCount, MAX_NUM_DS5W_CONTROLLERS); ++ControllerIndex)
 	{
-		UE_LOG(LogTemp, Error, TEXT("FDS5WInterface::FDS5WInterface: Failure initializing device. Aborting."));
-		bIsGamepadAttached = false;
-		return;
+		Readers[ControllerIndex] = MakeUnique<FDS5WDeviceReader>(ControllerIndex, ButtonMap, ButtonEvents, InputHistories[ControllerIndex], MotionLatches[ControllerIndex], ControllerStats[ControllerIndex], Trace, SharedState, ReportSubscribers);
+		if (!Readers[ControllerIndex]->Start(infos[ControllerIndex]))
+		{
+			UE_LOG(LogTemp, Error, TEXT("FDS5WInterface::FDS5WInterface: Failure initializing device %d."), ControllerIndex);
+			Readers[ControllerIndex].Reset();
+			continue;
+		}
+
+		bIsGamepadAttached = true;
 	}
 }
 
 FDS5WInterface::~FDS5WInterface()
 {
-	DS5W::freeDeviceContext(&con);
+	// It follows the histories, which go away with the interface
+	StreamServer.Reset();
+
+	for (int32 ControllerIndex = 0; ControllerIndex < MAX_NUM_DS5W_CONTROLLERS; ++ControllerIndex)
+	{
+		Readers[ControllerIndex].Reset();
+	}
 }
 
 void FDS5WInterface::SendControllerEvents()
 {
-	DS5W::DS5InputState DS5WStates[MAX_NUM_DS5W_CONTROLLERS];
-	DS5W::DS5OutputState DS5WOutputStates[MAX_NUM_DS5W_CONTROLLERS];
+	// Also charged with what the message handler allocates, check with a handler that doesn't
+	DS5W_ALLOCATION_SCOPE("FDS5WInterface::SendControllerEvents", NumFrames >= DS5W_ALLOCATION_WARMUP);
+	++NumFrames;
+
+	bool bHasNewSample[MAX_NUM_DS5W_CONTROLLERS];
 	bool bWereConnected[MAX_NUM_DS5W_CONTROLLERS];
 	bIsGamepadAttached = false;
-	int btMul = con._internal.connection == DS5W::DeviceConnection::BT ? 10 : 1;
+
+	// Only decode and fuse what somebody consumes
+	const double Now = GetTime();
+	const uint32 InputDemand = GetInputDemand(Now);
+
+	if (StreamServer)
+	{
+		FDS5WStreamCommand Command;
+		while (StreamServer->DequeueCommand(Command))
+		{
+			// Malformed commands are dropped, the client sees its outputs not change
+			if (Command.ControllerId < MAX_NUM_DS5W_CONTROLLERS)
+			{
+				RemoteOutputs[Command.ControllerId].AddCommand(Command, Now, StreamServer->GetCommandTimeout());
+			}
+		}
+	}
 
 	for (int32 ControllerIndex = 0; ControllerIndex < MAX_NUM_DS5W_CONTROLLERS; ++ControllerIndex)
 	{
-		FControllerState& ControllerState = ControllerStates[ControllerIndex];
+		FControllerHotState& HotState = HotStates[ControllerIndex];
+		FDS5WDeviceReader* Reader = Readers[ControllerIndex].Get();
 
-		bWereConnected[ControllerIndex] = ControllerState.bIsConnected;
+		bWereConnected[ControllerIndex] = HotState.bIsConnected;
+		bHasNewSample[ControllerIndex] = false;
 
-		if (ControllerState.bIsConnected || bNeedsControllerStateUpdate)
+		HotState.bIsConnected = Reader && Reader->IsConnected();
+		if (!HotState.bIsConnected)
 		{
-			DS5W::DS5InputState& DS5WState = DS5WStates[ControllerIndex];
-			DS5W::DS5OutputState& DS5WOutputState = DS5WOutputStates[ControllerIndex];
-			FMemory::Memzero(&DS5WState, sizeof(DS5W::DS5InputState));
+			// Send default states once so nothing stays held down, empty slots only cost their hot state
+			if (bWereConnected[ControllerIndex])
+			{
+				FMemory::Memzero(&ControllerStates[ControllerIndex].LastInputState, sizeof(DS5W::DS5InputState));
+			}
+			continue;
+		}
 
-			ControllerState.bIsConnected = (DS5W_SUCCESS(DS5W::getDeviceInputState(&con, &DS5WState)));
-			if (ControllerState.bIsConnected)
+		bIsGamepadAttached = true;
+		HotState.bIsBluetooth = Reader->IsBluetooth();
+		Reader->SetDecodeFlags(InputDemand);
+
+		// Consume everything the reader decoded since the last frame, the newest report wins.
+		// The predictor tracks each of them, it extrapolates from rates of change, and motion fuses each
+		// of them with the device's own sample spacing rather than the frame time
+		FDS5WInputSample Sample;
+		if (!bWereConnected[ControllerIndex])
+		{
+			Predictors[ControllerIndex].Reset();
+		}
+		FMotionBatch& MotionBatch = MotionBatches[ControllerIndex];
+		MotionBatch.Reset(bWereConnected[ControllerIndex] ? HotState.LastDeviceTime : -1.0);
+		const bool bCollectMotion = (InputDemand & DS5W_DECODE_MOTION) != 0;
+		while (Reader->DequeueSample(Sample))
+		{
+			bHasNewSample[ControllerIndex] = true;
+			if (bCollectMotion)
+			{
+				MotionBatch.Add(Sample.State.imuState, Sample.DeviceTime);
+			}
+			if (Trace.IsEnabled())
 			{
-				bIsGamepadAttached = true;
+				Trace.Record(EDS5WTraceStage::Consume, ControllerIndex, Sample.ArrivalCycles, FPlatformTime::Cycles64());
 			}
+			if (PredictionSettings.bEnabled)
+			{
+				Predictors[ControllerIndex].AddSample(Sample.State, Sample.CaptureTime);
+			}
+		}
+
+		if (bHasNewSample[ControllerIndex])
+		{
+			ControllerStates[ControllerIndex].LastInputState = Sample.State;
+			ControllerStates[ControllerIndex].GyroAccumulator = Sample.GyroAccumulator;
+			HotState.LastMeasurementTime = Sample.CaptureTime;
+			HotState.LastDeviceTime = Sample.DeviceTime;
+		}
+
+		// Frames without a new report deliver an older one, they count as well
+		if (bHasNewSample[ControllerIndex] || bWereConnected[ControllerIndex])
+		{
+			const double InputAge = FMath::Max(Now - HotState.LastMeasurementTime, 0.0);
+			ControllerStats[ControllerIndex].GetInputAge(HotState.bIsBluetooth).Record((uint64)(InputAge * 1.e9));
 		}
 	}
 
+	// Presses and releases of all controllers in the order they happened, ahead of this frame's analog values
+	DispatchButtonEvents();
+
 	for (int32 ControllerIndex = 0; ControllerIndex < MAX_NUM_DS5W_CONTROLLERS; ++ControllerIndex)
 	{
 		// Set input scope, there doesn't seem to be a reliable way to differentiate 360 vs Xbox one controllers so use generic name
-		FInputDeviceScope InputScope(this, DS5WInterfaceName, ControllerIndex, DS5WControllerIdentifier);
-
-		FControllerState& ControllerState = ControllerStates[ControllerIndex];
-		GamepadMotion& MotionState = MotionStates[ControllerIndex];
+		FInputDeviceScope InputScope(this, DS5WInterfaceName, ControllerIndex);
 
+		FControllerHotState& HotState = HotStates[ControllerIndex];
 		const bool bWasConnected = bWereConnected[ControllerIndex];
 
 		// If the controller is connected send events or if the controller was connected send a final event with default states so that 
 		// the game doesn't think that controller buttons are still held down
-		if (ControllerState.bIsConnected || bWasConnected)
+		if (HotState.bIsConnected || bWasConnected)
 		{
-			const DS5W::DS5InputState& DS5WState = DS5WStates[ControllerIndex];
-			DS5W::DS5OutputState DS5WOutputState = DS5WOutputStates[ControllerIndex];
+			const uint64 DispatchStartCycles = FPlatformTime::Cycles64();
+
+			FControllerState& ControllerState = ControllerStates[ControllerIndex];
+			FControllerConfig& ControllerConfig = ControllerConfigs[ControllerIndex];
+			GamepadMotion& MotionState = MotionStates[ControllerIndex];
+			FDS5WDeviceReader* Reader = Readers[ControllerIndex].Get();
+
+			CurrentInputEventTime = HotState.LastMeasurementTime;
+
+			const DS5W::DS5InputState& DS5WState = ControllerState.LastInputState;
+			DS5W::DS5OutputState DS5WOutputState;
+			FMemory::Memzero(&DS5WOutputState, sizeof(DS5W::DS5OutputState));
 
 			// If the controller is connected now but was not before, refresh the information
-			if (!bWasConnected && ControllerState.bIsConnected)
+			if (!bWasConnected && HotState.bIsConnected)
 			{
 				FCoreDelegates::OnControllerConnectionChange.Broadcast(true, -1, ControllerState.ControllerId);
+
+				// The factory calibration already removed the gyro bias, so start from a zero offset instead of learning it
+				if (Reader->GetIMUCalibration().factoryCalibrated)
+				{
+					MotionState.ResetContinuousCalibration();
+					MotionState.SetCalibrationOffset(0.f, 0.f, 0.f, 1);
+				}
 			}
-			else if (bWasConnected && !ControllerState.bIsConnected)
+			else if (bWasConnected && !HotState.bIsConnected)
 			{
 				FCoreDelegates::OnControllerConnectionChange.Broadcast(false, -1, ControllerState.ControllerId);
 			}
 
-			bool CurrentStates[MAX_NUM_CONTROLLER_BUTTONS] = { 0 };
-
-			// Get the current state of all buttons
-			CurrentStates[DS5WToXboxControllerMapping[0]] = !!(DS5WState.buttonsAndDpad & DS5W_ISTATE_BTX_CROSS);
-			CurrentStates[DS5WToXboxControllerMapping[1]] = !!(DS5WState.buttonsAndDpad & DS5W_ISTATE_BTX_CIRCLE);
-			CurrentStates[DS5WToXboxControllerMapping[2]] = !!(DS5WState.buttonsAndDpad & DS5W_ISTATE_BTX_SQUARE);
-			CurrentStates[DS5WToXboxControllerMapping[3]] = !!(DS5WState.buttonsAndDpad & DS5W_ISTATE_BTX_TRIANGLE);
-			CurrentStates[DS5WToXboxControllerMapping[4]] = !!(DS5WState.buttonsA & DS5W_ISTATE_BTN_A_LEFT_BUMPER);
-			CurrentStates[DS5WToXboxControllerMapping[5]] = !!(DS5WState.buttonsA & DS5W_ISTATE_BTN_A_RIGHT_BUMPER);
-			CurrentStates[DS5WToXboxControllerMapping[6]] = !!(DS5WState.buttonsA & DS5W_ISTATE_BTN_A_SELECT);
-			CurrentStates[DS5WToXboxControllerMapping[7]] = !!(DS5WState.buttonsA & DS5W_ISTATE_BTN_A_MENU);
-			CurrentStates[DS5WToXboxControllerMapping[8]] = !!(DS5WState.buttonsA & DS5W_ISTATE_BTN_A_LEFT_STICK);
-			CurrentStates[DS5WToXboxControllerMapping[9]] = !!(DS5WState.buttonsA & DS5W_ISTATE_BTN_A_RIGHT_STICK);
-			CurrentStates[DS5WToXboxControllerMapping[10]] = !!(DS5WState.leftTrigger > DS5W_ISTATE_BTN_A_LEFT_TRIGGER);
-			CurrentStates[DS5WToXboxControllerMapping[11]] = !!(DS5WState.rightTrigger > DS5W_ISTATE_BTN_A_RIGHT_TRIGGER);
-			CurrentStates[DS5WToXboxControllerMapping[12]] = !!(DS5WState.buttonsAndDpad & DS5W_ISTATE_DPAD_UP);
-			CurrentStates[DS5WToXboxControllerMapping[13]] = !!(DS5WState.buttonsAndDpad & DS5W_ISTATE_DPAD_DOWN);
-			CurrentStates[DS5WToXboxControllerMapping[14]] = !!(DS5WState.buttonsAndDpad & DS5W_ISTATE_DPAD_LEFT);
-			CurrentStates[DS5WToXboxControllerMapping[15]] = !!(DS5WState.buttonsAndDpad & DS5W_ISTATE_DPAD_RIGHT);
-			CurrentStates[DS5WToXboxControllerMapping[16]] = !!(DS5WState.leftStick.y > DS5W_LEFT_THUMB_DEADZONE);
-			CurrentStates[DS5WToXboxControllerMapping[17]] = !!(DS5WState.leftStick.y < -DS5W_LEFT_THUMB_DEADZONE);
-			CurrentStates[DS5WToXboxControllerMapping[18]] = !!(DS5WState.leftStick.x < -DS5W_LEFT_THUMB_DEADZONE);
-			CurrentStates[DS5WToXboxControllerMapping[19]] = !!(DS5WState.leftStick.x > DS5W_LEFT_THUMB_DEADZONE);
-			CurrentStates[DS5WToXboxControllerMapping[20]] = !!(DS5WState.rightStick.y > DS5W_RIGHT_THUMB_DEADZONE);
-			CurrentStates[DS5WToXboxControllerMapping[21]] = !!(DS5WState.rightStick.y < -DS5W_RIGHT_THUMB_DEADZONE);
-			CurrentStates[DS5WToXboxControllerMapping[22]] = !!(DS5WState.rightStick.y < -DS5W_RIGHT_THUMB_DEADZONE);
-			CurrentStates[DS5WToXboxControllerMapping[23]] = !!(DS5WState.rightStick.y > DS5W_RIGHT_THUMB_DEADZONE);
-			CurrentStates[DS5WToXboxControllerMapping[24]] = !!(DS5WState.buttonsB & DS5W_ISTATE_BTN_B_PLAYSTATION_LOGO);
-			CurrentStates[DS5WToXboxControllerMapping[25]] = !!(DS5WState.buttonsB & DS5W_ISTATE_BTN_B_PAD_BUTTON);
-			CurrentStates[DS5WToXboxControllerMapping[26]] = !!(DS5WState.buttonsB & DS5W_ISTATE_BTN_B_MIC_BUTTON);
-			
-			//TODO: Add touchpad
+			// Touch positions of the newest report, gestures come from the reader's full rate tracking
+			ControllerState.LastFirstFingerLocation_Touchpad = FVector2D(DS5WState.touchPoint1.x, DS5WState.touchPoint1.y);
+			ControllerState.LastSecondFingerLocation_Touchpad = FVector2D(DS5WState.touchPoint2.x, DS5WState.touchPoint2.y);
 
 			// Send new analog data if it's different or outside the platform deadzone.
 			auto OnControllerAnalog = [this, &ControllerState](const FName& GamePadKey, const auto NewAxisValue, const float NewAxisValueNormalized, auto& OldAxisValue, const auto DeadZone) 
@@ -340,33 +472,38 @@ void FDS5WInterface::SendControllerEvents()
 
 			const auto& Gamepad = DS5WState;
 
-			OnControllerAnalog(FGamepadKeyNames::LeftAnalogX, Gamepad.leftStick.x, FMath::GetMappedRangeValueClamped(FVector2D(-127, 127), FVector2D(-1, 1), Gamepad.leftStick.x), ControllerState.LeftXAnalog, DS5W_LEFT_THUMB_DEADZONE);
-			OnControllerAnalog(FGamepadKeyNames::LeftAnalogY, Gamepad.leftStick.y, FMath::GetMappedRangeValueClamped(FVector2D(-127, 127), FVector2D(-1, 1), Gamepad.leftStick.y), ControllerState.LeftYAnalog, DS5W_LEFT_THUMB_DEADZONE);
-			OnControllerAnalog(FGamepadKeyNames::RightAnalogX, Gamepad.rightStick.x, FMath::GetMappedRangeValueClamped(FVector2D(-127, 127), FVector2D(-1, 1), Gamepad.rightStick.x), ControllerState.RightXAnalog, DS5W_RIGHT_THUMB_DEADZONE);
-			OnControllerAnalog(FGamepadKeyNames::RightAnalogY, Gamepad.rightStick.y, FMath::GetMappedRangeValueClamped(FVector2D(-127, 127), FVector2D(-1, 1), Gamepad.rightStick.y), ControllerState.RightYAnalog, DS5W_RIGHT_THUMB_DEADZONE);
+			// Sticks and triggers in one pass, the engine keeps axis values so only changes are sent.
+			// The deadzone maps small movements to exactly zero, a resting stick sends nothing
+			static const FName AnalogKeys[DS5W_NUM_ANALOG_AXES] =
+			{
+				FGamepadKeyNames::LeftAnalogX, FGamepadKeyNames::LeftAnalogY,
+				FGamepadKeyNames::RightAnalogX, FGamepadKeyNames::RightAnalogY,
+				FGamepadKeyNames::LeftTriggerAnalog, FGamepadKeyNames::RightTriggerAnalog,
+			};
 
-			ControllerState.LeftXAnalog = Gamepad.leftStick.x;
-			ControllerState.LeftYAnalog = Gamepad.leftStick.y;
-			ControllerState.RightXAnalog = Gamepad.rightStick.x;
-			ControllerState.RightYAnalog = Gamepad.rightStick.y;
-			
-			OnControllerAnalog(FGamepadKeyNames::LeftTriggerAnalog, Gamepad.leftTrigger, Gamepad.leftTrigger / 255.f, ControllerState.LeftTriggerAnalog, DS5W_TRIGGER_THRESHOLD);
-			OnControllerAnalog(FGamepadKeyNames::RightTriggerAnalog, Gamepad.rightTrigger, Gamepad.rightTrigger / 255.f, ControllerState.RightTriggerAnalog, DS5W_TRIGGER_THRESHOLD);
+			float AnalogValues[DS5W_NUM_ANALOG_AXES];
+			AnalogProcessor.Process(Gamepad, AnalogValues);
 
+			for (int32 Axis = 0; Axis < DS5W_NUM_ANALOG_AXES; ++Axis)
+			{
+				if (AnalogValues[Axis] != HotState.AnalogValues[Axis])
+				{
+					MessageHandler->OnControllerAnalog(AnalogKeys[Axis], ControllerState.ControllerId, AnalogValues[Axis]);
+					HotState.AnalogValues[Axis] = AnalogValues[Axis];
+				}
+			}
 
-			const double CurrentTime = FPlatformTime::Seconds();
 
-			ControllerState.DeltaTime = CurrentTime - ControllerState.LastMeasurementTime;
-			ControllerState.LastMeasurementTime = CurrentTime;
+			const double CurrentTime = GetTime();
 
-			if (ControllerState.CueMotionReset)
+			if (ControllerConfig.CueMotionReset)
 			{
-				ControllerState.CueMotionReset = false;
+				ControllerConfig.CueMotionReset = false;
 				MotionState.Reset();
 			}
 			if (MotionState.GetCalibrationMode() == GamepadMotionHelpers::CalibrationMode::Manual)
 			{
-				if (ControllerState.UseContinuousCalibration)
+				if (ControllerConfig.UseContinuousCalibration)
 				{
 					MotionState.StartContinuousCalibration();
 				}
@@ -376,80 +513,122 @@ void FDS5WInterface::SendControllerEvents()
 				}
 			}
 
-			ControllerState.Accelerometer = FVector(Gamepad.imuState.accelX, Gamepad.imuState.accelY, Gamepad.imuState.accelZ);
-			ControllerState.Gyroscope = FVector(Gamepad.imuState.gyroX, Gamepad.imuState.gyroY, Gamepad.imuState.gyroZ);
+			// Only fuse motion for reports we haven't seen yet and only if anything reads it
+			const bool bMotionConsumed = (InputDemand & DS5W_DECODE_MOTION) != 0;
+			if (bHasNewSample[ControllerIndex] && bMotionConsumed)
+			{
+				const uint64 FusionStartCycles = FPlatformTime::Cycles64();
+
+				ControllerState.Accelerometer = FVector(Gamepad.imuState.accelX, Gamepad.imuState.accelY, Gamepad.imuState.accelZ);
+				ControllerState.Gyroscope = FVector(Gamepad.imuState.gyroX, Gamepad.imuState.gyroY, Gamepad.imuState.gyroZ);
 
-			push_sensor_samples(MotionState, ControllerState);
-			get_calibrated_gyro(ControllerState, MotionState);
-			get_motion_state(ControllerState, MotionState);
+				push_sensor_samples(MotionState, MotionBatches[ControllerIndex]);
+				get_calibrated_gyro(ControllerState, MotionState);
+				get_motion_state(ControllerState, MotionState);
 
-			FRotator Orientation = ControllerState.Orientation.Rotator();
-			FVector ControllerOrientation(Orientation.Roll, Orientation.Pitch, Orientation.Yaw);
+				MotionLatches[ControllerIndex].SetBase(ControllerState.Orientation, ControllerState.GyroAccumulator, HotState.LastMeasurementTime);
 
-			/*UE_LOG(LogTemp, Warning, TEXT("[%d]: Orientation (%f;%f;%f), Acceleration (%f;%f;%f), Gravity (%f;%f;%f)"), ControllerState.ControllerId,
-				Orientation.Roll, Orientation.Pitch, Orientation.Yaw,
-				ControllerState.Acceleration.X, ControllerState.Acceleration.Y, ControllerState.Acceleration.Z,
-				ControllerState.Gravity.X, ControllerState.Gravity.Y, ControllerState.Gravity.Z);*/
+				const uint64 FusionEndCycles = FPlatformTime::Cycles64();
+				ControllerStats[ControllerIndex].Fusion.RecordCycles(FusionEndCycles - FusionStartCycles);
+				if (Trace.IsEnabled())
+				{
+					Trace.Record(EDS5WTraceStage::Fusion, ControllerIndex, FusionStartCycles, FusionEndCycles);
+				}
+			}
+
+			if (bMotionConsumed)
+			{
+				FRotator Orientation = ControllerState.Orientation.Rotator();
+				FVector ControllerOrientation(Orientation.Roll, Orientation.Pitch, Orientation.Yaw);
+
+				/*UE_LOG(LogTemp, Warning, TEXT("[%d]: Orientation (%f;%f;%f), Acceleration (%f;%f;%f), Gravity (%f;%f;%f)"), ControllerState.ControllerId,
+					Orientation.Roll, Orientation.Pitch, Orientation.Yaw,
+					ControllerState.Acceleration.X, ControllerState.Acceleration.Y, ControllerState.Acceleration.Z,
+					ControllerState.Gravity.X, ControllerState.Gravity.Y, ControllerState.Gravity.Z);*/
 			
-			ControllerState.GyroscopeAxises.Update(ControllerOrientation);
+				ControllerState.GyroscopeAxises.Update(ControllerOrientation);
+
+				//if (ControllerIndex == 0) {
+					FVector2D GyroAxisLastDelta = ControllerState.GyroscopeAxises.GetLastDelta();
+					OnControllerAnalog(FDS5WKeyNames::DS5W_GyroAxis_X, GyroAxisLastDelta.X, GyroAxisLastDelta.X, ControllerState.GyroAxisLastDelta.X, DS5W_GYROSCOPE_THRESHOLD);
+					OnControllerAnalog(FDS5WKeyNames::DS5W_GyroAxis_Y, GyroAxisLastDelta.Y, GyroAxisLastDelta.Y, ControllerState.GyroAxisLastDelta.Y, DS5W_GYROSCOPE_THRESHOLD);
+					ControllerState.GyroAxisLastDelta = GyroAxisLastDelta;
+				//}
+			}
 
-			//if (ControllerIndex == 0) {
-				FVector2D GyroAxisLastDelta = ControllerState.GyroscopeAxises.GetLastDelta();
-				OnControllerAnalog(FDS5WKeyNames::DS5W_GyroAxis_X, GyroAxisLastDelta.X, GyroAxisLastDelta.X, ControllerState.GyroAxisLastDelta.X, DS5W_GYROSCOPE_THRESHOLD);
-				OnControllerAnalog(FDS5WKeyNames::DS5W_GyroAxis_Y, GyroAxisLastDelta.Y, GyroAxisLastDelta.Y, ControllerState.GyroAxisLastDelta.Y, DS5W_GYROSCOPE_THRESHOLD);
-				ControllerState.GyroAxisLastDelta = GyroAxisLastDelta;
-			//}
+			// Move held buttons over to a new profile
+			if (HotState.bButtonProfileChanged)
+			{
+				HotState.bButtonProfileChanged = false;
+				SendButtonChanges(ControllerIndex, ButtonProfiles[HotState.ButtonProfileIndex].Apply(HotState.RawButtonStates), CurrentTime);
+			}
 
-			// For each button check against the previous state and send the correct message if any
-			for (int32 ButtonIndex = 0; ButtonIndex < MAX_NUM_CONTROLLER_BUTTONS; ++ButtonIndex)
+			// The readers release everything on disconnect, this only catches edges lost to a full queue
+			if (!HotState.bIsConnected)
 			{
-				if (CurrentStates[ButtonIndex] != ControllerState.ButtonStates[ButtonIndex])
-				{
-					if (CurrentStates[ButtonIndex])
-					{
-						MessageHandler->OnControllerButtonPressed(Buttons[ButtonIndex], ControllerState.ControllerId, false);
-					}
-					else
-					{
-						MessageHandler->OnControllerButtonReleased(Buttons[ButtonIndex], ControllerState.ControllerId, false);
-					}
-
-					if (CurrentStates[ButtonIndex] != 0)
-					{
-						// this button was pressed - set the button's NextRepeatTime to the InitialButtonRepeatDelay
-						ControllerState.NextRepeatTime[ButtonIndex] = CurrentTime + InitialButtonRepeatDelay;
-					}
-				}
-				else if (CurrentStates[ButtonIndex] != 0 && ControllerState.NextRepeatTime[ButtonIndex] <= CurrentTime)
+				HotState.RawButtonStates = 0;
+				SendButtonChanges(ControllerIndex, 0, CurrentTime);
+			}
+
+			// Presses and releases went out with DispatchButtonEvents, only repeat the buttons still held
+			for (uint32 HeldButtons = HotState.ButtonStates; HeldButtons; HeldButtons &= HeldButtons - 1)
+			{
+				const int32 ButtonIndex = FMath::CountTrailingZeros(HeldButtons);
+				if (ControllerState.NextRepeatTime[ButtonIndex] <= CurrentTime)
 				{
 					MessageHandler->OnControllerButtonPressed(Buttons[ButtonIndex], ControllerState.ControllerId, true);
 
 					// set the button's NextRepeatTime to the ButtonRepeatDelay
 					ControllerState.NextRepeatTime[ButtonIndex] = CurrentTime + ButtonRepeatDelay;
 				}
+			}
 
-				// Update the state for next time
-				ControllerState.ButtonStates[ButtonIndex] = CurrentStates[ButtonIndex];
+			if (Reader)
+			{
+				SendTouchEvents(ControllerState, Reader->GetTouch());
 			}
 
 			// apply force feedback
 
-			const float LargeValue = (ControllerState.ForceFeedback.LeftLarge > ControllerState.ForceFeedback.RightLarge ? ControllerState.ForceFeedback.LeftLarge : ControllerState.ForceFeedback.RightLarge);
-			const float SmallValue = (ControllerState.ForceFeedback.LeftSmall > ControllerState.ForceFeedback.RightSmall ? ControllerState.ForceFeedback.LeftSmall : ControllerState.ForceFeedback.RightSmall);
+			const float LargeValue = (ControllerConfig.ForceFeedback.LeftLarge > ControllerConfig.ForceFeedback.RightLarge ? ControllerConfig.ForceFeedback.LeftLarge : ControllerConfig.ForceFeedback.RightLarge);
+			const float SmallValue = (ControllerConfig.ForceFeedback.LeftSmall > ControllerConfig.ForceFeedback.RightSmall ? ControllerConfig.ForceFeedback.LeftSmall : ControllerConfig.ForceFeedback.RightSmall);
 
 			// Player led
-			DS5WOutputState.playerLeds.playerLedFade = ControllerState.LEDState.Fade;
-			DS5WOutputState.playerLeds.bitmask = LEDIntToBitMask(ControllerState.LEDState);
-			DS5WOutputState.playerLeds.brightness = LEDBrightnessToEnum(ControllerState.LEDState);
+			DS5WOutputState.playerLeds.playerLedFade = ControllerConfig.LEDState.Fade;
+			DS5WOutputState.playerLeds.bitmask = LEDIntToBitMask(ControllerConfig.LEDState);
+			DS5WOutputState.playerLeds.brightness = LEDBrightnessToEnum(ControllerConfig.LEDState);
 
 			// Lightbar
-			DS5WOutputState.lightbar = DS5W::color_R8G8B8_UCHAR_A32_FLOAT((int)ControllerState.LightBarState.X, (int)ControllerState.LightBarState.Y, (int)ControllerState.LightBarState.Z, (int)ControllerState.LightBarState.W);
+			DS5WOutputState.lightbar = DS5W::color_R8G8B8_UCHAR_A32_FLOAT((int)ControllerConfig.LightBarState.X, (int)ControllerConfig.LightBarState.Y, (int)ControllerConfig.LightBarState.Z, (int)ControllerConfig.LightBarState.W);
 
 			DS5WOutputState.leftRumble = 0;
 			DS5WOutputState.rightRumble = 0;
 
-			DS5W::setDeviceOutputState(&con, &DS5WOutputState);
+			// A streaming client overrides what it sent commands for
+			RemoteOutputs[ControllerIndex].Apply(DS5WOutputState, Now);
+
+			// The reader writes it between two reads, only hand over changes
+			FDS5WControllerStats& Stats = ControllerStats[ControllerIndex];
+			if (Reader && HotState.bIsConnected)
+			{
+				if (FMemory::Memcmp(&DS5WOutputState, &ControllerState.LastOutputState, sizeof(DS5W::DS5OutputState)) != 0)
+				{
+					Reader->SetOutputState(DS5WOutputState);
+					ControllerState.LastOutputState = DS5WOutputState;
+					FDS5WControllerStats::Increment(Stats.NumOutputsPosted);
+				}
+				else
+				{
+					FDS5WControllerStats::Increment(Stats.NumOutputsSkipped);
+				}
+			}
 
+			const uint64 DispatchEndCycles = FPlatformTime::Cycles64();
+			Stats.Dispatch.RecordCycles(DispatchEndCycles - DispatchStartCycles);
+			if (Trace.IsEnabled())
+			{
+				Trace.Record(EDS5WTraceStage::Dispatch, ControllerIndex, DispatchStartCycles, DispatchEndCycles);
+			}
 		}
 	}
 
@@ -457,35 +636,562 @@ void FDS5WInterface::SendControllerEvents()
 
 }
 
+void FDS5WInterface::DispatchButtonEvents()
+{
+	// Each reader queues in capture order, merge the controllers by capture time
+	FDS5WButtonEvent Events[DS5W_BUTTON_EVENT_QUEUE_SIZE];
+	int32 NumEvents = 0;
+
+	while (NumEvents < DS5W_BUTTON_EVENT_QUEUE_SIZE && ButtonEvents.Dequeue(Events[NumEvents]))
+	{
+		const FDS5WButtonEvent Event = Events[NumEvents];
+		int32 Index = NumEvents++;
+		for (; Index > 0 && Events[Index - 1].CaptureTime > Event.CaptureTime; --Index)
+		{
+			Events[Index] = Events[Index - 1];
+		}
+		Events[Index] = Event;
+	}
+
+	for (int32 Index = 0; Index < NumEvents; ++Index)
+	{
+		const FDS5WButtonEvent& Event = Events[Index];
+		FControllerHotState& HotState = HotStates[Event.ControllerId];
+
+		const uint32 ButtonMask = 1u << Event.ButtonIndex;
+		if (((HotState.RawButtonStates & ButtonMask) != 0) == Event.bPressed)
+		{
+			continue;
+		}
+
+		FInputDeviceScope InputScope(this, DS5WInterfaceName, Event.ControllerId);
+		CurrentInputEventTime = Event.CaptureTime;
+
+		HotState.RawButtonStates ^= ButtonMask;
+		SendButtonChanges(Event.ControllerId, ButtonProfiles[HotState.ButtonProfileIndex].Apply(HotState.RawButtonStates), Event.CaptureTime);
+	}
+}
+
+void FDS5WInterface::SendButtonChanges(int32 ControllerIndex, uint32 NewButtonStates, double Time)
+{
+	FControllerHotState& HotState = HotStates[ControllerIndex];
+	FControllerState& ControllerState = ControllerStates[ControllerIndex];
+
+	for (uint32 ChangedButtons = NewButtonStates ^ HotState.ButtonStates; ChangedButtons; ChangedButtons &= ChangedButtons - 1)
+	{
+		const int32 ButtonIndex = FMath::CountTrailingZeros(ChangedButtons);
+		if (NewButtonStates & (1u << ButtonIndex))
+		{
+			MessageHandler->OnControllerButtonPressed(Buttons[ButtonIndex], ControllerState.ControllerId, false);
+
+			// this button was pressed - set the button's NextRepeatTime to the InitialButtonRepeatDelay
+			ControllerState.NextRepeatTime[ButtonIndex] = Time + InitialButtonRepeatDelay;
+		}
+		else
+		{
+			MessageHandler->OnControllerButtonReleased(Buttons[ButtonIndex], ControllerState.ControllerId, false);
+		}
+	}
+
+	HotState.ButtonStates = NewButtonStates;
+}
+
+void FDS5WInterface::LoadButtonProfiles()
+{
+	ButtonProfiles.Reset();
+	ButtonProfiles.AddDefaulted_GetRef().Compile(TEXT("Default"), DS5WToXboxControllerMapping);
+
+	TArray<FString> ProfileNames;
+	GConfig->GetArray(DS5W_BUTTON_PROFILES_CONFIG_SECTION, TEXT("Profiles"), ProfileNames, GInputIni);
+	for (const FString& ProfileName : ProfileNames)
+	{
+		FDS5WButtonProfile Profile;
+		if (Profile.LoadConfig(*ProfileName, DS5WToXboxControllerMapping))
+		{
+			ButtonProfiles.Add(Profile);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FDS5WInterface::LoadButtonProfiles: No section for button profile %s."), *ProfileName);
+		}
+	}
+
+	for (int32 ControllerIndex = 0; ControllerIndex < MAX_NUM_DS5W_CONTROLLERS; ++ControllerIndex)
+	{
+		FString ProfileName;
+		if (GConfig->GetString(DS5W_BUTTON_PROFILES_CONFIG_SECTION, *FString::Printf(TEXT("Player%d"), ControllerIndex), ProfileName, GInputIni))
+		{
+			SetButtonProfile(ControllerIndex, *ProfileName);
+		}
+	}
+}
+
+bool FDS5WInterface::SetButtonProfile(int32 ControllerId, FName ProfileName)
+{
+	if (ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS)
+	{
+		return false;
+	}
+
+	const int32 ProfileIndex = ButtonProfiles.IndexOfByPredicate([ProfileName](const FDS5WButtonProfile& Profile) { return Profile.GetName() == ProfileName; });
+	if (ProfileIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	FControllerHotState& HotState = HotStates[ControllerId];
+	if (HotState.ButtonProfileIndex != ProfileIndex)
+	{
+		HotState.ButtonProfileIndex = ProfileIndex;
+		HotState.bButtonProfileChanged = true;
+	}
+
+	return true;
+}
+
+FName FDS5WInterface::GetButtonProfile(int32 ControllerId) const
+{
+	if (ControllerId >= 0 && ControllerId < MAX_NUM_DS5W_CONTROLLERS)
+	{
+		return ButtonProfiles[HotStates[ControllerId].ButtonProfileIndex].GetName();
+	}
+
+	return NAME_None;
+}
+
+void FDS5WInterface::SendTouchEvents(FControllerState& ControllerState, FDS5WTouchTracker& Touch)
+{
+	float PinchValue = 0.f;
+	FVector2D ScrollValue = FVector2D::ZeroVector;
+
+	FDS5WTouchGestureEvent Gesture;
+	while (Touch.DequeueGesture(Gesture))
+	{
+		FName GestureKey = NAME_None;
+		switch (Gesture.Type)
+		{
+		case EDS5WTouchGesture::Tap:
+			GestureKey = FDS5WKeyNames::DS5W_Touch_Tap;
+			break;
+		case EDS5WTouchGesture::SwipeLeft:
+			GestureKey = FDS5WKeyNames::DS5W_Touch_SwipeLeft;
+			break;
+		case EDS5WTouchGesture::SwipeRight:
+			GestureKey = FDS5WKeyNames::DS5W_Touch_SwipeRight;
+			break;
+		case EDS5WTouchGesture::SwipeUp:
+			GestureKey = FDS5WKeyNames::DS5W_Touch_SwipeUp;
+			break;
+		case EDS5WTouchGesture::SwipeDown:
+			GestureKey = FDS5WKeyNames::DS5W_Touch_SwipeDown;
+			break;
+		case EDS5WTouchGesture::Pinch:
+			PinchValue += Gesture.Value.X;
+			break;
+		case EDS5WTouchGesture::Scroll:
+			ScrollValue += Gesture.Value;
+			break;
+		}
+
+		// Discrete gestures are a press immediately followed by a release
+		if (!GestureKey.IsNone())
+		{
+			MessageHandler->OnControllerButtonPressed(GestureKey, ControllerState.ControllerId, false);
+			MessageHandler->OnControllerButtonReleased(GestureKey, ControllerState.ControllerId, false);
+		}
+	}
+
+	// Continuous gestures are the movement since the last frame, send a final zero when they stop
+	if (PinchValue != 0.f || ControllerState.TouchPinchValue != 0.f)
+	{
+		MessageHandler->OnControllerAnalog(FDS5WKeyNames::DS5W_Touch_Pinch, ControllerState.ControllerId, PinchValue);
+	}
+	if (ScrollValue.X != 0.f || ControllerState.TouchScrollValue.X != 0.f)
+	{
+		MessageHandler->OnControllerAnalog(FDS5WKeyNames::DS5W_Touch_ScrollX, ControllerState.ControllerId, ScrollValue.X);
+	}
+	if (ScrollValue.Y != 0.f || ControllerState.TouchScrollValue.Y != 0.f)
+	{
+		MessageHandler->OnControllerAnalog(FDS5WKeyNames::DS5W_Touch_ScrollY, ControllerState.ControllerId, ScrollValue.Y);
+	}
+
+	ControllerState.TouchPinchValue = PinchValue;
+	ControllerState.TouchScrollValue = ScrollValue;
+}
+
+bool FDS5WInterface::AddSimulatedController(int32 ControllerId)
+{
+	if (ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS || Readers[ControllerId])
+	{
+		return false;
+	}
+
+	Readers[ControllerId] = MakeUnique<FDS5WDeviceReader>(ControllerId, ButtonMap, ButtonEvents, InputHistories[ControllerId], MotionLatches[ControllerId], ControllerStats[ControllerId], Trace, SharedState, ReportSubscribers);
+	return Readers[ControllerId]->StartSimulated();
+}
+
+bool FDS5WInterface::SubmitSimulatedReport(int32 ControllerId, const DS5W::DS5InputState& State, double CaptureTime)
+{
+	if (ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS || !Readers[ControllerId])
+	{
+		return false;
+	}
+
+	Readers[ControllerId]->SubmitSimulatedReport(State, CaptureTime);
+	return true;
+}
+
+bool FDS5WInterface::DisconnectSimulatedController(int32 ControllerId, double Time)
+{
+	if (ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS || !Readers[ControllerId])
+	{
+		return false;
+	}
+
+	Readers[ControllerId]->DisconnectSimulated(Time);
+	return true;
+}
+
+bool FDS5WInterface::SubmitSimulatedArrival(int32 ControllerId, const DS5W::DS5InputState& State, double ArrivalTime)
+{
+	if (ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS || !Readers[ControllerId])
+	{
+		return false;
+	}
+
+	Readers[ControllerId]->SubmitSimulatedArrival(State, ArrivalTime);
+	return true;
+}
+
+bool FDS5WInterface::SetSimulatedConnection(int32 ControllerId, bool bBluetooth)
+{
+	if (ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS || !Readers[ControllerId])
+	{
+		return false;
+	}
+
+	Readers[ControllerId]->SetSimulatedBluetooth(bBluetooth);
+	return true;
+}
+
+bool FDS5WInterface::GetInputAge(int32 ControllerId, double& OutAge) const
+{
+	if (ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS || !HotStates[ControllerId].bIsConnected)
+	{
+		return false;
+	}
+
+	OutAge = FMath::Max(GetTime() - HotStates[ControllerId].LastMeasurementTime, 0.0);
+	return true;
+}
+
+const FDS5WControllerStats* FDS5WInterface::GetControllerStats(int32 ControllerId) const
+{
+	return ControllerId >= 0 && ControllerId < MAX_NUM_DS5W_CONTROLLERS ? &ControllerStats[ControllerId] : nullptr;
+}
+
+int32 FDS5WInterface::GetTouchTrajectory(int32 ControllerId, FDS5WTouchSample* OutSamples, int32 MaxSamples) const
+{
+	if (ControllerId >= 0 && ControllerId < MAX_NUM_DS5W_CONTROLLERS && Readers[ControllerId])
+	{
+		AddQueryDemand(DS5W_DECODE_TOUCH);
+		return Readers[ControllerId]->GetTouch().GetTrajectory(OutSamples, MaxSamples);
+	}
+
+	return 0;
+}
+
+const FDS5WInputHistory* FDS5WInterface::GetInputHistory(int32 ControllerId) const
+{
+	return ControllerId >= 0 && ControllerId < MAX_NUM_DS5W_CONTROLLERS ? &InputHistories[ControllerId] : nullptr;
+}
+
+bool FDS5WInterface::GetInputStateAtTime(int32 ControllerId, double Time, DS5W::DS5InputState& OutState) const
+{
+	FDS5WInputHistoryEntry Entry;
+	if (ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS || !InputHistories[ControllerId].GetEntryAtTime(Time, Entry))
+	{
+		return false;
+	}
+
+	// A disconnected controller reads as neutral
+	Entry.Snapshot.ToInputState(OutState);
+	return true;
+}
+
+bool FDS5WInterface::GetTickInput(int32 ControllerId, double TickStart, double TickEnd, FDS5WTickInput& OutInput) const
+{
+	if (ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS)
+	{
+		return false;
+	}
+
+	// The gyro of the tick comes from the reports, which only carry it while motion is decoded
+	AddQueryDemand(DS5W_DECODE_MOTION);
+	return FDS5WInputResampler::Resample(InputHistories[ControllerId], TickStart, TickEnd, OutInput);
+}
+
+bool FDS5WInterface::GetSnapshot(int32 ControllerId, FDS5WSnapshot& OutSnapshot) const
+{
+	if (ControllerId >= 0 && ControllerId < MAX_NUM_DS5W_CONTROLLERS && HotStates[ControllerId].bIsConnected)
+	{
+		OutSnapshot.FromInputState(ControllerStates[ControllerId].LastInputState);
+		return true;
+	}
+
+	return false;
+}
+
+bool FDS5WInterface::GetOrientation(int32 ControllerId, FQuat& OutOrientation) const
+{
+	AddQueryDemand(DS5W_DECODE_MOTION);
+	if (ControllerId >= 0 && ControllerId < MAX_NUM_DS5W_CONTROLLERS && HotStates[ControllerId].bIsConnected)
+	{
+		OutOrientation = ControllerStates[ControllerId].Orientation;
+		return true;
+	}
+
+	return false;
+}
+
+bool FDS5WInterface::GetLatestOrientation(int32 ControllerId, FQuat& OutOrientation, double& OutTime) const
+{
+	if (ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS)
+	{
+		return false;
+	}
+
+	AddQueryDemand(DS5W_DECODE_MOTION);
+	return MotionLatches[ControllerId].GetLatestOrientation(OutOrientation, OutTime);
+}
+
+bool FDS5WInterface::GetGyroDeltaSince(int32 ControllerId, double Time, FQuat& OutDelta, double& OutTime) const
+{
+	if (ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS)
+	{
+		return false;
+	}
+
+	AddQueryDemand(DS5W_DECODE_MOTION);
+	return MotionLatches[ControllerId].GetGyroDeltaSince(Time, OutDelta, OutTime);
+}
+
+bool FDS5WInterface::GetPredictedInput(int32 ControllerId, FDS5WPrediction& OutPrediction, float Horizon) const
+{
+	if (PredictionSettings.bEnabled)
+	{
+		AddQueryDemand(DS5W_DECODE_MOTION);
+	}
+
+	if (!PredictionSettings.bEnabled || ControllerId < 0 || ControllerId >= MAX_NUM_DS5W_CONTROLLERS || !HotStates[ControllerId].bIsConnected)
+	{
+		return false;
+	}
+
+	return Predictors[ControllerId].Predict(Horizon < 0.f ? PredictionSettings.Horizon : Horizon, ControllerStates[ControllerId].Orientation, OutPrediction);
+}
+
+void FDS5WInterface::AddInputConsumer(uint32 DecodeFlags)
+{
+	for (int32 Bit = 0; Bit < UE_ARRAY_COUNT(InputConsumerCounts); ++Bit)
+	{
+		if (DecodeFlags & (1u << Bit))
+		{
+			++InputConsumerCounts[Bit];
+		}
+	}
+}
+
+void FDS5WInterface::RemoveInputConsumer(uint32 DecodeFlags)
+{
+	for (int32 Bit = 0; Bit < UE_ARRAY_COUNT(InputConsumerCounts); ++Bit)
+	{
+		if (DecodeFlags & (1u << Bit))
+		{
+			ensure(InputConsumerCounts[Bit] > 0);
+			InputConsumerCounts[Bit] = FMath::Max(InputConsumerCounts[Bit] - 1, 0);
+		}
+	}
+}
+
+uint32 FDS5WInterface::GetInputDemand(double CurrentTime)
+{
+	if (CurrentTime >= NextBindingRefreshTime)
+	{
+		RefreshBoundInputDemand();
+		NextBindingRefreshTime = CurrentTime + DS5W_BINDING_REFRESH_INTERVAL;
+	}
+
+	uint32 Demand = BoundInputDemand;
+	for (int32 Bit = 0; Bit < UE_ARRAY_COUNT(InputConsumerCounts); ++Bit)
+	{
+		if (InputConsumerCounts[Bit] > 0)
+		{
+			Demand |= 1u << Bit;
+		}
+	}
+
+	for (int32 Bit = 0; Bit < UE_ARRAY_COUNT(LastQueryTimes); ++Bit)
+	{
+		if (CurrentTime - LastQueryTimes[Bit].load(std::memory_order_relaxed) < DS5W_QUERY_DEMAND_TIMEOUT)
+		{
+			Demand |= 1u << Bit;
+		}
+	}
+
+	return Demand;
+}
+
+void FDS5WInterface::AddQueryDemand(uint32 DecodeFlag) const
+{
+	LastQueryTimes[FMath::CountTrailingZeros(DecodeFlag)].store(GetTime(), std::memory_order_relaxed);
+}
+
+void FDS5WInterface::RefreshBoundInputDemand()
+{
+	static const FKey* const TouchKeys[] =
+	{
+		&FDS5WKey::DS5W_Touch_Tap,
+		&FDS5WKey::DS5W_Touch_SwipeLeft,
+		&FDS5WKey::DS5W_Touch_SwipeRight,
+		&FDS5WKey::DS5W_Touch_SwipeUp,
+		&FDS5WKey::DS5W_Touch_SwipeDown,
+		&FDS5WKey::DS5W_Touch_Pinch,
+		&FDS5WKey::DS5W_Touch_ScrollX,
+		&FDS5WKey::DS5W_Touch_ScrollY,
+	};
+
+	BoundInputDemand = 0;
+
+	auto AddKeyDemand = [this](const FKey& Key)
+	{
+		if (Key == FDS5WKey::DS5W_GyroAxis_X || Key == FDS5WKey::DS5W_GyroAxis_Y)
+		{
+			BoundInputDemand |= DS5W_DECODE_MOTION;
+			return;
+		}
+
+		for (const FKey* TouchKey : TouchKeys)
+		{
+			if (Key == *TouchKey)
+			{
+				BoundInputDemand |= DS5W_DECODE_TOUCH;
+				return;
+			}
+		}
+	};
+
+	const UInputSettings* InputSettings = GetDefault<UInputSettings>();
+	for (const FInputAxisKeyMapping& Mapping : InputSettings->GetAxisMappings())
+	{
+		AddKeyDemand(Mapping.Key);
+	}
+	for (const FInputActionKeyMapping& Mapping : InputSettings->GetActionMappings())
+	{
+		AddKeyDemand(Mapping.Key);
+	}
+}
+
 void FDS5WInterface::SetMessageHandler(const TSharedRef< FGenericApplicationMessageHandler >& InMessageHandler)
 {
     MessageHandler = InMessageHandler;
 }
 
+bool FDS5WInterface::Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	if (!FParse::Command(&Cmd, TEXT("DS5W")))
+	{
+		return false;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("STATS")))
+	{
+		const double Now = GetTime();
+		if (FParse::Command(&Cmd, TEXT("RESET")))
+		{
+			for (FDS5WControllerStats& Stats : ControllerStats)
+			{
+				Stats.Reset();
+			}
+			StatsResetTime = Now;
+			return true;
+		}
+
+		for (int32 ControllerIndex = 0; ControllerIndex < MAX_NUM_DS5W_CONTROLLERS; ++ControllerIndex)
+		{
+			if (Readers[ControllerIndex])
+			{
+				ControllerStats[ControllerIndex].Dump(Ar, ControllerIndex, Now - StatsResetTime);
+			}
+		}
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("TRACE")))
+	{
+		if (FParse::Command(&Cmd, TEXT("START")))
+		{
+			if (!Trace.Start())
+			{
+				Ar.Log(TEXT("DS5W tracing is turned off, set a Capacity in the DS5WTrace section of the input ini"));
+			}
+			return true;
+		}
+
+		if (FParse::Command(&Cmd, TEXT("STOP")))
+		{
+			Trace.Stop();
+			return true;
+		}
+
+		if (FParse::Command(&Cmd, TEXT("FLUSH")))
+		{
+			FString Filename;
+			if (!FParse::Token(Cmd, Filename, false))
+			{
+				Filename = FPaths::ProfilingDir() / FString::Printf(TEXT("DS5WTrace-%s.json"), *FDateTime::Now().ToString());
+			}
+
+			if (Trace.Flush(*Filename))
+			{
+				Ar.Logf(TEXT("DS5W trace written to %s"), *Filename);
+			}
+			else
+			{
+				Ar.Logf(TEXT("Failed to write DS5W trace to %s"), *Filename);
+			}
+			return true;
+		}
+	}
+
+	Ar.Log(TEXT("Usage: DS5W STATS [RESET] | DS5W TRACE START|STOP|FLUSH [File]"));
+	return true;
+}
+
 void FDS5WInterface::SetChannelValue(int32 ControllerId, const FForceFeedbackChannelType ChannelType, const float Value)
 {
 	if (ControllerId >= 0 && ControllerId < MAX_NUM_DS5W_CONTROLLERS)
 	{
-		FControllerState& ControllerState = ControllerStates[ControllerId];
+		FControllerConfig& ControllerConfig = ControllerConfigs[ControllerId];
 
-		if (ControllerState.bIsConnected)
+		if (HotStates[ControllerId].bIsConnected)
 		{
 			switch (ChannelType)
 			{
 			case FForceFeedbackChannelType::LEFT_LARGE:
-				ControllerState.ForceFeedback.LeftLarge = Value;
+				ControllerConfig.ForceFeedback.LeftLarge = Value;
 				break;
 
 			case FForceFeedbackChannelType::LEFT_SMALL:
-				ControllerState.ForceFeedback.LeftSmall = Value;
+				ControllerConfig.ForceFeedback.LeftSmall = Value;
 				break;
 
 			case FForceFeedbackChannelType::RIGHT_LARGE:
-				ControllerState.ForceFeedback.RightLarge = Value;
+				ControllerConfig.ForceFeedback.RightLarge = Value;
 				break;
 
 			case FForceFeedbackChannelType::RIGHT_SMALL:
-				ControllerState.ForceFeedback.RightSmall = Value;
+				ControllerConfig.ForceFeedback.RightSmall = Value;
 				break;
 			}
 		}
@@ -496,11 +1202,11 @@ void FDS5WInterface::SetChannelValues(int32 ControllerId, const FForceFeedbackVa
 {
 	if (ControllerId >= 0 && ControllerId < MAX_NUM_DS5W_CONTROLLERS)
 	{
-		FControllerState& ControllerState = ControllerStates[ControllerId];
+		FControllerConfig& ControllerConfig = ControllerConfigs[ControllerId];
 
-		if (ControllerState.bIsConnected)
+		if (HotStates[ControllerId].bIsConnected)
 		{
-			ControllerState.ForceFeedback = Values;
+			ControllerConfig.ForceFeedback = Values;
 		}
 	}
 }
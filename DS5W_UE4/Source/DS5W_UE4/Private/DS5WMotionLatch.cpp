@@ -0,0 +1,113 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WMotionLatch.h"
+#include "Math/UnrealMathUtility.h"
+
+FDS5WMotionLatch::FDS5WMotionLatch()
+	: Accumulator(FQuat::Identity)
+	, LastDeviceTime(0.0)
+	, bHasDeviceTime(false)
+	, NumMarks(0)
+{
+}
+
+FQuat FDS5WMotionLatch::AddReport(const FVector& Gyro, double DeviceTime, double CaptureTime)
+{
+	// Same rule as the game thread's fusion, a jump backwards or a long gap integrates nothing
+	const double DeltaTime = DeviceTime - LastDeviceTime;
+	if (bHasDeviceTime && DeltaTime > 0.0 && DeltaTime < 1.0)
+	{
+		// Local rotation, appended like GamepadMotion does
+		const float AngleSpeed = Gyro.Size();
+		if (AngleSpeed > SMALL_NUMBER)
+		{
+			Accumulator *= FQuat(Gyro / AngleSpeed, FMath::DegreesToRadians(AngleSpeed) * (float)DeltaTime);
+			Accumulator.Normalize();
+		}
+	}
+	LastDeviceTime = DeviceTime;
+	bHasDeviceTime = true;
+
+	FMark Mark;
+	Mark.Index = NumMarks.load(std::memory_order_relaxed);
+	Mark.Time = CaptureTime;
+	Mark.Accumulator = Accumulator;
+	Marks[Mark.Index % DS5W_MOTION_LATCH_SLOTS].Write(Mark);
+	NumMarks.store(Mark.Index + 1, std::memory_order_release);
+
+	return Accumulator;
+}
+
+void FDS5WMotionLatch::SetBase(const FQuat& Orientation, const FQuat& InAccumulator, double Time)
+{
+	FBase NewBase;
+	NewBase.Time = Time;
+	NewBase.Orientation = Orientation;
+	NewBase.Accumulator = InAccumulator;
+	Base.Write(NewBase);
+}
+
+bool FDS5WMotionLatch::ReadMark(uint64 Index, FMark& OutMark) const
+{
+	Marks[Index % DS5W_MOTION_LATCH_SLOTS].Read(OutMark);
+	return OutMark.Index == Index;
+}
+
+bool FDS5WMotionLatch::ReadLatestMark(FMark& OutMark) const
+{
+	for (;;)
+	{
+		const uint64 Count = NumMarks.load(std::memory_order_acquire);
+		if (Count == 0)
+		{
+			return false;
+		}
+
+		if (ReadMark(Count - 1, OutMark))
+		{
+			return true;
+		}
+	}
+}
+
+bool FDS5WMotionLatch::GetLatestOrientation(FQuat& OutOrientation, double& OutTime) const
+{
+	FBase CurrentBase;
+	FMark Latest;
+	if (Base.GetNumWrites() == 0 || !ReadLatestMark(Latest))
+	{
+		return false;
+	}
+	Base.Read(CurrentBase);
+
+	// Turn the fused orientation by what the gyro measured since its report
+	OutOrientation = CurrentBase.Orientation * (CurrentBase.Accumulator.Inverse() * Latest.Accumulator);
+	OutOrientation.Normalize();
+	OutTime = Latest.Time;
+	return true;
+}
+
+bool FDS5WMotionLatch::GetGyroDeltaSince(double Time, FQuat& OutDelta, double& OutTime) const
+{
+	FMark Latest;
+	if (!ReadLatestMark(Latest))
+	{
+		return false;
+	}
+
+	OutTime = Latest.Time;
+
+	const uint64 Oldest = Latest.Index >= DS5W_MOTION_LATCH_SLOTS ? Latest.Index - DS5W_MOTION_LATCH_SLOTS + 1 : 0;
+	FMark Mark = Latest;
+	for (uint64 Index = Latest.Index; Mark.Time > Time; --Index)
+	{
+		if (Index == Oldest || !ReadMark(Index - 1, Mark))
+		{
+			return false;
+		}
+	}
+
+	OutDelta = Mark.Accumulator.Inverse() * Latest.Accumulator;
+	OutDelta.Normalize();
+	return true;
+}
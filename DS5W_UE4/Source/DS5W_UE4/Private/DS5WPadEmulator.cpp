@@ -0,0 +1,85 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WPadEmulator.h"
+#include "DS5WClockSync.h"
+#include "DS5WInterface.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/UnrealMathUtility.h"
+
+FDS5WPadEmulatorSettings::FDS5WPadEmulatorSettings()
+	: bBluetooth(false)
+	, ReportInterval(1.0 / 250.0)
+	, MinLatency(0.001)
+	, MaxJitter(0.001)
+	, ClockDrift(30.e-6)
+	, Seed(0)
+{
+}
+
+FDS5WPadEmulatorSettings FDS5WPadEmulatorSettings::Usb()
+{
+	return FDS5WPadEmulatorSettings();
+}
+
+FDS5WPadEmulatorSettings FDS5WPadEmulatorSettings::Bluetooth()
+{
+	// Same report rate, the radio adds latency and more jitter
+	FDS5WPadEmulatorSettings Settings;
+	Settings.bBluetooth = true;
+	Settings.MinLatency = 0.004;
+	Settings.MaxJitter = 0.006;
+	return Settings;
+}
+
+FDS5WPadEmulator::FDS5WPadEmulator(FDS5WInterface& InInterface, int32 InControllerId, const FDS5WPadEmulatorSettings& InSettings, double InStartTime)
+	: Interface(InInterface)
+	, ControllerId(InControllerId)
+	, Settings(InSettings)
+	, Random(InSettings.Seed)
+	, StartTime(InStartTime)
+	, NumReports(0)
+	, LastCaptureTime(InStartTime)
+{
+	FMemory::Memzero(State);
+
+	Settings.ReportInterval = FMath::Max(Settings.ReportInterval, 1.e-4);
+	Settings.MinLatency = FMath::Max(Settings.MinLatency, 0.0);
+	Settings.MaxJitter = FMath::Max(Settings.MaxJitter, 0.0);
+
+	// The device clock starts anywhere, so the 32 bit counter wraps at different points
+	TimestampBase = (uint32)Random.RandHelper(MAX_int32);
+
+	Interface.SetSimulatedConnection(ControllerId, Settings.bBluetooth);
+	PendingArrivalTime = StartTime;
+	ScheduleReport();
+}
+
+int32 FDS5WPadEmulator::Advance(double HostTime)
+{
+	int32 NumDelivered = 0;
+	while (PendingArrivalTime <= HostTime)
+	{
+		DS5W::DS5InputState Report = State;
+		Report.sensorTimestamp = PendingTimestamp;
+		Interface.SubmitSimulatedArrival(ControllerId, Report, PendingArrivalTime);
+
+		LastCaptureTime = PendingCaptureTime;
+		++NumDelivered;
+		ScheduleReport();
+	}
+
+	return NumDelivered;
+}
+
+void FDS5WPadEmulator::ScheduleReport()
+{
+	const double DeviceTime = NumReports * Settings.ReportInterval;
+	++NumReports;
+
+	PendingCaptureTime = StartTime + DeviceTime / (1.0 + Settings.ClockDrift);
+	PendingTimestamp = TimestampBase + (uint32)(uint64)(DeviceTime * FDS5WClockSync::DeviceTicksPerSecond);
+
+	// HID delivers in order, a late report holds back the ones behind it
+	const double Latency = Settings.MinLatency + Random.FRand() * Settings.MaxJitter;
+	PendingArrivalTime = FMath::Max(PendingCaptureTime + Latency, PendingArrivalTime);
+}
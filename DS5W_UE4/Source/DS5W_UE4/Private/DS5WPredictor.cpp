@@ -0,0 +1,229 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WPredictor.h"
+#include "DS5WInputHistory.h"
+#include "Containers/Array.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/UnrealMathUtility.h"
+#include "Misc/ConfigCacheIni.h"
+
+namespace
+{
+	void GetLanes(const DS5W::DS5InputState& State, float* OutLanes)
+	{
+		OutLanes[0] = FMath::Max(State.leftStick.x / 127.f, -1.f);
+		OutLanes[1] = FMath::Max(State.leftStick.y / 127.f, -1.f);
+		OutLanes[2] = FMath::Max(State.rightStick.x / 127.f, -1.f);
+		OutLanes[3] = FMath::Max(State.rightStick.y / 127.f, -1.f);
+		OutLanes[4] = State.imuState.gyroX;
+		OutLanes[5] = State.imuState.gyroY;
+		OutLanes[6] = State.imuState.gyroZ;
+		OutLanes[7] = 0.f;
+	}
+}
+
+FDS5WPredictionSettings::FDS5WPredictionSettings()
+	: bEnabled(false)
+	, Horizon(0.012f)
+	, StickAlpha(0.5f)
+	, StickBeta(0.1f)
+	, GyroAlpha(0.6f)
+	, GyroBeta(0.15f)
+{
+}
+
+void FDS5WPredictionSettings::LoadConfig()
+{
+	GConfig->GetBool(DS5W_PREDICTION_CONFIG_SECTION, TEXT("bEnabled"), bEnabled, GInputIni);
+	GConfig->GetFloat(DS5W_PREDICTION_CONFIG_SECTION, TEXT("Horizon"), Horizon, GInputIni);
+	GConfig->GetFloat(DS5W_PREDICTION_CONFIG_SECTION, TEXT("StickAlpha"), StickAlpha, GInputIni);
+	GConfig->GetFloat(DS5W_PREDICTION_CONFIG_SECTION, TEXT("StickBeta"), StickBeta, GInputIni);
+	GConfig->GetFloat(DS5W_PREDICTION_CONFIG_SECTION, TEXT("GyroAlpha"), GyroAlpha, GInputIni);
+	GConfig->GetFloat(DS5W_PREDICTION_CONFIG_SECTION, TEXT("GyroBeta"), GyroBeta, GInputIni);
+
+	Horizon = FMath::Clamp(Horizon, 0.f, DS5W_PREDICTION_MAX_HORIZON);
+}
+
+FDS5WPredictor::FDS5WPredictor()
+{
+	Init(FDS5WPredictionSettings());
+}
+
+void FDS5WPredictor::Init(const FDS5WPredictionSettings& Settings)
+{
+	for (int32 Lane = 0; Lane < DS5W_PREDICTION_LANES; ++Lane)
+	{
+		const bool bStick = Lane < 4;
+		Alpha[Lane] = FMath::Clamp(bStick ? Settings.StickAlpha : Settings.GyroAlpha, 0.f, 1.f);
+		Beta[Lane] = FMath::Clamp(bStick ? Settings.StickBeta : Settings.GyroBeta, 0.f, 1.f);
+	}
+
+	Reset();
+}
+
+void FDS5WPredictor::Reset()
+{
+	FMemory::Memzero(Values, sizeof(Values));
+	FMemory::Memzero(Rates, sizeof(Rates));
+	LastTime = 0.0;
+	bHasSample = false;
+}
+
+void FDS5WPredictor::AddSample(const DS5W::DS5InputState& State, double Time)
+{
+	alignas(16) float Measured[DS5W_PREDICTION_LANES];
+	GetLanes(State, Measured);
+
+	const double DeltaTime = Time - LastTime;
+	LastTime = Time;
+
+	if (!bHasSample || DeltaTime <= 0.0 || DeltaTime > DS5W_PREDICTION_MAX_GAP)
+	{
+		FMemory::Memcpy(Values, Measured, sizeof(Values));
+		FMemory::Memzero(Rates, sizeof(Rates));
+		bHasSample = true;
+		return;
+	}
+
+	const float Step = (float)DeltaTime;
+	const float InvStep = 1.f / Step;
+	for (int32 Lane = 0; Lane < DS5W_PREDICTION_LANES; ++Lane)
+	{
+		const float Predicted = Values[Lane] + Rates[Lane] * Step;
+		const float Residual = Measured[Lane] - Predicted;
+		Values[Lane] = Predicted + Alpha[Lane] * Residual;
+		Rates[Lane] += Beta[Lane] * InvStep * Residual;
+	}
+}
+
+bool FDS5WPredictor::Predict(float Horizon, const FQuat& Orientation, FDS5WPrediction& OutPrediction) const
+{
+	if (!bHasSample)
+	{
+		return false;
+	}
+
+	Horizon = FMath::Clamp(Horizon, 0.f, DS5W_PREDICTION_MAX_HORIZON);
+	OutPrediction.Time = LastTime + Horizon;
+
+	for (int32 Axis = 0; Axis < 4; ++Axis)
+	{
+		OutPrediction.Sticks[Axis] = FMath::Clamp(Values[Axis] + Rates[Axis] * Horizon, -1.f, 1.f);
+	}
+
+	OutPrediction.Gyro = FVector(Values[4] + Rates[4] * Horizon, Values[5] + Rates[5] * Horizon, Values[6] + Rates[6] * Horizon);
+
+	// Turn by the mean angular velocity over the horizon, a local rotation like GamepadMotion's
+	const float HalfHorizon = 0.5f * Horizon;
+	const FVector MeanGyro(Values[4] + Rates[4] * HalfHorizon, Values[5] + Rates[5] * HalfHorizon, Values[6] + Rates[6] * HalfHorizon);
+	const float AngleSpeed = MeanGyro.Size();
+
+	OutPrediction.Orientation = Orientation;
+	if (AngleSpeed > SMALL_NUMBER)
+	{
+		OutPrediction.Orientation *= FQuat(MeanGyro / AngleSpeed, FMath::DegreesToRadians(AngleSpeed) * Horizon);
+		OutPrediction.Orientation.Normalize();
+	}
+
+	return true;
+}
+
+void FDS5WPredictor::MeasureError(const FDS5WPredictionSettings& Settings, const FDS5WInputHistoryEntry* Entries, int32 NumEntries,
+	const float* Horizons, int32 NumHorizons, FDS5WPredictionError* OutErrors)
+{
+	// Lanes of the whole trace, the actual values are interpolated from these
+	TArray<float> Lanes;
+	Lanes.SetNumUninitialized(NumEntries * DS5W_PREDICTION_LANES);
+	for (int32 Index = 0; Index < NumEntries; ++Index)
+	{
+		DS5W::DS5InputState State;
+		Entries[Index].Snapshot.ToInputState(State);
+		GetLanes(State, &Lanes[Index * DS5W_PREDICTION_LANES]);
+	}
+
+	TArray<int32> Cursors;
+	Cursors.SetNumZeroed(NumHorizons);
+
+	// Squared errors per horizon: stick, stick held, gyro, gyro held
+	TArray<double> Sums;
+	Sums.SetNumZeroed(NumHorizons * 4);
+
+	for (int32 HorizonIndex = 0; HorizonIndex < NumHorizons; ++HorizonIndex)
+	{
+		FDS5WPredictionError& Error = OutErrors[HorizonIndex];
+		FMemory::Memzero(Error);
+		Error.Horizon = FMath::Clamp(Horizons[HorizonIndex], 0.f, DS5W_PREDICTION_MAX_HORIZON);
+	}
+
+	FDS5WPredictor Predictor;
+	Predictor.Init(Settings);
+
+	for (int32 Index = 0; Index < NumEntries; ++Index)
+	{
+		const FDS5WInputHistoryEntry& Entry = Entries[Index];
+		if (!Entry.bConnected)
+		{
+			Predictor.Reset();
+			continue;
+		}
+
+		DS5W::DS5InputState State;
+		Entry.Snapshot.ToInputState(State);
+		Predictor.AddSample(State, Entry.CaptureTime);
+
+		const float* Current = &Lanes[Index * DS5W_PREDICTION_LANES];
+		for (int32 HorizonIndex = 0; HorizonIndex < NumHorizons; ++HorizonIndex)
+		{
+			FDS5WPredictionError& Error = OutErrors[HorizonIndex];
+			const double TargetTime = Entry.CaptureTime + Error.Horizon;
+
+			// Reports around the target time, both connected
+			int32& Cursor = Cursors[HorizonIndex];
+			Cursor = FMath::Max(Cursor, Index);
+			while (Cursor + 1 < NumEntries && Entries[Cursor + 1].CaptureTime <= TargetTime)
+			{
+				++Cursor;
+			}
+			if (Cursor + 1 >= NumEntries || !Entries[Cursor].bConnected || !Entries[Cursor + 1].bConnected)
+			{
+				continue;
+			}
+
+			const FDS5WInputHistoryEntry& Before = Entries[Cursor];
+			const FDS5WInputHistoryEntry& After = Entries[Cursor + 1];
+			const float Fraction = (float)((TargetTime - Before.CaptureTime) / FMath::Max(After.CaptureTime - Before.CaptureTime, (double)SMALL_NUMBER));
+			const float* ActualBefore = &Lanes[Cursor * DS5W_PREDICTION_LANES];
+			const float* ActualAfter = &Lanes[(Cursor + 1) * DS5W_PREDICTION_LANES];
+
+			FDS5WPrediction Prediction;
+			Predictor.Predict(Error.Horizon, FQuat::Identity, Prediction);
+			const float Predicted[7] = { Prediction.Sticks[0], Prediction.Sticks[1], Prediction.Sticks[2], Prediction.Sticks[3], Prediction.Gyro.X, Prediction.Gyro.Y, Prediction.Gyro.Z };
+
+			for (int32 Lane = 0; Lane < 7; ++Lane)
+			{
+				const float Actual = FMath::Lerp(ActualBefore[Lane], ActualAfter[Lane], Fraction);
+				const float PredictedError = FMath::Square(Predicted[Lane] - Actual);
+				const float HoldError = FMath::Square(Current[Lane] - Actual);
+
+				double* HorizonSums = &Sums[HorizonIndex * 4 + (Lane < 4 ? 0 : 2)];
+				HorizonSums[0] += PredictedError;
+				HorizonSums[1] += HoldError;
+			}
+
+			++Error.NumSamples;
+		}
+	}
+
+	for (int32 HorizonIndex = 0; HorizonIndex < NumHorizons; ++HorizonIndex)
+	{
+		FDS5WPredictionError& Error = OutErrors[HorizonIndex];
+		if (Error.NumSamples > 0)
+		{
+			const double* HorizonSums = &Sums[HorizonIndex * 4];
+			Error.StickError = (float)FMath::Sqrt(HorizonSums[0] / (4 * Error.NumSamples));
+			Error.StickHoldError = (float)FMath::Sqrt(HorizonSums[1] / (4 * Error.NumSamples));
+			Error.GyroError = (float)FMath::Sqrt(HorizonSums[2] / (3 * Error.NumSamples));
+			Error.GyroHoldError = (float)FMath::Sqrt(HorizonSums[3] / (3 * Error.NumSamples));
+		}
+	}
+}
@@ -0,0 +1,165 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WQuatCodec.h"
+#include "Math/UnrealMathUtility.h"
+#include "Serialization/Archive.h"
+
+// Range of the three stored components
+#define DS5W_QUAT_COMPONENT_RANGE 0.70710678f
+
+namespace
+{
+	uint32 QuantiseComponent(float Value, int32 BitsPerComponent)
+	{
+		const uint32 MaxValue = (1u << BitsPerComponent) - 1;
+		const float Normalised = (Value + DS5W_QUAT_COMPONENT_RANGE) / (2.f * DS5W_QUAT_COMPONENT_RANGE);
+		return (uint32)FMath::Clamp(FMath::RoundToInt(Normalised * MaxValue), 0, (int32)MaxValue);
+	}
+
+	float DequantiseComponent(uint32 Value, int32 BitsPerComponent)
+	{
+		const uint32 MaxValue = (1u << BitsPerComponent) - 1;
+		return (float)Value / MaxValue * (2.f * DS5W_QUAT_COMPONENT_RANGE) - DS5W_QUAT_COMPONENT_RANGE;
+	}
+}
+
+uint64 FDS5WQuatCodec::Encode(const FQuat& Orientation, int32 BitsPerComponent)
+{
+	BitsPerComponent = FMath::Clamp(BitsPerComponent, MinBitsPerComponent, MaxBitsPerComponent);
+
+	const FQuat Normalised = Orientation.GetNormalized();
+	float Components[4] = { Normalised.X, Normalised.Y, Normalised.Z, Normalised.W };
+
+	int32 LargestIndex = 0;
+	for (int32 Index = 1; Index < 4; ++Index)
+	{
+		if (FMath::Abs(Components[Index]) > FMath::Abs(Components[LargestIndex]))
+		{
+			LargestIndex = Index;
+		}
+	}
+
+	// q and -q are the same rotation, make the dropped component positive
+	const float Sign = Components[LargestIndex] < 0.f ? -1.f : 1.f;
+
+	uint64 Packed = (uint64)LargestIndex;
+	int32 Shift = 2;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		if (Index != LargestIndex)
+		{
+			Packed |= (uint64)QuantiseComponent(Components[Index] * Sign, BitsPerComponent) << Shift;
+			Shift += BitsPerComponent;
+		}
+	}
+
+	return Packed;
+}
+
+FQuat FDS5WQuatCodec::Decode(uint64 Packed, int32 BitsPerComponent)
+{
+	BitsPerComponent = FMath::Clamp(BitsPerComponent, MinBitsPerComponent, MaxBitsPerComponent);
+
+	const int32 LargestIndex = (int32)(Packed & 0x3);
+	const uint64 ComponentMask = (1ull << BitsPerComponent) - 1;
+
+	float Components[4];
+	float SumSquares = 0.f;
+	int32 Shift = 2;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		if (Index != LargestIndex)
+		{
+			Components[Index] = DequantiseComponent((uint32)((Packed >> Shift) & ComponentMask), BitsPerComponent);
+			SumSquares += Components[Index] * Components[Index];
+			Shift += BitsPerComponent;
+		}
+	}
+	Components[LargestIndex] = FMath::Sqrt(FMath::Max(0.f, 1.f - SumSquares));
+
+	FQuat Orientation(Components[0], Components[1], Components[2], Components[3]);
+	Orientation.Normalize();
+	return Orientation;
+}
+
+void FDS5WQuatCodec::Serialize(FArchive& Ar, FQuat& Orientation, int32 BitsPerComponent)
+{
+	BitsPerComponent = FMath::Clamp(BitsPerComponent, MinBitsPerComponent, MaxBitsPerComponent);
+
+	uint64 Packed = Ar.IsSaving() ? Encode(Orientation, BitsPerComponent) : 0;
+
+	uint32 LargestIndex = (uint32)(Packed & 0x3);
+	Ar.SerializeInt(LargestIndex, 4);
+
+	uint64 Result = LargestIndex;
+	for (int32 Component = 0; Component < 3; ++Component)
+	{
+		const int32 Shift = 2 + Component * BitsPerComponent;
+		uint32 Value = (uint32)((Packed >> Shift) & ((1ull << BitsPerComponent) - 1));
+		Ar.SerializeInt(Value, 1u << BitsPerComponent);
+		Result |= (uint64)Value << Shift;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Orientation = Decode(Result, BitsPerComponent);
+	}
+}
+
+FDS5WOrientationStream::FDS5WOrientationStream(int32 InBitsPerComponent)
+	: BitsPerComponent(InBitsPerComponent)
+{
+	Reset();
+}
+
+void FDS5WOrientationStream::Reset()
+{
+	NumSamples = 0;
+	Head = DS5W_ORIENTATION_STREAM_SIZE - 1;
+}
+
+void FDS5WOrientationStream::AddSample(double Time, uint64 Packed)
+{
+	AddSample(Time, FDS5WQuatCodec::Decode(Packed, BitsPerComponent));
+}
+
+void FDS5WOrientationStream::AddSample(double Time, const FQuat& Orientation)
+{
+	Head = (Head + 1) % DS5W_ORIENTATION_STREAM_SIZE;
+	NumSamples = FMath::Min(NumSamples + 1, DS5W_ORIENTATION_STREAM_SIZE);
+
+	Samples[Head].Time = Time;
+	Samples[Head].Orientation = Orientation;
+}
+
+bool FDS5WOrientationStream::Sample(double Time, FQuat& OutOrientation) const
+{
+	if (NumSamples == 0)
+	{
+		return false;
+	}
+
+	const FSample& Newest = GetSample(0);
+	if (Time >= Newest.Time || NumSamples == 1)
+	{
+		OutOrientation = Newest.Orientation;
+		return true;
+	}
+
+	// Walk back to the pair around Time, usually only a step or two
+	for (int32 Age = 1; Age < NumSamples; ++Age)
+	{
+		const FSample& Older = GetSample(Age);
+		if (Older.Time <= Time)
+		{
+			const FSample& Newer = GetSample(Age - 1);
+			const double Span = Newer.Time - Older.Time;
+			const float Alpha = Span > 0.0 ? (float)((Time - Older.Time) / Span) : 1.f;
+			OutOrientation = FQuat::Slerp(Older.Orientation, Newer.Orientation, Alpha);
+			return true;
+		}
+	}
+
+	OutOrientation = GetSample(NumSamples - 1).Orientation;
+	return true;
+}
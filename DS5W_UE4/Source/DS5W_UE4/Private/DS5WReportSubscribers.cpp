@@ -0,0 +1,170 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WReportSubscribers.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/UnrealMathUtility.h"
+
+namespace
+{
+	/** Set while this thread runs subscriber callbacks, unsubscribing from there would wait for itself */
+	thread_local int32 DeliveryDepth = 0;
+}
+
+FDS5WReportSubscribers::FDS5WReportSubscribers()
+	: NumSubscribers(0)
+{
+	for (FSlot& Slot : Slots)
+	{
+		Slot.State.store(Slot_Free, std::memory_order_relaxed);
+		Slot.NumInFlight.store(0, std::memory_order_relaxed);
+		Slot.NumDropped.store(0, std::memory_order_relaxed);
+		Slot.Generation = 0;
+	}
+}
+
+FDS5WReportSubscription FDS5WReportSubscribers::Subscribe(FCallback Callback, bool bQueue)
+{
+	FDS5WReportSubscription Subscription;
+	if (!Callback && !bQueue)
+	{
+		return Subscription;
+	}
+
+	for (int32 Index = 0; Index < DS5W_MAX_REPORT_SUBSCRIBERS; ++Index)
+	{
+		FSlot& Slot = Slots[Index];
+		uint32 Expected = Slot_Free;
+		if (!Slot.State.compare_exchange_strong(Expected, Slot_Claimed, std::memory_order_acquire))
+		{
+			continue;
+		}
+
+		// Readers skip the slot until it is active, it is ours to fill in
+		Slot.Callback = MoveTemp(Callback);
+		Slot.Queue = bQueue ? MakeUnique<FQueue>() : nullptr;
+		Slot.NumDropped.store(0, std::memory_order_relaxed);
+		Slot.State.store(Slot_Active, std::memory_order_release);
+		NumSubscribers.fetch_add(1, std::memory_order_relaxed);
+
+		Subscription.Index = Index;
+		Subscription.Generation = Slot.Generation;
+		return Subscription;
+	}
+
+	UE_LOG(LogTemp, Warning, TEXT("FDS5WReportSubscribers::Subscribe: All %d subscriber slots are taken."), DS5W_MAX_REPORT_SUBSCRIBERS);
+	return Subscription;
+}
+
+void FDS5WReportSubscribers::Unsubscribe(FDS5WReportSubscription& Subscription)
+{
+	check(DeliveryDepth == 0);
+
+	FSlot* Slot = FindSlot(Subscription);
+	Subscription = FDS5WReportSubscription();
+	if (!Slot)
+	{
+		return;
+	}
+
+	uint32 Expected = Slot_Active;
+	if (!Slot->State.compare_exchange_strong(Expected, Slot_Retired, std::memory_order_seq_cst))
+	{
+		return;
+	}
+	NumSubscribers.fetch_sub(1, std::memory_order_relaxed);
+
+	// A reader that counted itself in before the slot retired may still be calling it, one report's worth of work
+	while (Slot->NumInFlight.load(std::memory_order_seq_cst) != 0)
+	{
+		FPlatformProcess::Yield();
+	}
+
+	Slot->Callback = nullptr;
+	Slot->Queue.Reset();
+	++Slot->Generation;
+	Slot->State.store(Slot_Free, std::memory_order_release);
+}
+
+bool FDS5WReportSubscribers::Dequeue(const FDS5WReportSubscription& Subscription, FDS5WRawReport& OutReport)
+{
+	FSlot* Slot = FindSlot(Subscription);
+	return Slot && Slot->Queue && Slot->Queue->Dequeue(OutReport);
+}
+
+uint64 FDS5WReportSubscribers::GetNumDropped(const FDS5WReportSubscription& Subscription) const
+{
+	const FSlot* Slot = FindSlot(Subscription);
+	return Slot ? Slot->NumDropped.load(std::memory_order_relaxed) : 0;
+}
+
+FDS5WReportSubscribers::FSlot* FDS5WReportSubscribers::FindSlot(const FDS5WReportSubscription& Subscription) const
+{
+	if (Subscription.Index < 0 || Subscription.Index >= DS5W_MAX_REPORT_SUBSCRIBERS)
+	{
+		return nullptr;
+	}
+
+	FSlot* Slot = const_cast<FSlot*>(&Slots[Subscription.Index]);
+	return Slot->State.load(std::memory_order_acquire) == Slot_Active && Slot->Generation == Subscription.Generation ? Slot : nullptr;
+}
+
+void FDS5WReportSubscribers::Deliver(const FDS5WRawReportView& Report)
+{
+	if (!HasSubscribers())
+	{
+		return;
+	}
+
+	++DeliveryDepth;
+
+	// Filled in for the first queue, shared by all of them
+	FDS5WRawReport Copy;
+	bool bHasCopy = false;
+
+	for (FSlot& Slot : Slots)
+	{
+		if (Slot.State.load(std::memory_order_relaxed) != Slot_Active)
+		{
+			continue;
+		}
+
+		// Count in first, then check the state again: Unsubscribe retires the slot first and then waits
+		// for the count, so either it sees this reader or this reader sees the slot retired
+		Slot.NumInFlight.fetch_add(1, std::memory_order_seq_cst);
+		if (Slot.State.load(std::memory_order_seq_cst) == Slot_Active)
+		{
+			if (Slot.Callback)
+			{
+				Slot.Callback(Report);
+			}
+
+			if (Slot.Queue)
+			{
+				if (!bHasCopy)
+				{
+					Copy.ControllerId = Report.ControllerId;
+					Copy.NumBytes = FMath::Min(Report.NumBytes, DS5W_RAW_REPORT_MAX_BYTES);
+					Copy.bBluetooth = Report.bBluetooth;
+					if (Copy.NumBytes > 0)
+					{
+						FMemory::Memcpy(Copy.Data, Report.Data, Copy.NumBytes);
+					}
+					Copy.State = *Report.State;
+					Copy.CaptureTime = Report.CaptureTime;
+					Copy.DeviceTime = Report.DeviceTime;
+					bHasCopy = true;
+				}
+
+				if (!Slot.Queue->Enqueue(Copy))
+				{
+					// Readers of several controllers share the queue
+					Slot.NumDropped.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		}
+		Slot.NumInFlight.fetch_sub(1, std::memory_order_release);
+	}
+
+	--DeliveryDepth;
+}
@@ -0,0 +1,145 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WSharedStateExport.h"
+#include "Containers/UnrealString.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/Quat.h"
+#include "Math/UnrealMathUtility.h"
+#include "Misc/ConfigCacheIni.h"
+
+FDS5WSharedStateExport::FDS5WSharedStateExport()
+	: MappedRegion(nullptr)
+	, Region(nullptr)
+{
+	FMemory::Memzero(NumReports, sizeof(NumReports));
+}
+
+FDS5WSharedStateExport::~FDS5WSharedStateExport()
+{
+	Close();
+}
+
+bool FDS5WSharedStateExport::Open(const TCHAR* Name)
+{
+	Close();
+
+	FString RegionName = Name ? FString(Name) : FString(TEXT(DS5W_SHARED_STATE_NAME));
+	if (!Name)
+	{
+		bool bEnabled = false;
+		GConfig->GetBool(DS5W_SHARED_STATE_CONFIG_SECTION, TEXT("bEnabled"), bEnabled, GInputIni);
+		GConfig->GetString(DS5W_SHARED_STATE_CONFIG_SECTION, TEXT("Name"), RegionName, GInputIni);
+		if (!bEnabled)
+		{
+			return false;
+		}
+	}
+
+	const uint32 AccessMode = (uint32)FPlatformMemory::ESharedMemoryAccess::Read | (uint32)FPlatformMemory::ESharedMemoryAccess::Write;
+	MappedRegion = FPlatformMemory::MapNamedSharedMemoryRegion(RegionName, true, AccessMode, sizeof(FDS5WSharedStateRegion));
+	if (!MappedRegion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FDS5WSharedStateExport::Open: Failed to map shared memory region %s."), *RegionName);
+		return false;
+	}
+
+	// Readers check the header before trusting the slots
+	FDS5WSharedStateRegion* NewRegion = (FDS5WSharedStateRegion*)MappedRegion->GetAddress();
+	FMemory::Memzero(NewRegion, sizeof(FDS5WSharedStateRegion));
+	NewRegion->Header.Version = DS5W_SHARED_STATE_VERSION;
+	NewRegion->Header.RegionSize = sizeof(FDS5WSharedStateRegion);
+	NewRegion->Header.SlotSize = sizeof(FDS5WSharedControllerSlot);
+	NewRegion->Header.NumControllers = DS5W_SHARED_STATE_MAX_CONTROLLERS;
+	NewRegion->Header.WriterProcessId = FPlatformProcess::GetCurrentProcessId();
+	NewRegion->Header.Magic.store(DS5W_SHARED_STATE_MAGIC, std::memory_order_release);
+
+	FMemory::Memzero(NumReports, sizeof(NumReports));
+	Region = NewRegion;
+	return true;
+}
+
+void FDS5WSharedStateExport::Close()
+{
+	if (MappedRegion)
+	{
+		// Readers still mapping it see a region nobody writes anymore
+		Region->Header.Magic.store(0, std::memory_order_relaxed);
+		Region = nullptr;
+
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(MappedRegion);
+		MappedRegion = nullptr;
+	}
+}
+
+void FDS5WSharedStateExport::Publish(int32 ControllerId, const DS5W::DS5InputState& State, double CaptureTime, bool bBluetooth, const FQuat* Orientation)
+{
+	if (!Region || ControllerId < 0 || ControllerId >= DS5W_SHARED_STATE_MAX_CONTROLLERS)
+	{
+		return;
+	}
+
+	FDS5WSharedControllerState Shared;
+	Shared.Flags = DS5W_SHARED_STATE_FLAG_CONNECTED
+		| (bBluetooth ? DS5W_SHARED_STATE_FLAG_BLUETOOTH : 0)
+		| (State.battery.chargin ? DS5W_SHARED_STATE_FLAG_CHARGING : 0)
+		| (State.battery.fullyCharged ? DS5W_SHARED_STATE_FLAG_FULLY_CHARGED : 0)
+		| (State.headPhoneConnected ? DS5W_SHARED_STATE_FLAG_HEADPHONES : 0)
+		| (Orientation ? DS5W_SHARED_STATE_FLAG_ORIENTATION : 0);
+	Shared.SensorTimestamp = State.sensorTimestamp;
+	Shared.NumReports = ++NumReports[ControllerId];
+	Shared.CaptureTime = CaptureTime;
+
+	Shared.Sticks[0] = State.leftStick.x;
+	Shared.Sticks[1] = State.leftStick.y;
+	Shared.Sticks[2] = State.rightStick.x;
+	Shared.Sticks[3] = State.rightStick.y;
+	Shared.Triggers[0] = State.leftTrigger;
+	Shared.Triggers[1] = State.rightTrigger;
+	Shared.BatteryLevel = State.battery.level;
+	Shared.Pad0 = 0;
+
+	Shared.ButtonsAndDpad = State.buttonsAndDpad;
+	Shared.ButtonsA = State.buttonsA;
+	Shared.ButtonsB = State.buttonsB;
+	Shared.Pad1 = 0;
+
+	const DS5W::Touch* const Touches[2] = { &State.touchPoint1, &State.touchPoint2 };
+	for (int32 Index = 0; Index < 2; ++Index)
+	{
+		Shared.TouchX[Index] = (uint16)Touches[Index]->x;
+		Shared.TouchY[Index] = (uint16)Touches[Index]->y;
+		Shared.TouchId[Index] = Touches[Index]->id;
+		Shared.TouchDown[Index] = Touches[Index]->down ? 1 : 0;
+	}
+
+	Shared.Gyro[0] = State.imuState.gyroX;
+	Shared.Gyro[1] = State.imuState.gyroY;
+	Shared.Gyro[2] = State.imuState.gyroZ;
+	Shared.Accel[0] = State.imuState.accelX;
+	Shared.Accel[1] = State.imuState.accelY;
+	Shared.Accel[2] = State.imuState.accelZ;
+
+	const FQuat& Rotation = Orientation ? *Orientation : FQuat::Identity;
+	Shared.Orientation[0] = Rotation.X;
+	Shared.Orientation[1] = Rotation.Y;
+	Shared.Orientation[2] = Rotation.Z;
+	Shared.Orientation[3] = Rotation.W;
+
+	DS5WWriteSharedControllerState(Region->Controllers[ControllerId], Shared);
+}
+
+void FDS5WSharedStateExport::PublishDisconnect(int32 ControllerId)
+{
+	if (!Region || ControllerId < 0 || ControllerId >= DS5W_SHARED_STATE_MAX_CONTROLLERS)
+	{
+		return;
+	}
+
+	FDS5WSharedControllerState Shared;
+	FMemory::Memzero(Shared);
+	Shared.NumReports = NumReports[ControllerId];
+	Shared.Orientation[3] = 1.f;
+
+	DS5WWriteSharedControllerState(Region->Controllers[ControllerId], Shared);
+}
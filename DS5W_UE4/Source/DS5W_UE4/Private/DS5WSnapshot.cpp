@@ -0,0 +1,305 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WSnapshot.h"
+#include "Math/UnrealMathUtility.h"
+#include "Serialization/Archive.h"
+
+// Sensor ranges covered by the quantised IMU values
+#define DS5W_SNAPSHOT_GYRO_RANGE  2000.f
+#define DS5W_SNAPSHOT_ACCEL_RANGE 4.f
+
+// Nominal raw sensor units, used to rebuild the raw fields
+#define DS5W_SNAPSHOT_GYRO_RAW_PER_UNIT  (32767.f / 2000.f)
+#define DS5W_SNAPSHOT_ACCEL_RAW_PER_UNIT 8192.f
+
+// Wire sizes
+#define DS5W_SNAPSHOT_BUTTON_BITS      19
+#define DS5W_SNAPSHOT_TOUCH_ID_BITS    7
+#define DS5W_SNAPSHOT_TOUCH_POS_BITS   11
+#define DS5W_SNAPSHOT_IMU_DELTA_BITS   6
+
+namespace
+{
+	/** Field groups that are only written when they differ from the baseline */
+	enum ESnapshotGroup : uint32
+	{
+		Group_Sticks   = 1 << 0,
+		Group_Triggers = 1 << 1,
+		Group_Buttons  = 1 << 2,
+		Group_Touch    = 1 << 3,
+		Group_Gyro     = 1 << 4,
+		Group_Accel    = 1 << 5,
+
+		Group_Count    = 6,
+		Group_All      = (1 << Group_Count) - 1,
+	};
+
+	/** Unsigned value in NumBits bits */
+	template<typename T>
+	void SerializeBits(FArchive& Ar, T& Value, uint32 NumBits)
+	{
+		uint32 Wire = (uint32)Value;
+		Ar.SerializeInt(Wire, 1u << NumBits);
+		Value = (T)Wire;
+	}
+
+	/** Signed value in NumBits bits, stored with an offset of half the range */
+	template<typename T>
+	void SerializeSignedBits(FArchive& Ar, T& Value, uint32 NumBits)
+	{
+		const int32 Bias = 1 << (NumBits - 1);
+		uint32 Wire = (uint32)FMath::Clamp<int32>(Value + Bias, 0, (1 << NumBits) - 1);
+		Ar.SerializeInt(Wire, 1u << NumBits);
+		Value = (T)((int32)Wire - Bias);
+	}
+
+	int16 Quantise(float Value, float Range, uint32 NumBits)
+	{
+		const int32 MaxValue = (1 << (NumBits - 1)) - 1;
+		return (int16)FMath::Clamp(FMath::RoundToInt(Value / Range * MaxValue), -MaxValue, MaxValue);
+	}
+
+	float Dequantise(int16 Value, float Range, uint32 NumBits)
+	{
+		const int32 MaxValue = (1 << (NumBits - 1)) - 1;
+		return Value * Range / MaxValue;
+	}
+
+	/** IMU axes as small deltas against the baseline where they fit, absolute otherwise */
+	void SerializeAxes(FArchive& Ar, int16* Values, const int16* BaselineValues, uint32 NumBits)
+	{
+		const int32 MaxDelta = (1 << (DS5W_SNAPSHOT_IMU_DELTA_BITS - 1)) - 1;
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (!BaselineValues)
+			{
+				SerializeSignedBits(Ar, Values[Axis], NumBits);
+				continue;
+			}
+
+			int32 Delta = Values[Axis] - BaselineValues[Axis];
+			uint8 bSmall = Ar.IsSaving() && FMath::Abs(Delta) <= MaxDelta;
+			Ar.SerializeBits(&bSmall, 1);
+
+			if (bSmall)
+			{
+				SerializeSignedBits(Ar, Delta, DS5W_SNAPSHOT_IMU_DELTA_BITS);
+				Values[Axis] = (int16)(BaselineValues[Axis] + Delta);
+			}
+			else
+			{
+				SerializeSignedBits(Ar, Values[Axis], NumBits);
+			}
+		}
+	}
+}
+
+void FDS5WSnapshot::FromInputState(const DS5W::DS5InputState& State)
+{
+	LeftStick[0] = State.leftStick.x;
+	LeftStick[1] = State.leftStick.y;
+	RightStick[0] = State.rightStick.x;
+	RightStick[1] = State.rightStick.y;
+	Triggers[0] = State.leftTrigger;
+	Triggers[1] = State.rightTrigger;
+
+	Buttons = State.buttonsAndDpad | (State.buttonsA << 8) | ((State.buttonsB & 0x07) << 16);
+
+	Gyro[0] = Quantise(State.imuState.gyroX, DS5W_SNAPSHOT_GYRO_RANGE, DS5W_SNAPSHOT_GYRO_BITS);
+	Gyro[1] = Quantise(State.imuState.gyroY, DS5W_SNAPSHOT_GYRO_RANGE, DS5W_SNAPSHOT_GYRO_BITS);
+	Gyro[2] = Quantise(State.imuState.gyroZ, DS5W_SNAPSHOT_GYRO_RANGE, DS5W_SNAPSHOT_GYRO_BITS);
+	Accel[0] = Quantise(State.imuState.accelX, DS5W_SNAPSHOT_ACCEL_RANGE, DS5W_SNAPSHOT_ACCEL_BITS);
+	Accel[1] = Quantise(State.imuState.accelY, DS5W_SNAPSHOT_ACCEL_RANGE, DS5W_SNAPSHOT_ACCEL_BITS);
+	Accel[2] = Quantise(State.imuState.accelZ, DS5W_SNAPSHOT_ACCEL_RANGE, DS5W_SNAPSHOT_ACCEL_BITS);
+
+	const DS5W::Touch* Points[2] = { &State.touchPoint1, &State.touchPoint2 };
+	for (int32 PointIndex = 0; PointIndex < 2; ++PointIndex)
+	{
+		// A lifted finger is stored as all zero so it compares equal to the baseline
+		FTouchPoint& Point = Touch[PointIndex];
+		Point.bDown = Points[PointIndex]->down;
+		Point.Id = Point.bDown ? Points[PointIndex]->id & 0x7F : 0;
+		Point.X = Point.bDown ? (uint16)FMath::Min<uint32>(Points[PointIndex]->x, (1 << DS5W_SNAPSHOT_TOUCH_POS_BITS) - 1) : 0;
+		Point.Y = Point.bDown ? (uint16)FMath::Min<uint32>(Points[PointIndex]->y, (1 << DS5W_SNAPSHOT_TOUCH_POS_BITS) - 1) : 0;
+	}
+
+	SensorTimestamp = State.sensorTimestamp;
+}
+
+void FDS5WSnapshot::ToInputState(DS5W::DS5InputState& OutState) const
+{
+	FMemory::Memzero(&OutState, sizeof(DS5W::DS5InputState));
+
+	OutState.leftStick.x = LeftStick[0];
+	OutState.leftStick.y = LeftStick[1];
+	OutState.rightStick.x = RightStick[0];
+	OutState.rightStick.y = RightStick[1];
+	OutState.leftTrigger = Triggers[0];
+	OutState.rightTrigger = Triggers[1];
+
+	OutState.buttonsAndDpad = Buttons & 0xFF;
+	OutState.buttonsA = (Buttons >> 8) & 0xFF;
+	OutState.buttonsB = (Buttons >> 16) & 0x07;
+
+	OutState.imuState.gyroX = Dequantise(Gyro[0], DS5W_SNAPSHOT_GYRO_RANGE, DS5W_SNAPSHOT_GYRO_BITS);
+	OutState.imuState.gyroY = Dequantise(Gyro[1], DS5W_SNAPSHOT_GYRO_RANGE, DS5W_SNAPSHOT_GYRO_BITS);
+	OutState.imuState.gyroZ = Dequantise(Gyro[2], DS5W_SNAPSHOT_GYRO_RANGE, DS5W_SNAPSHOT_GYRO_BITS);
+	OutState.imuState.accelX = Dequantise(Accel[0], DS5W_SNAPSHOT_ACCEL_RANGE, DS5W_SNAPSHOT_ACCEL_BITS);
+	OutState.imuState.accelY = Dequantise(Accel[1], DS5W_SNAPSHOT_ACCEL_RANGE, DS5W_SNAPSHOT_ACCEL_BITS);
+	OutState.imuState.accelZ = Dequantise(Accel[2], DS5W_SNAPSHOT_ACCEL_RANGE, DS5W_SNAPSHOT_ACCEL_BITS);
+
+	OutState.gyroscope.x = (short)FMath::Clamp(FMath::RoundToInt(OutState.imuState.gyroX * DS5W_SNAPSHOT_GYRO_RAW_PER_UNIT), -32768, 32767);
+	OutState.gyroscope.y = (short)FMath::Clamp(FMath::RoundToInt(OutState.imuState.gyroY * DS5W_SNAPSHOT_GYRO_RAW_PER_UNIT), -32768, 32767);
+	OutState.gyroscope.z = (short)FMath::Clamp(FMath::RoundToInt(OutState.imuState.gyroZ * DS5W_SNAPSHOT_GYRO_RAW_PER_UNIT), -32768, 32767);
+	OutState.accelerometer.x = (short)FMath::Clamp(FMath::RoundToInt(OutState.imuState.accelX * DS5W_SNAPSHOT_ACCEL_RAW_PER_UNIT), -32768, 32767);
+	OutState.accelerometer.y = (short)FMath::Clamp(FMath::RoundToInt(OutState.imuState.accelY * DS5W_SNAPSHOT_ACCEL_RAW_PER_UNIT), -32768, 32767);
+	OutState.accelerometer.z = (short)FMath::Clamp(FMath::RoundToInt(OutState.imuState.accelZ * DS5W_SNAPSHOT_ACCEL_RAW_PER_UNIT), -32768, 32767);
+
+	DS5W::Touch* Points[2] = { &OutState.touchPoint1, &OutState.touchPoint2 };
+	for (int32 PointIndex = 0; PointIndex < 2; ++PointIndex)
+	{
+		const FTouchPoint& Point = Touch[PointIndex];
+		Points[PointIndex]->down = Point.bDown;
+		Points[PointIndex]->id = Point.Id;
+		Points[PointIndex]->x = Point.X;
+		Points[PointIndex]->y = Point.Y;
+	}
+
+	OutState.sensorTimestamp = SensorTimestamp;
+}
+
+void FDS5WSnapshot::GetGyro(float* OutGyro) const
+{
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		OutGyro[Axis] = Dequantise(Gyro[Axis], DS5W_SNAPSHOT_GYRO_RANGE, DS5W_SNAPSHOT_GYRO_BITS);
+	}
+}
+
+bool FDS5WSnapshot::NetSerialize(FArchive& Ar, const FDS5WSnapshot* Baseline)
+{
+	uint32 ChangedGroups = Group_All;
+	if (Ar.IsSaving() && Baseline)
+	{
+		ChangedGroups = 0;
+		ChangedGroups |= FMemory::Memcmp(LeftStick, Baseline->LeftStick, sizeof(LeftStick)) || FMemory::Memcmp(RightStick, Baseline->RightStick, sizeof(RightStick)) ? Group_Sticks : 0;
+		ChangedGroups |= FMemory::Memcmp(Triggers, Baseline->Triggers, sizeof(Triggers)) ? Group_Triggers : 0;
+		ChangedGroups |= Buttons != Baseline->Buttons ? Group_Buttons : 0;
+		ChangedGroups |= FMemory::Memcmp(Gyro, Baseline->Gyro, sizeof(Gyro)) ? Group_Gyro : 0;
+		ChangedGroups |= FMemory::Memcmp(Accel, Baseline->Accel, sizeof(Accel)) ? Group_Accel : 0;
+
+		for (int32 PointIndex = 0; PointIndex < 2; ++PointIndex)
+		{
+			const FTouchPoint& Point = Touch[PointIndex];
+			const FTouchPoint& BaselinePoint = Baseline->Touch[PointIndex];
+			if (Point.bDown != BaselinePoint.bDown || Point.Id != BaselinePoint.Id || Point.X != BaselinePoint.X || Point.Y != BaselinePoint.Y)
+			{
+				ChangedGroups |= Group_Touch;
+			}
+		}
+	}
+
+	SerializeBits(Ar, ChangedGroups, Group_Count);
+
+	// Without a baseline there is nothing to leave out
+	if (!Baseline && ChangedGroups != Group_All)
+	{
+		Ar.SetError();
+		return false;
+	}
+
+	if (ChangedGroups & Group_Sticks)
+	{
+		SerializeSignedBits(Ar, LeftStick[0], 8);
+		SerializeSignedBits(Ar, LeftStick[1], 8);
+		SerializeSignedBits(Ar, RightStick[0], 8);
+		SerializeSignedBits(Ar, RightStick[1], 8);
+	}
+	else if (Ar.IsLoading())
+	{
+		FMemory::Memcpy(LeftStick, Baseline->LeftStick, sizeof(LeftStick));
+		FMemory::Memcpy(RightStick, Baseline->RightStick, sizeof(RightStick));
+	}
+
+	if (ChangedGroups & Group_Triggers)
+	{
+		SerializeBits(Ar, Triggers[0], 8);
+		SerializeBits(Ar, Triggers[1], 8);
+	}
+	else if (Ar.IsLoading())
+	{
+		FMemory::Memcpy(Triggers, Baseline->Triggers, sizeof(Triggers));
+	}
+
+	if (ChangedGroups & Group_Buttons)
+	{
+		SerializeBits(Ar, Buttons, DS5W_SNAPSHOT_BUTTON_BITS);
+	}
+	else if (Ar.IsLoading())
+	{
+		Buttons = Baseline->Buttons;
+	}
+
+	if (ChangedGroups & Group_Touch)
+	{
+		for (int32 PointIndex = 0; PointIndex < 2; ++PointIndex)
+		{
+			FTouchPoint& Point = Touch[PointIndex];
+
+			uint8 bDown = Ar.IsSaving() && Point.bDown;
+			Ar.SerializeBits(&bDown, 1);
+			Point.bDown = bDown != 0;
+
+			// Position and id of a lifted finger carry no information
+			if (Point.bDown)
+			{
+				SerializeBits(Ar, Point.Id, DS5W_SNAPSHOT_TOUCH_ID_BITS);
+				SerializeBits(Ar, Point.X, DS5W_SNAPSHOT_TOUCH_POS_BITS);
+				SerializeBits(Ar, Point.Y, DS5W_SNAPSHOT_TOUCH_POS_BITS);
+			}
+			else if (Ar.IsLoading())
+			{
+				Point.Id = 0;
+				Point.X = 0;
+				Point.Y = 0;
+			}
+		}
+	}
+	else if (Ar.IsLoading())
+	{
+		FMemory::Memcpy(Touch, Baseline->Touch, sizeof(Touch));
+	}
+
+	if (ChangedGroups & Group_Gyro)
+	{
+		SerializeAxes(Ar, Gyro, Baseline ? Baseline->Gyro : nullptr, DS5W_SNAPSHOT_GYRO_BITS);
+	}
+	else if (Ar.IsLoading())
+	{
+		FMemory::Memcpy(Gyro, Baseline->Gyro, sizeof(Gyro));
+	}
+
+	if (ChangedGroups & Group_Accel)
+	{
+		SerializeAxes(Ar, Accel, Baseline ? Baseline->Accel : nullptr, DS5W_SNAPSHOT_ACCEL_BITS);
+	}
+	else if (Ar.IsLoading())
+	{
+		FMemory::Memcpy(Accel, Baseline->Accel, sizeof(Accel));
+	}
+
+	// The timestamp always changes, against a baseline it is a small tick delta
+	if (Baseline)
+	{
+		uint32 DeltaTicks = SensorTimestamp - Baseline->SensorTimestamp;
+		Ar.SerializeIntPacked(DeltaTicks);
+		SensorTimestamp = Baseline->SensorTimestamp + DeltaTicks;
+	}
+	else
+	{
+		Ar << SensorTimestamp;
+	}
+
+	return !Ar.IsError();
+}
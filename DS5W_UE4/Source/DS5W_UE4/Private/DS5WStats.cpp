@@ -0,0 +1,168 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WStats.h"
+#include "HAL/PlatformMath.h"
+#include "HAL/PlatformTime.h"
+#include "Math/UnrealMathUtility.h"
+#include "Misc/OutputDevice.h"
+
+#define DS5W_HISTOGRAM_SUB_BUCKETS (1 << DS5W_HISTOGRAM_SUB_BUCKET_BITS)
+
+FDS5WHistogram::FDS5WHistogram()
+{
+	Reset();
+}
+
+int32 FDS5WHistogram::GetBucket(uint64 Value)
+{
+	// Small values are exact
+	if (Value < 2 * DS5W_HISTOGRAM_SUB_BUCKETS)
+	{
+		return (int32)Value;
+	}
+
+	// The power of two picks the row, the bits below the leading one the bucket within it
+	const int32 Exponent = (int32)FPlatformMath::FloorLog2_64(Value);
+	if (Exponent > DS5W_HISTOGRAM_MAX_EXPONENT)
+	{
+		return DS5W_HISTOGRAM_BUCKETS - 1;
+	}
+	const int32 SubBucket = (int32)(Value >> (Exponent - DS5W_HISTOGRAM_SUB_BUCKET_BITS)) & (DS5W_HISTOGRAM_SUB_BUCKETS - 1);
+
+	return 2 * DS5W_HISTOGRAM_SUB_BUCKETS + ((Exponent - DS5W_HISTOGRAM_SUB_BUCKET_BITS - 1) << DS5W_HISTOGRAM_SUB_BUCKET_BITS) + SubBucket;
+}
+
+uint64 FDS5WHistogram::GetBucketUpperBound(int32 Bucket)
+{
+	if (Bucket < 2 * DS5W_HISTOGRAM_SUB_BUCKETS)
+	{
+		return (uint64)Bucket;
+	}
+
+	const int32 Row = Bucket - 2 * DS5W_HISTOGRAM_SUB_BUCKETS;
+	const int32 Exponent = (Row >> DS5W_HISTOGRAM_SUB_BUCKET_BITS) + DS5W_HISTOGRAM_SUB_BUCKET_BITS + 1;
+	const uint64 SubBucket = (uint64)(Row & (DS5W_HISTOGRAM_SUB_BUCKETS - 1));
+	return ((DS5W_HISTOGRAM_SUB_BUCKETS + SubBucket + 1) << (Exponent - DS5W_HISTOGRAM_SUB_BUCKET_BITS)) - 1;
+}
+
+void FDS5WHistogram::Record(uint64 Nanoseconds)
+{
+	std::atomic<uint32>& Bucket = Buckets[GetBucket(Nanoseconds)];
+	Bucket.store(Bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+	Count.store(Count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	Sum.store(Sum.load(std::memory_order_relaxed) + Nanoseconds, std::memory_order_relaxed);
+	if (Nanoseconds < Min.load(std::memory_order_relaxed))
+	{
+		Min.store(Nanoseconds, std::memory_order_relaxed);
+	}
+	if (Nanoseconds > Max.load(std::memory_order_relaxed))
+	{
+		Max.store(Nanoseconds, std::memory_order_relaxed);
+	}
+}
+
+void FDS5WHistogram::RecordCycles(uint64 Cycles)
+{
+	Record((uint64)(FPlatformTime::ToSeconds64(Cycles) * 1.e9));
+}
+
+void FDS5WHistogram::Reset()
+{
+	for (std::atomic<uint32>& Bucket : Buckets)
+	{
+		Bucket.store(0, std::memory_order_relaxed);
+	}
+	Count.store(0, std::memory_order_relaxed);
+	Sum.store(0, std::memory_order_relaxed);
+	Min.store(MAX_uint64, std::memory_order_relaxed);
+	Max.store(0, std::memory_order_relaxed);
+}
+
+double FDS5WHistogram::GetMean() const
+{
+	const uint64 NumValues = GetCount();
+	return NumValues ? (double)Sum.load(std::memory_order_relaxed) / NumValues : 0.0;
+}
+
+uint64 FDS5WHistogram::GetPercentile(double Fraction) const
+{
+	const uint64 NumValues = GetCount();
+	if (NumValues == 0)
+	{
+		return 0;
+	}
+
+	const uint64 Target = FMath::Max<uint64>((uint64)FMath::CeilToDouble(Fraction * NumValues), 1);
+	uint64 NumBelow = 0;
+	for (int32 Bucket = 0; Bucket < DS5W_HISTOGRAM_BUCKETS; ++Bucket)
+	{
+		NumBelow += Buckets[Bucket].load(std::memory_order_relaxed);
+		if (NumBelow >= Target)
+		{
+			// The bucket bound overstates by up to a bucket width, the maximum is exact
+			return FMath::Min(GetBucketUpperBound(Bucket), GetMax());
+		}
+	}
+
+	return GetMax();
+}
+
+void FDS5WHistogram::Dump(FOutputDevice& Ar, const TCHAR* Name) const
+{
+	Ar.Logf(TEXT("  %-12s n=%-8llu mean=%8.1f min=%8.1f p50=%8.1f p90=%8.1f p99=%8.1f p99.9=%8.1f max=%8.1f us"),
+		Name, GetCount(), GetMean() / 1000.0, GetMin() / 1000.0,
+		GetPercentile(0.5) / 1000.0, GetPercentile(0.9) / 1000.0, GetPercentile(0.99) / 1000.0, GetPercentile(0.999) / 1000.0,
+		GetMax() / 1000.0);
+}
+
+FDS5WControllerStats::FDS5WControllerStats()
+{
+	Reset();
+}
+
+void FDS5WControllerStats::Reset()
+{
+	ReadWait.Reset();
+	Parse.Reset();
+	OutputWrite.Reset();
+	Fusion.Reset();
+	Dispatch.Reset();
+	InputAgeUsb.Reset();
+	InputAgeBluetooth.Reset();
+
+	NumReports.store(0, std::memory_order_relaxed);
+	NumBacklogReports.store(0, std::memory_order_relaxed);
+	NumDroppedReports.store(0, std::memory_order_relaxed);
+	NumOutputsSent.store(0, std::memory_order_relaxed);
+	NumOutputsPosted.store(0, std::memory_order_relaxed);
+	NumOutputsSkipped.store(0, std::memory_order_relaxed);
+}
+
+void FDS5WControllerStats::Dump(FOutputDevice& Ar, int32 ControllerId, double Seconds) const
+{
+	const uint64 Reports = NumReports.load(std::memory_order_relaxed);
+	const uint64 Posted = NumOutputsPosted.load(std::memory_order_relaxed);
+	const uint64 Sent = NumOutputsSent.load(std::memory_order_relaxed);
+
+	// Posted states the reader never wrote were replaced by a newer one first
+	Ar.Logf(TEXT("DS5W controller %d: %llu reports (%.1f/s), %llu from a backlog, %llu dropped; output %llu sent, %llu superseded, %llu unchanged"),
+		ControllerId, Reports, Seconds > 0.0 ? Reports / Seconds : 0.0, NumBacklogReports.load(std::memory_order_relaxed), NumDroppedReports.load(std::memory_order_relaxed),
+		Sent, Posted > Sent ? Posted - Sent : 0, NumOutputsSkipped.load(std::memory_order_relaxed));
+
+	ReadWait.Dump(Ar, TEXT("ReadWait"));
+	Parse.Dump(Ar, TEXT("Parse"));
+	Fusion.Dump(Ar, TEXT("Fusion"));
+	Dispatch.Dump(Ar, TEXT("Dispatch"));
+	OutputWrite.Dump(Ar, TEXT("OutputWrite"));
+
+	// Only the connection types the controller was seen on
+	if (InputAgeUsb.GetCount())
+	{
+		InputAgeUsb.Dump(Ar, TEXT("InputAge USB"));
+	}
+	if (InputAgeBluetooth.GetCount())
+	{
+		InputAgeBluetooth.Dump(Ar, TEXT("InputAge BT"));
+	}
+}
@@ -0,0 +1,531 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WStreamServer.h"
+#include "DS5WInputHistory.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/UnrealMathUtility.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/Timespan.h"
+#include "Serialization/BitReader.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+namespace
+{
+	/** Largest record: controller id, connected bit, capture time and a snapshot without baseline, with room to spare */
+	const int32 MaxRecordBytes = 64;
+
+	void WriteHeader(uint8* Data, EDS5WStreamDatagramType Type, uint16 NumRecords, uint32 Sequence)
+	{
+		const uint32 Magic = DS5W_STREAM_MAGIC;
+
+		// Little endian on every platform, clients don't need the engine to read it
+		for (int32 Byte = 0; Byte < 4; ++Byte)
+		{
+			Data[Byte] = (uint8)(Magic >> (8 * Byte));
+			Data[8 + Byte] = (uint8)(Sequence >> (8 * Byte));
+		}
+		Data[4] = DS5W_STREAM_VERSION;
+		Data[5] = (uint8)Type;
+		Data[6] = (uint8)NumRecords;
+		Data[7] = (uint8)(NumRecords >> 8);
+	}
+
+	bool ReadHeader(const uint8* Data, int32 NumBytes, EDS5WStreamDatagramType& OutType, int32& OutNumRecords)
+	{
+		if (NumBytes < DS5W_STREAM_HEADER_BYTES)
+		{
+			return false;
+		}
+
+		const uint32 Magic = (uint32)Data[0] | ((uint32)Data[1] << 8) | ((uint32)Data[2] << 16) | ((uint32)Data[3] << 24);
+		if (Magic != DS5W_STREAM_MAGIC || Data[4] != DS5W_STREAM_VERSION || Data[5] > (uint8)EDS5WStreamDatagramType::Commands)
+		{
+			return false;
+		}
+
+		OutType = (EDS5WStreamDatagramType)Data[5];
+		OutNumRecords = (int32)Data[6] | ((int32)Data[7] << 8);
+		return true;
+	}
+}
+
+FDS5WRemoteOutput::FDS5WRemoteOutput()
+{
+	Reset();
+}
+
+void FDS5WRemoteOutput::Reset()
+{
+	FMemory::Memzero(*this);
+}
+
+bool FDS5WRemoteOutput::AddCommand(const FDS5WStreamCommand& Command, double Time, double Timeout)
+{
+	switch (Command.Type)
+	{
+		case EDS5WStreamCommandType::Rumble:
+			bRumble = true;
+			Rumble[0] = Command.Data[0];
+			Rumble[1] = Command.Data[1];
+			break;
+		case EDS5WStreamCommandType::Lightbar:
+			bLightbar = true;
+			Lightbar.r = Command.Data[0];
+			Lightbar.g = Command.Data[1];
+			Lightbar.b = Command.Data[2];
+			break;
+		case EDS5WStreamCommandType::TriggerEffect:
+		{
+			const int32 Side = Command.Data[0];
+			if (Side > 1)
+			{
+				return false;
+			}
+
+			DS5W::TriggerEffect& Effect = TriggerEffects[Side];
+			Effect.effectType = (DS5W::TriggerEffectType)Command.Data[1];
+			FMemory::Memcpy(Effect._u1_raw, &Command.Data[2], sizeof(Effect._u1_raw));
+			bTriggerEffects[Side] = true;
+			break;
+		}
+		case EDS5WStreamCommandType::PlayerLeds:
+			if (Command.Data[1] > DS5W::LedBrightness::LOW)
+			{
+				return false;
+			}
+
+			bPlayerLeds = true;
+			PlayerLeds.bitmask = Command.Data[0];
+			PlayerLeds.brightness = (DS5W::LedBrightness)Command.Data[1];
+			PlayerLeds.playerLedFade = Command.Data[2] != 0;
+			break;
+		case EDS5WStreamCommandType::Release:
+			Reset();
+			return true;
+		default:
+			return false;
+	}
+
+	ExpireTime = Time + Timeout;
+	return true;
+}
+
+void FDS5WRemoteOutput::Apply(DS5W::DS5OutputState& OutputState, double Time)
+{
+	if (Time >= ExpireTime)
+	{
+		if (bRumble || bLightbar || bTriggerEffects[0] || bTriggerEffects[1] || bPlayerLeds)
+		{
+			Reset();
+		}
+		return;
+	}
+
+	if (bRumble)
+	{
+		OutputState.leftRumble = Rumble[0];
+		OutputState.rightRumble = Rumble[1];
+	}
+
+	if (bLightbar)
+	{
+		OutputState.lightbar = Lightbar;
+	}
+
+	if (bTriggerEffects[0])
+	{
+		OutputState.leftTriggerEffect = TriggerEffects[0];
+	}
+
+	if (bTriggerEffects[1])
+	{
+		OutputState.rightTriggerEffect = TriggerEffects[1];
+	}
+
+	if (bPlayerLeds)
+	{
+		OutputState.playerLeds = PlayerLeds;
+	}
+}
+
+FDS5WStreamServer::FDS5WStreamServer(const FDS5WInputHistory* InHistories, int32 InNumControllers)
+	: Histories(InHistories)
+	, NumControllers(InNumControllers)
+	, MaxBatchDelay(0.002)
+	, CommandTimeout(1.0)
+	, Socket(nullptr)
+	, Thread(nullptr)
+	, bStopRequested(false)
+	, ClientExpireTime(0.0)
+	, Writer((DS5W_STREAM_MAX_DATAGRAM_BYTES - DS5W_STREAM_HEADER_BYTES) * 8)
+	, RecordWriter(MaxRecordBytes * 8)
+	, NumBatchRecords(0)
+	, BatchStartTime(0.0)
+	, DatagramSequence(0)
+	, NumDatagramsSent(0)
+	, NumDatagramsDropped(0)
+	, NumReportsDropped(0)
+{
+	Cursors.SetNumZeroed(NumControllers);
+	Baselines.SetNumZeroed(NumControllers);
+	bHasBaseline.SetNumZeroed(NumControllers);
+}
+
+FDS5WStreamServer::~FDS5WStreamServer()
+{
+	Shutdown();
+}
+
+bool FDS5WStreamServer::Start(int32 Port)
+{
+	Shutdown();
+
+	if (Port == 0)
+	{
+		bool bEnabled = false;
+		Port = DS5W_STREAM_DEFAULT_PORT;
+		GConfig->GetBool(DS5W_STREAM_CONFIG_SECTION, TEXT("bEnabled"), bEnabled, GInputIni);
+		GConfig->GetInt(DS5W_STREAM_CONFIG_SECTION, TEXT("Port"), Port, GInputIni);
+		GConfig->GetDouble(DS5W_STREAM_CONFIG_SECTION, TEXT("MaxBatchDelay"), MaxBatchDelay, GInputIni);
+		GConfig->GetDouble(DS5W_STREAM_CONFIG_SECTION, TEXT("CommandTimeout"), CommandTimeout, GInputIni);
+		if (!bEnabled)
+		{
+			return false;
+		}
+	}
+
+	MaxBatchDelay = FMath::Max(MaxBatchDelay, 0.0);
+	CommandTimeout = FMath::Max(CommandTimeout, 0.1);
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (!SocketSubsystem)
+	{
+		return false;
+	}
+
+	// Loopback only, the stream is for tools on this machine
+	TSharedRef<FInternetAddr> Addr = SocketSubsystem->CreateInternetAddr();
+	Addr->SetLoopbackAddress();
+	Addr->SetPort(Port);
+
+	Socket = SocketSubsystem->CreateSocket(NAME_DGram, TEXT("DS5W stream"), Addr->GetProtocolType());
+	if (!Socket || !Socket->SetNonBlocking(true) || !Socket->Bind(*Addr))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FDS5WStreamServer::Start: Failed to bind loopback port %d."), Port);
+		if (Socket)
+		{
+			SocketSubsystem->DestroySocket(Socket);
+			Socket = nullptr;
+		}
+		return false;
+	}
+
+	for (int32 ControllerIndex = 0; ControllerIndex < NumControllers; ++ControllerIndex)
+	{
+		Cursors[ControllerIndex] = Histories[ControllerIndex].GetNumWritten();
+	}
+
+	ClientAddr.Reset();
+	BeginBatch();
+
+	bStopRequested.store(false, std::memory_order_relaxed);
+	Thread = FRunnableThread::Create(this, TEXT("DS5WStreamServer"), 0, TPri_Normal);
+	if (!Thread)
+	{
+		SocketSubsystem->DestroySocket(Socket);
+		Socket = nullptr;
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("FDS5WStreamServer::Start: Streaming on loopback port %d."), Port);
+	return true;
+}
+
+void FDS5WStreamServer::Shutdown()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (Socket)
+	{
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+
+	ClientAddr.Reset();
+}
+
+void FDS5WStreamServer::Stop()
+{
+	bStopRequested.store(true, std::memory_order_relaxed);
+}
+
+uint32 FDS5WStreamServer::Run()
+{
+	while (!bStopRequested.load(std::memory_order_relaxed))
+	{
+		// Client datagrams wake the thread right away, new reports are picked up at the poll interval
+		Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(DS5W_STREAM_POLL_INTERVAL));
+
+		ReceiveDatagrams();
+		StreamReports(FPlatformTime::Seconds());
+	}
+
+	return 0;
+}
+
+void FDS5WStreamServer::ReceiveDatagrams()
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	TSharedRef<FInternetAddr> Sender = SocketSubsystem->CreateInternetAddr();
+
+	uint8 Data[DS5W_STREAM_MAX_DATAGRAM_BYTES];
+	TArray<FDS5WStreamCommand> Received;
+	int32 NumBytes = 0;
+	while (Socket->RecvFrom(Data, sizeof(Data), NumBytes, *Sender))
+	{
+		EDS5WStreamDatagramType Type;
+		if (!DecodeCommands(Data, NumBytes, Type, Received) || Type == EDS5WStreamDatagramType::Samples)
+		{
+			continue;
+		}
+
+		// One client at a time, the latest one to send takes over the stream
+		if (!ClientAddr.IsValid() || !(*ClientAddr == *Sender))
+		{
+			ClientAddr = Sender->Clone();
+			for (int32 ControllerIndex = 0; ControllerIndex < NumControllers; ++ControllerIndex)
+			{
+				Cursors[ControllerIndex] = Histories[ControllerIndex].GetNumWritten();
+			}
+			BeginBatch();
+		}
+		ClientExpireTime = FPlatformTime::Seconds() + CommandTimeout;
+
+		for (const FDS5WStreamCommand& Command : Received)
+		{
+			if (!Commands.Enqueue(Command))
+			{
+				// The game thread fell behind, the client resends what it still wants
+				break;
+			}
+		}
+	}
+}
+
+void FDS5WStreamServer::StreamReports(double Now)
+{
+	if (ClientAddr.IsValid() && Now > ClientExpireTime)
+	{
+		ClientAddr.Reset();
+	}
+
+	// Nobody listens, keep up with the histories so a new client starts with fresh reports
+	if (!ClientAddr.IsValid())
+	{
+		for (int32 ControllerIndex = 0; ControllerIndex < NumControllers; ++ControllerIndex)
+		{
+			Cursors[ControllerIndex] = Histories[ControllerIndex].GetNumWritten();
+		}
+		return;
+	}
+
+	FDS5WInputHistoryEntry Entry;
+	for (int32 ControllerIndex = 0; ControllerIndex < NumControllers; ++ControllerIndex)
+	{
+		const FDS5WInputHistory& History = Histories[ControllerIndex];
+		const uint64 End = History.GetNumWritten();
+		const uint64 Capacity = (uint64)History.GetCapacity();
+		uint64& Cursor = Cursors[ControllerIndex];
+
+		// The reader lapped the server, what it overwrote is gone
+		if (End - Cursor > Capacity)
+		{
+			NumReportsDropped.store(GetNumReportsDropped() + (End - Capacity - Cursor), std::memory_order_relaxed);
+			Cursor = End - Capacity;
+		}
+
+		for (; Cursor < End; ++Cursor)
+		{
+			if (!History.GetEntry(Cursor, Entry))
+			{
+				NumReportsDropped.store(GetNumReportsDropped() + 1, std::memory_order_relaxed);
+				continue;
+			}
+
+			EncodeRecord(ControllerIndex, Entry);
+			if (Writer.GetNumBits() + RecordWriter.GetNumBits() > Writer.GetMaxBits() || NumBatchRecords == MAX_uint16)
+			{
+				// Every datagram decodes on its own, so the record is encoded again without the baseline
+				SendBatch();
+				BeginBatch();
+				EncodeRecord(ControllerIndex, Entry);
+			}
+
+			if (NumBatchRecords == 0)
+			{
+				BatchStartTime = Now;
+			}
+
+			Writer.SerializeBits(RecordWriter.GetData(), RecordWriter.GetNumBits());
+			++NumBatchRecords;
+
+			Baselines[ControllerIndex] = Entry.Snapshot;
+			bHasBaseline[ControllerIndex] = Entry.bConnected;
+		}
+	}
+
+	if (NumBatchRecords > 0 && Now - BatchStartTime >= MaxBatchDelay)
+	{
+		SendBatch();
+		BeginBatch();
+	}
+}
+
+void FDS5WStreamServer::BeginBatch()
+{
+	Writer.Reset();
+	NumBatchRecords = 0;
+	for (int32 ControllerIndex = 0; ControllerIndex < NumControllers; ++ControllerIndex)
+	{
+		bHasBaseline[ControllerIndex] = false;
+	}
+}
+
+void FDS5WStreamServer::SendBatch()
+{
+	if (NumBatchRecords == 0 || !ClientAddr.IsValid())
+	{
+		return;
+	}
+
+	uint8 Data[DS5W_STREAM_MAX_DATAGRAM_BYTES];
+	const int32 NumRecordBytes = (int32)Writer.GetNumBytes();
+	WriteHeader(Data, EDS5WStreamDatagramType::Samples, (uint16)NumBatchRecords, DatagramSequence++);
+	FMemory::Memcpy(Data + DS5W_STREAM_HEADER_BYTES, Writer.GetData(), NumRecordBytes);
+
+	// Non-blocking, a full socket buffer costs the datagram rather than the server's time
+	int32 BytesSent = 0;
+	const int32 NumBytes = DS5W_STREAM_HEADER_BYTES + NumRecordBytes;
+	if (Socket->SendTo(Data, NumBytes, BytesSent, *ClientAddr) && BytesSent == NumBytes)
+	{
+		NumDatagramsSent.store(GetNumDatagramsSent() + 1, std::memory_order_relaxed);
+	}
+	else
+	{
+		NumDatagramsDropped.store(GetNumDatagramsDropped() + 1, std::memory_order_relaxed);
+	}
+}
+
+void FDS5WStreamServer::EncodeRecord(int32 ControllerId, const FDS5WInputHistoryEntry& Entry)
+{
+	RecordWriter.Reset();
+
+	uint8 Id = (uint8)ControllerId;
+	double CaptureTime = Entry.CaptureTime;
+	RecordWriter << Id;
+	RecordWriter.WriteBit(Entry.bConnected ? 1 : 0);
+	RecordWriter << CaptureTime;
+
+	if (Entry.bConnected)
+	{
+		FDS5WSnapshot Snapshot = Entry.Snapshot;
+		Snapshot.NetSerialize(RecordWriter, bHasBaseline[ControllerId] ? &Baselines[ControllerId] : nullptr);
+	}
+}
+
+bool FDS5WStreamServer::DecodeSamples(const uint8* Data, int32 NumBytes, TArray<FDS5WStreamSample>& OutSamples)
+{
+	OutSamples.Reset();
+
+	EDS5WStreamDatagramType Type;
+	int32 NumRecords = 0;
+	if (!ReadHeader(Data, NumBytes, Type, NumRecords) || Type != EDS5WStreamDatagramType::Samples)
+	{
+		return false;
+	}
+
+	FDS5WSnapshot Baselines[256];
+	bool bHasBaseline[256] = {};
+
+	FBitReader Reader(const_cast<uint8*>(Data) + DS5W_STREAM_HEADER_BYTES, (int64)(NumBytes - DS5W_STREAM_HEADER_BYTES) * 8);
+	for (int32 RecordIndex = 0; RecordIndex < NumRecords; ++RecordIndex)
+	{
+		FDS5WStreamSample& Sample = OutSamples.AddDefaulted_GetRef();
+
+		uint8 Id = 0;
+		Reader << Id;
+		Sample.ControllerId = Id;
+		Sample.bConnected = Reader.ReadBit() != 0;
+		Reader << Sample.CaptureTime;
+
+		if (Sample.bConnected)
+		{
+			if (!Sample.Snapshot.NetSerialize(Reader, bHasBaseline[Id] ? &Baselines[Id] : nullptr))
+			{
+				return false;
+			}
+			Baselines[Id] = Sample.Snapshot;
+			bHasBaseline[Id] = true;
+		}
+		else
+		{
+			FMemory::Memzero(Sample.Snapshot);
+			bHasBaseline[Id] = false;
+		}
+
+		if (Reader.IsError())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FDS5WStreamServer::DecodeCommands(const uint8* Data, int32 NumBytes, EDS5WStreamDatagramType& OutType, TArray<FDS5WStreamCommand>& OutCommands)
+{
+	OutCommands.Reset();
+
+	int32 NumRecords = 0;
+	if (!ReadHeader(Data, NumBytes, OutType, NumRecords) || NumBytes != DS5W_STREAM_HEADER_BYTES + NumRecords * DS5W_STREAM_COMMAND_BYTES)
+	{
+		return false;
+	}
+
+	const uint8* Record = Data + DS5W_STREAM_HEADER_BYTES;
+	for (int32 RecordIndex = 0; RecordIndex < NumRecords; ++RecordIndex, Record += DS5W_STREAM_COMMAND_BYTES)
+	{
+		FDS5WStreamCommand& Command = OutCommands.AddDefaulted_GetRef();
+		Command.ControllerId = Record[0];
+		Command.Type = (EDS5WStreamCommandType)Record[1];
+		FMemory::Memcpy(Command.Data, &Record[2], sizeof(Command.Data));
+	}
+
+	return true;
+}
+
+void FDS5WStreamServer::EncodeCommands(const FDS5WStreamCommand* InCommands, int32 NumCommands, TArray<uint8>& OutData)
+{
+	OutData.SetNumUninitialized(DS5W_STREAM_HEADER_BYTES + NumCommands * DS5W_STREAM_COMMAND_BYTES);
+
+	const EDS5WStreamDatagramType Type = NumCommands > 0 ? EDS5WStreamDatagramType::Commands : EDS5WStreamDatagramType::Subscribe;
+	WriteHeader(OutData.GetData(), Type, (uint16)NumCommands, 0);
+
+	uint8* Record = OutData.GetData() + DS5W_STREAM_HEADER_BYTES;
+	for (int32 CommandIndex = 0; CommandIndex < NumCommands; ++CommandIndex, Record += DS5W_STREAM_COMMAND_BYTES)
+	{
+		const FDS5WStreamCommand& Command = InCommands[CommandIndex];
+		Record[0] = (uint8)Command.ControllerId;
+		Record[1] = (uint8)Command.Type;
+		FMemory::Memcpy(&Record[2], Command.Data, sizeof(Command.Data));
+	}
+}
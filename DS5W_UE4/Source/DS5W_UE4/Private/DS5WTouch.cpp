@@ -0,0 +1,242 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WTouch.h"
+#include "Math/UnrealMathUtility.h"
+
+// Touchpad resolution reported by the controller
+#define DS5W_TOUCHPAD_WIDTH  1920.f
+#define DS5W_TOUCHPAD_HEIGHT 1080.f
+
+// Gesture thresholds, distances are in normalised touchpad units
+#define DS5W_TOUCH_TAP_MAX_TIME      0.25
+#define DS5W_TOUCH_TAP_MAX_TRAVEL    0.03f
+#define DS5W_TOUCH_SWIPE_MAX_TIME    0.5
+#define DS5W_TOUCH_SWIPE_MIN_TRAVEL  0.25f
+#define DS5W_TOUCH_PINCH_MIN_CHANGE  0.05f
+#define DS5W_TOUCH_SCROLL_MIN_TRAVEL 0.05f
+
+FDS5WTouchTracker::FDS5WTouchTracker()
+	: Gestures(DS5W_TOUCH_GESTURE_QUEUE + 1)
+{
+	FMemory::Memzero(Samples, sizeof(Samples));
+	Reset();
+}
+
+void FDS5WTouchTracker::Reset()
+{
+	NumWritten.store(0, std::memory_order_release);
+	bWasTouching = false;
+
+	Mode = EMode::Idle;
+	bMoved = false;
+	StartTime = 0.0;
+	StartCentroid = FVector2D::ZeroVector;
+	LastCentroid = FVector2D::ZeroVector;
+	StartDistance = 0.f;
+	LastDistance = 0.f;
+}
+
+void FDS5WTouchTracker::AddSample(const DS5W::DS5InputState& State, double CaptureTime)
+{
+	FDS5WTouchSample Sample;
+	Sample.Time = CaptureTime;
+
+	const DS5W::Touch* Points[2] = { &State.touchPoint1, &State.touchPoint2 };
+	for (int32 PointIndex = 0; PointIndex < 2; ++PointIndex)
+	{
+		Sample.Position[PointIndex] = FVector2D(Points[PointIndex]->x / DS5W_TOUCHPAD_WIDTH, Points[PointIndex]->y / DS5W_TOUCHPAD_HEIGHT);
+		Sample.FingerId[PointIndex] = Points[PointIndex]->id;
+		Sample.bDown[PointIndex] = Points[PointIndex]->down;
+	}
+
+	const bool bTouching = Sample.bDown[0] || Sample.bDown[1];
+
+	// Only record while touching (plus the release) so the ring holds the interesting part of the trajectory
+	if (bTouching || bWasTouching)
+	{
+		const uint64 Index = NumWritten.load(std::memory_order_relaxed);
+		Samples[Index % DS5W_TOUCH_HISTORY] = Sample;
+		NumWritten.store(Index + 1, std::memory_order_release);
+
+		Recognise(Sample);
+	}
+
+	bWasTouching = bTouching;
+}
+
+int32 FDS5WTouchTracker::GetTrajectory(FDS5WTouchSample* OutSamples, int32 MaxSamples) const
+{
+	if (!OutSamples || MaxSamples <= 0)
+	{
+		return 0;
+	}
+
+	const uint64 End = NumWritten.load(std::memory_order_acquire);
+	const uint64 Count = FMath::Min<uint64>(FMath::Min<uint64>(End, DS5W_TOUCH_HISTORY), MaxSamples);
+	const uint64 Begin = End - Count;
+
+	for (uint64 Index = Begin; Index < End; ++Index)
+	{
+		OutSamples[Index - Begin] = Samples[Index % DS5W_TOUCH_HISTORY];
+	}
+
+	// Samples the writer may have overwritten while we were copying are dropped from the front
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64 EndAfterCopy = NumWritten.load(std::memory_order_relaxed);
+	if (EndAfterCopy < End)
+	{
+		// Reset while copying
+		return 0;
+	}
+
+	const uint64 FirstValid = EndAfterCopy + 1 > DS5W_TOUCH_HISTORY ? EndAfterCopy + 1 - DS5W_TOUCH_HISTORY : 0;
+	if (FirstValid <= Begin)
+	{
+		return (int32)Count;
+	}
+	if (FirstValid >= End)
+	{
+		return 0;
+	}
+
+	const uint64 NumValid = End - FirstValid;
+	FMemory::Memmove(OutSamples, OutSamples + (FirstValid - Begin), NumValid * sizeof(FDS5WTouchSample));
+	return (int32)NumValid;
+}
+
+void FDS5WTouchTracker::Recognise(const FDS5WTouchSample& Sample)
+{
+	const int32 NumDown = (Sample.bDown[0] ? 1 : 0) + (Sample.bDown[1] ? 1 : 0);
+
+	FVector2D Centroid = FVector2D::ZeroVector;
+	for (int32 PointIndex = 0; PointIndex < 2; ++PointIndex)
+	{
+		if (Sample.bDown[PointIndex])
+		{
+			Centroid += Sample.Position[PointIndex];
+		}
+	}
+	if (NumDown > 0)
+	{
+		Centroid /= (float)NumDown;
+	}
+
+	const float Distance = FVector2D::Distance(Sample.Position[0], Sample.Position[1]);
+
+	auto BeginTwoFingers = [&]()
+	{
+		Mode = EMode::TwoFingers;
+		StartCentroid = LastCentroid = Centroid;
+		StartDistance = LastDistance = Distance;
+	};
+
+	switch (Mode)
+	{
+	case EMode::Idle:
+		if (NumDown == 1)
+		{
+			Mode = EMode::OneFinger;
+			bMoved = false;
+			StartTime = Sample.Time;
+			StartCentroid = LastCentroid = Centroid;
+		}
+		else if (NumDown == 2)
+		{
+			BeginTwoFingers();
+		}
+		break;
+
+	case EMode::OneFinger:
+		if (NumDown == 1)
+		{
+			LastCentroid = Centroid;
+			bMoved |= FVector2D::Distance(Centroid, StartCentroid) > DS5W_TOUCH_TAP_MAX_TRAVEL;
+		}
+		else if (NumDown == 2)
+		{
+			BeginTwoFingers();
+		}
+		else
+		{
+			const FVector2D Travel = LastCentroid - StartCentroid;
+			const double Duration = Sample.Time - StartTime;
+
+			if (!bMoved && Duration <= DS5W_TOUCH_TAP_MAX_TIME)
+			{
+				Emit(EDS5WTouchGesture::Tap, StartCentroid, Sample.Time);
+			}
+			else if (Duration <= DS5W_TOUCH_SWIPE_MAX_TIME && Travel.Size() >= DS5W_TOUCH_SWIPE_MIN_TRAVEL)
+			{
+				if (FMath::Abs(Travel.X) >= FMath::Abs(Travel.Y))
+				{
+					Emit(Travel.X < 0.f ? EDS5WTouchGesture::SwipeLeft : EDS5WTouchGesture::SwipeRight, Travel, Sample.Time);
+				}
+				else
+				{
+					// Touchpad Y grows towards the player
+					Emit(Travel.Y < 0.f ? EDS5WTouchGesture::SwipeUp : EDS5WTouchGesture::SwipeDown, Travel, Sample.Time);
+				}
+			}
+
+			Mode = EMode::Idle;
+		}
+		break;
+
+	case EMode::TwoFingers:
+		if (NumDown < 2)
+		{
+			Mode = NumDown == 0 ? EMode::Idle : EMode::Finished;
+		}
+		else if (FMath::Abs(Distance - StartDistance) >= DS5W_TOUCH_PINCH_MIN_CHANGE)
+		{
+			Mode = EMode::Pinch;
+		}
+		else if (FVector2D::Distance(Centroid, StartCentroid) >= DS5W_TOUCH_SCROLL_MIN_TRAVEL)
+		{
+			Mode = EMode::Scroll;
+		}
+		break;
+
+	case EMode::Pinch:
+		if (NumDown < 2)
+		{
+			Mode = NumDown == 0 ? EMode::Idle : EMode::Finished;
+		}
+		else if (Distance != LastDistance)
+		{
+			Emit(EDS5WTouchGesture::Pinch, FVector2D(Distance - LastDistance, 0.f), Sample.Time);
+			LastDistance = Distance;
+		}
+		break;
+
+	case EMode::Scroll:
+		if (NumDown < 2)
+		{
+			Mode = NumDown == 0 ? EMode::Idle : EMode::Finished;
+		}
+		else if (Centroid != LastCentroid)
+		{
+			Emit(EDS5WTouchGesture::Scroll, Centroid - LastCentroid, Sample.Time);
+			LastCentroid = Centroid;
+		}
+		break;
+
+	case EMode::Finished:
+		if (NumDown == 0)
+		{
+			Mode = EMode::Idle;
+		}
+		break;
+	}
+}
+
+void FDS5WTouchTracker::Emit(EDS5WTouchGesture Type, const FVector2D& Value, double Time)
+{
+	FDS5WTouchGestureEvent Gesture;
+	Gesture.Type = Type;
+	Gesture.Value = Value;
+	Gesture.Time = Time;
+
+	// The game thread is behind, drop the gesture rather than block the reader
+	Gestures.Enqueue(Gesture);
+}
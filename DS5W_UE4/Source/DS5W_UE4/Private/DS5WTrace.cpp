@@ -0,0 +1,162 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "DS5WTrace.h"
+#include "Containers/Array.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/PlatformTime.h"
+#include "Math/UnrealMathUtility.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/FileHelper.h"
+
+FDS5WTrace::FDS5WTrace()
+	: Mask(0)
+	, NumWritten(0)
+	, bEnabled(false)
+	, FirstIndex(0)
+{
+}
+
+void FDS5WTrace::Init(int32 InCapacity)
+{
+	check(!IsEnabled());
+
+	bool bStartEnabled = false;
+	int32 Capacity = InCapacity;
+	if (Capacity <= 0)
+	{
+		Capacity = DS5W_TRACE_CAPACITY;
+		GConfig->GetInt(DS5W_TRACE_CONFIG_SECTION, TEXT("Capacity"), Capacity, GInputIni);
+		GConfig->GetBool(DS5W_TRACE_CONFIG_SECTION, TEXT("bStartEnabled"), bStartEnabled, GInputIni);
+	}
+
+	if (Capacity <= 0)
+	{
+		Slots = nullptr;
+		Mask = 0;
+		return;
+	}
+
+	Capacity = FMath::RoundUpToPowerOfTwo(FMath::Clamp(Capacity, DS5W_TRACE_MIN_CAPACITY, DS5W_TRACE_MAX_CAPACITY));
+
+	Slots = MakeUnique<FSlot[]>(Capacity);
+	Mask = Capacity - 1;
+	for (int32 Index = 0; Index < Capacity; ++Index)
+	{
+		// Never matches the sequence of an event that goes to this slot
+		Slots[Index].Sequence.store(0, std::memory_order_relaxed);
+	}
+	NumWritten.store(0, std::memory_order_relaxed);
+	FirstIndex.store(0, std::memory_order_relaxed);
+
+	if (bStartEnabled)
+	{
+		Start();
+	}
+}
+
+bool FDS5WTrace::Start()
+{
+	if (!Slots)
+	{
+		return false;
+	}
+
+	FirstIndex.store(NumWritten.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	bEnabled.store(true, std::memory_order_release);
+	return true;
+}
+
+void FDS5WTrace::Stop()
+{
+	bEnabled.store(false, std::memory_order_relaxed);
+}
+
+void FDS5WTrace::Record(EDS5WTraceStage Stage, int32 ControllerId, uint64 StartCycles, uint64 EndCycles)
+{
+	const uint64 Index = NumWritten.fetch_add(1, std::memory_order_relaxed);
+	FSlot& Slot = Slots[Index & Mask];
+
+	Slot.Sequence.store((uint32)(2 * Index + 1), std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Slot.Stage = (uint8)Stage;
+	Slot.ControllerId = (int8)ControllerId;
+	Slot.ThreadId = FPlatformTLS::GetCurrentThreadId();
+	Slot.StartCycles = StartCycles;
+	Slot.EndCycles = FMath::Max(StartCycles, EndCycles);
+
+	Slot.Sequence.store((uint32)(2 * Index + 2), std::memory_order_release);
+}
+
+bool FDS5WTrace::Flush(const TCHAR* Filename) const
+{
+	const uint64 Written = NumWritten.load(std::memory_order_acquire);
+	const uint64 First = FMath::Max(FirstIndex.load(std::memory_order_relaxed), Written > Mask ? Written - Mask : 0);
+	const double MicrosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1.e6;
+	const uint32 ProcessId = FPlatformProcess::GetCurrentProcessId();
+
+	// Name each thread after the first stage seen on it, reader threads only run reader stages
+	TArray<uint32> NamedThreads;
+
+	// One event per line, each but the first led by the comma separating it from the one before
+	TArray<FString> Lines;
+	Lines.Add(TEXT("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+	const int32 NumHeaderLines = Lines.Num();
+
+	for (uint64 Index = First; Slots && Index < Written; ++Index)
+	{
+		const FSlot& Slot = Slots[Index & Mask];
+		const uint32 Expected = (uint32)(2 * Index + 2);
+		if (Slot.Sequence.load(std::memory_order_acquire) != Expected)
+		{
+			continue;
+		}
+
+		const EDS5WTraceStage Stage = (EDS5WTraceStage)Slot.Stage;
+		const int32 ControllerId = Slot.ControllerId;
+		const uint32 ThreadId = Slot.ThreadId;
+		const uint64 StartCycles = Slot.StartCycles;
+		const uint64 EndCycles = Slot.EndCycles;
+
+		// Overwritten while copying
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (Slot.Sequence.load(std::memory_order_relaxed) != Expected || Stage >= EDS5WTraceStage::Num)
+		{
+			continue;
+		}
+
+		if (!NamedThreads.Contains(ThreadId))
+		{
+			NamedThreads.Add(ThreadId);
+
+			const bool bReaderThread = Stage == EDS5WTraceStage::Read || Stage == EDS5WTraceStage::Parse || Stage == EDS5WTraceStage::Queue || Stage == EDS5WTraceStage::OutputWrite;
+			const FString ThreadName = bReaderThread ? FString::Printf(TEXT("DS5W reader %d"), ControllerId) : FString(TEXT("DS5W game thread"));
+			Lines.Add(FString::Printf(TEXT("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}"),
+				Lines.Num() > NumHeaderLines ? TEXT(",") : TEXT(""), ProcessId, ThreadId, *ThreadName));
+		}
+
+		Lines.Add(FString::Printf(TEXT("%s{\"name\":\"%s\",\"cat\":\"DS5W\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"controller\":%d}}"),
+			Lines.Num() > NumHeaderLines ? TEXT(",") : TEXT(""), GetStageName(Stage), ProcessId, ThreadId, StartCycles * MicrosecondsPerCycle, (EndCycles - StartCycles) * MicrosecondsPerCycle, ControllerId));
+	}
+
+	Lines.Add(TEXT("]}"));
+
+	return FFileHelper::SaveStringArrayToFile(Lines, Filename);
+}
+
+const TCHAR* FDS5WTrace::GetStageName(EDS5WTraceStage Stage)
+{
+	static const TCHAR* const StageNames[(uint8)EDS5WTraceStage::Num] =
+	{
+		TEXT("Read"),
+		TEXT("Parse"),
+		TEXT("Queue"),
+		TEXT("Consume"),
+		TEXT("Fusion"),
+		TEXT("Dispatch"),
+		TEXT("OutputWrite"),
+	};
+
+	return Stage < EDS5WTraceStage::Num ? StageNames[(uint8)Stage] : TEXT("Unknown");
+}
@@ -3,6 +3,7 @@
 #include "Templates/SharedPointer.h"
 #include "IDS5W_UE4.h"
 #include "DS5WInterface.h"
+#include "DS5WAllocationTracker.h"
 
 #define LOCTEXT_NAMESPACE "DualSenseModule"
 
@@ -12,10 +13,40 @@ static FName ModuleName = FName("DualSense");
 const FKey FDS5WKey::DS5W_GyroAxis_X("DS5W_GyroAxis_X");
 const FKey FDS5WKey::DS5W_GyroAxis_Y("DS5W_GyroAxis_Y");
 
+// Setup touchpad gestures
+const FKey FDS5WKey::DS5W_Touch_Tap("DS5W_Touch_Tap");
+const FKey FDS5WKey::DS5W_Touch_SwipeLeft("DS5W_Touch_SwipeLeft");
+const FKey FDS5WKey::DS5W_Touch_SwipeRight("DS5W_Touch_SwipeRight");
+const FKey FDS5WKey::DS5W_Touch_SwipeUp("DS5W_Touch_SwipeUp");
+const FKey FDS5WKey::DS5W_Touch_SwipeDown("DS5W_Touch_SwipeDown");
+const FKey FDS5WKey::DS5W_Touch_Pinch("DS5W_Touch_Pinch");
+const FKey FDS5WKey::DS5W_Touch_ScrollX("DS5W_Touch_ScrollX");
+const FKey FDS5WKey::DS5W_Touch_ScrollY("DS5W_Touch_ScrollY");
+
+// Setup buttons
+const FKey FDS5WKey::DS5W_PS_Button("DS5W_PS_Button");
+const FKey FDS5WKey::DS5W_Touchpad_Button("DS5W_Touchpad_Button");
+const FKey FDS5WKey::DS5W_Mic_Button("DS5W_Mic_Button");
+
 // Setup gyroscope names
 const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_GyroAxis_X("DS5W_GyroAxis_X");
 const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_GyroAxis_Y("DS5W_GyroAxis_Y");
 
+// Setup touchpad gesture names
+const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_Touch_Tap("DS5W_Touch_Tap");
+const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_Touch_SwipeLeft("DS5W_Touch_SwipeLeft");
+const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_Touch_SwipeRight("DS5W_Touch_SwipeRight");
+const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_Touch_SwipeUp("DS5W_Touch_SwipeUp");
+const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_Touch_SwipeDown("DS5W_Touch_SwipeDown");
+const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_Touch_Pinch("DS5W_Touch_Pinch");
+const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_Touch_ScrollX("DS5W_Touch_ScrollX");
+const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_Touch_ScrollY("DS5W_Touch_ScrollY");
+
+// Setup button names
+const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_PS_Button("DS5W_PS_Button");
+const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_Touchpad_Button("DS5W_Touchpad_Button");
+const FDS5WKeyNames::Type FDS5WKeyNames::DS5W_Mic_Button("DS5W_Mic_Button");
+
 class FDS5W_UE4 : public IDS5W_UE4
 {
     /** Implements the rest of the IInputDeviceModule interface **/
@@ -50,6 +81,26 @@ void FDS5W_UE4::StartupModule()
 		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_GyroAxis_X, LOCTEXT("DS5W_GyroAxis_X", "DualSense Gyroscope X"), FKeyDetails::Axis1D | FKeyDetails::NotBlueprintBindableKey, ModuleName));
 		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_GyroAxis_Y, LOCTEXT("DS5W_GyroAxis_Y", "DualSense Gyroscope Y"), FKeyDetails::Axis1D | FKeyDetails::NotBlueprintBindableKey, ModuleName));
 
+		// Touchpad gestures
+		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_Touch_Tap, LOCTEXT("DS5W_Touch_Tap", "DualSense Touchpad Tap"), FKeyDetails::GamepadKey | FKeyDetails::NotBlueprintBindableKey, ModuleName));
+		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_Touch_SwipeLeft, LOCTEXT("DS5W_Touch_SwipeLeft", "DualSense Touchpad Swipe Left"), FKeyDetails::GamepadKey | FKeyDetails::NotBlueprintBindableKey, ModuleName));
+		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_Touch_SwipeRight, LOCTEXT("DS5W_Touch_SwipeRight", "DualSense Touchpad Swipe Right"), FKeyDetails::GamepadKey | FKeyDetails::NotBlueprintBindableKey, ModuleName));
+		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_Touch_SwipeUp, LOCTEXT("DS5W_Touch_SwipeUp", "DualSense Touchpad Swipe Up"), FKeyDetails::GamepadKey | FKeyDetails::NotBlueprintBindableKey, ModuleName));
+		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_Touch_SwipeDown, LOCTEXT("DS5W_Touch_SwipeDown", "DualSense Touchpad Swipe Down"), FKeyDetails::GamepadKey | FKeyDetails::NotBlueprintBindableKey, ModuleName));
+		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_Touch_Pinch, LOCTEXT("DS5W_Touch_Pinch", "DualSense Touchpad Pinch"), FKeyDetails::Axis1D | FKeyDetails::NotBlueprintBindableKey, ModuleName));
+		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_Touch_ScrollX, LOCTEXT("DS5W_Touch_ScrollX", "DualSense Touchpad Scroll X"), FKeyDetails::Axis1D | FKeyDetails::NotBlueprintBindableKey, ModuleName));
+		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_Touch_ScrollY, LOCTEXT("DS5W_Touch_ScrollY", "DualSense Touchpad Scroll Y"), FKeyDetails::Axis1D | FKeyDetails::NotBlueprintBindableKey, ModuleName));
+
+		// Buttons
+		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_PS_Button, LOCTEXT("DS5W_PS_Button", "DualSense PS Button"), FKeyDetails::GamepadKey | FKeyDetails::NotBlueprintBindableKey, ModuleName));
+		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_Touchpad_Button, LOCTEXT("DS5W_Touchpad_Button", "DualSense Touchpad Button"), FKeyDetails::GamepadKey | FKeyDetails::NotBlueprintBindableKey, ModuleName));
+		EKeys::AddKey(FKeyDetails(FDS5WKey::DS5W_Mic_Button, LOCTEXT("DS5W_Mic_Button", "DualSense Mic Button"), FKeyDetails::GamepadKey | FKeyDetails::NotBlueprintBindableKey, ModuleName));
+
+#if DS5W_TRACK_ALLOCATIONS
+		// Before any device exists, so the per-frame paths are counted from their first frame
+		FDS5WAllocationTracker::Install();
+#endif
+
     UE_LOG(LogTemp, Warning, TEXT("DS5W_UE4 initiated!"));
 
     // IMPORTANT: This line registers our input device module with the engine.
@@ -0,0 +1,333 @@
+/*
+	Batch.cpp is part of DualSenseWindows
+	https://github.com/Ohjurot/DualSense-Windows
+
+	Licensed under the MIT License (To be found in repository root directory)
+*/
+
+#include <DualSenseWindows/Batch.h>
+#include <DualSenseWindows/DS5_Input.h>
+
+#include <string.h>
+
+// Select the widest instruction set the compiler allows us to use
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DS5W_BATCH_SSE2
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#define DS5W_BATCH_AVX2
+#include <immintrin.h>
+#endif
+#elif defined(_M_ARM64) || defined(__ARM_NEON)
+#define DS5W_BATCH_NEON
+#include <arm_neon.h>
+#endif
+
+// Offsets inside the report payload
+#define DS5W_BATCH_OFFSET_AXES 0x00
+#define DS5W_BATCH_OFFSET_BUTTONS 0x07
+#define DS5W_BATCH_OFFSET_MOTION 0x0F
+#define DS5W_BATCH_OFFSET_TIMESTAMP 0x1B
+
+// Bytes read from the payload (the motion block is loaded as one 16 byte vector)
+#define DS5W_BATCH_PAYLOAD_SIZE (DS5W_BATCH_OFFSET_MOTION + 16)
+
+namespace {
+	/// <summary>
+	/// Dpad hat value to DS5W_ISTATE_DPAD_?? flags
+	/// </summary>
+	const unsigned char dpadLookup[16] = {
+		DS5W_ISTATE_DPAD_UP,
+		DS5W_ISTATE_DPAD_RIGHT | DS5W_ISTATE_DPAD_UP,
+		DS5W_ISTATE_DPAD_RIGHT,
+		DS5W_ISTATE_DPAD_RIGHT | DS5W_ISTATE_DPAD_DOWN,
+		DS5W_ISTATE_DPAD_DOWN,
+		DS5W_ISTATE_DPAD_LEFT | DS5W_ISTATE_DPAD_DOWN,
+		DS5W_ISTATE_DPAD_LEFT,
+		DS5W_ISTATE_DPAD_LEFT | DS5W_ISTATE_DPAD_UP,
+		0, 0, 0, 0, 0, 0, 0, 0,
+	};
+
+	/// <summary>
+	/// Pack the three button bytes of a report into one word
+	/// </summary>
+	inline unsigned int packButtons(const unsigned char* hidInBuffer) {
+		const unsigned char hat = hidInBuffer[DS5W_BATCH_OFFSET_BUTTONS];
+		return (unsigned int)((hat & 0xF0) | dpadLookup[hat & 0x0F])
+			| ((unsigned int)hidInBuffer[DS5W_BATCH_OFFSET_BUTTONS + 1] << 8)
+			| ((unsigned int)hidInBuffer[DS5W_BATCH_OFFSET_BUTTONS + 2] << 16);
+	}
+
+	/// <summary>
+	/// Sticks and triggers of a single report
+	/// </summary>
+	inline void decodeAxesScalar(const unsigned char* hidInBuffer, DS5W::InputBatch* ptrBatch, unsigned int index) {
+		const unsigned char* axes = &hidInBuffer[DS5W_BATCH_OFFSET_AXES];
+		ptrBatch->leftStickX[index] = (signed char)(axes[0x00] - 128);
+		ptrBatch->leftStickY[index] = (signed char)(127 - axes[0x01]);
+		ptrBatch->rightStickX[index] = (signed char)(axes[0x02] - 128);
+		ptrBatch->rightStickY[index] = (signed char)(127 - axes[0x03]);
+		ptrBatch->leftTrigger[index] = axes[0x04];
+		ptrBatch->rightTrigger[index] = axes[0x05];
+	}
+
+	/// <summary>
+	/// Gyro, accelerometer and timestamp of a single report
+	/// </summary>
+	inline void decodeMotionScalar(const unsigned char* hidInBuffer, const DS5W::IMUCalibration* ptrCalibration, DS5W::InputBatch* ptrBatch, unsigned int index) {
+		const float* scale = ptrCalibration->scale;
+		const float* offset = ptrCalibration->offset;
+
+		short motion[6];
+		memcpy(motion, &hidInBuffer[DS5W_BATCH_OFFSET_MOTION], sizeof(motion));
+		ptrBatch->gyroX[index] = (float)motion[0] * scale[0] + offset[0];
+		ptrBatch->gyroY[index] = (float)motion[1] * scale[1] + offset[1];
+		ptrBatch->gyroZ[index] = (float)motion[2] * scale[2] + offset[2];
+		ptrBatch->accelX[index] = (float)motion[3] * scale[3] + offset[3];
+		ptrBatch->accelY[index] = (float)motion[4] * scale[4] + offset[4];
+		ptrBatch->accelZ[index] = (float)motion[5] * scale[5] + offset[5];
+		memcpy(&ptrBatch->sensorTimestamp[index], &hidInBuffer[DS5W_BATCH_OFFSET_TIMESTAMP], sizeof(unsigned int));
+	}
+
+#if defined(DS5W_BATCH_SSE2)
+	/// <summary>
+	/// Sticks and triggers of four reports
+	/// </summary>
+	inline void decodeAxesSSE2(const unsigned char* const* hid, DS5W::InputBatch* ptrBatch, unsigned int index) {
+		// LX LY RX RY L2 R2 seq buttons of every report
+		const __m128i r0 = _mm_loadl_epi64((const __m128i*)&hid[0][DS5W_BATCH_OFFSET_AXES]);
+		const __m128i r1 = _mm_loadl_epi64((const __m128i*)&hid[1][DS5W_BATCH_OFFSET_AXES]);
+		const __m128i r2 = _mm_loadl_epi64((const __m128i*)&hid[2][DS5W_BATCH_OFFSET_AXES]);
+		const __m128i r3 = _mm_loadl_epi64((const __m128i*)&hid[3][DS5W_BATCH_OFFSET_AXES]);
+
+		// Transpose to LX0..3 LY0..3 RX0..3 RY0..3 and L2 0..3 R2 0..3
+		const __m128i r01 = _mm_unpacklo_epi8(r0, r1);
+		const __m128i r23 = _mm_unpacklo_epi8(r2, r3);
+		const __m128i sticks = _mm_unpacklo_epi16(r01, r23);
+		const __m128i triggers = _mm_unpackhi_epi16(r01, r23);
+
+		// X axes are recentered (v - 128), Y axes are flipped (127 - v)
+		const __m128i xMask = _mm_set_epi32(0, -1, 0, -1);
+		const __m128i xAxes = _mm_xor_si128(sticks, _mm_set1_epi8((char)0x80));
+		const __m128i yAxes = _mm_sub_epi8(_mm_set1_epi8(127), sticks);
+		const __m128i signedSticks = _mm_or_si128(_mm_and_si128(xMask, xAxes), _mm_andnot_si128(xMask, yAxes));
+
+		alignas(16) unsigned char lanes[32];
+		_mm_store_si128((__m128i*)&lanes[0], signedSticks);
+		_mm_store_si128((__m128i*)&lanes[16], triggers);
+		memcpy(&ptrBatch->leftStickX[index], &lanes[0], 4);
+		memcpy(&ptrBatch->leftStickY[index], &lanes[4], 4);
+		memcpy(&ptrBatch->rightStickX[index], &lanes[8], 4);
+		memcpy(&ptrBatch->rightStickY[index], &lanes[12], 4);
+		memcpy(&ptrBatch->leftTrigger[index], &lanes[16], 4);
+		memcpy(&ptrBatch->rightTrigger[index], &lanes[20], 4);
+	}
+
+	/// <summary>
+	/// Sign extend four int16 lanes, scale them and store as float
+	/// </summary>
+	inline void storeScaledSSE2(float* ptrOut, __m128i value32, float scale, float offset) {
+		_mm_storeu_ps(ptrOut, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(value32), _mm_set1_ps(scale)), _mm_set1_ps(offset)));
+	}
+
+	/// <summary>
+	/// Gyro, accelerometer and timestamp of four reports
+	/// </summary>
+	inline void decodeMotionSSE2(const unsigned char* const* hid, const DS5W::IMUCalibration* ptrCalibration, DS5W::InputBatch* ptrBatch, unsigned int index) {
+		// gx gy gz ax ay az tsLow tsHigh of every report
+		const __m128i r0 = _mm_loadu_si128((const __m128i*)&hid[0][DS5W_BATCH_OFFSET_MOTION]);
+		const __m128i r1 = _mm_loadu_si128((const __m128i*)&hid[1][DS5W_BATCH_OFFSET_MOTION]);
+		const __m128i r2 = _mm_loadu_si128((const __m128i*)&hid[2][DS5W_BATCH_OFFSET_MOTION]);
+		const __m128i r3 = _mm_loadu_si128((const __m128i*)&hid[3][DS5W_BATCH_OFFSET_MOTION]);
+
+		// 4x8 transpose
+		const __m128i lo01 = _mm_unpacklo_epi16(r0, r1);
+		const __m128i lo23 = _mm_unpacklo_epi16(r2, r3);
+		const __m128i hi01 = _mm_unpackhi_epi16(r0, r1);
+		const __m128i hi23 = _mm_unpackhi_epi16(r2, r3);
+		const __m128i gyroXY = _mm_unpacklo_epi32(lo01, lo23);
+		const __m128i gyroZAccelX = _mm_unpackhi_epi32(lo01, lo23);
+		const __m128i accelYZ = _mm_unpacklo_epi32(hi01, hi23);
+		const __m128i timestamps = _mm_unpackhi_epi32(hi01, hi23);
+
+		storeScaledSSE2(&ptrBatch->gyroX[index], _mm_srai_epi32(_mm_unpacklo_epi16(gyroXY, gyroXY), 16), ptrCalibration->scale[0], ptrCalibration->offset[0]);
+		storeScaledSSE2(&ptrBatch->gyroY[index], _mm_srai_epi32(_mm_unpackhi_epi16(gyroXY, gyroXY), 16), ptrCalibration->scale[1], ptrCalibration->offset[1]);
+		storeScaledSSE2(&ptrBatch->gyroZ[index], _mm_srai_epi32(_mm_unpacklo_epi16(gyroZAccelX, gyroZAccelX), 16), ptrCalibration->scale[2], ptrCalibration->offset[2]);
+		storeScaledSSE2(&ptrBatch->accelX[index], _mm_srai_epi32(_mm_unpackhi_epi16(gyroZAccelX, gyroZAccelX), 16), ptrCalibration->scale[3], ptrCalibration->offset[3]);
+		storeScaledSSE2(&ptrBatch->accelY[index], _mm_srai_epi32(_mm_unpacklo_epi16(accelYZ, accelYZ), 16), ptrCalibration->scale[4], ptrCalibration->offset[4]);
+		storeScaledSSE2(&ptrBatch->accelZ[index], _mm_srai_epi32(_mm_unpackhi_epi16(accelYZ, accelYZ), 16), ptrCalibration->scale[5], ptrCalibration->offset[5]);
+
+		// Rejoin the low and high timestamp halves
+		_mm_storeu_si128((__m128i*)&ptrBatch->sensorTimestamp[index], _mm_unpacklo_epi16(timestamps, _mm_srli_si128(timestamps, 8)));
+	}
+#endif
+
+#if defined(DS5W_BATCH_AVX2)
+	/// <summary>
+	/// Sign extend eight int16 lanes, scale them and store as float
+	/// </summary>
+	inline void storeScaledAVX2(float* ptrOut, __m256i value32, float scale, float offset) {
+		_mm256_storeu_ps(ptrOut, _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(value32), _mm256_set1_ps(scale)), _mm256_set1_ps(offset)));
+	}
+
+	/// <summary>
+	/// Load the motion block of report n into the low and of report n + 4 into the high lane
+	/// </summary>
+	inline __m256i loadMotionPairAVX2(const unsigned char* low, const unsigned char* high) {
+		const __m128i lowMotion = _mm_loadu_si128((const __m128i*)&low[DS5W_BATCH_OFFSET_MOTION]);
+		const __m128i highMotion = _mm_loadu_si128((const __m128i*)&high[DS5W_BATCH_OFFSET_MOTION]);
+		return _mm256_inserti128_si256(_mm256_castsi128_si256(lowMotion), highMotion, 1);
+	}
+
+	/// <summary>
+	/// Gyro, accelerometer and timestamp of eight reports (same transpose as SSE2, once per 128 bit lane)
+	/// </summary>
+	inline void decodeMotionAVX2(const unsigned char* const* hid, const DS5W::IMUCalibration* ptrCalibration, DS5W::InputBatch* ptrBatch, unsigned int index) {
+		const __m256i r0 = loadMotionPairAVX2(hid[0], hid[4]);
+		const __m256i r1 = loadMotionPairAVX2(hid[1], hid[5]);
+		const __m256i r2 = loadMotionPairAVX2(hid[2], hid[6]);
+		const __m256i r3 = loadMotionPairAVX2(hid[3], hid[7]);
+
+		const __m256i lo01 = _mm256_unpacklo_epi16(r0, r1);
+		const __m256i lo23 = _mm256_unpacklo_epi16(r2, r3);
+		const __m256i hi01 = _mm256_unpackhi_epi16(r0, r1);
+		const __m256i hi23 = _mm256_unpackhi_epi16(r2, r3);
+		const __m256i gyroXY = _mm256_unpacklo_epi32(lo01, lo23);
+		const __m256i gyroZAccelX = _mm256_unpackhi_epi32(lo01, lo23);
+		const __m256i accelYZ = _mm256_unpacklo_epi32(hi01, hi23);
+		const __m256i timestamps = _mm256_unpackhi_epi32(hi01, hi23);
+
+		storeScaledAVX2(&ptrBatch->gyroX[index], _mm256_srai_epi32(_mm256_unpacklo_epi16(gyroXY, gyroXY), 16), ptrCalibration->scale[0], ptrCalibration->offset[0]);
+		storeScaledAVX2(&ptrBatch->gyroY[index], _mm256_srai_epi32(_mm256_unpackhi_epi16(gyroXY, gyroXY), 16), ptrCalibration->scale[1], ptrCalibration->offset[1]);
+		storeScaledAVX2(&ptrBatch->gyroZ[index], _mm256_srai_epi32(_mm256_unpacklo_epi16(gyroZAccelX, gyroZAccelX), 16), ptrCalibration->scale[2], ptrCalibration->offset[2]);
+		storeScaledAVX2(&ptrBatch->accelX[index], _mm256_srai_epi32(_mm256_unpackhi_epi16(gyroZAccelX, gyroZAccelX), 16), ptrCalibration->scale[3], ptrCalibration->offset[3]);
+		storeScaledAVX2(&ptrBatch->accelY[index], _mm256_srai_epi32(_mm256_unpacklo_epi16(accelYZ, accelYZ), 16), ptrCalibration->scale[4], ptrCalibration->offset[4]);
+		storeScaledAVX2(&ptrBatch->accelZ[index], _mm256_srai_epi32(_mm256_unpackhi_epi16(accelYZ, accelYZ), 16), ptrCalibration->scale[5], ptrCalibration->offset[5]);
+
+		_mm256_storeu_si256((__m256i*)&ptrBatch->sensorTimestamp[index], _mm256_unpacklo_epi16(timestamps, _mm256_srli_si256(timestamps, 8)));
+	}
+#endif
+
+#if defined(DS5W_BATCH_NEON)
+	/// <summary>
+	/// Sign extend four int16 lanes, scale them and store as float
+	/// </summary>
+	inline void storeScaledNEON(float* ptrOut, int16x4_t value, float scale, float offset) {
+		vst1q_f32(ptrOut, vmlaq_n_f32(vdupq_n_f32(offset), vcvtq_f32_s32(vmovl_s16(value)), scale));
+	}
+
+	/// <summary>
+	/// Gyro, accelerometer and timestamp of four reports
+	/// </summary>
+	inline void decodeMotionNEON(const unsigned char* const* hid, const DS5W::IMUCalibration* ptrCalibration, DS5W::InputBatch* ptrBatch, unsigned int index) {
+		const int16x8_t r0 = vreinterpretq_s16_u8(vld1q_u8(&hid[0][DS5W_BATCH_OFFSET_MOTION]));
+		const int16x8_t r1 = vreinterpretq_s16_u8(vld1q_u8(&hid[1][DS5W_BATCH_OFFSET_MOTION]));
+		const int16x8_t r2 = vreinterpretq_s16_u8(vld1q_u8(&hid[2][DS5W_BATCH_OFFSET_MOTION]));
+		const int16x8_t r3 = vreinterpretq_s16_u8(vld1q_u8(&hid[3][DS5W_BATCH_OFFSET_MOTION]));
+
+		const int16x8x2_t r01 = vzipq_s16(r0, r1);
+		const int16x8x2_t r23 = vzipq_s16(r2, r3);
+		const int32x4x2_t lo = vzipq_s32(vreinterpretq_s32_s16(r01.val[0]), vreinterpretq_s32_s16(r23.val[0]));
+		const int32x4x2_t hi = vzipq_s32(vreinterpretq_s32_s16(r01.val[1]), vreinterpretq_s32_s16(r23.val[1]));
+		const int16x8_t gyroXY = vreinterpretq_s16_s32(lo.val[0]);
+		const int16x8_t gyroZAccelX = vreinterpretq_s16_s32(lo.val[1]);
+		const int16x8_t accelYZ = vreinterpretq_s16_s32(hi.val[0]);
+		const int16x8_t timestamps = vreinterpretq_s16_s32(hi.val[1]);
+
+		storeScaledNEON(&ptrBatch->gyroX[index], vget_low_s16(gyroXY), ptrCalibration->scale[0], ptrCalibration->offset[0]);
+		storeScaledNEON(&ptrBatch->gyroY[index], vget_high_s16(gyroXY), ptrCalibration->scale[1], ptrCalibration->offset[1]);
+		storeScaledNEON(&ptrBatch->gyroZ[index], vget_low_s16(gyroZAccelX), ptrCalibration->scale[2], ptrCalibration->offset[2]);
+		storeScaledNEON(&ptrBatch->accelX[index], vget_high_s16(gyroZAccelX), ptrCalibration->scale[3], ptrCalibration->offset[3]);
+		storeScaledNEON(&ptrBatch->accelY[index], vget_low_s16(accelYZ), ptrCalibration->scale[4], ptrCalibration->offset[4]);
+		storeScaledNEON(&ptrBatch->accelZ[index], vget_high_s16(accelYZ), ptrCalibration->scale[5], ptrCalibration->offset[5]);
+
+		const int16x4x2_t joined = vzip_s16(vget_low_s16(timestamps), vget_high_s16(timestamps));
+		vst1q_u32(&ptrBatch->sensorTimestamp[index], vreinterpretq_u32_s16(vcombine_s16(joined.val[0], joined.val[1])));
+	}
+#endif
+}
+
+DS5W_API DS5W_ReturnValue DS5W::decodeInputReports(const unsigned char* ptrReports, unsigned int reportStride, unsigned int reportCount, DS5W::DeviceConnection connection, DS5W::InputBatch* ptrBatch, const DS5W::IMUCalibration* ptrCalibration) {
+	// Check pointers
+	if (!ptrBatch || (reportCount && !ptrReports)) {
+		return DS5W_E_INVALID_ARGS;
+	}
+
+	if (!ptrBatch->leftStickX || !ptrBatch->leftStickY || !ptrBatch->rightStickX || !ptrBatch->rightStickY ||
+		!ptrBatch->leftTrigger || !ptrBatch->rightTrigger || !ptrBatch->buttons ||
+		!ptrBatch->gyroX || !ptrBatch->gyroY || !ptrBatch->gyroZ ||
+		!ptrBatch->accelX || !ptrBatch->accelY || !ptrBatch->accelZ || !ptrBatch->sensorTimestamp) {
+		return DS5W_E_INVALID_ARGS;
+	}
+
+	// The payload starts after the report id (and the bluetooth header)
+	const unsigned int payloadOffset = connection == DS5W::DeviceConnection::BT ? 2 : 1;
+	if (reportStride < payloadOffset + DS5W_BATCH_PAYLOAD_SIZE) {
+		return DS5W_E_INVALID_ARGS;
+	}
+
+	// Check capacity
+	ptrBatch->count = 0;
+	if (reportCount > ptrBatch->capacity) {
+		return DS5W_E_INSUFFICIENT_BUFFER;
+	}
+
+	// Fall back to the nominal conversion
+	DS5W::IMUCalibration nominalCalibration;
+	if (!ptrCalibration) {
+		__DS5W::Input::setDefaultCalibration(&nominalCalibration);
+		ptrCalibration = &nominalCalibration;
+	}
+
+	const unsigned char* payload = ptrReports + payloadOffset;
+	unsigned int index = 0;
+
+#if defined(DS5W_BATCH_AVX2)
+	// Eight reports at a time
+	for (; index + 8 <= reportCount; index += 8) {
+		const unsigned char* hid[8];
+		for (unsigned int i = 0; i < 8; i++) {
+			hid[i] = payload + (size_t)(index + i) * reportStride;
+			ptrBatch->buttons[index + i] = packButtons(hid[i]);
+		}
+
+		decodeAxesSSE2(&hid[0], ptrBatch, index);
+		decodeAxesSSE2(&hid[4], ptrBatch, index + 4);
+		decodeMotionAVX2(hid, ptrCalibration, ptrBatch, index);
+	}
+#endif
+
+#if defined(DS5W_BATCH_SSE2) || defined(DS5W_BATCH_NEON)
+	// Four reports at a time
+	for (; index + 4 <= reportCount; index += 4) {
+		const unsigned char* hid[4];
+		for (unsigned int i = 0; i < 4; i++) {
+			hid[i] = payload + (size_t)(index + i) * reportStride;
+			ptrBatch->buttons[index + i] = packButtons(hid[i]);
+		}
+
+#if defined(DS5W_BATCH_SSE2)
+		decodeAxesSSE2(hid, ptrBatch, index);
+		decodeMotionSSE2(hid, ptrCalibration, ptrBatch, index);
+#else
+		for (unsigned int i = 0; i < 4; i++) {
+			decodeAxesScalar(hid[i], ptrBatch, index + i);
+		}
+		decodeMotionNEON(hid, ptrCalibration, ptrBatch, index);
+#endif
+	}
+#endif
+
+	// Remaining reports
+	for (; index < reportCount; index++) {
+		const unsigned char* hid = payload + (size_t)index * reportStride;
+		ptrBatch->buttons[index] = packButtons(hid);
+		decodeAxesScalar(hid, ptrBatch, index);
+		decodeMotionScalar(hid, ptrCalibration, ptrBatch, index);
+	}
+
+	ptrBatch->count = reportCount;
+
+	// Return OK
+	return DS5W_OK;
+}
@@ -1,6 +1,33 @@
 #include "DS5_Input.h"
 
-void __DS5W::Input::evaluateHidInputBuffer(unsigned char* hidInBuffer, DS5W::DS5InputState* ptrInputState) {
+#include <stdlib.h>
+
+namespace {
+	/// <summary>
+	/// Nominal conversion of an uncalibrated device
+	/// </summary>
+	const DS5W::IMUCalibration nominalCalibration = {
+		{ DS5W_GYRO_SCALE, DS5W_GYRO_SCALE, DS5W_GYRO_SCALE, DS5W_ACCEL_SCALE, DS5W_ACCEL_SCALE, DS5W_ACCEL_SCALE },
+		{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+		false,
+	};
+
+	/// <summary>
+	/// Read a little endian signed 16 bit value
+	/// </summary>
+	inline int readInt16(const unsigned char* buffer, unsigned int offset) {
+		return (short)(buffer[offset] | (buffer[offset + 1] << 8));
+	}
+
+	/// <summary>
+	/// Check that a calibrated scale is within a plausible distance to the nominal one
+	/// </summary>
+	inline bool isPlausibleScale(float scale, float nominalScale) {
+		return scale > nominalScale * 0.5f && scale < nominalScale * 2.0f;
+	}
+}
+
+void __DS5W::Input::evaluateHidInputBuffer(unsigned char* hidInBuffer, const DS5W::IMUCalibration* ptrCalibration, unsigned int decodeFlags, DS5W::DS5InputState* ptrInputState) {
 	// Convert sticks to signed range
 	ptrInputState->leftStick.x = (char)(((short)(hidInBuffer[0x00] - 128)));
 	ptrInputState->leftStick.y = (char)(((short)(hidInBuffer[0x01] - 127)) * -1);
@@ -52,40 +79,110 @@ void __DS5W::Input::evaluateHidInputBuffer(unsigned char* hidInBuffer, DS5W::DS5
 		break;
 	}
 
-	// Copy accelerometer readings
-	memcpy(&ptrInputState->accelerometer, &hidInBuffer[0x15], 2 * 3);
+	// Sensor timestamp
+	memcpy(&ptrInputState->sensorTimestamp, &hidInBuffer[0x1B], 4);
+
+	// Motion
+	if (decodeFlags & DS5W_DECODE_MOTION) {
+		// Copy accelerometer readings
+		memcpy(&ptrInputState->accelerometer, &hidInBuffer[0x15], 2 * 3);
 
-	//TEMP: Copy gyro data (no processing currently done!)
-	memcpy(&ptrInputState->gyroscope, &hidInBuffer[0x0F], 2 * 3);
+		//TEMP: Copy gyro data (no processing currently done!)
+		memcpy(&ptrInputState->gyroscope, &hidInBuffer[0x0F], 2 * 3);
 
-	// convert to real units
-	ptrInputState->imuState.gyroX = (float)(ptrInputState->gyroscope.x) * (2000.0 / 32767.0);
-	ptrInputState->imuState.gyroY = (float)(ptrInputState->gyroscope.y) * (2000.0 / 32767.0);
-	ptrInputState->imuState.gyroZ = (float)(ptrInputState->gyroscope.z) * (2000.0 / 32767.0);
+		// convert to real units (calibration is folded into one scale and offset per axis)
+		if (!ptrCalibration) {
+			ptrCalibration = &nominalCalibration;
+		}
+		const float* scale = ptrCalibration->scale;
+		const float* offset = ptrCalibration->offset;
 
-	ptrInputState->imuState.accelX = (float)(ptrInputState->accelerometer.x) / 8192.0;
-	ptrInputState->imuState.accelY = (float)(ptrInputState->accelerometer.y) / 8192.0;
-	ptrInputState->imuState.accelZ = (float)(ptrInputState->accelerometer.z) / 8192.0;
+		ptrInputState->imuState.gyroX = (float)(ptrInputState->gyroscope.x) * scale[0] + offset[0];
+		ptrInputState->imuState.gyroY = (float)(ptrInputState->gyroscope.y) * scale[1] + offset[1];
+		ptrInputState->imuState.gyroZ = (float)(ptrInputState->gyroscope.z) * scale[2] + offset[2];
 
-	// Evaluate touch state 1
-	UINT32 touchpad1Raw = *(UINT32*)(&hidInBuffer[0x20]);
-	ptrInputState->touchPoint1.y = (touchpad1Raw & 0xFFF00000) >> 20;
-	ptrInputState->touchPoint1.x = (touchpad1Raw & 0x000FFF00) >> 8;
+		ptrInputState->imuState.accelX = (float)(ptrInputState->accelerometer.x) * scale[3] + offset[3];
+		ptrInputState->imuState.accelY = (float)(ptrInputState->accelerometer.y) * scale[4] + offset[4];
+		ptrInputState->imuState.accelZ = (float)(ptrInputState->accelerometer.z) * scale[5] + offset[5];
+	}
 
-	// Evaluate touch state 2
-	UINT32 touchpad2Raw = *(UINT32*)(&hidInBuffer[0x24]);
-	ptrInputState->touchPoint2.y = (touchpad2Raw & 0xFFF00000) >> 20;
-	ptrInputState->touchPoint2.x = (touchpad2Raw & 0x000FFF00) >> 8;
+	// Touch
+	if (decodeFlags & DS5W_DECODE_TOUCH) {
+		// Evaluate touch state 1
+		UINT32 touchpad1Raw = *(UINT32*)(&hidInBuffer[0x20]);
+		ptrInputState->touchPoint1.y = (touchpad1Raw & 0xFFF00000) >> 20;
+		ptrInputState->touchPoint1.x = (touchpad1Raw & 0x000FFF00) >> 8;
+		ptrInputState->touchPoint1.down = !(touchpad1Raw & 0x80);
+		ptrInputState->touchPoint1.id = touchpad1Raw & 0x7F;
 
-	// Evaluate headphone input
-	ptrInputState->headPhoneConnected = hidInBuffer[0x35] & 0x01;
+		// Evaluate touch state 2
+		UINT32 touchpad2Raw = *(UINT32*)(&hidInBuffer[0x24]);
+		ptrInputState->touchPoint2.y = (touchpad2Raw & 0xFFF00000) >> 20;
+		ptrInputState->touchPoint2.x = (touchpad2Raw & 0x000FFF00) >> 8;
+		ptrInputState->touchPoint2.down = !(touchpad2Raw & 0x80);
+		ptrInputState->touchPoint2.id = touchpad2Raw & 0x7F;
+	}
 
 	// Trigger force feedback
-	ptrInputState->leftTriggerFeedback = hidInBuffer[0x2A];
-	ptrInputState->rightTriggerFeedback = hidInBuffer[0x29];
+	if (decodeFlags & DS5W_DECODE_TRIGGER_FEEDBACK) {
+		ptrInputState->leftTriggerFeedback = hidInBuffer[0x2A];
+		ptrInputState->rightTriggerFeedback = hidInBuffer[0x29];
+	}
+
+	// Status
+	if (decodeFlags & DS5W_DECODE_STATUS) {
+		// Evaluate headphone input
+		ptrInputState->headPhoneConnected = hidInBuffer[0x35] & 0x01;
+
+		// Battery
+		ptrInputState->battery.chargin = (hidInBuffer[0x35] & 0x08);
+		ptrInputState->battery.fullyCharged = (hidInBuffer[0x36] & 0x20);
+		ptrInputState->battery.level = (hidInBuffer[0x36] & 0x0F);
+	}
+}
+
+void __DS5W::Input::setDefaultCalibration(DS5W::IMUCalibration* ptrCalibration) {
+	*ptrCalibration = nominalCalibration;
+}
+
+bool __DS5W::Input::evaluateCalibrationReport(const unsigned char* featureBuffer, DS5W::IMUCalibration* ptrCalibration) {
+	// Gyro bias and readings at the positive / negative reference speed (pitch = x, yaw = y, roll = z)
+	const int gyroBias[3] = { readInt16(featureBuffer, 0x01), readInt16(featureBuffer, 0x03), readInt16(featureBuffer, 0x05) };
+	const int gyroPlus[3] = { readInt16(featureBuffer, 0x07), readInt16(featureBuffer, 0x0B), readInt16(featureBuffer, 0x0F) };
+	const int gyroMinus[3] = { readInt16(featureBuffer, 0x09), readInt16(featureBuffer, 0x0D), readInt16(featureBuffer, 0x11) };
+
+	// Reference speed in degrees per second (sum of positive and negative)
+	const int gyroSpeed2x = readInt16(featureBuffer, 0x13) + readInt16(featureBuffer, 0x15);
+
+	// Accelerometer readings at +1g / -1g
+	const int accelPlus[3] = { readInt16(featureBuffer, 0x17), readInt16(featureBuffer, 0x1B), readInt16(featureBuffer, 0x1F) };
+	const int accelMinus[3] = { readInt16(featureBuffer, 0x19), readInt16(featureBuffer, 0x1D), readInt16(featureBuffer, 0x21) };
+
+	DS5W::IMUCalibration calibration;
+	for (int axis = 0; axis < 3; axis++) {
+		// Gyro
+		const int gyroRange = abs(gyroPlus[axis] - gyroBias[axis]) + abs(gyroMinus[axis] - gyroBias[axis]);
+		if (gyroRange == 0) {
+			return false;
+		}
+		calibration.scale[axis] = (float)gyroSpeed2x / (float)gyroRange;
+		calibration.offset[axis] = -(float)gyroBias[axis] * calibration.scale[axis];
+
+		// Accelerometer (the range spans 2g)
+		const int accelRange = accelPlus[axis] - accelMinus[axis];
+		if (accelRange == 0) {
+			return false;
+		}
+		calibration.scale[axis + 3] = 2.0f / (float)accelRange;
+		calibration.offset[axis + 3] = -((float)(accelPlus[axis] + accelMinus[axis]) * 0.5f) * calibration.scale[axis + 3];
+
+		// Reject reports that are obviously garbage
+		if (!isPlausibleScale(calibration.scale[axis], DS5W_GYRO_SCALE) || !isPlausibleScale(calibration.scale[axis + 3], DS5W_ACCEL_SCALE)) {
+			return false;
+		}
+	}
 
-	// Battery
-	ptrInputState->battery.chargin = (hidInBuffer[0x35] & 0x08);
-	ptrInputState->battery.fullyCharged = (hidInBuffer[0x36] & 0x20);
-	ptrInputState->battery.level = (hidInBuffer[0x36] & 0x0F);
+	calibration.factoryCalibrated = true;
+	*ptrCalibration = calibration;
+	return true;
 }
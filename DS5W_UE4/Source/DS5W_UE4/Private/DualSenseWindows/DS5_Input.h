@@ -15,14 +15,37 @@
 
 #include "Windows/MinWindows.h"
 
+// Conversion from raw sensor values to real units
+#define DS5W_GYRO_SCALE (2000.0f / 32767.0f)
+#define DS5W_ACCEL_SCALE (1.0f / 8192.0f)
+
+// Battery and headphone flags are refreshed every n-th report when not decoded on every report (~1 s over USB)
+#define DS5W_STATUS_DECODE_INTERVAL 250
+
 namespace __DS5W {
 	namespace Input {
 		/// <summary>
 		/// Interprete the hid returned buffer 
 		/// </summary>
 		/// <param name="hidInBuffer">Input buffer</param>
+		/// <param name="ptrCalibration">IMU conversion of the device (nullptr for the nominal conversion)</param>
+		/// <param name="decodeFlags">Optional fields to decode (DS5W_DECODE_*)</param>
 		/// <param name="ptrInputState">Input state to be set</param>
 		/// <returns></returns>
-		void evaluateHidInputBuffer(unsigned char* hidInBuffer, DS5W::DS5InputState* ptrInputState);
+		void evaluateHidInputBuffer(unsigned char* hidInBuffer, const DS5W::IMUCalibration* ptrCalibration, unsigned int decodeFlags, DS5W::DS5InputState* ptrInputState);
+
+		/// <summary>
+		/// Set the nominal IMU conversion used when no factory calibration is available
+		/// </summary>
+		/// <param name="ptrCalibration">Calibration to be set</param>
+		void setDefaultCalibration(DS5W::IMUCalibration* ptrCalibration);
+
+		/// <summary>
+		/// Interprete the calibration feature report (0x05) and fold it into a scale and offset table
+		/// </summary>
+		/// <param name="featureBuffer">Feature report buffer (starting with the report id)</param>
+		/// <param name="ptrCalibration">Calibration to be set (left untouched if the report is implausible)</param>
+		/// <returns>If the report was valid</returns>
+		bool evaluateCalibrationReport(const unsigned char* featureBuffer, DS5W::IMUCalibration* ptrCalibration);
 	}
 }
\ No newline at end of file
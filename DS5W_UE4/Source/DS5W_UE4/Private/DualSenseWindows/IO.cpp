@@ -190,17 +190,24 @@ DS5W_API DS5W_ReturnValue DS5W::initDeviceContext(DS5W::DeviceEnumInfo* ptrEnumI
 	ptrContext->_internal.connection = ptrEnumInfo->_internal.connection;
 	ptrContext->_internal.deviceHandle = deviceHandle;
 	wcscpy_s(ptrContext->_internal.devicePath, 260, ptrEnumInfo->_internal.path);
+	ptrContext->_internal.decodeFlags = DS5W_DECODE_ALL;
+	ptrContext->_internal.reportCounter = 0;
+
+	// Read the IMU calibration from feature report 5 (on BT this also starts the full input report)
+	__DS5W::Input::setDefaultCalibration(&ptrContext->_internal.imuCalibration);
+	unsigned char fBuffer[64];
+	fBuffer[0] = 0x05;
+	if (HidD_GetFeature(deviceHandle, fBuffer, 64)) {
+		// Keeps the nominal conversion if the report is implausible
+		__DS5W::Input::evaluateCalibrationReport(fBuffer, &ptrContext->_internal.imuCalibration);
+	}
+	else if (ptrContext->_internal.connection == DS5W::DeviceConnection::BT) {
+		return DS5W_E_BT_COM;
+	}
 
 	// Get input report length
 	unsigned short reportLength = 0;
 	if (ptrContext->_internal.connection == DS5W::DeviceConnection::BT) {
-		// Start BT by reading feature report 5
-		unsigned char fBuffer[64];
-		fBuffer[0] = 0x05;
-		if (!HidD_GetFeature(deviceHandle, fBuffer, 64)) {
-			return DS5W_E_BT_COM;
-		}
-		
 		// The bluetooth input report is 78 Bytes long
 		reportLength = 547;
 	}
@@ -271,6 +278,20 @@ DS5W_API DS5W_ReturnValue DS5W::getDeviceInputState(DS5W::DeviceContext* ptrCont
 	// Get the most recent package
 	HidD_FlushQueue(ptrContext->_internal.deviceHandle);
 
+	return DS5W::readDeviceInputState(ptrContext, ptrInputState);
+}
+
+DS5W_API DS5W_ReturnValue DS5W::readDeviceInputState(DS5W::DeviceContext* ptrContext, DS5W::DS5InputState* ptrInputState) {
+	// Check pointer
+	if (!ptrContext || !ptrInputState) {
+		return DS5W_E_INVALID_ARGS;
+	}
+
+	// Check for connection
+	if (!ptrContext->_internal.connected || !ptrContext->_internal.deviceHandle) {
+		return DS5W_E_DEVICE_REMOVED;
+	}
+
 	// Get input report length
 	unsigned short inputReportLength = 0;
 	if (ptrContext->_internal.connection == DS5W::DeviceConnection::BT) {
@@ -296,19 +317,118 @@ DS5W_API DS5W_ReturnValue DS5W::getDeviceInputState(DS5W::DeviceContext* ptrCont
 		return DS5W_E_DEVICE_REMOVED;
 	}
 
+	// Tells waiting for the report apart from decoding it
+	LARGE_INTEGER readCompletion;
+	QueryPerformanceCounter(&readCompletion);
+	ptrContext->_internal.readCompletionTicks = readCompletion.QuadPart;
+
+	// Refresh the cold status fields at a low rate even if nobody asked for them
+	unsigned int decodeFlags = ptrContext->_internal.decodeFlags;
+	if ((ptrContext->_internal.reportCounter++ % DS5W_STATUS_DECODE_INTERVAL) == 0) {
+		decodeFlags |= DS5W_DECODE_STATUS;
+	}
+
 	// Evaluete input buffer
 	if (ptrContext->_internal.connection == DS5W::DeviceConnection::BT) {
 		// Call bluetooth evaluator if connection is qual to BT
-		__DS5W::Input::evaluateHidInputBuffer(&ptrContext->_internal.hidBuffer[2], ptrInputState);
+		__DS5W::Input::evaluateHidInputBuffer(&ptrContext->_internal.hidBuffer[2], &ptrContext->_internal.imuCalibration, decodeFlags, ptrInputState);
 	} else {
 		// Else it is USB so call its evaluator
-		__DS5W::Input::evaluateHidInputBuffer(&ptrContext->_internal.hidBuffer[1], ptrInputState);
+		__DS5W::Input::evaluateHidInputBuffer(&ptrContext->_internal.hidBuffer[1], &ptrContext->_internal.imuCalibration, decodeFlags, ptrInputState);
 	}
 	
 	// Return ok
 	return DS5W_OK;
 }
 
+DS5W_API DS5W_ReturnValue DS5W::readDeviceInputReports(DS5W::DeviceContext* ptrContext, unsigned char* ptrReports, unsigned int reportCapacity, DS5W::InputBatch* ptrBatch, DS5W::DS5InputState* ptrInputState) {
+	// Check pointer
+	if (!ptrContext || !ptrReports || !reportCapacity || !ptrBatch || !ptrInputState) {
+		return DS5W_E_INVALID_ARGS;
+	}
+
+	// Check capacity
+	if (reportCapacity - 1 > ptrBatch->capacity) {
+		return DS5W_E_INSUFFICIENT_BUFFER;
+	}
+
+	// Check for connection
+	if (!ptrContext->_internal.connected || !ptrContext->_internal.deviceHandle) {
+		return DS5W_E_DEVICE_REMOVED;
+	}
+
+	// Get input report length and the offset of the payload
+	unsigned short inputReportLength = 0;
+	unsigned int payloadOffset = 0;
+	if (ptrContext->_internal.connection == DS5W::DeviceConnection::BT) {
+		inputReportLength = 78;
+		payloadOffset = 2;
+		ptrReports[0] = 0x31;
+	}
+	else {
+		inputReportLength = 64;
+		payloadOffset = 1;
+		ptrReports[0] = 0x01;
+	}
+
+	// The HID class driver completes a read with as many queued reports as fit into the buffer, one if none were waiting
+	DWORD bytesRead = 0;
+	if (!ReadFile(ptrContext->_internal.deviceHandle, ptrReports, reportCapacity * inputReportLength, &bytesRead, NULL)) {
+		// Close handle and set error state
+		CloseHandle(ptrContext->_internal.deviceHandle);
+
+		ptrContext->_internal.deviceHandle = NULL;
+		ptrContext->_internal.connected = false;
+
+		// Return error
+		return DS5W_E_DEVICE_REMOVED;
+	}
+
+	// Tells waiting for the reports apart from decoding them
+	LARGE_INTEGER readCompletion;
+	QueryPerformanceCounter(&readCompletion);
+	ptrContext->_internal.readCompletionTicks = readCompletion.QuadPart;
+
+	const unsigned int reportCount = bytesRead / inputReportLength;
+	if (!reportCount) {
+		ptrBatch->count = 0;
+		return DS5W_E_UNKNOWN;
+	}
+
+	// The backlog in one pass
+	const DS5W_ReturnValue batchResult = DS5W::decodeInputReports(ptrReports, inputReportLength, reportCount - 1, ptrContext->_internal.connection, ptrBatch, &ptrContext->_internal.imuCalibration);
+	if (DS5W_FAILED(batchResult)) {
+		return batchResult;
+	}
+
+	// Refresh the cold status fields if their turn came up among the reports read
+	unsigned int decodeFlags = ptrContext->_internal.decodeFlags;
+	const unsigned int statusPhase = ptrContext->_internal.reportCounter % DS5W_STATUS_DECODE_INTERVAL;
+	if (statusPhase == 0 || statusPhase + reportCount > DS5W_STATUS_DECODE_INTERVAL) {
+		decodeFlags |= DS5W_DECODE_STATUS;
+	}
+	ptrContext->_internal.reportCounter += reportCount;
+
+	// Evaluete the newest report
+	__DS5W::Input::evaluateHidInputBuffer(&ptrReports[(size_t)(reportCount - 1) * inputReportLength + payloadOffset], &ptrContext->_internal.imuCalibration, decodeFlags, ptrInputState);
+
+	// Return ok
+	return DS5W_OK;
+}
+
+DS5W_API DS5W_ReturnValue DS5W::setDeviceInputDecodeFlags(DS5W::DeviceContext* ptrContext, unsigned int decodeFlags) {
+	// Check pointer
+	if (!ptrContext) {
+		return DS5W_E_INVALID_ARGS;
+	}
+
+	// Set flags
+	ptrContext->_internal.decodeFlags = decodeFlags & DS5W_DECODE_ALL;
+
+	// Return ok
+	return DS5W_OK;
+}
+
 DS5W_API DS5W_ReturnValue DS5W::setDeviceOutputState(DS5W::DeviceContext* ptrContext, DS5W::DS5OutputState* ptrOutputState) {
 	// Check pointer
 	if (!ptrContext || !ptrOutputState) {
@@ -0,0 +1,56 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WAllocationTracker.h"
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+#include "DS5WTestPatterns.h"
+
+// Frames checked after warming up, the recorded events are dropped every so often to stay within their reserve
+#define DS5W_ALLOCATION_TEST_FRAMES 1200
+#define DS5W_ALLOCATION_TEST_EVENT_RESET_INTERVAL 60
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WAllocationTest, "DS5W.Allocation.SteadyState", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WAllocationTest::RunTest(const FString& Parameters)
+{
+	const bool bWasEnabled = FDS5WAllocationTracker::IsEnabled();
+	FDS5WAllocationTracker::Install();
+
+	const uint64 NumViolationsBefore = FDS5WAllocationTracker::GetNumViolations();
+	{
+		// A wired and a wireless pad, everything decoded and fused
+		FDS5WHeadlessHarness Harness(2);
+		FDS5WPadEmulator* Pads[] = { &Harness.EmulatePad(0, FDS5WPadEmulatorSettings::Usb()), &Harness.EmulatePad(1, FDS5WPadEmulatorSettings::Bluetooth()) };
+		Harness.GetInterface().AddInputConsumer(DS5W_DECODE_ALL);
+
+		// Reports of the warm-up frames warm up the readers as well
+		for (int32 Frame = 0; Frame < DS5W_ALLOCATION_WARMUP + DS5W_ALLOCATION_TEST_FRAMES; ++Frame)
+		{
+			for (FDS5WPadEmulator* Pad : Pads)
+			{
+				Pad->SetState(DS5WTest::MakeMovingState(Harness.GetTime()));
+			}
+
+			if (Frame % DS5W_ALLOCATION_TEST_EVENT_RESET_INTERVAL == 0)
+			{
+				Harness.ResetEvents();
+			}
+
+			Harness.RunFrame();
+		}
+
+		Harness.GetInterface().RemoveInputConsumer(DS5W_DECODE_ALL);
+	}
+
+	// Every steady state scope that allocated was counted and logged with its name
+	TestEqual(TEXT("Allocation scopes that allocated after warming up"), FDS5WAllocationTracker::GetNumViolations() - NumViolationsBefore, (uint64)0);
+
+	FDS5WAllocationTracker::SetEnabled(bWasEnabled);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,138 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WAnalog.h"
+#include "DS5WButtons.h"
+#include "DS5WClockSync.h"
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+#include "Math/RandomStream.h"
+
+// Seconds the stick rests on the press threshold, and how far the reports scatter around it
+#define DS5W_ANALOG_TEST_NOISE_DURATION 2.0
+#define DS5W_ANALOG_TEST_NOISE          5
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WAnalogDefaultsTest, "DS5W.Analog.Defaults", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WAnalogDefaultsTest::RunTest(const FString& Parameters)
+{
+	const FDS5WAnalogSettings Settings;
+	FDS5WAnalogProcessor Processor;
+	Processor.Init(Settings);
+	FDS5WButtonMap ButtonMap;
+	ButtonMap.Build(Settings);
+
+	// Every stick position and trigger value against the plain mapping without deadzone
+	DS5W::DS5InputState State;
+	FMemory::Memzero(State);
+	float MaxStickDifference = 0.f;
+	float MaxTriggerDifference = 0.f;
+	bool bButtonsMatch = true;
+	for (int32 X = -128; X <= 127; ++X)
+	{
+		for (int32 Y = -128; Y <= 127; ++Y)
+		{
+			State.leftStick.x = (char)X;
+			State.leftStick.y = (char)Y;
+			State.rightStick.x = (char)Y;
+			State.rightStick.y = (char)X;
+			State.leftTrigger = (unsigned char)(X + 128);
+			State.rightTrigger = (unsigned char)(Y + 128);
+
+			float Values[DS5W_NUM_ANALOG_AXES];
+			Processor.Process(State, Values);
+
+			const float Expected[] = { (float)X, (float)Y, (float)Y, (float)X };
+			for (int32 Axis = 0; Axis < 4; ++Axis)
+			{
+				MaxStickDifference = FMath::Max(MaxStickDifference, FMath::Abs(Values[Axis] - FMath::GetMappedRangeValueClamped(FVector2D(-127.f, 127.f), FVector2D(-1.f, 1.f), Expected[Axis])));
+			}
+			MaxTriggerDifference = FMath::Max3(MaxTriggerDifference, FMath::Abs(Values[4] - (X + 128) / 255.f), FMath::Abs(Values[5] - (Y + 128) / 255.f));
+
+			// From rest the direction buttons press past the old fixed threshold, each on its own axis
+			const uint32 Word = ButtonMap.GetButtonWord(State, 0);
+			const bool ExpectedDirections[] = { Y > DS5W_LEFT_THUMB_DEADZONE, Y < -DS5W_LEFT_THUMB_DEADZONE, X < -DS5W_LEFT_THUMB_DEADZONE, X > DS5W_LEFT_THUMB_DEADZONE,
+				X > DS5W_RIGHT_THUMB_DEADZONE, X < -DS5W_RIGHT_THUMB_DEADZONE, Y < -DS5W_RIGHT_THUMB_DEADZONE, Y > DS5W_RIGHT_THUMB_DEADZONE };
+			for (int32 Button = 0; Button < UE_ARRAY_COUNT(ExpectedDirections); ++Button)
+			{
+				bButtonsMatch &= ((Word >> (16 + Button)) & 1) == (ExpectedDirections[Button] ? 1u : 0u);
+			}
+			bButtonsMatch &= ((Word >> 10) & 1) == (X + 128 > DS5W_TRIGGER_THRESHOLD ? 1u : 0u);
+			bButtonsMatch &= ((Word >> 11) & 1) == (Y + 128 > DS5W_TRIGGER_THRESHOLD ? 1u : 0u);
+		}
+	}
+
+	TestTrue(FString::Printf(TEXT("Sticks map linearly without deadzone (max difference %g)"), MaxStickDifference), MaxStickDifference <= 1.e-5f);
+	TestTrue(FString::Printf(TEXT("Triggers map linearly without deadzone (max difference %g)"), MaxTriggerDifference), MaxTriggerDifference <= 1.e-5f);
+	TestTrue(TEXT("Direction and trigger buttons press at the previous thresholds"), bButtonsMatch);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WAnalogHysteresisTest, "DS5W.Analog.Hysteresis", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WAnalogHysteresisTest::RunTest(const FString& Parameters)
+{
+	const FDS5WAnalogSettings Settings;
+	const int32 PressThreshold = FMath::RoundToInt(Settings.StickPressThreshold * 127.f);
+	const int32 ReleaseThreshold = FMath::RoundToInt(Settings.StickReleaseThreshold * 127.f);
+	if (!TestTrue(TEXT("Release threshold leaves room for the noise"), PressThreshold - DS5W_ANALOG_TEST_NOISE > ReleaseThreshold))
+	{
+		return false;
+	}
+
+	const double FrameInterval = 1.0 / 60.0;
+	const double ReportInterval = 0.004;
+	FDS5WHeadlessHarness Harness(1, FrameInterval, ReportInterval);
+
+	// A frame at rest connects the controller
+	DS5W::DS5InputState State;
+	FMemory::Memzero(State);
+	const DS5W::DS5InputState* States[] = { &State };
+	Harness.RunFrame(States);
+
+	// The right stick held right on the press threshold, every report a little off in either direction,
+	// then let go. Y stays at rest, the right stick's left and right keys follow X
+	FRandomStream Random(35);
+	const double StartTime = Harness.GetTime();
+	const double ReleaseTime = StartTime + DS5W_ANALOG_TEST_NOISE_DURATION;
+	int32 NumReports = 0;
+	while (Harness.GetTime() < ReleaseTime + 0.5)
+	{
+		while (StartTime + ReportInterval * (NumReports + 1) <= Harness.GetTime() + FrameInterval)
+		{
+			const double ReportTime = StartTime + ReportInterval * ++NumReports;
+			State.rightStick.x = ReportTime < ReleaseTime ? (char)(PressThreshold + Random.RandRange(-DS5W_ANALOG_TEST_NOISE, DS5W_ANALOG_TEST_NOISE)) : 0;
+			State.sensorTimestamp = (uint32)(uint64)(ReportTime * FDS5WClockSync::DeviceTicksPerSecond);
+			Harness.SubmitReport(0, State, ReportTime);
+		}
+
+		Harness.RunFrame();
+	}
+
+	int32 NumPresses[4] = {};
+	int32 NumReleases[4] = {};
+	const FName Keys[] = { FGamepadKeyNames::RightStickRight, FGamepadKeyNames::RightStickLeft, FGamepadKeyNames::RightStickUp, FGamepadKeyNames::RightStickDown };
+	for (const FDS5WRecordedEvent& Event : Harness.GetEvents())
+	{
+		for (int32 Index = 0; Index < UE_ARRAY_COUNT(Keys); ++Index)
+		{
+			if (Event.Key == Keys[Index] && !Event.bIsRepeat)
+			{
+				NumPresses[Index] += Event.Type == EDS5WRecordedEventType::Pressed ? 1 : 0;
+				NumReleases[Index] += Event.Type == EDS5WRecordedEventType::Released ? 1 : 0;
+			}
+		}
+	}
+
+	TestEqual(TEXT("Right stick right pressed once while resting on the threshold"), NumPresses[0], 1);
+	TestEqual(TEXT("Right stick right released once when let go"), NumReleases[0], 1);
+	TestEqual(TEXT("Right stick left never pressed"), NumPresses[1], 0);
+	TestEqual(TEXT("Right stick up never pressed"), NumPresses[2], 0);
+	TestEqual(TEXT("Right stick down never pressed"), NumPresses[3], 0);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,127 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WDeviceReader.h"
+#include "DualSenseWindows/Batch.h"
+#include "DualSenseWindows/DS5_Input.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+// Backlogs of raw reports decoded per connection type, and how often the timing decodes all of them
+#define DS5W_BATCH_DECODE_TEST_BACKLOGS 64
+#define DS5W_BATCH_DECODE_TEST_TIMING_REPEATS 50
+
+namespace
+{
+	/** Fields the batch decodes, as the reader sees them */
+	bool BatchFieldsEqual(const DS5W::DS5InputState& A, const DS5W::DS5InputState& B)
+	{
+		return A.leftStick.x == B.leftStick.x && A.leftStick.y == B.leftStick.y && A.rightStick.x == B.rightStick.x && A.rightStick.y == B.rightStick.y
+			&& A.leftTrigger == B.leftTrigger && A.rightTrigger == B.rightTrigger
+			&& A.buttonsAndDpad == B.buttonsAndDpad && A.buttonsA == B.buttonsA && A.buttonsB == B.buttonsB
+			&& A.imuState.gyroX == B.imuState.gyroX && A.imuState.gyroY == B.imuState.gyroY && A.imuState.gyroZ == B.imuState.gyroZ
+			&& A.imuState.accelX == B.imuState.accelX && A.imuState.accelY == B.imuState.accelY && A.imuState.accelZ == B.imuState.accelZ
+			&& A.sensorTimestamp == B.sensorTimestamp;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WBatchDecodeTest, "DS5W.Batch.Decode", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WBatchDecodeTest::RunTest(const FString& Parameters)
+{
+	const int32 NumBacklogReports = DS5W_READ_BACKLOG_SIZE - 1;
+
+	// A factory calibration that differs per axis, so a mixed up lane shows
+	DS5W::IMUCalibration Calibration;
+	for (int32 Axis = 0; Axis < 6; ++Axis)
+	{
+		Calibration.scale[Axis] = (Axis < 3 ? DS5W_GYRO_SCALE : DS5W_ACCEL_SCALE) * (1.f + 0.01f * Axis);
+		Calibration.offset[Axis] = (Axis < 3 ? 0.5f : 0.005f) * (Axis + 1);
+	}
+	Calibration.factoryCalibrated = true;
+
+	FRandomStream Random(26);
+	TUniquePtr<FDS5WReportBacklog> Backlog = MakeUnique<FDS5WReportBacklog>();
+	for (const bool bBluetooth : { false, true })
+	{
+		const TCHAR* Connection = bBluetooth ? TEXT("Bluetooth") : TEXT("USB");
+		const int32 ReportBytes = bBluetooth ? DS5W_RAW_REPORT_BT_BYTES : DS5W_RAW_REPORT_USB_BYTES;
+		const int32 PayloadOffset = bBluetooth ? 2 : 1;
+
+		// Every byte random, the decoders have to agree on any of them
+		TArray<uint8> Reports;
+		Reports.SetNumUninitialized(DS5W_BATCH_DECODE_TEST_BACKLOGS * NumBacklogReports * ReportBytes);
+		for (uint8& Byte : Reports)
+		{
+			Byte = (uint8)Random.RandHelper(256);
+		}
+
+		// Each backlog against the single report decoder the newest report goes through
+		int32 NumDifferent = 0;
+		for (int32 BacklogIndex = 0; BacklogIndex < DS5W_BATCH_DECODE_TEST_BACKLOGS; ++BacklogIndex)
+		{
+			uint8* const First = &Reports[BacklogIndex * NumBacklogReports * ReportBytes];
+			if (!TestTrue(FString::Printf(TEXT("%s: backlog decoded"), Connection),
+				DS5W_SUCCESS(DS5W::decodeInputReports(First, ReportBytes, NumBacklogReports, bBluetooth ? DS5W::DeviceConnection::BT : DS5W::DeviceConnection::USB, &Backlog->Batch, &Calibration))))
+			{
+				return false;
+			}
+
+			for (int32 Index = 0; Index < NumBacklogReports; ++Index)
+			{
+				DS5W::DS5InputState Expected;
+				DS5W::DS5InputState Batched;
+				FMemory::Memzero(Expected);
+				FMemory::Memzero(Batched);
+				__DS5W::Input::evaluateHidInputBuffer(First + Index * ReportBytes + PayloadOffset, &Calibration, DS5W_DECODE_MOTION, &Expected);
+				Backlog->GetInputState(Index, Batched);
+				NumDifferent += BatchFieldsEqual(Expected, Batched) ? 0 : 1;
+			}
+		}
+		TestEqual(FString::Printf(TEXT("%s: batch decodes every report like the single report decoder"), Connection), NumDifferent, 0);
+
+		// Reported, not checked: timings depend on the machine
+		uint64 BatchCycles = 0;
+		uint64 SingleCycles = 0;
+		uint64 Checksum = 0;
+		DS5W::DS5InputState State;
+		FMemory::Memzero(State);
+		for (int32 Repeat = 0; Repeat < DS5W_BATCH_DECODE_TEST_TIMING_REPEATS; ++Repeat)
+		{
+			const uint64 BatchStartCycles = FPlatformTime::Cycles64();
+			for (int32 BacklogIndex = 0; BacklogIndex < DS5W_BATCH_DECODE_TEST_BACKLOGS; ++BacklogIndex)
+			{
+				DS5W::decodeInputReports(&Reports[BacklogIndex * NumBacklogReports * ReportBytes], ReportBytes, NumBacklogReports, bBluetooth ? DS5W::DeviceConnection::BT : DS5W::DeviceConnection::USB, &Backlog->Batch, &Calibration);
+				Checksum += Backlog->SensorTimestamp[BacklogIndex % NumBacklogReports];
+			}
+			BatchCycles += FPlatformTime::Cycles64() - BatchStartCycles;
+
+			const uint64 SingleStartCycles = FPlatformTime::Cycles64();
+			for (int32 Report = 0; Report < DS5W_BATCH_DECODE_TEST_BACKLOGS * NumBacklogReports; ++Report)
+			{
+				__DS5W::Input::evaluateHidInputBuffer(&Reports[Report * ReportBytes + PayloadOffset], &Calibration, DS5W_DECODE_MOTION, &State);
+				Checksum += State.sensorTimestamp;
+			}
+			SingleCycles += FPlatformTime::Cycles64() - SingleStartCycles;
+		}
+
+		const double NumDecoded = (double)DS5W_BATCH_DECODE_TEST_BACKLOGS * NumBacklogReports * DS5W_BATCH_DECODE_TEST_TIMING_REPEATS;
+		AddInfo(FString::Printf(TEXT("%s: batch %.1f M reports/s, one at a time %.1f M reports/s, backlogs of %d reports (%llu)"), Connection,
+			NumDecoded / FPlatformTime::ToSeconds64(FMath::Max<uint64>(BatchCycles, 1)) * 1.e-6, NumDecoded / FPlatformTime::ToSeconds64(FMath::Max<uint64>(SingleCycles, 1)) * 1.e-6,
+			NumBacklogReports, Checksum));
+	}
+
+	// Arguments the decoder refuses, without touching the batch arrays
+	uint8 Report[DS5W_RAW_REPORT_USB_BYTES] = {};
+	TestTrue(TEXT("More reports than the batch holds are refused"),
+		DS5W::decodeInputReports(Report, DS5W_RAW_REPORT_USB_BYTES, NumBacklogReports + 1, DS5W::DeviceConnection::USB, &Backlog->Batch, &Calibration) == DS5W_E_INSUFFICIENT_BUFFER && Backlog->Batch.count == 0);
+	TestTrue(TEXT("A stride shorter than the decoded fields is refused"),
+		DS5W::decodeInputReports(Report, 16, 1, DS5W::DeviceConnection::USB, &Backlog->Batch, &Calibration) == DS5W_E_INVALID_ARGS);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,114 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WClockSync.h"
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+
+namespace
+{
+	/** A button held on a controller over reports [FirstReport, LastReport) of the frame */
+	struct FButtonTap
+	{
+		int32 ControllerId;
+		uint8 Button;
+		FName Key;
+		int32 FirstReport;
+		int32 LastReport;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WButtonEdgeTest, "DS5W.Buttons.SubFrameEdges", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WButtonEdgeTest::RunTest(const FString& Parameters)
+{
+	const double FrameInterval = 1.0 / 60.0;
+	const double ReportInterval = 0.001;
+	const int32 NumReports = 16;
+	FDS5WHeadlessHarness Harness(2, FrameInterval, ReportInterval);
+
+	// One frame of released buttons connects both controllers
+	DS5W::DS5InputState Idle;
+	FMemory::Memzero(Idle);
+	const DS5W::DS5InputState* States[] = { &Idle, &Idle };
+	Harness.RunFrame(States);
+	Harness.ResetEvents();
+
+	// Taps shorter than a frame, interleaved between the controllers
+	const FButtonTap Taps[] =
+	{
+		{ 0, DS5W_ISTATE_BTX_CROSS, FGamepadKeyNames::FaceButtonBottom, 2, 5 },
+		{ 1, DS5W_ISTATE_BTX_CIRCLE, FGamepadKeyNames::FaceButtonRight, 3, 8 },
+		{ 0, DS5W_ISTATE_BTX_SQUARE, FGamepadKeyNames::FaceButtonLeft, 10, 12 },
+	};
+
+	// Each controller's reports go in at once, like readers running ahead of the game thread
+	const double FrameStart = Harness.GetTime();
+	for (int32 ControllerId = 0; ControllerId < 2; ++ControllerId)
+	{
+		for (int32 Report = 1; Report <= NumReports; ++Report)
+		{
+			const double CaptureTime = FrameStart + ReportInterval * Report;
+			DS5W::DS5InputState State = Idle;
+			State.sensorTimestamp = (uint32)(uint64)(CaptureTime * FDS5WClockSync::DeviceTicksPerSecond);
+			for (const FButtonTap& Tap : Taps)
+			{
+				if (Tap.ControllerId == ControllerId && Report >= Tap.FirstReport && Report < Tap.LastReport)
+				{
+					State.buttonsAndDpad |= Tap.Button;
+				}
+			}
+			Harness.SubmitReport(ControllerId, State, CaptureTime);
+		}
+	}
+	Harness.RunFrame();
+
+	// Every edge arrives in capture order across the controllers, stamped with its report's time
+	struct FExpectedEdge
+	{
+		const FButtonTap* Tap;
+		bool bPressed;
+		int32 Report;
+	};
+	TArray<FExpectedEdge> Expected;
+	for (const FButtonTap& Tap : Taps)
+	{
+		Expected.Add({ &Tap, true, Tap.FirstReport });
+		Expected.Add({ &Tap, false, Tap.LastReport });
+	}
+	Expected.StableSort([](const FExpectedEdge& A, const FExpectedEdge& B) { return A.Report < B.Report; });
+
+	TArray<const FDS5WRecordedEvent*> Edges;
+	for (const FDS5WRecordedEvent& Event : Harness.GetEvents())
+	{
+		if (Event.Type != EDS5WRecordedEventType::Analog && !Event.bIsRepeat)
+		{
+			Edges.Add(&Event);
+		}
+	}
+
+	if (!TestEqual(TEXT("Every press and release sent"), Edges.Num(), Expected.Num()))
+	{
+		for (const FDS5WRecordedEvent* Edge : Edges)
+		{
+			AddInfo(Edge->ToString());
+		}
+		return false;
+	}
+
+	for (int32 Index = 0; Index < Edges.Num(); ++Index)
+	{
+		const FDS5WRecordedEvent& Edge = *Edges[Index];
+		const FExpectedEdge& ExpectedEdge = Expected[Index];
+		const FString What = FString::Printf(TEXT("Edge %d (%s %s on controller %d)"), Index, *ExpectedEdge.Tap->Key.ToString(), ExpectedEdge.bPressed ? TEXT("pressed") : TEXT("released"), ExpectedEdge.Tap->ControllerId);
+		TestTrue(What + TEXT(" in order"), Edge.Key == ExpectedEdge.Tap->Key && Edge.ControllerId == ExpectedEdge.Tap->ControllerId && (Edge.Type == EDS5WRecordedEventType::Pressed) == ExpectedEdge.bPressed);
+		TestEqual(What + TEXT(" input time"), Edge.InputTime, FrameStart + ReportInterval * ExpectedEdge.Report);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
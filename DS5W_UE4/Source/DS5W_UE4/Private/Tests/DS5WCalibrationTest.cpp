@@ -0,0 +1,128 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DualSenseWindows/DS5_Input.h"
+
+namespace
+{
+	/** Raw values of a calibration feature report (0x05), per axis x, y, z */
+	struct FCalibrationReportValues
+	{
+		int32 GyroBias[3];
+		int32 GyroPlus[3];
+		int32 GyroMinus[3];
+		int32 GyroSpeedPlus;
+		int32 GyroSpeedMinus;
+		int32 AccelPlus[3];
+		int32 AccelMinus[3];
+	};
+
+	/** Little endian 16 bit value at Offset */
+	void WriteCalibrationValue(uint8* Report, int32 Offset, int32 Value)
+	{
+		Report[Offset] = (uint8)(Value & 0xFF);
+		Report[Offset + 1] = (uint8)((Value >> 8) & 0xFF);
+	}
+
+	/** Lay the values out like the controller does, starting with the report id */
+	void WriteCalibrationReport(const FCalibrationReportValues& Values, uint8 (&OutReport)[64])
+	{
+		FMemory::Memzero(OutReport);
+		OutReport[0] = 0x05;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			WriteCalibrationValue(OutReport, 0x01 + 2 * Axis, Values.GyroBias[Axis]);
+			WriteCalibrationValue(OutReport, 0x07 + 4 * Axis, Values.GyroPlus[Axis]);
+			WriteCalibrationValue(OutReport, 0x09 + 4 * Axis, Values.GyroMinus[Axis]);
+			WriteCalibrationValue(OutReport, 0x17 + 4 * Axis, Values.AccelPlus[Axis]);
+			WriteCalibrationValue(OutReport, 0x19 + 4 * Axis, Values.AccelMinus[Axis]);
+		}
+		WriteCalibrationValue(OutReport, 0x13, Values.GyroSpeedPlus);
+		WriteCalibrationValue(OutReport, 0x15, Values.GyroSpeedMinus);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WCalibrationTest, "DS5W.Calibration.Report", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WCalibrationTest::RunTest(const FString& Parameters)
+{
+	// Close to a real controller: the gyro reads about 8850 either side of its bias at 540 deg/s, the
+	// accelerometer about 8190 either side of its center at 1 g
+	const FCalibrationReportValues Values =
+	{
+		{ 12, -7, 3 },
+		{ 8862, 8843, 8803 },
+		{ -8838, -8857, -8847 },
+		540, 540,
+		{ 8250, 8160, 8200 },
+		{ -8130, -8224, -8184 },
+	};
+	uint8 Report[64];
+	WriteCalibrationReport(Values, Report);
+
+	// Twice the reference speed over the readings' spread, bias and center scaled away
+	const float ExpectedScale[6] = { 1080.f / 17700.f, 1080.f / 17700.f, 1080.f / 17650.f, 2.f / 16380.f, 2.f / 16384.f, 2.f / 16384.f };
+	const float ExpectedOffset[6] = { -12.f * ExpectedScale[0], 7.f * ExpectedScale[1], -3.f * ExpectedScale[2], -60.f * ExpectedScale[3], 32.f * ExpectedScale[4], -8.f * ExpectedScale[5] };
+
+	DS5W::IMUCalibration Calibration;
+	__DS5W::Input::setDefaultCalibration(&Calibration);
+	if (!TestTrue(TEXT("Plausible report accepted"), __DS5W::Input::evaluateCalibrationReport(Report, &Calibration)))
+	{
+		return false;
+	}
+	TestTrue(TEXT("Marked as factory calibrated"), Calibration.factoryCalibrated);
+	for (int32 Axis = 0; Axis < 6; ++Axis)
+	{
+		TestTrue(FString::Printf(TEXT("Axis %d scale %g is %g"), Axis, Calibration.scale[Axis], ExpectedScale[Axis]), FMath::IsNearlyEqual(Calibration.scale[Axis], ExpectedScale[Axis], ExpectedScale[Axis] * 1.e-5f));
+		TestTrue(FString::Printf(TEXT("Axis %d offset %g is %g"), Axis, Calibration.offset[Axis], ExpectedOffset[Axis]), FMath::IsNearlyEqual(Calibration.offset[Axis], ExpectedOffset[Axis], 1.e-6f));
+	}
+
+	// Decoding with it: the bias reads zero, the reference readings the reference speed and 1 g
+	uint8 Input[64] = {};
+	WriteCalibrationValue(Input, 0x0F, Values.GyroBias[0]);
+	WriteCalibrationValue(Input, 0x11, Values.GyroPlus[1]);
+	WriteCalibrationValue(Input, 0x15, Values.AccelPlus[0]);
+	WriteCalibrationValue(Input, 0x17, Values.AccelMinus[1]);
+	DS5W::DS5InputState State;
+	FMemory::Memzero(State);
+	__DS5W::Input::evaluateHidInputBuffer(Input, &Calibration, DS5W_DECODE_MOTION, &State);
+	TestTrue(FString::Printf(TEXT("Gyro bias reads 0 deg/s (%g)"), State.imuState.gyroX), FMath::IsNearlyZero(State.imuState.gyroX, 1.e-4f));
+	TestTrue(FString::Printf(TEXT("Gyro reference reads 540 deg/s (%g)"), State.imuState.gyroY), FMath::IsNearlyEqual(State.imuState.gyroY, 540.f, 1.e-2f));
+	TestTrue(FString::Printf(TEXT("Accelerometer reads +1 g (%g)"), State.imuState.accelX), FMath::IsNearlyEqual(State.imuState.accelX, 1.f, 1.e-5f));
+	TestTrue(FString::Printf(TEXT("Accelerometer reads -1 g (%g)"), State.imuState.accelY), FMath::IsNearlyEqual(State.imuState.accelY, -1.f, 1.e-5f));
+
+	// Reports outside 0.5x to 2x of the nominal scale, or without any spread, leave the nominal conversion in place
+	struct FBrokenReport
+	{
+		const TCHAR* Name;
+		FCalibrationReportValues Values;
+	};
+	FBrokenReport BrokenReports[] = { { TEXT("gyro scale too large"), Values }, { TEXT("accelerometer scale too small"), Values }, { TEXT("no gyro spread"), Values } };
+	BrokenReports[0].Values.GyroPlus[1] = Values.GyroBias[1] + 10;
+	BrokenReports[0].Values.GyroMinus[1] = Values.GyroBias[1] - 10;
+	BrokenReports[1].Values.AccelPlus[2] = 30000;
+	BrokenReports[1].Values.AccelMinus[2] = -30000;
+	BrokenReports[2].Values.GyroPlus[0] = Values.GyroBias[0];
+	BrokenReports[2].Values.GyroMinus[0] = Values.GyroBias[0];
+
+	for (const FBrokenReport& Broken : BrokenReports)
+	{
+		WriteCalibrationReport(Broken.Values, Report);
+		__DS5W::Input::setDefaultCalibration(&Calibration);
+		TestFalse(FString::Printf(TEXT("%s: rejected"), Broken.Name), __DS5W::Input::evaluateCalibrationReport(Report, &Calibration));
+
+		bool bNominal = !Calibration.factoryCalibrated;
+		for (int32 Axis = 0; Axis < 6; ++Axis)
+		{
+			bNominal &= Calibration.scale[Axis] == (Axis < 3 ? DS5W_GYRO_SCALE : DS5W_ACCEL_SCALE) && Calibration.offset[Axis] == 0.f;
+		}
+		TestTrue(FString::Printf(TEXT("%s: nominal conversion kept"), Broken.Name), bNominal);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
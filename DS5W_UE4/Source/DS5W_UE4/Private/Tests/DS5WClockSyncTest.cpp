@@ -0,0 +1,88 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WClockSync.h"
+#include "Math/RandomStream.h"
+
+// Seconds of reports, when the device counter restarts, and how long the mapping may take to settle
+#define DS5W_CLOCK_SYNC_TEST_DURATION 40.0
+#define DS5W_CLOCK_SYNC_TEST_RESTART  20.0
+#define DS5W_CLOCK_SYNC_TEST_SETTLE   1.5
+
+// Transport latency is this at least, plus up to the jitter on top, mostly little of it
+#define DS5W_CLOCK_SYNC_TEST_MIN_LATENCY 0.0005
+#define DS5W_CLOCK_SYNC_TEST_JITTER      0.003
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WClockSyncTest, "DS5W.ClockSync", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WClockSyncTest::RunTest(const FString& Parameters)
+{
+	const double HostStart = 1000.0;
+	const double ReportInterval = 0.004;
+
+	// The counter wraps one second in, the restart begins counting near zero
+	const uint32 TimestampBase = MAX_uint32 - (uint32)FDS5WClockSync::DeviceTicksPerSecond;
+	const uint32 RestartBase = 12345;
+
+	for (const double DriftPpm : { 200.0, -300.0 })
+	{
+		FDS5WClockSync ClockSync;
+		ClockSync.Reset();
+		FRandomStream Random(27);
+
+		double LastCaptureTime = 0.0;
+		double LastDeviceTime = 0.0;
+		double MaxSettledError = 0.0;
+		double MaxError = 0.0;
+		int32 NumDecreasing = 0;
+		int32 NumAfterArrival = 0;
+		int32 NumDeviceTimeBack = 0;
+		for (int32 Report = 0; Report * ReportInterval < DS5W_CLOCK_SYNC_TEST_DURATION; ++Report)
+		{
+			const double Time = Report * ReportInterval;
+			const double CaptureTime = HostStart + Time;
+			const double ArrivalTime = CaptureTime + DS5W_CLOCK_SYNC_TEST_MIN_LATENCY + DS5W_CLOCK_SYNC_TEST_JITTER * FMath::Square(Random.FRand());
+
+			// The device oscillator runs off by DriftPpm against the host clock
+			const bool bRestarted = Time >= DS5W_CLOCK_SYNC_TEST_RESTART;
+			const double DeviceSeconds = (bRestarted ? Time - DS5W_CLOCK_SYNC_TEST_RESTART : Time) * (1.0 + DriftPpm * 1.e-6);
+			const uint32 Timestamp = (bRestarted ? RestartBase : TimestampBase) + (uint32)(uint64)(DeviceSeconds * FDS5WClockSync::DeviceTicksPerSecond);
+
+			const double MappedTime = ClockSync.AddSample(Timestamp, ArrivalTime);
+			NumDecreasing += MappedTime < LastCaptureTime ? 1 : 0;
+			NumAfterArrival += MappedTime > ArrivalTime ? 1 : 0;
+			LastCaptureTime = MappedTime;
+
+			// Unwrapped device time keeps counting through the wraparound
+			if (!bRestarted)
+			{
+				NumDeviceTimeBack += ClockSync.GetLastDeviceTime() < LastDeviceTime ? 1 : 0;
+				LastDeviceTime = ClockSync.GetLastDeviceTime();
+			}
+
+			// Once settled, the mapping lands on the capture plus the latency every report has, which it can't see
+			const double Error = MappedTime - CaptureTime;
+			MaxError = FMath::Max(MaxError, FMath::Abs(Error));
+			const bool bSettled = Time >= DS5W_CLOCK_SYNC_TEST_SETTLE && (Time < DS5W_CLOCK_SYNC_TEST_RESTART || Time >= DS5W_CLOCK_SYNC_TEST_RESTART + DS5W_CLOCK_SYNC_TEST_SETTLE);
+			if (bSettled)
+			{
+				MaxSettledError = FMath::Max(MaxSettledError, FMath::Abs(Error - DS5W_CLOCK_SYNC_TEST_MIN_LATENCY));
+			}
+		}
+
+		const FString Drift = FString::Printf(TEXT("%+.0f ppm"), DriftPpm);
+		TestEqual(Drift + TEXT(": capture times never decrease"), NumDecreasing, 0);
+		TestEqual(Drift + TEXT(": capture times never after arrival"), NumAfterArrival, 0);
+		TestEqual(Drift + TEXT(": device time unwrapped across the wraparound"), NumDeviceTimeBack, 0);
+		TestTrue(FString::Printf(TEXT("%s: settled capture times within 0.1 ms (%.3f ms)"), *Drift, MaxSettledError * 1.e3), MaxSettledError <= 0.0001);
+		TestTrue(FString::Printf(TEXT("%s: capture times within the latency before settling (%.3f ms)"), *Drift, MaxError * 1.e3),
+			MaxError <= DS5W_CLOCK_SYNC_TEST_MIN_LATENCY + DS5W_CLOCK_SYNC_TEST_JITTER);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
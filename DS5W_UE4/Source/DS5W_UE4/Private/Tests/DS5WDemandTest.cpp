@@ -0,0 +1,94 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+#include "DS5WStats.h"
+#include "DS5WTestPatterns.h"
+
+// Frames per phase at 60 Hz, and how long a motion query keeps motion decoded (DS5W_QUERY_DEMAND_TIMEOUT)
+#define DS5W_DEMAND_TEST_FRAMES        120
+#define DS5W_DEMAND_TEST_QUERY_TIMEOUT 2.0
+
+namespace
+{
+	/** Fusions and mean frame time over some frames of a pad moving like the common pattern */
+	struct FDemandPhase
+	{
+		uint64 NumFusions = 0;
+		double MeanFrameSeconds = 0.0;
+	};
+
+	FDemandPhase RunPhase(FDS5WHeadlessHarness& Harness, FDS5WPadEmulator& Pad, int32 NumFrames)
+	{
+		const FDS5WHistogram& Fusion = Harness.GetInterface().GetControllerStats(0)->Fusion;
+		const uint64 NumFusionsBefore = Fusion.GetCount();
+
+		double Seconds = 0.0;
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			Pad.SetState(DS5WTest::MakeMovingState(Harness.GetTime()));
+			Seconds += Harness.RunFrame().Seconds;
+			Harness.ResetEvents();
+		}
+
+		FDemandPhase Phase;
+		Phase.NumFusions = Fusion.GetCount() - NumFusionsBefore;
+		Phase.MeanFrameSeconds = Seconds / NumFrames;
+		return Phase;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WMotionDemandTest, "DS5W.Demand.Motion", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WMotionDemandTest::RunTest(const FString& Parameters)
+{
+	FDS5WHeadlessHarness Harness(1);
+	FDS5WPadEmulator& Pad = Harness.EmulatePad(0, FDS5WPadEmulatorSettings::Usb());
+	FDS5WInterface& Interface = Harness.GetInterface();
+
+	// Nothing reads motion: the first frame only connects the pad, none of them fuses
+	RunPhase(Harness, Pad, 1);
+	const FDemandPhase Unconsumed = RunPhase(Harness, Pad, DS5W_DEMAND_TEST_FRAMES);
+	if (Unconsumed.NumFusions > 0)
+	{
+		AddWarning(TEXT("Motion keys are bound in the project's input settings, skipped the demand checks"));
+		return true;
+	}
+
+	// A consumer fuses every frame that brought reports, and stops right after it is removed
+	Interface.AddInputConsumer(DS5W_DECODE_MOTION);
+	const FDemandPhase Consumed = RunPhase(Harness, Pad, DS5W_DEMAND_TEST_FRAMES);
+	Interface.RemoveInputConsumer(DS5W_DECODE_MOTION);
+	TestTrue(FString::Printf(TEXT("Consumer fuses every frame (%llu of %d)"), Consumed.NumFusions, DS5W_DEMAND_TEST_FRAMES), Consumed.NumFusions >= DS5W_DEMAND_TEST_FRAMES - 1);
+	TestEqual(TEXT("No fusion after the consumer left"), (int32)RunPhase(Harness, Pad, DS5W_DEMAND_TEST_FRAMES).NumFusions, 0);
+
+	// Each motion query counts as a consumer for a while
+	auto CheckQuery = [this, &Harness, &Pad](const TCHAR* Name, TFunctionRef<void()> Query)
+	{
+		Query();
+
+		// A few frames short of the timeout fuse, a few frames past it none do
+		const int32 NumQueriedFrames = FMath::RoundToInt(DS5W_DEMAND_TEST_QUERY_TIMEOUT * 60.0) - 6;
+		const FDemandPhase Queried = RunPhase(Harness, Pad, NumQueriedFrames);
+		TestTrue(FString::Printf(TEXT("%s keeps motion fused (%llu of %d frames)"), Name, Queried.NumFusions, NumQueriedFrames), Queried.NumFusions >= (uint64)NumQueriedFrames - 1);
+
+		RunPhase(Harness, Pad, 12);
+		TestEqual(FString::Printf(TEXT("%s demand times out"), Name), (int32)RunPhase(Harness, Pad, DS5W_DEMAND_TEST_FRAMES).NumFusions, 0);
+	};
+
+	FQuat Orientation;
+	double Time;
+	CheckQuery(TEXT("GetOrientation"), [&]() { Interface.GetOrientation(0, Orientation); });
+	CheckQuery(TEXT("GetLatestOrientation"), [&]() { Interface.GetLatestOrientation(0, Orientation, Time); });
+	CheckQuery(TEXT("GetGyroDeltaSince"), [&]() { Interface.GetGyroDeltaSince(0, Harness.GetTime(), Orientation, Time); });
+
+	// Reported, not checked: what skipping the fusion saves depends on the machine
+	AddInfo(FString::Printf(TEXT("Frame time %.2f us with a motion consumer, %.2f us without"), Consumed.MeanFrameSeconds * 1.e6, Unconsumed.MeanFrameSeconds * 1.e6));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,159 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+#include "DS5WTestPatterns.h"
+
+// Frames before the measurement (connects and fills the queues), and frames measured per controller count
+#define DS5W_FRAME_COST_TEST_WARMUP 60
+#define DS5W_FRAME_COST_TEST_FRAMES 600
+
+// Frames measured after evicting the caches, and the bytes written to evict them (more than a last level cache)
+#define DS5W_FRAME_COST_TEST_COLD_FRAMES 120
+#define DS5W_FRAME_COST_TEST_EVICT_BYTES (32 * 1024 * 1024)
+
+// Cache line stride of the eviction writes
+#define DS5W_FRAME_COST_TEST_EVICT_STRIDE 64
+
+namespace
+{
+	/** Mean, median and 99th percentile of the frame cycles, sorts them */
+	FString DescribeFrameCycles(TArray<uint64>& Cycles)
+	{
+		Cycles.Sort();
+		uint64 Total = 0;
+		for (const uint64 FrameCycles : Cycles)
+		{
+			Total += FrameCycles;
+		}
+		return FString::Printf(TEXT("%llu cycles per frame, p50 %llu, p99 %llu"), Total / FMath::Max(Cycles.Num(), 1), Cycles[Cycles.Num() / 2], Cycles[Cycles.Num() * 99 / 100]);
+	}
+}
+
+/**
+ * What a frame costs the game thread with 0 to MAX_NUM_DS5W_CONTROLLERS controllers sending input.
+ *
+ * The warm frames run back to back. Before each cold frame the caches are evicted, like the rest of a game
+ * frame does between two dispatches, so the cold cycles follow the cache lines the dispatch touches. That is
+ * what the hot/cold split of the controller state (FControllerHotState, FControllerState, FControllerConfig)
+ * is for: empty and disconnected slots only read their line of the hot array. To compare against the
+ * single array layout from before the split, carry the harness back to it (the harness came later), run this
+ * test on both layouts under `perf stat -e cycles,cache-misses,L1-dcache-load-misses` (a VTune memory access
+ * analysis on Windows) and compare the cold cycles and misses per controller count.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WFrameCostTest, "DS5W.Controllers.FrameCost", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WFrameCostTest::RunTest(const FString& Parameters)
+{
+	TArray<uint8> EvictBuffer;
+	EvictBuffer.SetNumZeroed(DS5W_FRAME_COST_TEST_EVICT_BYTES);
+
+	for (int32 NumConnected = 0; NumConnected <= MAX_NUM_DS5W_CONTROLLERS; ++NumConnected)
+	{
+		// Every slot exists, the first NumConnected get reports, everything is decoded
+		FDS5WHeadlessHarness Harness(MAX_NUM_DS5W_CONTROLLERS);
+		Harness.GetInterface().AddInputConsumer(DS5W_DECODE_ALL);
+
+		DS5W::DS5InputState States[MAX_NUM_DS5W_CONTROLLERS];
+		const DS5W::DS5InputState* StatePointers[MAX_NUM_DS5W_CONTROLLERS];
+		auto RunFrame = [&](int32 NumSending)
+		{
+			for (int32 ControllerId = 0; ControllerId < MAX_NUM_DS5W_CONTROLLERS; ++ControllerId)
+			{
+				// Out of phase so the controllers don't all change in the same frames
+				States[ControllerId] = DS5WTest::MakeMovingState(Harness.GetTime() + 0.05 * ControllerId);
+				StatePointers[ControllerId] = ControllerId < NumSending ? &States[ControllerId] : nullptr;
+			}
+			return Harness.RunFrame(StatePointers);
+		};
+
+		for (int32 Frame = 0; Frame < DS5W_FRAME_COST_TEST_WARMUP; ++Frame)
+		{
+			RunFrame(NumConnected);
+		}
+		Harness.ResetEvents();
+
+		double TotalSeconds = 0.0;
+		TArray<double> FrameSeconds;
+		TArray<uint64> FrameCycles;
+		FrameSeconds.Reserve(DS5W_FRAME_COST_TEST_FRAMES);
+		FrameCycles.Reserve(DS5W_FRAME_COST_TEST_FRAMES);
+		int32 NumEvents[MAX_NUM_DS5W_CONTROLLERS] = {};
+		for (int32 Frame = 0; Frame < DS5W_FRAME_COST_TEST_FRAMES; ++Frame)
+		{
+			const FDS5WHarnessFrameStats& Stats = RunFrame(NumConnected);
+			TotalSeconds += Stats.Seconds;
+			FrameSeconds.Add(Stats.Seconds);
+			FrameCycles.Add(Stats.Cycles);
+
+			for (const FDS5WRecordedEvent& Event : Harness.GetEvents())
+			{
+				++NumEvents[Event.ControllerId];
+			}
+			Harness.ResetEvents();
+		}
+
+		// Connected controllers send their input, empty slots stay quiet
+		for (int32 ControllerId = 0; ControllerId < MAX_NUM_DS5W_CONTROLLERS; ++ControllerId)
+		{
+			if (ControllerId < NumConnected)
+			{
+				TestTrue(FString::Printf(TEXT("%d connected: controller %d sends events"), NumConnected, ControllerId), NumEvents[ControllerId] > 0);
+			}
+			else
+			{
+				TestEqual(FString::Printf(TEXT("%d connected: empty slot %d sends nothing"), NumConnected, ControllerId), NumEvents[ControllerId], 0);
+			}
+		}
+
+		TArray<uint64> ColdFrameCycles;
+		ColdFrameCycles.Reserve(DS5W_FRAME_COST_TEST_COLD_FRAMES);
+		for (int32 Frame = 0; Frame < DS5W_FRAME_COST_TEST_COLD_FRAMES; ++Frame)
+		{
+			for (int32 Offset = 0; Offset < EvictBuffer.Num(); Offset += DS5W_FRAME_COST_TEST_EVICT_STRIDE)
+			{
+				++EvictBuffer[Offset];
+			}
+			ColdFrameCycles.Add(RunFrame(NumConnected).Cycles);
+			Harness.ResetEvents();
+		}
+
+		// A controller going away sends its releases in one frame and nothing after
+		if (NumConnected > 0)
+		{
+			const int32 Leaving = NumConnected - 1;
+			Harness.Disconnect(Leaving);
+
+			int32 NumFramesWithEvents = 0;
+			for (int32 Frame = 0; Frame < DS5W_FRAME_COST_TEST_WARMUP; ++Frame)
+			{
+				RunFrame(Leaving);
+				bool bSentEvents = false;
+				for (const FDS5WRecordedEvent& Event : Harness.GetEvents())
+				{
+					bSentEvents |= Event.ControllerId == Leaving;
+				}
+				NumFramesWithEvents += bSentEvents ? 1 : 0;
+				Harness.ResetEvents();
+			}
+			TestEqual(FString::Printf(TEXT("%d connected: controller %d sends its releases once after disconnecting"), Leaving + 1, Leaving), NumFramesWithEvents, 1);
+		}
+
+		// Reported, not checked: timings depend on the machine
+		FrameSeconds.Sort();
+		AddInfo(FString::Printf(TEXT("%d of %d controllers connected: %.2f us per frame, p50 %.2f us, p99 %.2f us"), NumConnected, MAX_NUM_DS5W_CONTROLLERS,
+			TotalSeconds / DS5W_FRAME_COST_TEST_FRAMES * 1.e6, FrameSeconds[FrameSeconds.Num() / 2] * 1.e6, FrameSeconds[FrameSeconds.Num() * 99 / 100] * 1.e6));
+		AddInfo(FString::Printf(TEXT("%d of %d controllers connected: warm %s; cold caches %s"), NumConnected, MAX_NUM_DS5W_CONTROLLERS,
+			*DescribeFrameCycles(FrameCycles), *DescribeFrameCycles(ColdFrameCycles)));
+
+		Harness.GetInterface().RemoveInputConsumer(DS5W_DECODE_ALL);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,107 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WHeadlessHarness.h"
+#include "DS5WTestPatterns.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+// Frames of the scripted run
+#define DS5W_GOLDEN_TEST_FRAMES 120
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WGoldenTest, "DS5W.Harness.Golden", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WGoldenTest::RunTest(const FString& Parameters)
+{
+	// Two seconds of the moving pad on one controller and a slower button pattern on the other
+	FDS5WHeadlessHarness Harness(2);
+	DS5W::DS5InputState States[2];
+	const DS5W::DS5InputState* StatePointers[] = { &States[0], &States[1] };
+	for (int32 Frame = 0; Frame < DS5W_GOLDEN_TEST_FRAMES; ++Frame)
+	{
+		States[0] = DS5WTest::MakeMovingState(Harness.GetTime());
+		States[1] = DS5WTest::MakeMovingState(Harness.GetTime() * 0.5);
+		States[1].leftStick.x = 0;
+		States[1].leftStick.y = 0;
+		Harness.RunFrame(StatePointers);
+	}
+
+	const TArray<FDS5WRecordedEvent>& Events = Harness.GetEvents();
+	if (!TestTrue(TEXT("Run sent events"), Events.Num() > DS5W_GOLDEN_TEST_FRAMES))
+	{
+		return false;
+	}
+
+	// Saved and loaded back through FromString, the run matches its own golden file
+	const FString Filename = FPaths::AutomationTransientDir() / TEXT("DS5WGoldenTest.txt");
+	TArray<FDS5WRecordedEvent> Golden;
+	TestTrue(TEXT("Golden file saved"), Harness.SaveGolden(Filename));
+	TestTrue(TEXT("Golden file loaded"), FDS5WHeadlessHarness::LoadGolden(Filename, Golden));
+	IFileManager::Get().Delete(*Filename);
+	if (!TestEqual(TEXT("Every event loaded"), Golden.Num(), Events.Num()))
+	{
+		return false;
+	}
+
+	TArray<FString> Diff;
+	if (!TestTrue(TEXT("Run matches its golden file"), Harness.CompareWithGolden(Golden, Diff)))
+	{
+		for (const FString& Line : Diff)
+		{
+			AddInfo(Line);
+		}
+	}
+	TestEqual(TEXT("No diff lines"), Diff.Num(), 0);
+
+	// A changed event shows up as the expected and the actual line at its index, nothing else
+	const int32 ChangedIndex = Golden.Num() / 2;
+	const FDS5WRecordedEvent Original = Golden[ChangedIndex];
+	Golden[ChangedIndex].ControllerId = 1 - Original.ControllerId;
+	TestFalse(TEXT("Changed event fails the comparison"), Harness.CompareWithGolden(Golden, Diff));
+	if (TestEqual(TEXT("Changed event gives two diff lines"), Diff.Num(), 2))
+	{
+		TestEqual(TEXT("Expected line"), Diff[0], FString::Printf(TEXT("#%d - %s"), ChangedIndex, *Golden[ChangedIndex].ToString()));
+		TestEqual(TEXT("Actual line"), Diff[1], FString::Printf(TEXT("#%d + %s"), ChangedIndex, *Events[ChangedIndex].ToString()));
+	}
+
+	// Differences below the tolerance pass, above it they don't
+	Golden[ChangedIndex] = Original;
+	Golden[ChangedIndex].InputTime += 0.5e-4;
+	TestTrue(TEXT("Input time within the tolerance matches"), Harness.CompareWithGolden(Golden, Diff));
+	Golden[ChangedIndex].InputTime += 1.e-3;
+	TestFalse(TEXT("Input time beyond the tolerance differs"), Harness.CompareWithGolden(Golden, Diff));
+	Golden[ChangedIndex] = Original;
+
+	// An event the run didn't send
+	Golden.Add(Original);
+	TestFalse(TEXT("Extra golden event fails the comparison"), Harness.CompareWithGolden(Golden, Diff));
+	if (TestEqual(TEXT("Extra golden event gives two diff lines"), Diff.Num(), 2))
+	{
+		TestEqual(TEXT("Missing event line"), Diff[1], FString::Printf(TEXT("#%d + (none)"), Events.Num()));
+	}
+	Golden.Pop();
+
+	// The diff stops after MaxDiffLines differences and counts the rest
+	for (FDS5WRecordedEvent& Event : Golden)
+	{
+		++Event.Frame;
+	}
+	TestFalse(TEXT("Shifted frames fail the comparison"), Harness.CompareWithGolden(Golden, Diff, 1.e-4f, 4));
+	if (TestEqual(TEXT("Shifted frames give four differences and a count"), Diff.Num(), 9))
+	{
+		TestEqual(TEXT("Count of the differences left out"), Diff.Last(), FString::Printf(TEXT("... %d more differences"), Golden.Num() - 4));
+	}
+
+	// Lines that aren't events
+	FDS5WRecordedEvent Parsed;
+	TestTrue(TEXT("Recorded line parses"), FDS5WRecordedEvent::FromString(Events[0].ToString(), Parsed) && Parsed.ToString() == Events[0].ToString());
+	TestFalse(TEXT("Line with a field missing is rejected"), FDS5WRecordedEvent::FromString(TEXT("3 Pressed Gamepad_FaceButton_Bottom 0 0.000000 0"), Parsed));
+	TestFalse(TEXT("Line with an unknown type is rejected"), FDS5WRecordedEvent::FromString(TEXT("3 Held Gamepad_FaceButton_Bottom 0 0.000000 0 1.000000"), Parsed));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,81 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WStats.h"
+
+// Values below this get a bucket each
+#define DS5W_HISTOGRAM_TEST_EXACT_VALUES (2 << DS5W_HISTOGRAM_SUB_BUCKET_BITS)
+
+// The known distribution: every whole microsecond from 1 us to 100 ms once
+#define DS5W_HISTOGRAM_TEST_VALUES 100000
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WHistogramTest, "DS5W.Stats.Histogram", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WHistogramTest::RunTest(const FString& Parameters)
+{
+	// Bucket bounds line up with the bucket lookup: the bound is in its bucket, one past it in the next one
+	int32 NumMisplacedBounds = 0;
+	for (int32 Bucket = 0; Bucket < DS5W_HISTOGRAM_BUCKETS - 1; ++Bucket)
+	{
+		const uint64 UpperBound = FDS5WHistogram::GetBucketUpperBound(Bucket);
+		if (FDS5WHistogram::GetBucket(UpperBound) != Bucket || FDS5WHistogram::GetBucket(UpperBound + 1) != Bucket + 1)
+		{
+			AddInfo(FString::Printf(TEXT("Bucket %d: upper bound %llu is in bucket %d, one past it in %d"), Bucket, UpperBound,
+				FDS5WHistogram::GetBucket(UpperBound), FDS5WHistogram::GetBucket(UpperBound + 1)));
+			++NumMisplacedBounds;
+		}
+	}
+	TestEqual(TEXT("Every bucket bound in its bucket, the value after it in the next"), NumMisplacedBounds, 0);
+
+	// Beyond the last row everything lands in the last bucket
+	const uint64 Largest = FDS5WHistogram::GetBucketUpperBound(DS5W_HISTOGRAM_BUCKETS - 1);
+	TestEqual(TEXT("Past the last bound in the last bucket"), FDS5WHistogram::GetBucket(Largest + 1), DS5W_HISTOGRAM_BUCKETS - 1);
+	TestEqual(TEXT("Largest value in the last bucket"), FDS5WHistogram::GetBucket(MAX_uint64), DS5W_HISTOGRAM_BUCKETS - 1);
+
+	// Small values are exact, so are their percentiles
+	FDS5WHistogram Histogram;
+	bool bExact = true;
+	for (int32 Value = 0; Value < DS5W_HISTOGRAM_TEST_EXACT_VALUES; ++Value)
+	{
+		bExact &= FDS5WHistogram::GetBucket(Value) == Value && FDS5WHistogram::GetBucketUpperBound(Value) == (uint64)Value;
+		Histogram.Record(Value);
+	}
+	TestTrue(TEXT("Small values get a bucket each"), bExact);
+	bool bExactPercentiles = true;
+	for (int32 Value = 0; Value < DS5W_HISTOGRAM_TEST_EXACT_VALUES; ++Value)
+	{
+		bExactPercentiles &= Histogram.GetPercentile((Value + 1) / (double)DS5W_HISTOGRAM_TEST_EXACT_VALUES) == (uint64)Value;
+	}
+	TestTrue(TEXT("Percentiles of small values are exact"), bExactPercentiles);
+
+	// Percentiles of the known distribution are at or above the true value, by less than one bucket
+	Histogram.Reset();
+	TestEqual(TEXT("Reset clears the count"), (int32)Histogram.GetCount(), 0);
+	TestEqual(TEXT("Empty histogram percentile"), (int32)Histogram.GetPercentile(0.5), 0);
+	for (int32 Value = 1; Value <= DS5W_HISTOGRAM_TEST_VALUES; ++Value)
+	{
+		Histogram.Record(Value * 1000ull);
+	}
+	TestEqual(TEXT("Count"), (int32)Histogram.GetCount(), DS5W_HISTOGRAM_TEST_VALUES);
+	TestEqual(TEXT("Min"), (int32)Histogram.GetMin(), 1000);
+	TestEqual(TEXT("Max"), (int32)Histogram.GetMax(), DS5W_HISTOGRAM_TEST_VALUES * 1000);
+	TestTrue(FString::Printf(TEXT("Mean (%.1f)"), Histogram.GetMean()), Histogram.GetMean() == (DS5W_HISTOGRAM_TEST_VALUES + 1) * 500.0);
+
+	for (const double Fraction : { 0.01, 0.5, 0.9, 0.99, 0.999, 1.0 })
+	{
+		const uint64 Expected = (uint64)FMath::CeilToDouble(Fraction * DS5W_HISTOGRAM_TEST_VALUES) * 1000;
+		const int32 Bucket = FDS5WHistogram::GetBucket(Expected);
+		const uint64 BucketWidth = FDS5WHistogram::GetBucketUpperBound(Bucket) - FDS5WHistogram::GetBucketUpperBound(Bucket - 1);
+		const uint64 Percentile = Histogram.GetPercentile(Fraction);
+		TestTrue(FString::Printf(TEXT("p%g is %llu ns, true %llu ns, bucket width %llu ns"), Fraction * 100.0, Percentile, Expected, BucketWidth),
+			Percentile >= Expected && Percentile - Expected < BucketWidth);
+	}
+	TestEqual(TEXT("p100 is the exact maximum"), (int32)Histogram.GetPercentile(1.0), DS5W_HISTOGRAM_TEST_VALUES * 1000);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,113 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+#include "DS5WPadEmulator.h"
+#include "DS5WStats.h"
+#include "DS5WTestPatterns.h"
+#include "Misc/OutputDeviceNull.h"
+
+// Frames for the clock mapping to settle before the stats are reset, and frames measured after that
+#define DS5W_INPUT_AGE_TEST_SETTLE_FRAMES 120
+#define DS5W_INPUT_AGE_TEST_FRAMES        600
+
+// Once settled, the mapped capture time is off the true one plus MinLatency by at most this part of the jitter
+#define DS5W_INPUT_AGE_TEST_SYNC_ERROR 0.1
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WInputAgeTest, "DS5W.InputAge", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WInputAgeTest::RunTest(const FString& Parameters)
+{
+	// A wired pad on controller 0 and a wireless one on controller 1
+	FDS5WHeadlessHarness Harness(2);
+	FDS5WPadEmulator* Pads[] = { &Harness.EmulatePad(0, FDS5WPadEmulatorSettings::Usb()), &Harness.EmulatePad(1, FDS5WPadEmulatorSettings::Bluetooth()) };
+	FDS5WInterface& Interface = Harness.GetInterface();
+
+	for (int32 Frame = 0; Frame < DS5W_INPUT_AGE_TEST_SETTLE_FRAMES; ++Frame)
+	{
+		for (FDS5WPadEmulator* Pad : Pads)
+		{
+			Pad->SetState(DS5WTest::MakeMovingState(Harness.GetTime()));
+		}
+		Harness.RunFrame();
+	}
+	FOutputDeviceNull Ar;
+	Interface.Exec(nullptr, TEXT("DS5W STATS RESET"), Ar);
+
+	// Every frame the age of the newest report that reached the host by then: at least its transport
+	// latency, at most the slowest transport plus the report interval it may have just missed. The
+	// measured age is short of it by MinLatency, which the clock mapping can't tell from the clock offset
+	double MaxSyncError[2] = {};
+	int32 NumTrueAgesOutside[2] = {};
+	for (int32 Frame = 0; Frame < DS5W_INPUT_AGE_TEST_FRAMES; ++Frame)
+	{
+		for (FDS5WPadEmulator* Pad : Pads)
+		{
+			Pad->SetState(DS5WTest::MakeMovingState(Harness.GetTime()));
+		}
+		Harness.RunFrame();
+
+		for (int32 ControllerId = 0; ControllerId < 2; ++ControllerId)
+		{
+			const FDS5WPadEmulatorSettings& Settings = Pads[ControllerId]->GetSettings();
+			const double TrueAge = Harness.GetTime() - Pads[ControllerId]->GetLastCaptureTime();
+			NumTrueAgesOutside[ControllerId] += TrueAge < Settings.MinLatency || TrueAge > Settings.MinLatency + Settings.MaxJitter + Settings.ReportInterval ? 1 : 0;
+
+			double MeasuredAge;
+			if (TestTrue(FString::Printf(TEXT("Controller %d connected"), ControllerId), Interface.GetInputAge(ControllerId, MeasuredAge)))
+			{
+				MaxSyncError[ControllerId] = FMath::Max(MaxSyncError[ControllerId], FMath::Abs(MeasuredAge - (TrueAge - Settings.MinLatency)));
+			}
+		}
+	}
+
+	for (int32 ControllerId = 0; ControllerId < 2; ++ControllerId)
+	{
+		const FDS5WPadEmulatorSettings& Settings = Pads[ControllerId]->GetSettings();
+		const TCHAR* ConnectionName = Settings.bBluetooth ? TEXT("BT") : TEXT("USB");
+		const double SyncTolerance = DS5W_INPUT_AGE_TEST_SYNC_ERROR * Settings.MaxJitter;
+		TestEqual(FString::Printf(TEXT("%s: true ages within the transport and report interval"), ConnectionName), NumTrueAgesOutside[ControllerId], 0);
+		TestTrue(FString::Printf(TEXT("%s: measured age is the true one less the minimum latency (off by %.3f ms)"), ConnectionName, MaxSyncError[ControllerId] * 1.e3),
+			MaxSyncError[ControllerId] <= SyncTolerance);
+
+		// One age per frame, in the histogram of the connection type only
+		const FDS5WControllerStats* Stats = Interface.GetControllerStats(ControllerId);
+		const FDS5WHistogram& InputAge = Stats->GetInputAge(Settings.bBluetooth);
+		TestEqual(FString::Printf(TEXT("%s: an age per frame"), ConnectionName), (int32)InputAge.GetCount(), DS5W_INPUT_AGE_TEST_FRAMES);
+		TestEqual(FString::Printf(TEXT("%s: nothing in the other connection type's histogram"), ConnectionName), (int32)Stats->GetInputAge(!Settings.bBluetooth).GetCount(), 0);
+
+		// Which bounds the histogram: percentiles are clamped to the exact maximum
+		const double MinAge = InputAge.GetMin() / 1.e9;
+		const double P50Age = InputAge.GetPercentile(0.5) / 1.e9;
+		const double P99Age = InputAge.GetPercentile(0.99) / 1.e9;
+		const double MaxAge = Settings.MaxJitter + Settings.ReportInterval + SyncTolerance;
+		TestTrue(FString::Printf(TEXT("%s: min %.3f ms <= p50 %.3f ms <= p99 %.3f ms <= %.3f ms"), ConnectionName, MinAge * 1.e3, P50Age * 1.e3, P99Age * 1.e3, MaxAge * 1.e3),
+			MinAge >= 0.0 && MinAge <= P50Age && P50Age <= P99Age && P99Age <= MaxAge);
+	}
+
+	// The radio's jitter shows in the typical age, not just the tail
+	const FDS5WControllerStats* UsbStats = Interface.GetControllerStats(0);
+	const FDS5WControllerStats* BluetoothStats = Interface.GetControllerStats(1);
+	TestTrue(TEXT("BT p50 above USB p50"), BluetoothStats->GetInputAge(true).GetPercentile(0.5) > UsbStats->GetInputAge(false).GetPercentile(0.5));
+
+	// The summary has a line per controller and connection type seen
+	TArray<FString> Lines;
+	Harness.GetInputAgeSummary(Lines);
+	if (TestEqual(TEXT("Summary lines"), Lines.Num(), 2))
+	{
+		TestTrue(Lines[0], Lines[0].StartsWith(TEXT("Controller 0 (USB)")));
+		TestTrue(Lines[1], Lines[1].StartsWith(TEXT("Controller 1 (BT)")));
+	}
+	for (const FString& Line : Lines)
+	{
+		AddInfo(Line);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,131 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WInputHistory.h"
+
+// Ring size, reports pushed (wrapping it more than twice) and the one that is a disconnect instead
+#define DS5W_INPUT_HISTORY_TEST_CAPACITY   16
+#define DS5W_INPUT_HISTORY_TEST_REPORTS    40
+#define DS5W_INPUT_HISTORY_TEST_DISCONNECT 25
+
+// Reports carry their index in the sensor timestamp, offset so no report has a zero one
+#define DS5W_INPUT_HISTORY_TEST_TIMESTAMP_BASE 1000
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WInputHistoryTest, "DS5W.InputHistory.Wraparound", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WInputHistoryTest::RunTest(const FString& Parameters)
+{
+	auto GetCaptureTime = [](int32 Index) { return 10.0 + 0.01 * Index; };
+
+	FDS5WInputHistory History;
+	History.Init(DS5W_INPUT_HISTORY_TEST_CAPACITY);
+	TestEqual(TEXT("Capacity"), History.GetCapacity(), DS5W_INPUT_HISTORY_TEST_CAPACITY);
+
+	FDS5WInputHistoryEntry Entry;
+	TestFalse(TEXT("Empty history has no entry at any time"), History.GetEntryAtTime(GetCaptureTime(0), Entry));
+	TestEqual(TEXT("Empty history has nothing after any time"), (int32)History.FindFirstAfter(0.0), 0);
+
+	DS5W::DS5InputState State;
+	FMemory::Memzero(State);
+	for (int32 Index = 0; Index < DS5W_INPUT_HISTORY_TEST_REPORTS; ++Index)
+	{
+		if (Index == DS5W_INPUT_HISTORY_TEST_DISCONNECT)
+		{
+			History.PushDisconnect(GetCaptureTime(Index));
+		}
+		else
+		{
+			State.sensorTimestamp = DS5W_INPUT_HISTORY_TEST_TIMESTAMP_BASE + Index;
+			History.Push(State, GetCaptureTime(Index));
+		}
+	}
+
+	const int32 Oldest = DS5W_INPUT_HISTORY_TEST_REPORTS - DS5W_INPUT_HISTORY_TEST_CAPACITY;
+	TestEqual(TEXT("Every report counted"), (int32)History.GetNumWritten(), DS5W_INPUT_HISTORY_TEST_REPORTS);
+
+	// Overwritten slots are gone, the held ones come back as pushed
+	bool bOverwrittenGone = true;
+	bool bHeldIntact = true;
+	for (int32 Index = 0; Index <= DS5W_INPUT_HISTORY_TEST_REPORTS; ++Index)
+	{
+		const bool bFound = History.GetEntry(Index, Entry);
+		if (Index < Oldest || Index == DS5W_INPUT_HISTORY_TEST_REPORTS)
+		{
+			bOverwrittenGone &= !bFound;
+		}
+		else
+		{
+			const bool bDisconnect = Index == DS5W_INPUT_HISTORY_TEST_DISCONNECT;
+			bHeldIntact &= bFound && Entry.CaptureTime == GetCaptureTime(Index) && Entry.bConnected == !bDisconnect
+				&& Entry.Snapshot.SensorTimestamp == (bDisconnect ? 0u : (uint32)(DS5W_INPUT_HISTORY_TEST_TIMESTAMP_BASE + Index));
+		}
+	}
+	TestTrue(TEXT("Overwritten and unwritten reports are not returned"), bOverwrittenGone);
+	TestTrue(TEXT("Held reports come back as pushed"), bHeldIntact);
+
+	// Latest report at or before a time
+	struct FTimeQuery
+	{
+		const TCHAR* Name;
+		double Time;
+		int32 ExpectedIndex;
+	};
+	const FTimeQuery Queries[] =
+	{
+		{ TEXT("before the oldest held report"), GetCaptureTime(Oldest) - 0.005, -1 },
+		{ TEXT("at an overwritten report"), GetCaptureTime(Oldest - 3), -1 },
+		{ TEXT("exactly at the oldest held report"), GetCaptureTime(Oldest), Oldest },
+		{ TEXT("exactly at a capture time"), GetCaptureTime(30), 30 },
+		{ TEXT("between two reports"), GetCaptureTime(30) + 0.005, 30 },
+		{ TEXT("just before the disconnect"), GetCaptureTime(DS5W_INPUT_HISTORY_TEST_DISCONNECT) - 0.001, DS5W_INPUT_HISTORY_TEST_DISCONNECT - 1 },
+		{ TEXT("after the disconnect"), GetCaptureTime(DS5W_INPUT_HISTORY_TEST_DISCONNECT) + 0.005, DS5W_INPUT_HISTORY_TEST_DISCONNECT },
+		{ TEXT("at the first report after the disconnect"), GetCaptureTime(DS5W_INPUT_HISTORY_TEST_DISCONNECT + 1), DS5W_INPUT_HISTORY_TEST_DISCONNECT + 1 },
+		{ TEXT("after the newest report"), GetCaptureTime(DS5W_INPUT_HISTORY_TEST_REPORTS) + 1.0, DS5W_INPUT_HISTORY_TEST_REPORTS - 1 },
+	};
+	for (const FTimeQuery& Query : Queries)
+	{
+		const bool bFound = History.GetEntryAtTime(Query.Time, Entry);
+		if (Query.ExpectedIndex < 0)
+		{
+			TestFalse(FString::Printf(TEXT("GetEntryAtTime %s finds nothing"), Query.Name), bFound);
+		}
+		else if (TestTrue(FString::Printf(TEXT("GetEntryAtTime %s finds a report"), Query.Name), bFound))
+		{
+			TestEqual(FString::Printf(TEXT("GetEntryAtTime %s capture time"), Query.Name), Entry.CaptureTime, GetCaptureTime(Query.ExpectedIndex));
+			TestTrue(FString::Printf(TEXT("GetEntryAtTime %s connection"), Query.Name), Entry.bConnected == (Query.ExpectedIndex != DS5W_INPUT_HISTORY_TEST_DISCONNECT));
+		}
+	}
+
+	// First report captured after a time, overwritten ones count as older than anything held
+	const FTimeQuery AfterQueries[] =
+	{
+		{ TEXT("long before the oldest held report"), 0.0, Oldest },
+		{ TEXT("at an overwritten report"), GetCaptureTime(Oldest - 3), Oldest },
+		{ TEXT("exactly at the oldest held report"), GetCaptureTime(Oldest), Oldest + 1 },
+		{ TEXT("exactly at a capture time"), GetCaptureTime(30), 31 },
+		{ TEXT("between two reports"), GetCaptureTime(30) + 0.005, 31 },
+		{ TEXT("at the disconnect"), GetCaptureTime(DS5W_INPUT_HISTORY_TEST_DISCONNECT), DS5W_INPUT_HISTORY_TEST_DISCONNECT + 1 },
+		{ TEXT("after the newest report"), GetCaptureTime(DS5W_INPUT_HISTORY_TEST_REPORTS), DS5W_INPUT_HISTORY_TEST_REPORTS },
+	};
+	for (const FTimeQuery& Query : AfterQueries)
+	{
+		TestEqual(FString::Printf(TEXT("FindFirstAfter %s"), Query.Name), (int32)History.FindFirstAfter(Query.Time), Query.ExpectedIndex);
+	}
+
+	// A range starting before the oldest held report begins with it and includes the disconnect
+	FDS5WInputHistoryEntry Range[DS5W_INPUT_HISTORY_TEST_CAPACITY];
+	const int32 NumInRange = History.GetEntriesInRange(GetCaptureTime(Oldest - 5), GetCaptureTime(Oldest + 3), Range, UE_ARRAY_COUNT(Range));
+	if (TestEqual(TEXT("Range holds the reports still there"), NumInRange, 4))
+	{
+		TestEqual(TEXT("Range starts at the oldest held report"), Range[0].CaptureTime, GetCaptureTime(Oldest));
+		TestTrue(TEXT("Range includes the disconnect"), !Range[DS5W_INPUT_HISTORY_TEST_DISCONNECT - Oldest].bConnected);
+		TestEqual(TEXT("Range ends at its end time"), Range[3].CaptureTime, GetCaptureTime(Oldest + 3));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
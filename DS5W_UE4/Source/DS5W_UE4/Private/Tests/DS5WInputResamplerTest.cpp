@@ -0,0 +1,126 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WInputHistory.h"
+#include "DS5WInputResampler.h"
+#include "DS5WSnapshot.h"
+
+// Reports in the history, 4 ms apart, and the ones the cross button is held for
+#define DS5W_RESAMPLER_TEST_REPORTS     50
+#define DS5W_RESAMPLER_TEST_TAP_FIRST   30
+#define DS5W_RESAMPLER_TEST_TAP_LAST    31
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WInputResamplerTest, "DS5W.InputResampler.Resample", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WInputResamplerTest::RunTest(const FString& Parameters)
+{
+	auto GetCaptureTime = [](int32 Index) { return 2.0 + 0.004 * Index; };
+
+	FDS5WInputHistory History;
+	History.Init(64);
+
+	FDS5WTickInput Input;
+	TestFalse(TEXT("Empty history gives no input"), FDS5WInputResampler::Resample(History, 0.0, GetCaptureTime(0), Input));
+
+	// Sticks and triggers ramp, the gyro changes every report, cross is tapped for two reports
+	DS5W::DS5InputState State;
+	FMemory::Memzero(State);
+	for (int32 Index = 0; Index < DS5W_RESAMPLER_TEST_REPORTS; ++Index)
+	{
+		State.leftStick.x = (char)(2 * Index - 50);
+		State.rightStick.y = (char)(40 - Index);
+		State.leftTrigger = (unsigned char)(5 * Index);
+		State.buttonsAndDpad = Index >= DS5W_RESAMPLER_TEST_TAP_FIRST && Index <= DS5W_RESAMPLER_TEST_TAP_LAST ? DS5W_ISTATE_BTX_CROSS : 0;
+		State.imuState.gyroX = 100.f * FMath::Sin(0.3f * Index);
+		State.imuState.gyroY = 50.f + Index;
+		State.imuState.gyroZ = -30.f;
+		History.Push(State, GetCaptureTime(Index));
+	}
+
+	FDS5WSnapshot CrossOnly;
+	FMemory::Memzero(State);
+	State.buttonsAndDpad = DS5W_ISTATE_BTX_CROSS;
+	CrossOnly.FromInputState(State);
+	const uint32 CrossMask = CrossOnly.Buttons;
+
+	// The history's own values, quantised like the resampler sees them
+	TArray<FDS5WInputHistoryEntry> Entries;
+	Entries.SetNum(DS5W_RESAMPLER_TEST_REPORTS);
+	for (int32 Index = 0; Index < DS5W_RESAMPLER_TEST_REPORTS; ++Index)
+	{
+		History.GetEntry(Index, Entries[Index]);
+	}
+	auto GetGyro = [&Entries](int32 Index)
+	{
+		float Gyro[3];
+		Entries[Index].Snapshot.GetGyro(Gyro);
+		return FVector(Gyro[0], Gyro[1], Gyro[2]);
+	};
+
+	// Before the first report there is nothing to resample
+	TestFalse(TEXT("Tick ending before the first report gives no input"), FDS5WInputResampler::Resample(History, GetCaptureTime(0) - 0.02, GetCaptureTime(0) - 0.001, Input));
+
+	// 60 Hz ticks out of phase with the reports add up to the gyro over the whole stream, each report
+	// covering the 4 ms since the one before
+	FVector StreamRotation = FVector::ZeroVector;
+	for (int32 Index = 1; Index < DS5W_RESAMPLER_TEST_REPORTS; ++Index)
+	{
+		StreamRotation += GetGyro(Index) * (float)(GetCaptureTime(Index) - GetCaptureTime(Index - 1));
+	}
+	FVector TickRotation = FVector::ZeroVector;
+	int32 NumReports = 0;
+	const double StreamEnd = GetCaptureTime(DS5W_RESAMPLER_TEST_REPORTS - 1);
+	for (double TickStart = GetCaptureTime(0); TickStart < StreamEnd; TickStart += 1.0 / 60.0)
+	{
+		const double TickEnd = FMath::Min(TickStart + 1.0 / 60.0, StreamEnd);
+		if (!TestTrue(FString::Printf(TEXT("Tick ending at %.4f resampled"), TickEnd), FDS5WInputResampler::Resample(History, TickStart, TickEnd, Input)))
+		{
+			return false;
+		}
+		TickRotation += Input.GyroRotation;
+		NumReports += Input.NumReports;
+	}
+	TestTrue(FString::Printf(TEXT("Ticks add up to the stream's gyro (%s vs %s)"), *TickRotation.ToString(), *StreamRotation.ToString()), TickRotation.Equals(StreamRotation, 1.e-3f));
+	TestEqual(TEXT("Every report after the first counted once"), NumReports, DS5W_RESAMPLER_TEST_REPORTS - 1);
+
+	// Analog values a quarter of the way from report 10 to report 11
+	const float Alpha = 0.25f;
+	TestTrue(TEXT("Tick ending between reports"), FDS5WInputResampler::Resample(History, GetCaptureTime(8), GetCaptureTime(10) + 0.001, Input));
+	TestTrue(FString::Printf(TEXT("Left stick x interpolated (%f)"), Input.Sticks[0]), FMath::IsNearlyEqual(Input.Sticks[0], FMath::Lerp(-30.f, -28.f, Alpha) / 127.f, 1.e-5f));
+	TestTrue(FString::Printf(TEXT("Right stick y interpolated (%f)"), Input.Sticks[3]), FMath::IsNearlyEqual(Input.Sticks[3], FMath::Lerp(30.f, 29.f, Alpha) / 127.f, 1.e-5f));
+	TestTrue(FString::Printf(TEXT("Left trigger interpolated (%f)"), Input.Triggers[0]), FMath::IsNearlyEqual(Input.Triggers[0], FMath::Lerp(50.f, 55.f, Alpha) / 255.f, 1.e-5f));
+	TestEqual(TEXT("Reports 9 and 10 in the tick"), Input.NumReports, 2);
+
+	// Exactly on a report the report's own values
+	TestTrue(TEXT("Tick ending on a report"), FDS5WInputResampler::Resample(History, GetCaptureTime(18), GetCaptureTime(20), Input));
+	TestTrue(FString::Printf(TEXT("Left stick x of the report (%f)"), Input.Sticks[0]), FMath::IsNearlyEqual(Input.Sticks[0], -10.f / 127.f, 1.e-6f));
+	TestTrue(FString::Printf(TEXT("Left trigger of the report (%f)"), Input.Triggers[0]), FMath::IsNearlyEqual(Input.Triggers[0], 100.f / 255.f, 1.e-6f));
+
+	// A tap that starts and ends inside one tick
+	TestTrue(TEXT("Tick around the tap"), FDS5WInputResampler::Resample(History, GetCaptureTime(DS5W_RESAMPLER_TEST_TAP_FIRST - 1) + 0.001, GetCaptureTime(DS5W_RESAMPLER_TEST_TAP_LAST + 2), Input));
+	TestTrue(TEXT("Tap pressed during the tick"), (Input.PressedButtons & CrossMask) != 0);
+	TestTrue(TEXT("Tap released during the tick"), (Input.ReleasedButtons & CrossMask) != 0);
+	TestTrue(TEXT("Tap not held at the end of the tick"), (Input.Buttons & CrossMask) == 0);
+
+	// The tick before it sees nothing of the tap
+	TestTrue(TEXT("Tick before the tap"), FDS5WInputResampler::Resample(History, GetCaptureTime(20), GetCaptureTime(DS5W_RESAMPLER_TEST_TAP_FIRST - 1), Input));
+	TestTrue(TEXT("No edges before the tap"), Input.PressedButtons == 0 && Input.ReleasedButtons == 0);
+
+	// Past the newest report its values are held and its gyro carries on
+	const int32 Newest = DS5W_RESAMPLER_TEST_REPORTS - 1;
+	const double LateStart = GetCaptureTime(Newest - 1) + 0.002;
+	const double LateEnd = GetCaptureTime(Newest) + 0.010;
+	TestTrue(TEXT("Tick ending past the newest report"), FDS5WInputResampler::Resample(History, LateStart, LateEnd, Input));
+	TestTrue(FString::Printf(TEXT("Left stick x held (%f)"), Input.Sticks[0]), FMath::IsNearlyEqual(Input.Sticks[0], (2.f * Newest - 50.f) / 127.f, 1.e-6f));
+	TestEqual(TEXT("Only the newest report in the tick"), Input.NumReports, 1);
+	const FVector LateRotation = GetGyro(Newest) * (float)(LateEnd - LateStart);
+	TestTrue(FString::Printf(TEXT("Gyro extrapolated with the newest report (%s vs %s)"), *Input.GyroRotation.ToString(), *LateRotation.ToString()), Input.GyroRotation.Equals(LateRotation, 1.e-4f));
+	TestTrue(TEXT("Still connected"), Input.bConnected);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,209 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+#include "DS5WReportSubscribers.h"
+#include "DS5WTestPatterns.h"
+#include "GamepadMotion.hpp"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+// Simulated seconds recorded per report rate, and how often the timing replays them
+#define DS5W_MOTION_BATCH_TEST_DURATION 20.0
+#define DS5W_MOTION_BATCH_TEST_TIMING_REPEATS 10
+
+namespace
+{
+	/** Reports of a pad recorded through the harness, split into the batches the game frames would fuse */
+	struct FMotionRecording
+	{
+		TArray<GamepadMotionHelpers::MotionSample> Samples;
+
+		/** First sample of each frame's batch */
+		TArray<int32> BatchStarts;
+
+		int32 GetBatchEnd(int32 Batch) const { return Batch + 1 < BatchStarts.Num() ? BatchStarts[Batch + 1] : Samples.Num(); }
+	};
+
+	/**
+	 * Record an emulated pad reporting every ReportInterval. It rests on the table for the first half of
+	 * every six seconds, long enough for stillness calibration to find the gyro bias, and is waved around
+	 * in between.
+	 */
+	void RecordMotion(double ReportInterval, FMotionRecording& OutRecording)
+	{
+		FDS5WPadEmulatorSettings Settings = FDS5WPadEmulatorSettings::Usb();
+		Settings.ReportInterval = ReportInterval;
+
+		FDS5WHeadlessHarness Harness(1, 1.0 / 60.0, ReportInterval);
+		FDS5WPadEmulator& Pad = Harness.EmulatePad(0, Settings);
+		FDS5WReportSubscribers& Subscribers = Harness.GetInterface().GetReportSubscribers();
+		FDS5WReportSubscription Subscription = Subscribers.Subscribe(nullptr, true);
+
+		FRandomStream Random(50);
+		FDS5WRawReport Report;
+		const double StartTime = Harness.GetTime();
+		while (Harness.GetTime() < StartTime + DS5W_MOTION_BATCH_TEST_DURATION)
+		{
+			const double Time = Harness.GetTime() - StartTime;
+			const bool bResting = FMath::Fmod(Time, 6.0) < 3.0;
+			const float Swing = bResting ? 0.f : 1.f;
+
+			DS5W::DS5InputState State = DS5WTest::MakeMovingState(Time);
+			DS5W::IMUState& IMU = State.imuState;
+			IMU.gyroX = 0.4f + Swing * 150.f * FMath::Sin((float)(Time * 3.0 * PI)) + 0.1f * Random.FRandRange(-1.f, 1.f);
+			IMU.gyroY = -0.3f + Swing * 220.f * FMath::Cos((float)(Time * 2.0 * PI)) + 0.1f * Random.FRandRange(-1.f, 1.f);
+			IMU.gyroZ = 0.2f + Swing * 60.f * FMath::Sin((float)(Time * 5.0 * PI)) + 0.1f * Random.FRandRange(-1.f, 1.f);
+			IMU.accelX = Swing * 0.4f * FMath::Sin((float)(Time * 3.0 * PI)) + 0.01f * Random.FRandRange(-1.f, 1.f);
+			IMU.accelY = -1.f + 0.01f * Random.FRandRange(-1.f, 1.f);
+			IMU.accelZ = Swing * 0.3f * FMath::Cos((float)(Time * 2.0 * PI)) + 0.01f * Random.FRandRange(-1.f, 1.f);
+			Pad.SetState(State);
+
+			Harness.RunFrame();
+			Harness.ResetEvents();
+
+			// The reports that reached this frame, with the device's sample spacing like the interface uses
+			OutRecording.BatchStarts.Add(OutRecording.Samples.Num());
+			while (Subscribers.Dequeue(Subscription, Report))
+			{
+				const DS5W::IMUState& Recorded = Report.State.imuState;
+				OutRecording.Samples.Add({ Recorded.gyroX, Recorded.gyroY, Recorded.gyroZ, Recorded.accelX, Recorded.accelY, Recorded.accelZ, Report.DeviceTime });
+			}
+		}
+
+		Subscribers.Unsubscribe(Subscription);
+	}
+
+	void SetUpCalibration(GamepadMotion& Motion, GamepadMotionHelpers::CalibrationMode Mode, bool bContinuous)
+	{
+		Motion.SetCalibrationMode(Mode);
+		if (bContinuous)
+		{
+			Motion.StartContinuousCalibration();
+		}
+	}
+
+	/** ProcessMotion once per sample, the delta time taken from the timestamps like the batch does */
+	void ProcessSamples(GamepadMotion& Motion, const FMotionRecording& Recording, int32 Start, int32 End)
+	{
+		for (int32 Index = Start; Index < End; ++Index)
+		{
+			const GamepadMotionHelpers::MotionSample& Sample = Recording.Samples[Index];
+			const float DeltaTime = Index > 0 ? (float)FMath::Max(Sample.Timestamp - Recording.Samples[Index - 1].Timestamp, 0.0) : 0.f;
+			Motion.ProcessMotion(Sample.GyroX, Sample.GyroY, Sample.GyroZ, Sample.AccelX, Sample.AccelY, Sample.AccelZ, DeltaTime);
+		}
+	}
+
+	void ProcessBatch(GamepadMotion& Motion, const FMotionRecording& Recording, int32 Start, int32 End)
+	{
+		Motion.ProcessMotionBatch(Recording.Samples.GetData() + Start, End - Start, Start > 0 ? Recording.Samples[Start - 1].Timestamp : -1.0);
+	}
+
+	/** Largest difference in orientation, calibration offset and calibrated gyro, relative to values above 1 */
+	float GetMaxDifference(GamepadMotion& A, GamepadMotion& B)
+	{
+		float ValuesA[10];
+		float ValuesB[10];
+		A.GetOrientation(ValuesA[0], ValuesA[1], ValuesA[2], ValuesA[3]);
+		B.GetOrientation(ValuesB[0], ValuesB[1], ValuesB[2], ValuesB[3]);
+		A.GetCalibrationOffset(ValuesA[4], ValuesA[5], ValuesA[6]);
+		B.GetCalibrationOffset(ValuesB[4], ValuesB[5], ValuesB[6]);
+		A.GetCalibratedGyro(ValuesA[7], ValuesA[8], ValuesA[9]);
+		B.GetCalibratedGyro(ValuesB[7], ValuesB[8], ValuesB[9]);
+
+		float MaxDifference = 0.f;
+		for (int32 Index = 0; Index < UE_ARRAY_COUNT(ValuesA); ++Index)
+		{
+			MaxDifference = FMath::Max(MaxDifference, FMath::Abs(ValuesA[Index] - ValuesB[Index]) / FMath::Max(FMath::Abs(ValuesA[Index]), 1.f));
+		}
+		return MaxDifference;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WMotionBatchTest, "DS5W.Motion.Batch", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WMotionBatchTest::RunTest(const FString& Parameters)
+{
+	struct FCalibrationSetup
+	{
+		const TCHAR* Name;
+		GamepadMotionHelpers::CalibrationMode Mode;
+		bool bContinuous;
+	};
+	const FCalibrationSetup Setups[] =
+	{
+		{ TEXT("manual"), GamepadMotionHelpers::Manual, false },
+		{ TEXT("manual, continuous"), GamepadMotionHelpers::Manual, true },
+		{ TEXT("stillness"), GamepadMotionHelpers::Stillness, false },
+		{ TEXT("sensor fusion"), GamepadMotionHelpers::SensorFusion, false },
+		{ TEXT("stillness and sensor fusion"), GamepadMotionHelpers::Stillness | GamepadMotionHelpers::SensorFusion, false },
+	};
+
+	for (const double ReportRate : { 250.0, 1000.0 })
+	{
+		FMotionRecording Recording;
+		RecordMotion(1.0 / ReportRate, Recording);
+		if (!TestTrue(FString::Printf(TEXT("Reports recorded at %.0f Hz"), ReportRate), Recording.Samples.Num() > DS5W_MOTION_BATCH_TEST_DURATION * ReportRate * 0.9))
+		{
+			return false;
+		}
+
+		for (const FCalibrationSetup& Setup : Setups)
+		{
+			// Both paths must agree after every frame, not only at the end
+			GamepadMotion PerSample;
+			GamepadMotion Batched;
+			SetUpCalibration(PerSample, Setup.Mode, Setup.bContinuous);
+			SetUpCalibration(Batched, Setup.Mode, Setup.bContinuous);
+
+			float MaxDifference = 0.f;
+			for (int32 Batch = 0; Batch < Recording.BatchStarts.Num(); ++Batch)
+			{
+				ProcessSamples(PerSample, Recording, Recording.BatchStarts[Batch], Recording.GetBatchEnd(Batch));
+				ProcessBatch(Batched, Recording, Recording.BatchStarts[Batch], Recording.GetBatchEnd(Batch));
+				MaxDifference = FMath::Max(MaxDifference, GetMaxDifference(PerSample, Batched));
+			}
+
+			TestTrue(FString::Printf(TEXT("%.0f Hz, %s calibration: batch matches per sample calls (max difference %g)"), ReportRate, Setup.Name, MaxDifference), MaxDifference <= 1.e-6f);
+
+			// Cost of fusing the recording both ways, replayed a few times so the timer resolution doesn't matter
+			uint64 PerSampleCycles = 0;
+			uint64 BatchedCycles = 0;
+			for (int32 Repeat = 0; Repeat < DS5W_MOTION_BATCH_TEST_TIMING_REPEATS; ++Repeat)
+			{
+				GamepadMotion TimedPerSample;
+				GamepadMotion TimedBatched;
+				SetUpCalibration(TimedPerSample, Setup.Mode, Setup.bContinuous);
+				SetUpCalibration(TimedBatched, Setup.Mode, Setup.bContinuous);
+
+				uint64 StartCycles = FPlatformTime::Cycles64();
+				for (int32 Batch = 0; Batch < Recording.BatchStarts.Num(); ++Batch)
+				{
+					ProcessSamples(TimedPerSample, Recording, Recording.BatchStarts[Batch], Recording.GetBatchEnd(Batch));
+				}
+				PerSampleCycles += FPlatformTime::Cycles64() - StartCycles;
+
+				StartCycles = FPlatformTime::Cycles64();
+				for (int32 Batch = 0; Batch < Recording.BatchStarts.Num(); ++Batch)
+				{
+					ProcessBatch(TimedBatched, Recording, Recording.BatchStarts[Batch], Recording.GetBatchEnd(Batch));
+				}
+				BatchedCycles += FPlatformTime::Cycles64() - StartCycles;
+			}
+
+			// Reported, not checked: timings depend on the machine and what else runs on it
+			const double NumSamples = (double)Recording.Samples.Num() * DS5W_MOTION_BATCH_TEST_TIMING_REPEATS;
+			AddInfo(FString::Printf(TEXT("%.0f Hz, %s calibration: %.1f ns per sample one by one, %.1f ns batched (%.0f%%)"), ReportRate, Setup.Name,
+				FPlatformTime::ToSeconds64(PerSampleCycles) / NumSamples * 1.e9, FPlatformTime::ToSeconds64(BatchedCycles) / NumSamples * 1.e9,
+				100.0 * BatchedCycles / FMath::Max<uint64>(PerSampleCycles, 1)));
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,91 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+#include "DS5WTestPatterns.h"
+
+// Frames measured after the clock mapping settled, and where in the frame the render thread asks
+#define DS5W_MOTION_LATCH_TEST_WARMUP 60
+#define DS5W_MOTION_LATCH_TEST_FRAMES 600
+#define DS5W_MOTION_LATCH_TEST_QUERY_POINT 0.9
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WMotionLatchLatencyTest, "DS5W.MotionLatch.Latency", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WMotionLatchLatencyTest::RunTest(const FString& Parameters)
+{
+	const double FrameInterval = 1.0 / 60.0;
+	const FDS5WPadEmulatorSettings Settings = FDS5WPadEmulatorSettings::Usb();
+
+	FDS5WHeadlessHarness Harness(1, FrameInterval, Settings.ReportInterval);
+	FDS5WPadEmulator& Pad = Harness.EmulatePad(0, Settings);
+	FDS5WInterface& Interface = Harness.GetInterface();
+	Interface.AddInputConsumer(DS5W_DECODE_MOTION);
+
+	// Gap between a query and the capture of the newest motion it reflects
+	double MaxLatchGap = 0.0;
+	double TotalLatchGap = 0.0;
+	double TotalFrameGap = 0.0;
+	double MaxAngleError = 0.0;
+
+	for (int32 Frame = 0; Frame < DS5W_MOTION_LATCH_TEST_WARMUP + DS5W_MOTION_LATCH_TEST_FRAMES; ++Frame)
+	{
+		Pad.SetState(DS5WTest::MakeMovingState(Harness.GetTime()));
+		Harness.RunFrame();
+		if (Frame < DS5W_MOTION_LATCH_TEST_WARMUP)
+		{
+			continue;
+		}
+
+		// Right after the frame the newest report is the one the frame fused
+		FQuat FrameOrientation;
+		FQuat Unused;
+		double FrameReportTime = 0.0;
+		if (!Interface.GetOrientation(0, FrameOrientation) || !Interface.GetLatestOrientation(0, Unused, FrameReportTime))
+		{
+			AddError(FString::Printf(TEXT("No orientation after frame %d."), Frame));
+			return false;
+		}
+		const double FrameCaptureTime = Pad.GetLastCaptureTime();
+
+		// The render thread asks late in the frame, the pad kept reporting meanwhile
+		const double QueryTime = Harness.GetTime() + DS5W_MOTION_LATCH_TEST_QUERY_POINT * FrameInterval;
+		Pad.Advance(QueryTime);
+
+		FQuat LatchedOrientation;
+		double LatchedTime = 0.0;
+		if (!Interface.GetLatestOrientation(0, LatchedOrientation, LatchedTime))
+		{
+			AddError(FString::Printf(TEXT("No latched orientation in frame %d."), Frame));
+			return false;
+		}
+
+		const double LatchGap = QueryTime - LatchedTime;
+		MaxLatchGap = FMath::Max(MaxLatchGap, LatchGap);
+		TotalLatchGap += LatchGap;
+		TotalFrameGap += QueryTime - FrameReportTime;
+
+		// The latched orientation is the frame's turned by the gyro since, the pad turns at a constant rate
+		const double ExpectedAngle = FMath::DegreesToRadians(90.0) * (Pad.GetLastCaptureTime() - FrameCaptureTime);
+		MaxAngleError = FMath::Max(MaxAngleError, FMath::Abs(FrameOrientation.AngularDistance(LatchedOrientation) - ExpectedAngle));
+	}
+
+	Interface.RemoveInputConsumer(DS5W_DECODE_MOTION);
+
+	const double MeanLatchGap = TotalLatchGap / DS5W_MOTION_LATCH_TEST_FRAMES;
+	const double MeanFrameGap = TotalFrameGap / DS5W_MOTION_LATCH_TEST_FRAMES;
+	AddInfo(FString::Printf(TEXT("Motion to query: %.2f ms latched (max %.2f ms), %.2f ms from the frame"), MeanLatchGap * 1.e3, MaxLatchGap * 1.e3, MeanFrameGap * 1.e3));
+
+	// Mapped capture times include the fastest transport latency, the newest report may be late by the jitter
+	const double MaxExpectedGap = Settings.ReportInterval + Settings.MinLatency + Settings.MaxJitter + 0.001;
+	TestTrue(FString::Printf(TEXT("Latched motion is at most one report interval old (%.2f ms)"), MaxLatchGap * 1.e3), MaxLatchGap <= MaxExpectedGap);
+	TestTrue(TEXT("Frame motion is about a frame old"), MeanFrameGap >= DS5W_MOTION_LATCH_TEST_QUERY_POINT * FrameInterval);
+	TestTrue(FString::Printf(TEXT("Latched rotation matches the gyro (off by %.4f rad)"), MaxAngleError), MaxAngleError < FMath::DegreesToRadians(0.01));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
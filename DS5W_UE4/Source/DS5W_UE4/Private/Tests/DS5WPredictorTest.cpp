@@ -0,0 +1,77 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInputHistory.h"
+#include "DS5WInterface.h"
+#include "DS5WPredictor.h"
+#include "DS5WTestPatterns.h"
+
+// Seconds recorded, the first of them only settle the clock mapping
+#define DS5W_PREDICTOR_TEST_WARMUP 0.5
+#define DS5W_PREDICTOR_TEST_DURATION 2.5
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WPredictorErrorTest, "DS5W.Predictor.Error", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WPredictorErrorTest::RunTest(const FString& Parameters)
+{
+	// The pad moves every millisecond and reports at the USB rate, so the trace is smooth between reports
+	const FDS5WPadEmulatorSettings Settings = FDS5WPadEmulatorSettings::Usb();
+	FDS5WHeadlessHarness Harness(1, 0.001, Settings.ReportInterval);
+	FDS5WPadEmulator& Pad = Harness.EmulatePad(0, Settings);
+
+	const double StartTime = Harness.GetTime();
+	while (Harness.GetTime() < StartTime + DS5W_PREDICTOR_TEST_DURATION)
+	{
+		// Sticks from the common pattern, the gyro swings like a player aiming back and forth
+		const double Time = Harness.GetTime() - StartTime;
+		DS5W::DS5InputState State = DS5WTest::MakeMovingState(Time);
+		State.imuState.gyroX = 120.f * FMath::Cos((float)(Time * 3.0 * PI));
+		State.imuState.gyroY = 200.f * FMath::Sin((float)(Time * 3.0 * PI));
+
+		Pad.SetState(State);
+		Harness.RunFrame();
+		Harness.ResetEvents();
+	}
+
+	// The recorded trace straight from the history
+	const FDS5WInputHistory* History = Harness.GetInterface().GetInputHistory(0);
+	TArray<FDS5WInputHistoryEntry> Entries;
+	Entries.SetNumUninitialized(History->GetCapacity());
+	Entries.SetNum(History->GetEntriesInRange(StartTime + DS5W_PREDICTOR_TEST_WARMUP, Harness.GetTime(), Entries.GetData(), Entries.Num()));
+	if (!TestTrue(TEXT("History holds the trace"), Entries.Num() > 250))
+	{
+		return false;
+	}
+
+	// Default gains
+	const FDS5WPredictionSettings PredictionSettings;
+
+	const float Horizons[] = { 0.004f, 0.008f, 0.012f, 0.016f };
+	FDS5WPredictionError Errors[UE_ARRAY_COUNT(Horizons)];
+	FDS5WPredictor::MeasureError(PredictionSettings, Entries.GetData(), Entries.Num(), Horizons, UE_ARRAY_COUNT(Horizons), Errors);
+
+	for (const FDS5WPredictionError& Error : Errors)
+	{
+		AddInfo(FString::Printf(TEXT("%.0f ms over %d reports: sticks %.4f (held %.4f), gyro %.2f deg/s (held %.2f deg/s)"),
+			Error.Horizon * 1.e3f, Error.NumSamples, Error.StickError, Error.StickHoldError, Error.GyroError, Error.GyroHoldError));
+
+		// Smooth motion is what the predictor is for, it has to clearly beat holding the newest report
+		TestTrue(FString::Printf(TEXT("Predicted sticks %.0f ms ahead beat holding them"), Error.Horizon * 1.e3f), Error.NumSamples > 0 && Error.StickError < 0.5f * Error.StickHoldError);
+		TestTrue(FString::Printf(TEXT("Predicted gyro %.0f ms ahead beats holding it"), Error.Horizon * 1.e3f), Error.NumSamples > 0 && Error.GyroError < 0.5f * Error.GyroHoldError);
+	}
+
+	// Further ahead is never more accurate
+	for (int32 Index = 1; Index < UE_ARRAY_COUNT(Errors); ++Index)
+	{
+		TestTrue(TEXT("Stick error grows with the horizon"), Errors[Index].StickError >= Errors[Index - 1].StickError);
+		TestTrue(TEXT("Gyro error grows with the horizon"), Errors[Index].GyroError >= Errors[Index - 1].GyroError);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,149 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+#include "DS5WQuatCodec.h"
+#include "DS5WTestPatterns.h"
+#include "HAL/PlatformTime.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+// Simulated seconds of fused orientations, and how often the timing encodes and decodes all of them
+#define DS5W_QUAT_CODEC_TEST_DURATION 10.0
+#define DS5W_QUAT_CODEC_TEST_TIMING_REPEATS 20
+
+namespace
+{
+	/** Fused orientation of a pad tumbling around all three axes, once per 60 Hz frame */
+	void RecordOrientations(TArray<FQuat>& OutOrientations, TArray<double>& OutTimes)
+	{
+		FDS5WHeadlessHarness Harness(1);
+		FDS5WPadEmulator& Pad = Harness.EmulatePad(0, FDS5WPadEmulatorSettings::Usb());
+		FDS5WInterface& Interface = Harness.GetInterface();
+		Interface.AddInputConsumer(DS5W_DECODE_MOTION);
+
+		const double StartTime = Harness.GetTime();
+		while (Harness.GetTime() < StartTime + DS5W_QUAT_CODEC_TEST_DURATION)
+		{
+			const double Time = Harness.GetTime() - StartTime;
+			DS5W::DS5InputState State = DS5WTest::MakeMovingState(Time);
+			State.imuState.gyroX = 150.f * FMath::Sin((float)(Time * 0.7 * PI));
+			State.imuState.gyroY = 200.f * FMath::Cos((float)(Time * 0.5 * PI));
+			State.imuState.gyroZ = 120.f + 60.f * FMath::Sin((float)(Time * 1.3 * PI));
+			Pad.SetState(State);
+
+			Harness.RunFrame();
+			Harness.ResetEvents();
+
+			FQuat Orientation;
+			if (Interface.GetOrientation(0, Orientation))
+			{
+				OutOrientations.Add(Orientation.GetNormalized());
+				OutTimes.Add(Harness.GetTime());
+			}
+		}
+
+		Interface.RemoveInputConsumer(DS5W_DECODE_MOTION);
+	}
+
+	/** Rotation between two orientations in radians, from the chord so it stays precise for tiny angles */
+	double GetAngle(const FQuat& A, const FQuat& B)
+	{
+		const double Minus = FMath::Sqrt(FMath::Square((double)A.X - B.X) + FMath::Square((double)A.Y - B.Y) + FMath::Square((double)A.Z - B.Z) + FMath::Square((double)A.W - B.W));
+		const double Plus = FMath::Sqrt(FMath::Square((double)A.X + B.X) + FMath::Square((double)A.Y + B.Y) + FMath::Square((double)A.Z + B.Z) + FMath::Square((double)A.W + B.W));
+		return 4.0 * FMath::Asin(FMath::Min(FMath::Min(Minus, Plus) * 0.5, 1.0));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WQuatCodecTest, "DS5W.QuatCodec.Error", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WQuatCodecTest::RunTest(const FString& Parameters)
+{
+	TArray<FQuat> Orientations;
+	TArray<double> Times;
+	RecordOrientations(Orientations, Times);
+	if (!TestTrue(TEXT("Orientations recorded"), Orientations.Num() > DS5W_QUAT_CODEC_TEST_DURATION * 60.0 * 0.9))
+	{
+		return false;
+	}
+
+	// The trace has to reach every dropped component for the error to cover the codec
+	int32 NumLargest[4] = {};
+	for (const FQuat& Orientation : Orientations)
+	{
+		++NumLargest[FDS5WQuatCodec::Encode(Orientation, 10) & 3];
+	}
+	TestTrue(FString::Printf(TEXT("Every component dropped somewhere (%d, %d, %d, %d)"), NumLargest[0], NumLargest[1], NumLargest[2], NumLargest[3]),
+		NumLargest[0] > 0 && NumLargest[1] > 0 && NumLargest[2] > 0 && NumLargest[3] > 0);
+
+	for (const int32 Bits : { FDS5WQuatCodec::MinBitsPerComponent, 8, 10, 12, 15, FDS5WQuatCodec::MaxBitsPerComponent })
+	{
+		// Each kept component is off by up to half a step and the rebuilt one follows, which turns the
+		// orientation by up to about 2 * sqrt(3) steps. Some room on top for the coarsest depths
+		const double Step = 2.0 * 0.70710678 / ((1 << Bits) - 1);
+		const double MaxExpectedAngle = 2.5 * FMath::Sqrt(3.0) * Step + 1.e-5;
+
+		double MaxAngle = 0.0;
+		double SumAngle = 0.0;
+		bool bSerializedEqual = true;
+		for (const FQuat& Orientation : Orientations)
+		{
+			const uint64 Packed = FDS5WQuatCodec::Encode(Orientation, Bits);
+			const FQuat Decoded = FDS5WQuatCodec::Decode(Packed, Bits);
+			const double Angle = GetAngle(Orientation, Decoded);
+			MaxAngle = FMath::Max(MaxAngle, Angle);
+			SumAngle += Angle;
+
+			// The archive path writes exactly GetNumBits and reads back what Decode gives
+			FBitWriter Writer(0, true);
+			FQuat Written = Orientation;
+			FDS5WQuatCodec::Serialize(Writer, Written, Bits);
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			FQuat Read;
+			FDS5WQuatCodec::Serialize(Reader, Read, Bits);
+			bSerializedEqual &= Writer.GetNumBits() == FDS5WQuatCodec::GetNumBits(Bits) && !Reader.IsError() && Read.Equals(Decoded, 0.f);
+		}
+
+		TestTrue(FString::Printf(TEXT("%d bits: error %.4f deg within %.4f deg"), Bits, FMath::RadiansToDegrees(MaxAngle), FMath::RadiansToDegrees(MaxExpectedAngle)), MaxAngle <= MaxExpectedAngle);
+		TestTrue(FString::Printf(TEXT("%d bits: serialized like Encode and Decode"), Bits), bSerializedEqual);
+
+		// Reported, not checked: timings depend on the machine
+		uint64 Cycles = 0;
+		uint64 Checksum = 0;
+		for (int32 Repeat = 0; Repeat < DS5W_QUAT_CODEC_TEST_TIMING_REPEATS; ++Repeat)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			for (const FQuat& Orientation : Orientations)
+			{
+				Checksum += (uint64)(FDS5WQuatCodec::Decode(FDS5WQuatCodec::Encode(Orientation, Bits), Bits).W * 1000.f);
+			}
+			Cycles += FPlatformTime::Cycles64() - StartCycles;
+		}
+
+		AddInfo(FString::Printf(TEXT("%d bits: %d bits per orientation, %.0f bytes/s at 60 Hz, error mean %.4f deg max %.4f deg, %.1f ns per encode and decode (%llu)"),
+			Bits, FDS5WQuatCodec::GetNumBits(Bits), FDS5WQuatCodec::GetNumBits(Bits) * 60.0 / 8.0, FMath::RadiansToDegrees(SumAngle / Orientations.Num()), FMath::RadiansToDegrees(MaxAngle),
+			FPlatformTime::ToSeconds64(Cycles) / ((double)Orientations.Num() * DS5W_QUAT_CODEC_TEST_TIMING_REPEATS) * 1.e9, Checksum));
+	}
+
+	// A receiver that gets every other frame interpolates the ones in between
+	FDS5WOrientationStream Stream(15);
+	double MaxInterpolatedAngle = 0.0;
+	Stream.AddSample(Times[0], FDS5WQuatCodec::Encode(Orientations[0], 15));
+	for (int32 Index = 0; Index + 2 < Orientations.Num(); Index += 2)
+	{
+		Stream.AddSample(Times[Index + 2], FDS5WQuatCodec::Encode(Orientations[Index + 2], 15));
+
+		FQuat Interpolated;
+		TestTrue(TEXT("Stream has samples"), Stream.Sample(Times[Index + 1], Interpolated));
+		MaxInterpolatedAngle = FMath::Max(MaxInterpolatedAngle, GetAngle(Orientations[Index + 1], Interpolated));
+	}
+	AddInfo(FString::Printf(TEXT("30 Hz stream at 15 bits, largest error of the interpolated frames %.3f deg"), FMath::RadiansToDegrees(MaxInterpolatedAngle)));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,151 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+#include "DS5WReportSubscribers.h"
+#include "DS5WSnapshot.h"
+#include "DS5WTestPatterns.h"
+#include "Math/RandomStream.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+// Simulated seconds of the recorded trace
+#define DS5W_SNAPSHOT_TEST_DURATION 10.0
+
+namespace
+{
+	/** Reports of a pad moving like the common pattern plus sensor noise, and the last report of each frame */
+	void RecordSnapshots(TArray<FDS5WSnapshot>& OutReports, TArray<int32>& OutFrameEnds, TArray<DS5W::DS5InputState>& OutStates)
+	{
+		FDS5WHeadlessHarness Harness(1);
+		FDS5WPadEmulator& Pad = Harness.EmulatePad(0, FDS5WPadEmulatorSettings::Usb());
+		FDS5WReportSubscribers& Subscribers = Harness.GetInterface().GetReportSubscribers();
+		FDS5WReportSubscription Subscription = Subscribers.Subscribe(nullptr, true);
+
+		FRandomStream Random(31);
+		FDS5WRawReport Report;
+		const double StartTime = Harness.GetTime();
+		while (Harness.GetTime() < StartTime + DS5W_SNAPSHOT_TEST_DURATION)
+		{
+			DS5W::DS5InputState State = DS5WTest::MakeMovingState(Harness.GetTime() - StartTime);
+			DS5W::IMUState& IMU = State.imuState;
+			IMU.gyroX = 0.5f * Random.FRandRange(-1.f, 1.f);
+			IMU.gyroY += 0.5f * Random.FRandRange(-1.f, 1.f);
+			IMU.gyroZ = 0.5f * Random.FRandRange(-1.f, 1.f);
+			IMU.accelX = 0.005f * Random.FRandRange(-1.f, 1.f);
+			IMU.accelY = 0.005f * Random.FRandRange(-1.f, 1.f);
+			IMU.accelZ += 0.005f * Random.FRandRange(-1.f, 1.f);
+			Pad.SetState(State);
+
+			Harness.RunFrame();
+			Harness.ResetEvents();
+
+			while (Subscribers.Dequeue(Subscription, Report))
+			{
+				OutReports.AddDefaulted_GetRef().FromInputState(Report.State);
+				OutStates.Add(Report.State);
+			}
+			if (OutReports.Num() > 0 && (OutFrameEnds.Num() == 0 || OutFrameEnds.Last() != OutReports.Num() - 1))
+			{
+				OutFrameEnds.Add(OutReports.Num() - 1);
+			}
+		}
+
+		Subscribers.Unsubscribe(Subscription);
+	}
+
+	/**
+	 * Serialize every snapshot of a sequence, each against the one sent before it if bDelta, and read it
+	 * back the way the receiving side would. Returns the bits sent, or -1 if a snapshot didn't come back equal.
+	 */
+	int64 RoundTrip(const TArray<FDS5WSnapshot>& Snapshots, const TArray<int32>& Indices, bool bDelta)
+	{
+		int64 NumBits = 0;
+		FDS5WSnapshot ReceivedBaseline;
+		for (int32 Step = 0; Step < Indices.Num(); ++Step)
+		{
+			FDS5WSnapshot Sent = Snapshots[Indices[Step]];
+			const FDS5WSnapshot* Baseline = bDelta && Step > 0 ? &Snapshots[Indices[Step - 1]] : nullptr;
+
+			FBitWriter Writer(0, true);
+			if (!Sent.NetSerialize(Writer, Baseline))
+			{
+				return -1;
+			}
+			NumBits += Writer.GetNumBits();
+
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			FDS5WSnapshot Received;
+			if (!Received.NetSerialize(Reader, Baseline ? &ReceivedBaseline : nullptr) || Reader.GetBitsLeft() != 0 || !DS5WTest::SnapshotsEqual(Received, Sent))
+			{
+				return -1;
+			}
+			ReceivedBaseline = Received;
+		}
+		return NumBits;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WSnapshotTest, "DS5W.Snapshot.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WSnapshotTest::RunTest(const FString& Parameters)
+{
+	TArray<FDS5WSnapshot> Snapshots;
+	TArray<int32> FrameEnds;
+	TArray<DS5W::DS5InputState> States;
+	RecordSnapshots(Snapshots, FrameEnds, States);
+	if (!TestTrue(TEXT("Reports recorded"), Snapshots.Num() > DS5W_SNAPSHOT_TEST_DURATION * 250.0 * 0.9))
+	{
+		return false;
+	}
+
+	// Quantisation stays within half a step of the reported IMU
+	const float GyroStep = 2000.f / ((1 << (DS5W_SNAPSHOT_GYRO_BITS - 1)) - 1);
+	const float AccelStep = 4.f / ((1 << (DS5W_SNAPSHOT_ACCEL_BITS - 1)) - 1);
+	float MaxGyroError = 0.f;
+	float MaxAccelError = 0.f;
+	for (int32 Index = 0; Index < Snapshots.Num(); ++Index)
+	{
+		DS5W::DS5InputState Expanded;
+		Snapshots[Index].ToInputState(Expanded);
+		const DS5W::IMUState& Original = States[Index].imuState;
+		MaxGyroError = FMath::Max3(MaxGyroError, FMath::Abs(Expanded.imuState.gyroX - Original.gyroX), FMath::Max(FMath::Abs(Expanded.imuState.gyroY - Original.gyroY), FMath::Abs(Expanded.imuState.gyroZ - Original.gyroZ)));
+		MaxAccelError = FMath::Max3(MaxAccelError, FMath::Abs(Expanded.imuState.accelX - Original.accelX), FMath::Max(FMath::Abs(Expanded.imuState.accelY - Original.accelY), FMath::Abs(Expanded.imuState.accelZ - Original.accelZ)));
+	}
+	TestTrue(FString::Printf(TEXT("Gyro within half a step (%.4f deg/s)"), MaxGyroError), MaxGyroError <= 0.5f * GyroStep * 1.001f);
+	TestTrue(FString::Printf(TEXT("Accelerometer within half a step (%.5f g)"), MaxAccelError), MaxAccelError <= 0.5f * AccelStep * 1.001f);
+
+	// Every report, as a recorder would keep them, and the newest report per frame, as replication sends them
+	TArray<int32> EveryReport;
+	for (int32 Index = 0; Index < Snapshots.Num(); ++Index)
+	{
+		EveryReport.Add(Index);
+	}
+
+	struct FSequence
+	{
+		const TCHAR* Name;
+		const TArray<int32>& Indices;
+	};
+	const FSequence Sequences[] = { { TEXT("every report"), EveryReport }, { TEXT("one per frame"), FrameEnds } };
+	for (const FSequence& Sequence : Sequences)
+	{
+		const int64 FullBits = RoundTrip(Snapshots, Sequence.Indices, false);
+		const int64 DeltaBits = RoundTrip(Snapshots, Sequence.Indices, true);
+		TestTrue(FString::Printf(TEXT("%s: full snapshots decode equal"), Sequence.Name), FullBits > 0);
+		TestTrue(FString::Printf(TEXT("%s: delta snapshots decode equal"), Sequence.Name), DeltaBits > 0);
+		TestTrue(FString::Printf(TEXT("%s: delta is smaller"), Sequence.Name), DeltaBits > 0 && DeltaBits < FullBits);
+
+		AddInfo(FString::Printf(TEXT("%s: %.1f bytes full, %.1f bytes delta per snapshot, %.0f and %.0f bytes/s (DS5InputState %d bytes)"), Sequence.Name,
+			FullBits / 8.0 / Sequence.Indices.Num(), DeltaBits / 8.0 / Sequence.Indices.Num(),
+			FullBits / 8.0 / DS5W_SNAPSHOT_TEST_DURATION, DeltaBits / 8.0 / DS5W_SNAPSHOT_TEST_DURATION, (int32)sizeof(DS5W::DS5InputState)));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,384 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInputHistory.h"
+#include "DS5WInterface.h"
+#include "DS5WStats.h"
+#include "DS5WStreamServer.h"
+#include "DS5WTestPatterns.h"
+#include "HAL/PlatformTime.h"
+#include "IPAddress.h"
+#include "Misc/Timespan.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+// Next to the default port, so a game streaming on this machine isn't disturbed
+#define DS5W_STREAM_TEST_PORT (DS5W_STREAM_DEFAULT_PORT + 1)
+
+// Frames per chunk stay well below the history capacity, the client catches up after each chunk
+#define DS5W_STREAM_TEST_CHUNKS 10
+#define DS5W_STREAM_TEST_CHUNK_FRAMES 25
+
+// Real seconds to wait for the server thread before giving up
+#define DS5W_STREAM_TEST_TIMEOUT 2.0
+
+namespace
+{
+	/** The tool end of the stream: subscribes, sends commands and checks every record against the histories */
+	class FStreamTestClient
+	{
+	public:
+
+		FStreamTestClient(const FDS5WInterface& InInterface, int32 InNumControllers)
+			: Interface(InInterface)
+			, NumControllers(InNumControllers)
+			, Socket(nullptr)
+			, NumDatagrams(0)
+			, NumRecords(0)
+			, NumMismatches(0)
+			, NumMalformed(0)
+		{
+			ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+			ServerAddr = SocketSubsystem->CreateInternetAddr();
+			ServerAddr->SetLoopbackAddress();
+			ServerAddr->SetPort(DS5W_STREAM_TEST_PORT);
+
+			TSharedRef<FInternetAddr> LocalAddr = SocketSubsystem->CreateInternetAddr();
+			LocalAddr->SetLoopbackAddress();
+			LocalAddr->SetPort(0);
+
+			Socket = SocketSubsystem->CreateSocket(NAME_DGram, TEXT("DS5W stream test"), ServerAddr->GetProtocolType());
+			if (Socket && (!Socket->SetNonBlocking(true) || !Socket->Bind(*LocalAddr)))
+			{
+				SocketSubsystem->DestroySocket(Socket);
+				Socket = nullptr;
+			}
+
+			NextIndices.Init(MAX_uint64, NumControllers);
+			Writes.SetNum(NumControllers);
+			NextWrites.Init(0, NumControllers);
+		}
+
+		~FStreamTestClient()
+		{
+			if (Socket)
+			{
+				ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+			}
+		}
+
+		bool IsValid() const { return Socket != nullptr; }
+
+		/** Send commands, or only keep the subscription without any */
+		bool Send(const FDS5WStreamCommand* Commands, int32 NumCommands)
+		{
+			TArray<uint8> Data;
+			FDS5WStreamServer::EncodeCommands(Commands, NumCommands, Data);
+
+			int32 BytesSent = 0;
+			return Socket->SendTo(Data.GetData(), Data.Num(), BytesSent, *ServerAddr) && BytesSent == Data.Num();
+		}
+
+		/**
+		 * Note that the histories were written up to where they are now, by code that started at StartTime
+		 * (FPlatformTime::Seconds). Records of those reports are timed from then until they were received.
+		 */
+		void AddWrites(double StartTime)
+		{
+			for (int32 ControllerId = 0; ControllerId < NumControllers; ++ControllerId)
+			{
+				Writes[ControllerId].Add(FHistoryWrite{ Interface.GetInputHistory(ControllerId)->GetNumWritten(), StartTime });
+			}
+		}
+
+		/** Wait up to Seconds for a datagram, then take in everything that arrived */
+		void WaitAndReceive(double Seconds)
+		{
+			Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(Seconds));
+			Receive();
+		}
+
+		/** Decode everything that arrived and compare it with what the histories hold */
+		void Receive()
+		{
+			uint8 Data[DS5W_STREAM_MAX_DATAGRAM_BYTES];
+			int32 NumBytes = 0;
+			TSharedRef<FInternetAddr> Sender = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+			while (Socket->RecvFrom(Data, sizeof(Data), NumBytes, *Sender))
+			{
+				const double ReceiveTime = FPlatformTime::Seconds();
+				if (!FDS5WStreamServer::DecodeSamples(Data, NumBytes, Samples))
+				{
+					++NumMalformed;
+					continue;
+				}
+
+				++NumDatagrams;
+				for (const FDS5WStreamSample& Sample : Samples)
+				{
+					CheckSample(Sample, ReceiveTime);
+				}
+			}
+		}
+
+		/** True once every controller streamed and the client holds everything written since */
+		bool IsCaughtUp() const
+		{
+			for (int32 ControllerId = 0; ControllerId < NumControllers; ++ControllerId)
+			{
+				if (NextIndices[ControllerId] != Interface.GetInputHistory(ControllerId)->GetNumWritten())
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		int32 NumDatagrams;
+		int32 NumRecords;
+		int32 NumMismatches;
+		int32 NumMalformed;
+
+		/** From writing a report into the history until its record was received, in nanoseconds */
+		FDS5WHistogram Latency;
+
+	private:
+
+		/** Every report before NumWritten was in the history by the end of code started at StartTime */
+		struct FHistoryWrite
+		{
+			uint64 NumWritten;
+			double StartTime;
+		};
+
+		void CheckSample(const FDS5WStreamSample& Sample, double ReceiveTime)
+		{
+			++NumRecords;
+			if (Sample.ControllerId < 0 || Sample.ControllerId >= NumControllers)
+			{
+				++NumMismatches;
+				return;
+			}
+
+			const FDS5WInputHistory& History = *Interface.GetInputHistory(Sample.ControllerId);
+			uint64& NextIndex = NextIndices[Sample.ControllerId];
+
+			// The stream starts wherever the server was when the subscription came in
+			FDS5WInputHistoryEntry Entry;
+			if (NextIndex == MAX_uint64)
+			{
+				NextIndex = History.FindFirstAfter(Sample.CaptureTime);
+				while (NextIndex > 0 && History.GetEntry(NextIndex - 1, Entry) && Entry.CaptureTime == Sample.CaptureTime)
+				{
+					--NextIndex;
+				}
+			}
+
+			// Every report in order, none skipped
+			const uint64 Index = NextIndex++;
+			const bool bMatches = History.GetEntry(Index, Entry) && Entry.CaptureTime == Sample.CaptureTime && Entry.bConnected == Sample.bConnected
+				&& (!Entry.bConnected || DS5WTest::SnapshotsEqual(Entry.Snapshot, Sample.Snapshot));
+			NumMismatches += bMatches ? 0 : 1;
+
+			// Capture times are simulated, the write that brought the report into the history is real. Records
+			// arrive in order, so the writes are searched from where the previous record was found
+			const TArray<FHistoryWrite>& ControllerWrites = Writes[Sample.ControllerId];
+			int32& NextWrite = NextWrites[Sample.ControllerId];
+			while (NextWrite < ControllerWrites.Num() && ControllerWrites[NextWrite].NumWritten <= Index)
+			{
+				++NextWrite;
+			}
+			if (bMatches && NextWrite < ControllerWrites.Num())
+			{
+				Latency.Record((uint64)(FMath::Max(ReceiveTime - ControllerWrites[NextWrite].StartTime, 0.0) * 1.e9));
+			}
+		}
+
+		const FDS5WInterface& Interface;
+		int32 NumControllers;
+
+		FSocket* Socket;
+		TSharedPtr<FInternetAddr> ServerAddr;
+
+		TArray<FDS5WStreamSample> Samples;
+
+		/** History index the next record of each controller has to match, MAX_uint64 before its first */
+		TArray<uint64> NextIndices;
+
+		/** Per controller: how far the histories were written by when, and the first write a record may be from */
+		TArray<TArray<FHistoryWrite>> Writes;
+		TArray<int32> NextWrites;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WStreamCommandCodecTest, "DS5W.Stream.CommandCodec", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WStreamCommandCodecTest::RunTest(const FString& Parameters)
+{
+	FDS5WStreamCommand Commands[3];
+	FMemory::Memzero(Commands);
+	Commands[0].ControllerId = 0;
+	Commands[0].Type = EDS5WStreamCommandType::Rumble;
+	Commands[0].Data[0] = 200;
+	Commands[0].Data[1] = 40;
+	Commands[1].ControllerId = 1;
+	Commands[1].Type = EDS5WStreamCommandType::Lightbar;
+	Commands[1].Data[0] = 255;
+	Commands[1].Data[2] = 128;
+	Commands[2].ControllerId = 3;
+	Commands[2].Type = EDS5WStreamCommandType::TriggerEffect;
+	for (int32 Byte = 0; Byte < UE_ARRAY_COUNT(Commands[2].Data); ++Byte)
+	{
+		Commands[2].Data[Byte] = (uint8)(Byte * 31 + 1);
+	}
+	Commands[2].Data[0] = 1;
+
+	TArray<uint8> Data;
+	TArray<FDS5WStreamCommand> Decoded;
+	EDS5WStreamDatagramType Type;
+
+	FDS5WStreamServer::EncodeCommands(Commands, UE_ARRAY_COUNT(Commands), Data);
+	TestEqual(TEXT("Datagram size"), Data.Num(), (int32)(DS5W_STREAM_HEADER_BYTES + UE_ARRAY_COUNT(Commands) * DS5W_STREAM_COMMAND_BYTES));
+	if (TestTrue(TEXT("Commands decode"), FDS5WStreamServer::DecodeCommands(Data.GetData(), Data.Num(), Type, Decoded)) && TestEqual(TEXT("Command count"), Decoded.Num(), (int32)UE_ARRAY_COUNT(Commands)))
+	{
+		TestTrue(TEXT("Commands datagram"), Type == EDS5WStreamDatagramType::Commands);
+		for (int32 Index = 0; Index < Decoded.Num(); ++Index)
+		{
+			TestTrue(FString::Printf(TEXT("Command %d round trips"), Index), Decoded[Index].ControllerId == Commands[Index].ControllerId && Decoded[Index].Type == Commands[Index].Type
+				&& FMemory::Memcmp(Decoded[Index].Data, Commands[Index].Data, sizeof(Commands[Index].Data)) == 0);
+		}
+	}
+
+	// Truncated or foreign datagrams never decode
+	TestFalse(TEXT("Truncated commands are rejected"), FDS5WStreamServer::DecodeCommands(Data.GetData(), Data.Num() - 1, Type, Decoded));
+	TArray<FDS5WStreamSample> Samples;
+	TestFalse(TEXT("Commands aren't samples"), FDS5WStreamServer::DecodeSamples(Data.GetData(), Data.Num(), Samples));
+	Data[0] ^= 0xFF;
+	TestFalse(TEXT("Wrong magic is rejected"), FDS5WStreamServer::DecodeCommands(Data.GetData(), Data.Num(), Type, Decoded));
+
+	FDS5WStreamServer::EncodeCommands(nullptr, 0, Data);
+	TestTrue(TEXT("Subscribe decodes"), FDS5WStreamServer::DecodeCommands(Data.GetData(), Data.Num(), Type, Decoded) && Type == EDS5WStreamDatagramType::Subscribe && Decoded.Num() == 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WStreamLoopbackTest, "DS5W.Stream.Loopback", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WStreamLoopbackTest::RunTest(const FString& Parameters)
+{
+	// A wired and a wireless pad, the server follows the harness interface's histories
+	FDS5WHeadlessHarness Harness(2);
+	FDS5WPadEmulator* Pads[] = { &Harness.EmulatePad(0, FDS5WPadEmulatorSettings::Usb()), &Harness.EmulatePad(1, FDS5WPadEmulatorSettings::Bluetooth()) };
+	const FDS5WInterface& Interface = Harness.GetInterface();
+
+	FDS5WStreamServer Server(Interface.GetInputHistory(0), (int32)UE_ARRAY_COUNT(Pads));
+	if (!TestTrue(TEXT("Server starts"), Server.Start(DS5W_STREAM_TEST_PORT)))
+	{
+		return false;
+	}
+
+	FStreamTestClient Client(Interface, (int32)UE_ARRAY_COUNT(Pads));
+	if (!TestTrue(TEXT("Client socket"), Client.IsValid()))
+	{
+		return false;
+	}
+
+	// The client takes in what arrived after every frame, so records are timed as soon as they're there
+	auto RunFrame = [&Harness, &Pads, &Client]()
+	{
+		for (FDS5WPadEmulator* Pad : Pads)
+		{
+			Pad->SetState(DS5WTest::MakeMovingState(Harness.GetTime()));
+		}
+		const double FrameStartTime = FPlatformTime::Seconds();
+		Harness.RunFrame();
+		Client.AddWrites(FrameStartTime);
+		Client.Receive();
+	};
+
+	auto WaitUntil = [&Client](TFunctionRef<bool()> Condition)
+	{
+		const double Deadline = FPlatformTime::Seconds() + DS5W_STREAM_TEST_TIMEOUT;
+		while (!Condition())
+		{
+			if (FPlatformTime::Seconds() >= Deadline)
+			{
+				return false;
+			}
+
+			Client.WaitAndReceive(0.001);
+		}
+		return true;
+	};
+
+	// Subscribing takes a round of the server thread, until then reports go nowhere
+	const bool bSubscribed = WaitUntil([&]()
+	{
+		Client.Send(nullptr, 0);
+		RunFrame();
+		return Client.NumDatagrams > 0;
+	});
+	if (!TestTrue(TEXT("Samples arrive after subscribing"), bSubscribed))
+	{
+		return false;
+	}
+
+	const int32 NumRecordsBefore = Client.NumRecords;
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	for (int32 Chunk = 0; Chunk < DS5W_STREAM_TEST_CHUNKS; ++Chunk)
+	{
+		// Keep the subscription, and take the wireless pad away once so disconnect records go out too
+		Client.Send(nullptr, 0);
+		for (int32 Frame = 0; Frame < DS5W_STREAM_TEST_CHUNK_FRAMES; ++Frame)
+		{
+			if (Chunk == DS5W_STREAM_TEST_CHUNKS / 2 && Frame == 0)
+			{
+				const double DisconnectTime = FPlatformTime::Seconds();
+				Harness.Disconnect(1);
+				Client.AddWrites(DisconnectTime);
+			}
+			RunFrame();
+		}
+
+		if (!TestTrue(FString::Printf(TEXT("Client caught up after chunk %d"), Chunk), WaitUntil([&Client]() { return Client.IsCaughtUp(); })))
+		{
+			break;
+		}
+	}
+	const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	// Reported, not checked: timings depend on the machine. Latency runs from the start of the frame that
+	// wrote a report into the history until the client received its record, so it includes the rest of
+	// that frame and the server thread's polling
+	AddInfo(FString::Printf(TEXT("%d records in %d datagrams (%.1f per datagram) in %.1f ms, %.0f records/s"), Client.NumRecords, Client.NumDatagrams,
+		(float)Client.NumRecords / FMath::Max(Client.NumDatagrams, 1), Seconds * 1.e3, (Client.NumRecords - NumRecordsBefore) / FMath::Max(Seconds, 1.e-9)));
+	AddInfo(FString::Printf(TEXT("History to client latency: min %.3f ms, p50 %.3f ms, p99 %.3f ms over %llu records"), Client.Latency.GetMin() / 1.e6,
+		Client.Latency.GetPercentile(0.5) / 1.e6, Client.Latency.GetPercentile(0.99) / 1.e6, Client.Latency.GetCount()));
+	TestTrue(TEXT("Records timed"), Client.Latency.GetCount() > 0);
+	TestEqual(TEXT("Records that don't match the history"), Client.NumMismatches, 0);
+	TestEqual(TEXT("Malformed datagrams"), Client.NumMalformed, 0);
+	TestEqual(TEXT("Datagrams dropped"), Server.GetNumDatagramsDropped(), (uint64)0);
+	TestEqual(TEXT("Reports dropped"), Server.GetNumReportsDropped(), (uint64)0);
+
+	// Commands come back to the game thread as sent
+	FDS5WStreamCommand Rumble;
+	FMemory::Memzero(Rumble);
+	Rumble.ControllerId = 1;
+	Rumble.Type = EDS5WStreamCommandType::Rumble;
+	Rumble.Data[0] = 90;
+	Rumble.Data[1] = 180;
+	Client.Send(&Rumble, 1);
+
+	FDS5WStreamCommand Received;
+	const bool bReceived = WaitUntil([&Server, &Received]() { return Server.DequeueCommand(Received); });
+	TestTrue(TEXT("Command round trips"), bReceived && Received.ControllerId == Rumble.ControllerId && Received.Type == Rumble.Type && FMemory::Memcmp(Received.Data, Rumble.Data, sizeof(Rumble.Data)) == 0);
+
+	Server.Shutdown();
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
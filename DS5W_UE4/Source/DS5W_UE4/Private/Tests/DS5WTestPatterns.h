@@ -0,0 +1,61 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/UnrealMathUtility.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+#include "DS5WSnapshot.h"
+
+namespace DS5WTest
+{
+	/**
+	 * Pad state at Time in seconds: sticks and triggers sweep, the face buttons toggle a few times per
+	 * second, a finger circles on the touchpad and the pad turns around its vertical axis at 90 deg/s.
+	 * The sensor timestamp is left to whoever sends the report.
+	 */
+	inline DS5W::DS5InputState MakeMovingState(double Time)
+	{
+		DS5W::DS5InputState State;
+		FMemory::Memzero(State);
+
+		const float Phase = (float)(Time * 2.0 * PI);
+		State.leftStick.x = (char)(100.f * FMath::Sin(Phase));
+		State.leftStick.y = (char)(100.f * FMath::Cos(Phase));
+		State.rightStick.x = (char)(60.f * FMath::Sin(0.5f * Phase));
+		State.leftTrigger = (unsigned char)(127.5f + 127.5f * FMath::Sin(Phase));
+		State.rightTrigger = (unsigned char)(127.5f - 127.5f * FMath::Sin(Phase));
+
+		const int32 Step = FMath::FloorToInt(Time * 5.0);
+		State.buttonsAndDpad = (Step & 1) ? DS5W_ISTATE_BTX_CROSS : DS5W_ISTATE_BTX_SQUARE;
+		State.buttonsA = (Step & 2) ? DS5W_ISTATE_BTN_A_RIGHT_BUMPER : 0;
+
+		State.touchPoint1.down = true;
+		State.touchPoint1.id = 1;
+		State.touchPoint1.x = (unsigned int)(960.f + 500.f * FMath::Cos(Phase));
+		State.touchPoint1.y = (unsigned int)(540.f + 300.f * FMath::Sin(Phase));
+
+		State.imuState.accelZ = 1.f;
+		State.imuState.gyroY = 90.f;
+		return State;
+	}
+
+	/** Field by field, the struct has padding */
+	inline bool SnapshotsEqual(const FDS5WSnapshot& A, const FDS5WSnapshot& B)
+	{
+		bool bEqual = A.Buttons == B.Buttons && A.SensorTimestamp == B.SensorTimestamp;
+		for (int32 Index = 0; Index < 2; ++Index)
+		{
+			bEqual &= A.LeftStick[Index] == B.LeftStick[Index] && A.RightStick[Index] == B.RightStick[Index] && A.Triggers[Index] == B.Triggers[Index];
+			bEqual &= A.Touch[Index].bDown == B.Touch[Index].bDown && A.Touch[Index].Id == B.Touch[Index].Id && A.Touch[Index].X == B.Touch[Index].X && A.Touch[Index].Y == B.Touch[Index].Y;
+		}
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			bEqual &= A.Gyro[Axis] == B.Gyro[Axis] && A.Accel[Axis] == B.Accel[Axis];
+		}
+		return bEqual;
+	}
+}
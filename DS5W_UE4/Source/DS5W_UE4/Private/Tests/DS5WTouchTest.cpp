@@ -0,0 +1,104 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DS5WClockSync.h"
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+#include "DS5WTouch.h"
+#include "IDS5W_UE4.h"
+
+// Reports per swipe while the finger is down, one millisecond apart, the release follows
+#define DS5W_TOUCH_TEST_SWIPE_REPORTS 7
+
+namespace
+{
+	DS5W::DS5InputState MakeTouchState(bool bDown, uint8 FingerId, float X, double CaptureTime)
+	{
+		DS5W::DS5InputState State;
+		FMemory::Memzero(State);
+		State.touchPoint1.down = bDown;
+		State.touchPoint1.id = FingerId;
+		State.touchPoint1.x = (unsigned int)X;
+		State.touchPoint1.y = 540;
+		State.sensorTimestamp = (uint32)(uint64)(CaptureTime * FDS5WClockSync::DeviceTicksPerSecond);
+		return State;
+	}
+
+	int32 CountPresses(const TArray<FDS5WRecordedEvent>& Events, const FName& Key)
+	{
+		int32 NumPresses = 0;
+		for (const FDS5WRecordedEvent& Event : Events)
+		{
+			NumPresses += Event.Type == EDS5WRecordedEventType::Pressed && Event.Key == Key ? 1 : 0;
+		}
+		return NumPresses;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WTouchSubFrameTest, "DS5W.Touch.SubFrameSwipes", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WTouchSubFrameTest::RunTest(const FString& Parameters)
+{
+	const double FrameInterval = 1.0 / 60.0;
+	const double ReportInterval = 0.001;
+	FDS5WHeadlessHarness Harness(1, FrameInterval, ReportInterval);
+	FDS5WInterface& Interface = Harness.GetInterface();
+	Interface.AddInputConsumer(DS5W_DECODE_TOUCH);
+
+	// One untouched frame connects the controller and hands it the decode flags
+	const DS5W::DS5InputState Idle = MakeTouchState(false, 0, 0.f, Harness.GetTime());
+	const DS5W::DS5InputState* States[] = { &Idle };
+	Harness.RunFrame(States);
+	Harness.ResetEvents();
+
+	// A swipe right and one back left, both begun and finished before the next frame
+	const double FrameStart = Harness.GetTime();
+	TArray<double> CaptureTimes;
+	int32 Report = 0;
+	for (int32 Swipe = 0; Swipe < 2; ++Swipe)
+	{
+		const float FromX = Swipe == 0 ? 300.f : 1600.f;
+		const float ToX = Swipe == 0 ? 1600.f : 300.f;
+		for (int32 Step = 0; Step <= DS5W_TOUCH_TEST_SWIPE_REPORTS; ++Step)
+		{
+			const double CaptureTime = FrameStart + ReportInterval * ++Report;
+			const bool bDown = Step < DS5W_TOUCH_TEST_SWIPE_REPORTS;
+			const float X = FMath::Lerp(FromX, ToX, (float)FMath::Min(Step, DS5W_TOUCH_TEST_SWIPE_REPORTS - 1) / (DS5W_TOUCH_TEST_SWIPE_REPORTS - 1));
+			Harness.SubmitReport(0, MakeTouchState(bDown, (uint8)(Swipe + 1), X, CaptureTime), CaptureTime);
+			CaptureTimes.Add(CaptureTime);
+		}
+	}
+	if (!TestTrue(TEXT("Both swipes fit into one frame"), CaptureTimes.Last() < FrameStart + FrameInterval))
+	{
+		return false;
+	}
+
+	Harness.RunFrame();
+
+	const TArray<FDS5WRecordedEvent>& Events = Harness.GetEvents();
+	TestEqual(TEXT("Swipe right sent once"), CountPresses(Events, FDS5WKeyNames::DS5W_Touch_SwipeRight), 1);
+	TestEqual(TEXT("Swipe left sent once"), CountPresses(Events, FDS5WKeyNames::DS5W_Touch_SwipeLeft), 1);
+	TestEqual(TEXT("No tap"), CountPresses(Events, FDS5WKeyNames::DS5W_Touch_Tap), 0);
+
+	// Every report of the frame is in the trajectory, releases included, in capture order
+	FDS5WTouchSample Samples[DS5W_TOUCH_HISTORY];
+	const int32 NumSamples = Interface.GetTouchTrajectory(0, Samples, UE_ARRAY_COUNT(Samples));
+	if (!TestEqual(TEXT("Trajectory holds every report"), NumSamples, CaptureTimes.Num()))
+	{
+		return false;
+	}
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		const bool bDown = Index % (DS5W_TOUCH_TEST_SWIPE_REPORTS + 1) < DS5W_TOUCH_TEST_SWIPE_REPORTS;
+		TestEqual(FString::Printf(TEXT("Sample %d capture time"), Index), Samples[Index].Time, CaptureTimes[Index]);
+		TestTrue(FString::Printf(TEXT("Sample %d down"), Index), Samples[Index].bDown[0] == bDown);
+	}
+
+	Interface.RemoveInputConsumer(DS5W_DECODE_TOUCH);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
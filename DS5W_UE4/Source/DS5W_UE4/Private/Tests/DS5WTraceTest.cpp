@@ -0,0 +1,268 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Async/Async.h"
+#include "DS5WHeadlessHarness.h"
+#include "DS5WInterface.h"
+#include "DS5WTestPatterns.h"
+#include "DS5WTrace.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/OutputDeviceNull.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+// Frames run before tracing starts, traced, and run again after it stopped
+#define DS5W_TRACE_TEST_WARMUP_FRAMES 10
+#define DS5W_TRACE_TEST_FRAMES        60
+#define DS5W_TRACE_TEST_RESTART_FRAMES 5
+
+// Events recorded directly: wrapping the ring more than twice, and flushes while another thread records
+#define DS5W_TRACE_TEST_WRAPPED_EVENTS (5 * DS5W_TRACE_MIN_CAPACITY / 2)
+#define DS5W_TRACE_TEST_CONCURRENT_FLUSHES 20
+
+// Cycles between the start of one encoded event and the next
+#define DS5W_TRACE_TEST_CYCLES_PER_EVENT 1000
+
+namespace
+{
+	/** One complete event of a flushed trace */
+	struct FTraceFileEvent
+	{
+		FString Name;
+		int32 ControllerId;
+		uint32 ThreadId;
+		double Timestamp;
+		double Duration;
+	};
+
+	/** What a flushed trace held, false if it isn't trace-event JSON of the expected shape */
+	bool LoadTraceFile(const FString& Filename, TArray<FTraceFileEvent>& OutEvents, TArray<FString>& OutThreadNames)
+	{
+		OutEvents.Reset();
+		OutThreadNames.Reset();
+
+		FString Json;
+		TSharedPtr<FJsonObject> Root;
+		if (!FFileHelper::LoadFileToString(Json, *Filename) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Root) || !Root.IsValid())
+		{
+			return false;
+		}
+
+		const TArray<TSharedPtr<FJsonValue>>* TraceEvents;
+		if (!Root->TryGetArrayField(TEXT("traceEvents"), TraceEvents))
+		{
+			return false;
+		}
+
+		for (const TSharedPtr<FJsonValue>& Value : *TraceEvents)
+		{
+			const TSharedPtr<FJsonObject>* Event;
+			const TSharedPtr<FJsonObject>* Args;
+			FString Phase;
+			FString Name;
+			double ThreadId;
+			if (!Value->TryGetObject(Event) || !(*Event)->TryGetStringField(TEXT("ph"), Phase) || !(*Event)->TryGetStringField(TEXT("name"), Name)
+				|| !(*Event)->TryGetNumberField(TEXT("tid"), ThreadId) || !(*Event)->HasTypedField<EJson::Number>(TEXT("pid")) || !(*Event)->TryGetObjectField(TEXT("args"), Args))
+			{
+				return false;
+			}
+
+			if (Phase == TEXT("M"))
+			{
+				FString ThreadName;
+				if (Name != TEXT("thread_name") || !(*Args)->TryGetStringField(TEXT("name"), ThreadName))
+				{
+					return false;
+				}
+				OutThreadNames.Add(ThreadName);
+				continue;
+			}
+
+			FTraceFileEvent& FileEvent = OutEvents.AddDefaulted_GetRef();
+			FileEvent.Name = Name;
+			FileEvent.ThreadId = (uint32)ThreadId;
+			FString Category;
+			double ControllerId;
+			if (Phase != TEXT("X") || !(*Event)->TryGetStringField(TEXT("cat"), Category) || Category != TEXT("DS5W") || !(*Event)->TryGetNumberField(TEXT("ts"), FileEvent.Timestamp)
+				|| !(*Event)->TryGetNumberField(TEXT("dur"), FileEvent.Duration) || FileEvent.Duration < 0.0 || !(*Args)->TryGetNumberField(TEXT("controller"), ControllerId))
+			{
+				return false;
+			}
+			FileEvent.ControllerId = (int32)ControllerId;
+		}
+
+		return true;
+	}
+
+	/** Events of one stage and controller */
+	int32 CountTraceEvents(const TArray<FTraceFileEvent>& Events, EDS5WTraceStage Stage, int32 ControllerId)
+	{
+		int32 NumEvents = 0;
+		for (const FTraceFileEvent& Event : Events)
+		{
+			NumEvents += Event.Name == FDS5WTrace::GetStageName(Stage) && Event.ControllerId == ControllerId ? 1 : 0;
+		}
+		return NumEvents;
+	}
+
+	/**
+	 * Record event Index so every field tells which event it is: the start its index, the stage the index
+	 * modulo the stages, controller and duration how often the ring wrapped before it. A slot mixing two
+	 * events can't decode consistently.
+	 */
+	void RecordEncodedEvent(FDS5WTrace& Trace, uint64 Index)
+	{
+		const int32 Wraps = (int32)((Index / Trace.GetCapacity()) % MAX_NUM_DS5W_CONTROLLERS);
+		const uint64 StartCycles = Index * DS5W_TRACE_TEST_CYCLES_PER_EVENT;
+		Trace.Record((EDS5WTraceStage)(Index % (uint64)EDS5WTraceStage::Num), Wraps, StartCycles, StartCycles + (Wraps + 1) * DS5W_TRACE_TEST_CYCLES_PER_EVENT);
+	}
+
+	/** Index of an event written by RecordEncodedEvent, -1 if its fields don't agree */
+	int64 DecodeTraceEvent(const FTraceFileEvent& Event, int32 Capacity)
+	{
+		const double MicrosecondsPerEvent = FPlatformTime::GetSecondsPerCycle64() * 1.e6 * DS5W_TRACE_TEST_CYCLES_PER_EVENT;
+		const int64 Index = FMath::RoundToInt64(Event.Timestamp / MicrosecondsPerEvent);
+		const int32 Wraps = (int32)((Index / Capacity) % MAX_NUM_DS5W_CONTROLLERS);
+		const bool bConsistent = Index >= 0 && Event.Name == FDS5WTrace::GetStageName((EDS5WTraceStage)(Index % (int64)EDS5WTraceStage::Num))
+			&& Event.ControllerId == Wraps && FMath::RoundToInt(Event.Duration / MicrosecondsPerEvent) == Wraps + 1;
+		return bConsistent ? Index : -1;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDS5WTraceTest, "DS5W.Trace.Flush", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FDS5WTraceTest::RunTest(const FString& Parameters)
+{
+	const FString Filename = FPaths::AutomationTransientDir() / TEXT("DS5WTraceTest.json");
+	TArray<FTraceFileEvent> Events;
+	TArray<FString> ThreadNames;
+
+	// Through the console commands: two controllers, traced for a while in the middle of the run
+	{
+		FDS5WHeadlessHarness Harness(2);
+		FDS5WInterface& Interface = Harness.GetInterface();
+		FOutputDeviceNull Ar;
+		DS5W::DS5InputState States[2];
+		const DS5W::DS5InputState* StatePointers[] = { &States[0], &States[1] };
+		auto RunFrames = [&Harness, &States, &StatePointers](int32 NumFrames)
+		{
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				States[0] = DS5WTest::MakeMovingState(Harness.GetTime());
+				States[1] = DS5WTest::MakeMovingState(Harness.GetTime() * 0.5);
+				Harness.RunFrame(StatePointers);
+			}
+		};
+		const FString FlushCommand = FString::Printf(TEXT("DS5W TRACE FLUSH \"%s\""), *Filename);
+
+		RunFrames(DS5W_TRACE_TEST_WARMUP_FRAMES);
+		Interface.Exec(nullptr, TEXT("DS5W TRACE START"), Ar);
+		RunFrames(DS5W_TRACE_TEST_FRAMES);
+		Interface.Exec(nullptr, TEXT("DS5W TRACE STOP"), Ar);
+		RunFrames(DS5W_TRACE_TEST_WARMUP_FRAMES);
+		Interface.Exec(nullptr, *FlushCommand, Ar);
+
+		if (!TestTrue(TEXT("Flushed trace is trace-event JSON"), LoadTraceFile(Filename, Events, ThreadNames)))
+		{
+			IFileManager::Get().Delete(*Filename);
+			return false;
+		}
+		TestTrue(TEXT("Game thread named"), ThreadNames.Contains(TEXT("DS5W game thread")));
+
+		// Every traced frame dispatched each controller once and consumed at least one report of it
+		for (int32 ControllerId = 0; ControllerId < 2; ++ControllerId)
+		{
+			TestEqual(FString::Printf(TEXT("Controller %d: a dispatch event per traced frame"), ControllerId), CountTraceEvents(Events, EDS5WTraceStage::Dispatch, ControllerId), DS5W_TRACE_TEST_FRAMES);
+			TestTrue(FString::Printf(TEXT("Controller %d: consumed reports traced"), ControllerId), CountTraceEvents(Events, EDS5WTraceStage::Consume, ControllerId) >= DS5W_TRACE_TEST_FRAMES);
+		}
+		int32 NumUnknownStages = 0;
+		for (const FTraceFileEvent& Event : Events)
+		{
+			NumUnknownStages += Event.Name == FDS5WTrace::GetStageName(EDS5WTraceStage::Num) ? 1 : 0;
+		}
+		TestEqual(TEXT("Only known stages"), NumUnknownStages, 0);
+
+		// Starting again drops the first run
+		Interface.Exec(nullptr, TEXT("DS5W TRACE START"), Ar);
+		RunFrames(DS5W_TRACE_TEST_RESTART_FRAMES);
+		Interface.Exec(nullptr, TEXT("DS5W TRACE STOP"), Ar);
+		Interface.Exec(nullptr, *FlushCommand, Ar);
+		if (TestTrue(TEXT("Restarted trace is trace-event JSON"), LoadTraceFile(Filename, Events, ThreadNames)))
+		{
+			TestEqual(TEXT("Restarted trace holds only its own frames"), CountTraceEvents(Events, EDS5WTraceStage::Dispatch, 0), DS5W_TRACE_TEST_RESTART_FRAMES);
+		}
+	}
+
+	// Wrapped slots: only the newest events are written, oldest first
+	FDS5WTrace Trace;
+	Trace.Init(DS5W_TRACE_MIN_CAPACITY);
+	const int32 Capacity = Trace.GetCapacity();
+	TestTrue(TEXT("Trace started"), Trace.Start());
+	for (uint64 Index = 0; Index < DS5W_TRACE_TEST_WRAPPED_EVENTS; ++Index)
+	{
+		RecordEncodedEvent(Trace, Index);
+	}
+	TestTrue(TEXT("Wrapped trace flushed"), Trace.Flush(*Filename));
+	if (TestTrue(TEXT("Wrapped trace is trace-event JSON"), LoadTraceFile(Filename, Events, ThreadNames))
+		&& TestEqual(TEXT("Wrapped trace holds all but the slot written next"), Events.Num(), Capacity - 1))
+	{
+		bool bNewestInOrder = true;
+		for (int32 EventIndex = 0; EventIndex < Events.Num(); ++EventIndex)
+		{
+			bNewestInOrder &= DecodeTraceEvent(Events[EventIndex], Capacity) == DS5W_TRACE_TEST_WRAPPED_EVENTS - Capacity + 1 + EventIndex;
+		}
+		TestTrue(TEXT("Wrapped trace holds the newest events, oldest first"), bNewestInOrder);
+	}
+
+	// Torn slots: flushes racing a recording thread only write events that were complete
+	std::atomic<bool> bStopRecording(false);
+	std::atomic<uint64> NumRecorded(DS5W_TRACE_TEST_WRAPPED_EVENTS);
+	TFuture<void> Recorder = Async(EAsyncExecution::Thread, [&Trace, &bStopRecording, &NumRecorded]()
+	{
+		while (!bStopRecording.load(std::memory_order_relaxed))
+		{
+			RecordEncodedEvent(Trace, NumRecorded.fetch_add(1, std::memory_order_relaxed));
+		}
+	});
+
+	int32 NumBadFlushes = 0;
+	int32 NumInconsistent = 0;
+	int32 NumOutOfOrder = 0;
+	for (int32 Flush = 0; Flush < DS5W_TRACE_TEST_CONCURRENT_FLUSHES; ++Flush)
+	{
+		if (!Trace.Flush(*Filename) || !LoadTraceFile(Filename, Events, ThreadNames) || Events.Num() >= Capacity)
+		{
+			++NumBadFlushes;
+			continue;
+		}
+
+		int64 LastIndex = -1;
+		for (const FTraceFileEvent& Event : Events)
+		{
+			const int64 Index = DecodeTraceEvent(Event, Capacity);
+			NumInconsistent += Index < 0 ? 1 : 0;
+			NumOutOfOrder += Index >= 0 && Index <= LastIndex ? 1 : 0;
+			LastIndex = FMath::Max(LastIndex, Index);
+		}
+	}
+	bStopRecording.store(true, std::memory_order_relaxed);
+	Recorder.Wait();
+	Trace.Stop();
+	IFileManager::Get().Delete(*Filename);
+
+	AddInfo(FString::Printf(TEXT("%llu events recorded while flushing"), NumRecorded.load() - DS5W_TRACE_TEST_WRAPPED_EVENTS));
+	TestEqual(TEXT("Every flush while recording is trace-event JSON within the capacity"), NumBadFlushes, 0);
+	TestEqual(TEXT("No event mixes fields of two events"), NumInconsistent, 0);
+	TestEqual(TEXT("Events oldest first"), NumOutOfOrder, 0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,79 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+#include <atomic>
+
+/**
+ * Define to 1 to check that the per-frame paths stop allocating once warmed up, from startup on. Wraps
+ * GMalloc with a counting proxy, so it's meant for development builds, not for shipping. Builds with
+ * automation tests keep the scopes so the allocation test can install the proxy itself.
+ */
+#ifndef DS5W_TRACK_ALLOCATIONS
+#define DS5W_TRACK_ALLOCATIONS 0
+#endif
+
+#define DS5W_ALLOCATION_SCOPES (DS5W_TRACK_ALLOCATIONS || WITH_DEV_AUTOMATION_TESTS)
+
+/** Frames (game thread) or reports (reader threads) after which no more allocations are expected */
+#define DS5W_ALLOCATION_WARMUP 120
+
+/**
+ * Counts the allocations a thread makes inside FDS5WAllocationScope.
+ * Only the current thread's scope is charged, other threads allocating at the same time don't count.
+ */
+class FDS5WAllocationTracker
+{
+public:
+
+	/** Wrap GMalloc with the counting proxy and start counting. The proxy stays installed once there */
+	static void Install();
+
+	static bool IsInstalled();
+
+	/** Pause or resume counting, e.g. to count only while a test runs. No effect before Install */
+	static void SetEnabled(bool bInEnabled) { bEnabled.store(bInEnabled, std::memory_order_relaxed); }
+	static bool IsEnabled() { return IsInstalled() && bEnabled.load(std::memory_order_relaxed); }
+
+	/** Steady state scopes that saw an allocation since the start */
+	static uint64 GetNumViolations() { return NumViolations.load(std::memory_order_relaxed); }
+
+private:
+
+	friend class FDS5WAllocationScope;
+
+	static std::atomic<uint64> NumViolations;
+	static std::atomic<bool> bEnabled;
+};
+
+/**
+ * Charges this thread's allocations to the scope. In the steady state any allocation counts as a
+ * violation and logs a warning naming the scope, the allocation test fails on the count.
+ */
+class FDS5WAllocationScope
+{
+public:
+
+	FDS5WAllocationScope(const TCHAR* InName, bool bInSteadyState);
+	~FDS5WAllocationScope();
+
+	uint64 GetNumAllocations() const { return NumAllocations; }
+
+private:
+
+	const TCHAR* Name;
+	bool bSteadyState;
+
+	uint64 NumAllocations;
+
+	/** Scopes nest, the outer scope is charged again once this one ends */
+	uint64* OuterCounter;
+};
+
+#if DS5W_ALLOCATION_SCOPES
+#define DS5W_ALLOCATION_SCOPE(Name, bSteadyState) FDS5WAllocationScope PREPROCESSOR_JOIN(DS5WAllocationScope, __LINE__)(TEXT(Name), bSteadyState)
+#else
+#define DS5W_ALLOCATION_SCOPE(Name, bSteadyState)
+#endif
@@ -0,0 +1,86 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+/** Default press thresholds of the stick direction and trigger buttons in report units */
+#define DS5W_LEFT_THUMB_DEADZONE  30
+#define DS5W_RIGHT_THUMB_DEADZONE 30
+#define DS5W_TRIGGER_THRESHOLD    30
+
+/** Processed analog values: left stick x/y, right stick x/y, left and right trigger */
+#define DS5W_NUM_ANALOG_AXES 6
+
+/** Config section the analog settings are read from (in the input ini) */
+#define DS5W_ANALOG_CONFIG_SECTION TEXT("/Script/DS5W_UE4.DS5WAnalog")
+
+/**
+ * Response of one stick (applied to its length, so the deadzones are radial) or one trigger.
+ * All values are normalised, 1 being full deflection.
+ */
+struct FDS5WAnalogResponse
+{
+	/** Input below this is zero */
+	float InnerDeadzone;
+
+	/** Input above this is full deflection. Stick axes saturate on their own, so diagonals can go past it */
+	float OuterDeadzone;
+
+	/** Smallest output once past the inner deadzone, to overcome a game's own deadzone */
+	float AntiDeadzone;
+
+	/** 0 is linear, 1 is cubic, values between blend the two */
+	float Curvature;
+};
+
+/** Analog processing and the thresholds of the buttons derived from analog values */
+struct FDS5WAnalogSettings
+{
+	FDS5WAnalogResponse LeftStick;
+	FDS5WAnalogResponse RightStick;
+	FDS5WAnalogResponse LeftTrigger;
+	FDS5WAnalogResponse RightTrigger;
+
+	/** Stick direction buttons press past the press threshold and release below the release threshold */
+	float StickPressThreshold;
+	float StickReleaseThreshold;
+
+	/** Same for the trigger buttons */
+	float TriggerPressThreshold;
+	float TriggerReleaseThreshold;
+
+	/**
+	 * Defaults map the raw range linearly without a deadzone, leaving that to the engine's axis settings,
+	 * and press the buttons at the previous fixed thresholds
+	 */
+	FDS5WAnalogSettings();
+
+	/** Override the defaults with the values in DS5W_ANALOG_CONFIG_SECTION of the input ini */
+	void LoadConfig();
+};
+
+/**
+ * Applies deadzones, anti-deadzone and response curve to both sticks and both triggers at once.
+ * The length of each stick and the triggers share one vector register, so the whole report is
+ * processed in one pass without per axis range mapping.
+ */
+class FDS5WAnalogProcessor
+{
+public:
+
+	void Init(const FDS5WAnalogSettings& Settings);
+
+	/** Write the DS5W_NUM_ANALOG_AXES processed values, sticks in [-1, 1] and triggers in [0, 1] */
+	void Process(const DS5W::DS5InputState& State, float* OutValues) const;
+
+private:
+
+	/** Per lane (left stick, right stick, left trigger, right trigger) response parameters */
+	alignas(16) float InnerDeadzone[4];
+	alignas(16) float InvRange[4];
+	alignas(16) float AntiDeadzone[4];
+	alignas(16) float Curvature[4];
+};
@@ -0,0 +1,103 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "UObject/NameTypes.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+#include "DS5WAnalog.h"
+#include "DS5WEventQueue.h"
+
+/** Max number of controller buttons. Must be <= 32, button states are packed into one word */
+#define MAX_NUM_CONTROLLER_BUTTONS 27
+
+/** Config section listing the button profiles (in the input ini), each profile has its own section */
+#define DS5W_BUTTON_PROFILES_CONFIG_SECTION TEXT("/Script/DS5W_UE4.DS5WButtonProfiles")
+
+/** Button edges that can wait for the game thread, shared by all controllers */
+#define DS5W_BUTTON_EVENT_QUEUE_SIZE 256
+
+/** One press or release, detected at report rate */
+struct FDS5WButtonEvent
+{
+	/** Host time the report with the edge was captured at */
+	double CaptureTime;
+
+	int32 ControllerId;
+
+	/** DS5W button index (bit of the raw button word) */
+	uint8 ButtonIndex;
+
+	bool bPressed;
+};
+
+typedef TDS5WMpscQueue<FDS5WButtonEvent, DS5W_BUTTON_EVENT_QUEUE_SIZE> FDS5WButtonEventQueue;
+
+/**
+ * Packs the buttons of a report into one raw word, bit i being DS5W button i.
+ * The order is the one of FDS5WButtonProfile::GetButtonName.
+ * Digital buttons go through one 256 entry table per report byte, buttons derived from analog
+ * values (trigger and stick directions) through precomputed masks.
+ */
+class FDS5WButtonMap
+{
+public:
+
+	/** Build the tables, buttons derived from analog values use the press / release thresholds of Settings */
+	void Build(const FDS5WAnalogSettings& Settings);
+
+	/** PreviousWord selects the press or release threshold of each analog derived button */
+	uint32 GetButtonWord(const DS5W::DS5InputState& State, uint32 PreviousWord) const;
+
+private:
+
+	/** Engine button bits per value of buttonsAndDpad, buttonsA and buttonsB */
+	uint32 LUT[3][256];
+
+	/** Thresholds in report units */
+	int32 StickPressThreshold;
+	int32 StickReleaseThreshold;
+	int32 TriggerPressThreshold;
+	int32 TriggerReleaseThreshold;
+};
+
+/**
+ * Maps raw button words to engine button words. Each DS5W button drives one engine button or none,
+ * several may drive the same one. The mapping is compiled into one 256 entry table per byte of the
+ * raw word, so remapping a word costs four lookups whatever the profile.
+ */
+class FDS5WButtonProfile
+{
+public:
+
+	FDS5WButtonProfile();
+
+	/** Targets holds the engine button index of each DS5W button, INDEX_NONE unbinds it */
+	void Compile(FName InName, const int32* Targets);
+
+	/**
+	 * Load the profile from its config section, "[DS5WButtonProfile <Name>]" with entries like "Cross=Circle":
+	 * the left button does what the right one does in DefaultTargets, "None" unbinds it. Unlisted buttons keep
+	 * their default. @return false if the section doesn't exist
+	 */
+	bool LoadConfig(FName InName, const int32* DefaultTargets);
+
+	uint32 Apply(uint32 RawButtons) const
+	{
+		return LUT[0][RawButtons & 0xFF] | LUT[1][(RawButtons >> 8) & 0xFF] | LUT[2][(RawButtons >> 16) & 0xFF] | LUT[3][RawButtons >> 24];
+	}
+
+	FName GetName() const { return Name; }
+
+	/** Config name of DS5W button ButtonIndex */
+	static const TCHAR* GetButtonName(int32 ButtonIndex);
+
+private:
+
+	FName Name;
+
+	/** Engine button bits per value of each byte of the raw word */
+	uint32 LUT[4][256];
+};
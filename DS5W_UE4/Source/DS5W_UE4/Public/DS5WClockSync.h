@@ -0,0 +1,85 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+/** Number of device time windows used for the drift fit */
+#define DS5W_CLOCK_SYNC_WINDOWS 16
+
+/**
+ * Online estimator mapping DualSense sensor timestamps onto the host clock (FPlatformTime::Seconds).
+ *
+ * Read completion times are capture time plus a jittery, non-negative transport latency. The estimator
+ * keeps the minimum host-minus-device offset per window of device time (the samples that got through
+ * fastest) and fits a line through the last windows, which gives the clock offset and the drift between
+ * the two oscillators. The 32 bit device counter is unwrapped so the mapping survives wraparound.
+ */
+class FDS5WClockSync
+{
+public:
+
+	/** Sensor timestamps count in 1/3 microseconds */
+	static constexpr double DeviceTicksPerSecond = 3000000.0;
+
+	/** Length of one min-filter window in device seconds */
+	static constexpr double WindowLength = 0.5;
+
+	/** Forget the mapping, e.g. after a reconnect */
+	void Reset();
+
+	/**
+	 * Feed the raw timestamp of a report together with the host time its read completed.
+	 * @return Host time the sample was captured at, never before the previous sample's until Reset
+	 */
+	double AddSample(uint32 DeviceTimestamp, double HostArrivalTime);
+
+	/** Convert unwrapped device seconds to host seconds */
+	double DeviceToHost(double DeviceSeconds) const;
+
+	/** Unwrapped device time of the last sample in seconds */
+	double GetLastDeviceTime() const { return LastDeviceTime; }
+
+	/** Device time between the last two samples in seconds */
+	double GetLastDeviceDelta() const { return LastDeviceDelta; }
+
+	/** Host capture time of the last sample */
+	double GetLastCaptureTime() const { return LastCaptureTime; }
+
+private:
+
+	struct FWindow
+	{
+		/** Device time of the sample that produced the minimum */
+		double DeviceTime;
+
+		/** Minimum of host minus device time */
+		double MinOffset;
+	};
+
+	void FitWindows();
+
+	bool bHasSample;
+
+	uint32 LastRawTimestamp;
+	uint64 UnwrappedTicks;
+
+	double LastDeviceTime;
+	double LastDeviceDelta;
+	double LastHostTime;
+	double LastCaptureTime;
+
+	/** Min filter of the window being collected */
+	FWindow Current;
+	double CurrentWindowStart;
+
+	/** Completed windows (ring) */
+	FWindow Windows[DS5W_CLOCK_SYNC_WINDOWS];
+	int32 NumWindows;
+	int32 NextWindow;
+
+	/** host = device + Offset + Drift * (device - FitOrigin) */
+	double Offset;
+	double Drift;
+	double FitOrigin;
+};
@@ -0,0 +1,205 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "HAL/Runnable.h"
+#include "Containers/CircularQueue.h"
+#include "Containers/TripleBuffer.h"
+
+#include "DualSenseWindows/Batch.h"
+#include "DualSenseWindows/Device.h"
+#include "DualSenseWindows/DS5State.h"
+#include "DualSenseWindows/IO.h"
+
+#include "DS5WButtons.h"
+#include "DS5WClockSync.h"
+#include "DS5WInputHistory.h"
+#include "DS5WMotionLatch.h"
+#include "DS5WReportSubscribers.h"
+#include "DS5WSharedStateExport.h"
+#include "DS5WStats.h"
+#include "DS5WTouch.h"
+#include "DS5WTrace.h"
+
+#include <atomic>
+
+class FRunnableThread;
+
+/** Number of decoded reports that can wait for the game thread (~250 ms at the USB report rate) */
+#define DS5W_INPUT_QUEUE_SIZE 64
+
+/** Reports taken in one read after the reader thread was held up (the HID driver queues 32 by default) */
+#define DS5W_READ_BACKLOG_SIZE 32
+
+/** One decoded input report */
+struct FDS5WInputSample
+{
+	DS5W::DS5InputState State;
+
+	/** Host time the report was captured at */
+	double CaptureTime;
+
+	/** Unwrapped device time of the report in seconds */
+	double DeviceTime;
+
+	/** Running gyro rotation after the report, see FDS5WMotionLatch. Only advances while motion is decoded */
+	FQuat GyroAccumulator;
+
+	/** Cycle counter when the report arrived, for tracing */
+	uint64 ArrivalCycles;
+};
+
+/**
+ * Raw reports of one read. The ones before the newest are decoded together into a structure of arrays,
+ * usually there are none.
+ */
+struct FDS5WReportBacklog
+{
+	uint8 Reports[DS5W_READ_BACKLOG_SIZE * DS5W_RAW_REPORT_MAX_BYTES];
+
+	int8 LeftStickX[DS5W_READ_BACKLOG_SIZE - 1];
+	int8 LeftStickY[DS5W_READ_BACKLOG_SIZE - 1];
+	int8 RightStickX[DS5W_READ_BACKLOG_SIZE - 1];
+	int8 RightStickY[DS5W_READ_BACKLOG_SIZE - 1];
+	uint8 LeftTrigger[DS5W_READ_BACKLOG_SIZE - 1];
+	uint8 RightTrigger[DS5W_READ_BACKLOG_SIZE - 1];
+	uint32 Buttons[DS5W_READ_BACKLOG_SIZE - 1];
+	float GyroX[DS5W_READ_BACKLOG_SIZE - 1];
+	float GyroY[DS5W_READ_BACKLOG_SIZE - 1];
+	float GyroZ[DS5W_READ_BACKLOG_SIZE - 1];
+	float AccelX[DS5W_READ_BACKLOG_SIZE - 1];
+	float AccelY[DS5W_READ_BACKLOG_SIZE - 1];
+	float AccelZ[DS5W_READ_BACKLOG_SIZE - 1];
+	uint32 SensorTimestamp[DS5W_READ_BACKLOG_SIZE - 1];
+
+	/** Points at the arrays above */
+	DS5W::InputBatch Batch;
+
+	FDS5WReportBacklog();
+
+	/** Write the fields the batch decodes of report Index into OutState, touch, status and raw IMU values keep theirs */
+	void GetInputState(uint32 Index, DS5W::DS5InputState& OutState) const;
+
+	/** Raw report Index of the read */
+	const uint8* GetReport(uint32 Index, bool bBluetooth) const { return &Reports[Index * (bBluetooth ? DS5W_RAW_REPORT_BT_BYTES : DS5W_RAW_REPORT_USB_BYTES)]; }
+};
+
+/**
+ * Reads every input report of one device on a dedicated thread.
+ * Decoded reports are queued for the game thread, button edges and touch input are detected at
+ * report rate and the latest output state posted by the game thread is written back between reads.
+ */
+class FDS5WDeviceReader : public FRunnable
+{
+public:
+
+	FDS5WDeviceReader(int32 InControllerId, const FDS5WButtonMap& InButtonMap, FDS5WButtonEventQueue& InButtonEvents, FDS5WInputHistory& InInputHistory, FDS5WMotionLatch& InMotionLatch, FDS5WControllerStats& InStats, FDS5WTrace& InTrace, FDS5WSharedStateExport& InSharedState, FDS5WReportSubscribers& InReportSubscribers);
+	virtual ~FDS5WDeviceReader();
+
+	/** Open the device and start the reader thread */
+	bool Start(DS5W::DeviceEnumInfo& EnumInfo);
+
+	/** Stop the reader thread and close the device */
+	void Shutdown();
+
+	/**
+	 * Run without a device or thread, reports come from SubmitSimulatedReport instead (headless harness).
+	 * They go through the same edge detection, touch tracking and queueing as device reports.
+	 */
+	bool StartSimulated();
+
+	/** Simulated mode only, call from one thread at a time */
+	void SubmitSimulatedReport(const DS5W::DS5InputState& State, double CaptureTime);
+	void DisconnectSimulated(double Time);
+
+	/**
+	 * Simulated mode only. Submit a report that reached the host at ArrivalTime, its capture time is
+	 * estimated from the sensor timestamp like for a device (see FDS5WPadEmulator).
+	 */
+	void SubmitSimulatedArrival(const DS5W::DS5InputState& State, double ArrivalTime);
+
+	/** Simulated mode only, connection type the controller reports */
+	void SetSimulatedBluetooth(bool bBluetooth) { Context._internal.connection = bBluetooth ? DS5W::DeviceConnection::BT : DS5W::DeviceConnection::USB; }
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+	/** Pop the oldest report the game thread has not consumed yet */
+	bool DequeueSample(FDS5WInputSample& OutSample) { return Samples.Dequeue(OutSample); }
+
+	/** Hand the output state to the reader thread, only the latest one is written */
+	void SetOutputState(const DS5W::DS5OutputState& InOutputState);
+
+	/** Select the optional fields (DS5W_DECODE_*) decoded from now on, touch tracking stops without DS5W_DECODE_TOUCH */
+	void SetDecodeFlags(uint32 InDecodeFlags) { DecodeFlags.store(InDecodeFlags, std::memory_order_relaxed); }
+
+	bool IsConnected() const { return bConnected.load(std::memory_order_acquire); }
+	bool IsBluetooth() const { return Context._internal.connection == DS5W::DeviceConnection::BT; }
+
+	/** Conversion the device reported for its IMU */
+	const DS5W::IMUCalibration& GetIMUCalibration() const { return Context._internal.imuCalibration; }
+
+	/** Touch trajectory and gestures of this device */
+	FDS5WTouchTracker& GetTouch() { return Touch; }
+	const FDS5WTouchTracker& GetTouch() const { return Touch; }
+
+	/** Reports dropped because the game thread fell behind */
+	uint64 GetNumDroppedSamples() const { return Stats.NumDroppedReports.load(std::memory_order_relaxed); }
+
+private:
+
+	/** Detect edges, track touch and motion, record and queue one report for the game thread */
+	void ProcessSample(FDS5WInputSample& Sample);
+
+	/** Hand the report to the raw report subscribers, Data is the raw report or null if simulated */
+	void DeliverToSubscribers(const FDS5WInputSample& Sample, const uint8* Data);
+
+	/** Release the held buttons and mark the disconnect in the history, once per disconnect */
+	void HandleDisconnect(double Time);
+
+	/** Queue an event for every button that changed since the last report */
+	void EmitButtonEvents(uint32 Buttons, double CaptureTime);
+
+	int32 ControllerId;
+
+	const FDS5WButtonMap& ButtonMap;
+	FDS5WButtonEventQueue& ButtonEvents;
+	FDS5WInputHistory& InputHistory;
+	FDS5WMotionLatch& MotionLatch;
+	FDS5WControllerStats& Stats;
+	FDS5WTrace& Trace;
+	FDS5WSharedStateExport& SharedState;
+	FDS5WReportSubscribers& ReportSubscribers;
+
+	/** Button word the queued events lead to, only touched by the reader thread */
+	uint32 LastButtons;
+
+	/** Reports since the device (re)connected, none of them should allocate after warming up */
+	uint64 NumReports;
+
+	/** Reports come from SubmitSimulatedReport */
+	bool bSimulated;
+
+	/** CaptureTime is the arrival time if bMapDeviceTime is set */
+	void SubmitSimulated(const DS5W::DS5InputState& State, double Time, bool bMapDeviceTime);
+
+	DS5W::DeviceContext Context;
+	FRunnableThread* Thread;
+
+	std::atomic<bool> bStopRequested;
+	std::atomic<bool> bConnected;
+	std::atomic<uint32> DecodeFlags;
+
+	/** Only touched by the reader thread */
+	FDS5WClockSync ClockSync;
+
+	FDS5WTouchTracker Touch;
+
+	/** Only touched by the reader thread */
+	FDS5WReportBacklog Backlog;
+
+	TCircularQueue<FDS5WInputSample> Samples;
+	TTripleBuffer<DS5W::DS5OutputState> OutputState;
+};
@@ -0,0 +1,90 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+#include <atomic>
+
+/**
+ * Bounded lock-free multi producer / single consumer queue (Vyukov's array queue).
+ * Every cell carries a sequence number, producers claim a position with one CAS and publish the
+ * cell by bumping its sequence, so nothing allocates and a full queue fails instead of blocking.
+ */
+template<typename T, uint32 Capacity>
+class TDS5WMpscQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+
+	TDS5WMpscQueue()
+		: EnqueuePos(0)
+		, DequeuePos(0)
+	{
+		for (uint32 Index = 0; Index < Capacity; ++Index)
+		{
+			Cells[Index].Sequence.store(Index, std::memory_order_relaxed);
+		}
+	}
+
+	/** Any thread. @return false if the queue is full */
+	bool Enqueue(const T& Item)
+	{
+		uint64 Pos = EnqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			FCell& Cell = Cells[Pos & (Capacity - 1)];
+			const uint64 Sequence = Cell.Sequence.load(std::memory_order_acquire);
+			const int64 Difference = (int64)Sequence - (int64)Pos;
+
+			if (Difference == 0)
+			{
+				if (EnqueuePos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+				{
+					Cell.Item = Item;
+					Cell.Sequence.store(Pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (Difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				Pos = EnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/** Consumer thread only. @return false if the queue is empty */
+	bool Dequeue(T& OutItem)
+	{
+		FCell& Cell = Cells[DequeuePos & (Capacity - 1)];
+		const uint64 Sequence = Cell.Sequence.load(std::memory_order_acquire);
+		if ((int64)Sequence - (int64)(DequeuePos + 1) < 0)
+		{
+			return false;
+		}
+
+		OutItem = Cell.Item;
+		Cell.Sequence.store(DequeuePos + Capacity, std::memory_order_release);
+		++DequeuePos;
+		return true;
+	}
+
+private:
+
+	struct FCell
+	{
+		std::atomic<uint64> Sequence;
+		T Item;
+	};
+
+	FCell Cells[Capacity];
+
+	/** Producers and the consumer on separate cache lines */
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> EnqueuePos;
+	alignas(PLATFORM_CACHE_LINE_SIZE) uint64 DequeuePos;
+};
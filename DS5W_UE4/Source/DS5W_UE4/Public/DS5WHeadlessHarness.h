@@ -0,0 +1,163 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Containers/Array.h"
+#include "Containers/UnrealString.h"
+#include "GenericPlatform/GenericApplicationMessageHandler.h"
+#include "Templates/SharedPointer.h"
+#include "Templates/UniquePtr.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+#include "DS5WPadEmulator.h"
+
+class FDS5WInterface;
+
+enum class EDS5WRecordedEventType : uint8
+{
+	Pressed,
+	Released,
+	Analog,
+};
+
+/** One call the interface made on the message handler */
+struct FDS5WRecordedEvent
+{
+	/** Harness frame the event was sent in */
+	uint32 Frame;
+
+	EDS5WRecordedEventType Type;
+	FName Key;
+	int32 ControllerId;
+
+	/** Analog value, unused for buttons */
+	float Value;
+
+	bool bIsRepeat;
+
+	/** FDS5WInterface::GetCurrentInputEventTime when the event was sent */
+	double InputTime;
+
+	/** One line of a golden file: frame, type, key, controller, value, repeat and input time */
+	FString ToString() const;
+	static bool FromString(const FString& Line, FDS5WRecordedEvent& OutEvent);
+};
+
+/** Message handler that records every controller event instead of handling it */
+class FDS5WRecordingMessageHandler : public FGenericApplicationMessageHandler
+{
+public:
+
+	/** Events are kept in one array, reserved up front so recording doesn't show up as allocations */
+	FDS5WRecordingMessageHandler(int32 NumReservedEvents = 16384);
+
+	/** Interface asked for the input time of each event */
+	void SetInterface(const FDS5WInterface* InInterface) { Interface = InInterface; }
+
+	void SetFrame(uint32 InFrame) { Frame = InFrame; }
+
+	const TArray<FDS5WRecordedEvent>& GetEvents() const { return Events; }
+	void Reset() { Events.Reset(); }
+
+	// FGenericApplicationMessageHandler interface
+	virtual bool OnControllerAnalog(FGamepadKeyNames::Type KeyName, int32 ControllerId, float AnalogValue) override;
+	virtual bool OnControllerButtonPressed(FGamepadKeyNames::Type KeyName, int32 ControllerId, bool IsRepeat) override;
+	virtual bool OnControllerButtonReleased(FGamepadKeyNames::Type KeyName, int32 ControllerId, bool IsRepeat) override;
+
+private:
+
+	void Record(EDS5WRecordedEventType Type, FGamepadKeyNames::Type KeyName, int32 ControllerId, float Value, bool bIsRepeat);
+
+	const FDS5WInterface* Interface;
+	uint32 Frame;
+	TArray<FDS5WRecordedEvent> Events;
+};
+
+/** Cost of one harness frame */
+struct FDS5WHarnessFrameStats
+{
+	int32 NumEvents;
+
+	/** Time spent in SendControllerEvents */
+	double Seconds;
+
+	/** Cycles spent in SendControllerEvents, from the time stamp counter where there is one */
+	uint64 Cycles;
+};
+
+/**
+ * Drives an FDS5WInterface without devices or engine loop. Reports are fed to simulated controllers,
+ * every frame advances a simulated clock and runs SendControllerEvents, and everything sent to the
+ * message handler is recorded. Recordings can be saved as golden files and diffed against later runs,
+ * per frame statistics show what a dispatch change costs.
+ */
+class FDS5WHeadlessHarness
+{
+public:
+
+	FDS5WHeadlessHarness(int32 InNumControllers, double InFrameInterval = 1.0 / 60.0, double InReportInterval = 1.0 / 250.0);
+	~FDS5WHeadlessHarness();
+
+	/** Submit one report, CaptureTime should lie between the previous frame and the next one */
+	void SubmitReport(int32 ControllerId, const DS5W::DS5InputState& State, double CaptureTime);
+
+	/** Disconnect a controller now, the next report connects it again */
+	void Disconnect(int32 ControllerId);
+
+	/**
+	 * Emulate a pad on a controller from now on: every frame first delivers the reports that reached the
+	 * host by then. Set what the pad holds on the returned emulator. Don't also submit reports to it.
+	 */
+	FDS5WPadEmulator& EmulatePad(int32 ControllerId, const FDS5WPadEmulatorSettings& Settings = FDS5WPadEmulatorSettings());
+
+	/** Advance the clock by one frame interval and send the events */
+	const FDS5WHarnessFrameStats& RunFrame();
+
+	/**
+	 * Hold States[i] on controller i for one frame, submitted at the report interval with matching
+	 * sensor timestamps, then run the frame. Null entries submit nothing for that controller.
+	 */
+	const FDS5WHarnessFrameStats& RunFrame(const DS5W::DS5InputState* const* States);
+
+	/** Simulated time of the last frame */
+	double GetTime() const { return Time; }
+
+	FDS5WInterface& GetInterface() { return *Interface; }
+	const TArray<FDS5WRecordedEvent>& GetEvents() const { return Handler->GetEvents(); }
+	const TArray<FDS5WHarnessFrameStats>& GetFrameStats() const { return FrameStats; }
+
+	/** Drop the recorded events but keep their memory, so long runs stay within the reserved events */
+	void ResetEvents() { Handler->Reset(); }
+
+	/** Frames, events and time per frame (mean and max) */
+	FString GetSummary() const;
+
+	/** One line per controller and connection type it was seen on: input age min, p50 and p99 */
+	void GetInputAgeSummary(TArray<FString>& OutLines) const;
+
+	/**
+	 * Compare the recording with a golden one, input times and values within Tolerance.
+	 * @return true if equal, otherwise OutDiff describes the first MaxDiffLines differences
+	 */
+	bool CompareWithGolden(const TArray<FDS5WRecordedEvent>& Golden, TArray<FString>& OutDiff, float Tolerance = 1.e-4f, int32 MaxDiffLines = 32) const;
+
+	bool SaveGolden(const FString& Filename) const;
+	static bool LoadGolden(const FString& Filename, TArray<FDS5WRecordedEvent>& OutGolden);
+
+private:
+
+	int32 NumControllers;
+	double FrameInterval;
+	double ReportInterval;
+
+	double Time;
+	uint32 Frame;
+
+	TSharedRef<FDS5WRecordingMessageHandler> Handler;
+	TUniquePtr<FDS5WInterface> Interface;
+
+	TArray<FDS5WHarnessFrameStats> FrameStats;
+	TArray<TUniquePtr<FDS5WPadEmulator>> Emulators;
+};
@@ -0,0 +1,108 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Templates/UniquePtr.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+#include "DS5WSnapshot.h"
+
+#include <atomic>
+
+/** Reports kept per controller unless configured otherwise, ~4 s at the USB report rate */
+#define DS5W_INPUT_HISTORY_CAPACITY 1024
+
+/** Capacity is clamped to this range and rounded up to a power of two */
+#define DS5W_INPUT_HISTORY_MIN_CAPACITY 16
+#define DS5W_INPUT_HISTORY_MAX_CAPACITY 65536
+
+/** Section holding the Capacity entry */
+#define DS5W_INPUT_HISTORY_CONFIG_SECTION TEXT("/Script/DS5W_UE4.DS5WInputHistory")
+
+/** One report of the history */
+struct FDS5WInputHistoryEntry
+{
+	/** Host time the report was captured at */
+	double CaptureTime;
+
+	FDS5WSnapshot Snapshot;
+
+	/** False for the entry marking a disconnect, its snapshot is neutral */
+	bool bConnected;
+};
+
+/**
+ * Timestamped reports of one controller for rollback, replays and anything else that needs the state at
+ * a past time. Written by the reader thread only, read from any thread.
+ *
+ * Capture times never decrease from one entry to the next, disconnects included: FDS5WClockSync keeps
+ * mapped times monotonic and the searches by time rely on it. Reports pushed with their own times
+ * (simulated controllers) have to keep that order too.
+ *
+ * The entries live in a fixed ring of one cache line per slot, so memory is Capacity * 64 bytes and
+ * nothing is allocated after Init. Each slot carries a sequence number telling which report it holds:
+ * readers copy a slot and check the number before and after, a slot overwritten meanwhile fails the
+ * check and counts as too old. Readers never wait on the writer and the writer never waits at all.
+ */
+class FDS5WInputHistory
+{
+public:
+
+	FDS5WInputHistory();
+
+	/** Allocate the ring, reading the capacity from the config when InCapacity is 0. Not thread safe */
+	void Init(int32 InCapacity = 0);
+
+	/** Writer only */
+	void Push(const DS5W::DS5InputState& State, double CaptureTime);
+	void PushDisconnect(double Time);
+
+	/** Reports written so far, the latest one has index GetNumWritten() - 1 */
+	uint64 GetNumWritten() const { return NumWritten.load(std::memory_order_acquire); }
+
+	int32 GetCapacity() const { return (int32)(Mask + 1); }
+
+	/**
+	 * Copy report Index.
+	 * @return false if it wasn't written yet or was overwritten already
+	 */
+	bool GetEntry(uint64 Index, FDS5WInputHistoryEntry& OutEntry) const;
+
+	/**
+	 * Latest report captured at or before Time, found by binary search.
+	 * @return false if the history is empty or Time lies before the oldest report still held
+	 */
+	bool GetEntryAtTime(double Time, FDS5WInputHistoryEntry& OutEntry) const;
+
+	/** Index of the first report captured after Time, GetNumWritten() if there is none yet */
+	uint64 FindFirstAfter(double Time) const;
+
+	/**
+	 * Copy the reports captured after StartTime up to and including EndTime, oldest first.
+	 * @return number of reports copied, at most MaxEntries
+	 */
+	int32 GetEntriesInRange(double StartTime, double EndTime, FDS5WInputHistoryEntry* OutEntries, int32 MaxEntries) const;
+
+private:
+
+	struct alignas(PLATFORM_CACHE_LINE_SIZE) FSlot
+	{
+		/** 2 * index + 1 while report index is written, 2 * index + 2 once it is complete */
+		std::atomic<uint32> Sequence;
+
+		FDS5WInputHistoryEntry Entry;
+	};
+	static_assert(sizeof(FSlot) == PLATFORM_CACHE_LINE_SIZE, "A history slot should take one cache line");
+
+	void Write(const FDS5WInputHistoryEntry& Entry);
+
+	/** Index of the first report captured after Time among the reports from Oldest on */
+	uint64 FindFirstAfter(double Time, uint64 Oldest, uint64 End) const;
+
+	TUniquePtr<FSlot[]> Slots;
+	uint64 Mask;
+
+	std::atomic<uint64> NumWritten;
+};
@@ -0,0 +1,53 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Math/Vector.h"
+
+class FDS5WInputHistory;
+
+/** Controller input over one simulation tick */
+struct FDS5WTickInput
+{
+	/** Left x, left y, right x, right y in [-1, 1] at the end of the tick, before deadzones */
+	float Sticks[4];
+
+	/** Left and right trigger in [0, 1] at the end of the tick */
+	float Triggers[2];
+
+	/** Buttons held at the end of the tick, in the report layout of FDS5WSnapshot::Buttons */
+	uint32 Buttons;
+
+	/** Buttons that went down or up during the tick, so a tap shorter than a tick isn't lost */
+	uint32 PressedButtons;
+	uint32 ReleasedButtons;
+
+	/** Gyro integrated over the tick, degrees around the calibrated axes */
+	FVector GyroRotation;
+
+	/** Reports captured during the tick */
+	int32 NumReports;
+
+	bool bConnected;
+};
+
+/**
+ * Resamples the full rate report stream of an FDS5WInputHistory onto arbitrary ticks, for simulations
+ * stepping at their own rate. Times are host times, like the capture times of the reports.
+ *
+ * Analog values are interpolated between the reports around the end of the tick. Each report's gyro
+ * reading covers the time since the report before it, so integrating over consecutive ticks adds up to
+ * the integral over the whole stream. Past the newest report the last values are held, so a tick ending
+ * now is complete but the gyro of its last few milliseconds is extrapolated.
+ */
+class FDS5WInputResampler
+{
+public:
+
+	/**
+	 * Input over (TickStart, TickEnd]. Safe from any thread, like reading the history.
+	 * @return false if the history holds no report from before TickEnd
+	 */
+	static bool Resample(const FDS5WInputHistory& History, double TickStart, double TickEnd, FDS5WTickInput& OutInput);
+};
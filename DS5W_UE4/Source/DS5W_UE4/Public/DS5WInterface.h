@@ -13,13 +13,32 @@
 #include "DualSenseWindows/Helpers.h"
 #include "DualSenseWindows/IO.h"
 
+#include "HAL/PlatformTime.h"
+#include "Templates/UniquePtr.h"
+
 #include "GamepadMotion.hpp"
 
+#include "DS5WAnalog.h"
+#include "DS5WButtons.h"
+#include "DS5WDeviceReader.h"
+#include "DS5WInputHistory.h"
+#include "DS5WInputResampler.h"
+#include "DS5WMotionLatch.h"
+#include "DS5WPredictor.h"
+#include "DS5WReportSubscribers.h"
+#include "DS5WSharedStateExport.h"
+#include "DS5WSnapshot.h"
+#include "DS5WStats.h"
+#include "DS5WStreamServer.h"
+#include "DS5WTouch.h"
+#include "DS5WTrace.h"
+
 /** Max number of controllers. */
 #define MAX_NUM_DS5W_CONTROLLERS 4
 
-/** Max number of controller buttons.  Must be < 256*/
-#define MAX_NUM_CONTROLLER_BUTTONS 27
+/** Gyroscope samples averaged by the smoothing filter */
+#define DS5W_GYRO_SMOOTHING_SAMPLES 10
+
 
 enum class FForceFeedbackChannelType;
 
@@ -27,7 +46,8 @@ class FDS5WInterface : public IInputDevice
 {
 public:
 
-    FDS5WInterface(const TSharedRef<FGenericApplicationMessageHandler>& InMessageHandler);
+    /** bOpenDevices false starts without devices, for simulated controllers */
+    FDS5WInterface(const TSharedRef<FGenericApplicationMessageHandler>& InMessageHandler, bool bOpenDevices = true);
     ~FDS5WInterface();
 
     /** Tick the interface (e.g. check for new controllers) */
@@ -39,8 +59,14 @@ public:
     /** Set which MessageHandler will get the events from SendControllerEvents. */
     virtual void SetMessageHandler(const TSharedRef< FGenericApplicationMessageHandler >& InMessageHandler) override;
 
-    /** Exec handler to allow console commands to be passed through for debugging */
-    virtual bool Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar) override { return false; } ;
+    /**
+     * Exec handler to allow console commands to be passed through for debugging.
+     * "DS5W STATS" prints the counters and latency histograms of every connected controller,
+     * "DS5W STATS RESET" starts them over.
+     * "DS5W TRACE START|STOP" records the pipeline timeline, "DS5W TRACE FLUSH [File]" writes it as
+     * Chrome trace-event JSON, by default to the profiling directory.
+     */
+    virtual bool Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar) override;
 
     void SetNeedsControllerStateUpdate() { bNeedsControllerStateUpdate = true; }
     virtual bool IsGamepadAttached() const override { return bIsGamepadAttached; }
@@ -49,6 +75,118 @@ public:
 	virtual void SetChannelValue(int32 ControllerId, const FForceFeedbackChannelType ChannelType, const float Value) override;
 	virtual void SetChannelValues(int32 ControllerId, const FForceFeedbackValues& Values) override;
 
+	/**
+	 * Copy the newest touchpad samples of a controller, oldest first. Safe to call from any thread.
+	 * @return Number of samples written to OutSamples
+	 */
+	int32 GetTouchTrajectory(int32 ControllerId, FDS5WTouchSample* OutSamples, int32 MaxSamples) const;
+
+	/**
+	 * Timestamped reports of a controller, kept across disconnects for as long as the interface lives.
+	 * Safe to read from any thread, see FDS5WInputHistory.
+	 */
+	const FDS5WInputHistory* GetInputHistory(int32 ControllerId) const;
+
+	/**
+	 * State of a controller at a past host time, the latest report captured at or before Time.
+	 * @return false if Time lies outside the history
+	 */
+	bool GetInputStateAtTime(int32 ControllerId, double Time, DS5W::DS5InputState& OutState) const;
+
+	/**
+	 * Input of a controller over the simulation tick (TickStart, TickEnd], resampled from every report
+	 * rather than from what the last frame saw. Safe to call from any thread. Calls keep the gyro decoded
+	 * like a motion consumer for a while, see AddInputConsumer.
+	 * @return false if the history holds nothing from before TickEnd
+	 */
+	bool GetTickInput(int32 ControllerId, double TickStart, double TickEnd, FDS5WTickInput& OutInput) const;
+
+	/**
+	 * Register interest in optional inputs (DS5W_DECODE_* flags). Inputs nobody consumes are neither decoded nor fused.
+	 * Every AddInputConsumer needs a matching RemoveInputConsumer.
+	 *
+	 * DS5W keys bound in the project's input settings register themselves, bindings made elsewhere (Enhanced
+	 * Input mapping contexts, mappings added at runtime) need an explicit consumer. The queries of motion and
+	 * touch register their input for a couple of seconds after each call, so the first call after a quiet
+	 * spell sees no fresh data yet; callers that need every report from the start hold a consumer instead.
+	 */
+	void AddInputConsumer(uint32 DecodeFlags);
+	void RemoveInputConsumer(uint32 DecodeFlags);
+
+	/**
+	 * Every raw report of every controller at full rate, delivered on the reader threads or queued for
+	 * consumers on other threads. Stays valid for as long as the interface lives.
+	 */
+	FDS5WReportSubscribers& GetReportSubscribers() { return ReportSubscribers; }
+
+	/** Quantised copy of the newest report of a controller, for replication. Returns false if it isn't connected */
+	bool GetSnapshot(int32 ControllerId, FDS5WSnapshot& OutSnapshot) const;
+
+	/**
+	 * Fused orientation of a controller (pack with FDS5WQuatCodec for streaming).
+	 * Only updated while motion has a consumer, calls count as one for a while (see AddInputConsumer).
+	 */
+	bool GetOrientation(int32 ControllerId, FQuat& OutOrientation) const;
+
+	/**
+	 * Late latched motion for the render thread, see FDS5WMotionLatch. The fused orientation of the last
+	 * frame is advanced by the gyro of every report since, OutTime is the capture time of the newest one.
+	 * Never blocks, callable from any thread. Needs a motion consumer and counts as one like GetOrientation.
+	 */
+	bool GetLatestOrientation(int32 ControllerId, FQuat& OutOrientation, double& OutTime) const;
+
+	/**
+	 * Rotation in controller space measured by the gyro since the report at or before Time, any thread.
+	 * Needs a motion consumer and counts as one like GetOrientation.
+	 */
+	bool GetGyroDeltaSince(int32 ControllerId, double Time, FQuat& OutDelta, double& OutTime) const;
+
+	/**
+	 * Sticks, gyro and orientation predicted Horizon seconds past the newest report (the configured horizon
+	 * if negative), see FDS5WPredictor. Game thread. Gyro and orientation need a motion consumer, calls
+	 * count as one like GetOrientation. @return false unless prediction is enabled in the input ini and
+	 * the controller is connected
+	 */
+	bool GetPredictedInput(int32 ControllerId, FDS5WPrediction& OutPrediction, float Horizon = -1.f) const;
+
+	/**
+	 * Switch the button profile of a player, "Default" or one listed in the input ini (see FDS5WButtonProfile).
+	 * Held buttons are moved over in the next frame. @return false if there is no such profile
+	 */
+	bool SetButtonProfile(int32 ControllerId, FName ProfileName);
+	FName GetButtonProfile(int32 ControllerId) const;
+
+	/**
+	 * Host time the input being sent to the message handler was captured at. Button edges carry the time of
+	 * the report they happened in, so handlers can order inputs finer than the frame.
+	 */
+	double GetCurrentInputEventTime() const { return CurrentInputEventTime; }
+
+	/**
+	 * Age of the input a controller delivered this frame: the time since the newest consumed report was
+	 * captured, its device timestamp mapped to host time. Every frame's age goes into the controller's
+	 * stats, per connection type. @return false if the controller isn't connected
+	 */
+	bool GetInputAge(int32 ControllerId, double& OutAge) const;
+
+	/** Counters and latency histograms of a controller, see FDS5WControllerStats */
+	const FDS5WControllerStats* GetControllerStats(int32 ControllerId) const;
+
+	/**
+	 * Simulated controllers, fed with reports instead of a device (see FDS5WHeadlessHarness).
+	 * Reports of one controller must be submitted from one thread, in capture order.
+	 */
+	bool AddSimulatedController(int32 ControllerId);
+	bool SubmitSimulatedReport(int32 ControllerId, const DS5W::DS5InputState& State, double CaptureTime);
+	bool DisconnectSimulatedController(int32 ControllerId, double Time);
+
+	/** Report that reached the host at ArrivalTime, the capture time is estimated like for a device */
+	bool SubmitSimulatedArrival(int32 ControllerId, const DS5W::DS5InputState& State, double ArrivalTime);
+	bool SetSimulatedConnection(int32 ControllerId, bool bBluetooth);
+
+	/** Drive button repeats and timeouts from Time instead of the platform clock, a negative time restores it */
+	void SetSimulatedTime(double Time) { SimulatedTime = Time; }
+
 private:
 
 	struct FPlayerLED
@@ -101,20 +239,19 @@ private:
 			return input;
 		}
 
-		// smoothing buffer
-		TArray<FVector2D>::SizeType InputBufferSize;
-		TArray<FVector2D> InputBuffer;
+		// smoothing buffer, fixed so the controller state never allocates
+		FVector2D InputBuffer[DS5W_GYRO_SMOOTHING_SAMPLES];
 		int CurrentInputIndex;
 
 		FVector2D GetSmoothedInput(FVector2D input) {
-			CurrentInputIndex = (CurrentInputIndex + 1) % InputBuffer.Num();
+			CurrentInputIndex = (CurrentInputIndex + 1) % DS5W_GYRO_SMOOTHING_SAMPLES;
 			InputBuffer[CurrentInputIndex] = input;
 
 			FVector2D average = FVector2D::ZeroVector;
 			for (FVector2D sample : InputBuffer) {
 				average += sample;
 			}
-			average /= InputBuffer.Num();
+			average /= DS5W_GYRO_SMOOTHING_SAMPLES;
 
 			return average;
 		}
@@ -146,38 +283,91 @@ private:
 		}
 	};
 
+	/**
+	 * Per controller state read or written every frame for every controller, one cache line each.
+	 * Everything else is only touched for controllers with new reports, consumers or settings changes.
+	 */
+	struct alignas(PLATFORM_CACHE_LINE_SIZE) FControllerHotState
+	{
+		/* Host time the last sample was captured at */
+		double LastMeasurementTime;
+
+		/* Device time of the last consumed sample */
+		double LastDeviceTime;
+
+		/** Processed stick and trigger values sent last, events only go out when they change */
+		float AnalogValues[DS5W_NUM_ANALOG_AXES];
+
+		/** Engine button states sent so far (one bit per button), so we only send events on edges */
+		uint32 ButtonStates;
+
+		/** DS5W button states the events so far lead to, ButtonStates is this word remapped by the profile */
+		uint32 RawButtonStates;
+
+		/** Index into ButtonProfiles, a change is applied to the held buttons in the next frame */
+		int32 ButtonProfileIndex;
+		bool bButtonProfileChanged;
+
+		/** If the controller is currently connected */
+		bool bIsConnected;
+
+		/** Bluetooth or USB? */
+		bool bIsBluetooth;
+	};
+
+	static_assert(sizeof(FControllerHotState) <= PLATFORM_CACHE_LINE_SIZE, "FControllerHotState should fit a cache line");
+
+	/** Per report state, only touched for controllers that are connected */
 	struct FControllerState
 	{
-		/** Last frame's button states, so we only send events on edges */
-		bool ButtonStates[MAX_NUM_CONTROLLER_BUTTONS];
+		/** Id of the controller */
+		int32 ControllerId;
 
 		/** Next time a repeat event should be generated for each button */
 		double NextRepeatTime[MAX_NUM_CONTROLLER_BUTTONS];
 
-		/** Raw Left thumb x analog value */
-		int16 LeftXAnalog;
+		/** The last recorded location of Finger 1 on the touchpad */
+		FVector2D LastFirstFingerLocation_Touchpad;
+
+		/** The last recorded location of Finger 2 on the touchpad */
+		FVector2D LastSecondFingerLocation_Touchpad;
+
+		/* Accelerometer */
+		FVector Accelerometer;
 
-		/** Raw left thumb y analog value */
-		int16 LeftYAnalog;
+		/* Gyroscope */
+		FVector Gyroscope;
 
-		/** Raw Right thumb x analog value */
-		int16 RightXAnalog;
+		/* Gamepad orientation */ 
+		FQuat Orientation;
 
-		/** Raw Right thumb x analog value */
-		int16 RightYAnalog;
+		/* Running gyro rotation of the newest report, published with the orientation for late latching */
+		FQuat GyroAccumulator;
 
-		/** Left Trigger analog value */
-		uint8 LeftTriggerAnalog;
+		/* Gamepad acceleration */
+		FVector Acceleration;
 
-		/** Right trigger analog value */
-		uint8 RightTriggerAnalog;
+		/* Gravity vector */
+		FVector Gravity;
 
-		/** If the controller is currently connected */
-		bool bIsConnected;
+		/* Newest report consumed from the reader, kept for frames without a new report */
+		DS5W::DS5InputState LastInputState;
 
-		/** Id of the controller */
-		int32 ControllerId;
+		/* Output state last handed to the reader */
+		DS5W::DS5OutputState LastOutputState;
+
+		/* Touchpad axis values sent last frame */
+		float TouchPinchValue;
+		FVector2D TouchScrollValue;
+
+		/* Gyroscope axises */
+		FGyroscopeSensor GyroscopeAxises;
+		FVector2D GyroAxisLastDelta;
+	};
 
+	/** Per controller settings, written by the game and read when building the output state */
+	struct FControllerConfig
+	{
 		/** Current force feedback values */
 		FForceFeedbackValues ForceFeedback;
 
@@ -193,15 +383,6 @@ private:
 		/** Resistance Type for Triggers. Maps to DS5W:TriggerEffectType */
 		uint8 TriggerEffectType;
 
-		/** Bluetooth or USB? */
-		bool bIsBluetooth;
-
-		/** The last recorded location of Finger 1 on the touchpad */
-		FVector2D LastFirstFingerLocation_Touchpad;
-
-		/** The last recorded location of Finger 2 on the touchpad */
-		FVector2D LastSecondFingerLocation_Touchpad;
-
 		FVector4 LightBarState; // R, G, B  (0-255) with W used for intensity (0-1)
 
 		/** What part of the Touchbar should be what color. Note: Unreal maps 0-255 to 0-1, so we're using a Vector here (RGBA). The uint8 maps to DS5W_OSTATE_PLAYER_LED */
@@ -214,52 +395,149 @@ private:
 		// for calibration:
 		bool UseContinuousCalibration;
 		bool CueMotionReset;
+	};
 
-		/* Accelerometer */
-		FVector Accelerometer;
+	/** Explicit consumers per DS5W_DECODE_* bit */
+	int32 InputConsumerCounts[4];
 
-		/* Gyroscope */
-		FVector Gyroscope;
+	/** Inputs required by the current key bindings */
+	uint32 BoundInputDemand;
+	double NextBindingRefreshTime;
 
-		/* Gamepad orientation */ 
-		FQuat Orientation;
+	/** Host time of the last query per DS5W_DECODE_* bit, queries keep their input decoded for a while */
+	mutable std::atomic<double> LastQueryTimes[4];
 
-		/* Gamepad acceleration */
-		FVector Acceleration;
+	/** Combine explicit consumers, bindings and recent queries into DS5W_DECODE_* flags */
+	uint32 GetInputDemand(double CurrentTime);
+	void RefreshBoundInputDemand();
 
-		/* Gravity vector */
-		FVector Gravity;
-
-		/* Delta time */
-		double LastMeasurementTime;
-		double DeltaTime;
-
-		/* Gyroscope axises */
-		FGyroscopeSensor GyroscopeAxises;
-		FVector2D GyroAxisLastDelta;
-	};
+	/** Note a query of one DS5W_DECODE_* input, any thread */
+	void AddQueryDemand(uint32 DecodeFlag) const;
 
 	/** If we've been notified by the system that the controller state may have changed */
 	bool bNeedsControllerStateUpdate;
 	bool bIsGamepadAttached;
 
-	/** In the engine, all controllers map to xbox controllers for consistency */
-	uint8 DS5WToXboxControllerMapping[MAX_NUM_CONTROLLER_BUTTONS];
+	/** In the engine, all controllers map to xbox controllers for consistency. This is the default button profile */
+	int32 DS5WToXboxControllerMapping[MAX_NUM_CONTROLLER_BUTTONS];
+
+	/** Compiled button profiles, the first one is the default mapping. Only filled in the constructor */
+	TArray<FDS5WButtonProfile> ButtonProfiles;
+
+	/** Load the profiles listed in the input ini and the profile of each player */
+	void LoadButtonProfiles();
+
+	/** Deadzones, response curves and analog button thresholds, read from the input ini */
+	FDS5WAnalogSettings AnalogSettings;
+	FDS5WAnalogProcessor AnalogProcessor;
+
+	/** Packs report buttons into raw button words, shared with the readers */
+	FDS5WButtonMap ButtonMap;
+
+	/** Button edges from all reader threads */
+	FDS5WButtonEventQueue ButtonEvents;
 
-	/** Controller states */
+	/** Written by the readers, owned here so readers on other threads never see them go away */
+	FDS5WInputHistory InputHistories[MAX_NUM_DS5W_CONTROLLERS];
+	FDS5WMotionLatch MotionLatches[MAX_NUM_DS5W_CONTROLLERS];
+	FDS5WControllerStats ControllerStats[MAX_NUM_DS5W_CONTROLLERS];
+
+	/** When the stats were last reset, for the report rates */
+	double StatsResetTime;
+
+	/** Pipeline timeline of all controllers, written by the readers and the game thread */
+	FDS5WTrace Trace;
+
+	/** Live state for other processes, written by the readers while enabled in the input ini */
+	FDS5WSharedStateExport SharedState;
+
+	/** Raw report consumers, called by the readers */
+	FDS5WReportSubscribers ReportSubscribers;
+
+	/** Reports to and output commands from a local client, while enabled in the input ini */
+	TUniquePtr<FDS5WStreamServer> StreamServer;
+	FDS5WRemoteOutput RemoteOutputs[MAX_NUM_DS5W_CONTROLLERS];
+
+	/** Fed with every report the game thread consumes, while enabled */
+	FDS5WPredictionSettings PredictionSettings;
+	FDS5WPredictor Predictors[MAX_NUM_DS5W_CONTROLLERS];
+
+	/** Clock override of the headless harness, negative when the platform clock is used */
+	double SimulatedTime;
+	double GetTime() const { return SimulatedTime >= 0.0 ? SimulatedTime : FPlatformTime::Seconds(); }
+
+	/** Frames sent so far, the allocation tracker expects no allocations after warming up */
+	uint64 NumFrames;
+
+	/** Capture time of the input being sent to the message handler */
+	double CurrentInputEventTime;
+
+	/** Send the queued button edges of all controllers in capture order */
+	void DispatchButtonEvents();
+
+	/** Send presses and releases for the engine buttons that differ from NewButtonStates */
+	void SendButtonChanges(int32 ControllerIndex, uint32 NewButtonStates, double Time);
+
+	/** Controller states, split by how often they are touched */
+	FControllerHotState HotStates[MAX_NUM_DS5W_CONTROLLERS];
 	FControllerState ControllerStates[MAX_NUM_DS5W_CONTROLLERS];
+	FControllerConfig ControllerConfigs[MAX_NUM_DS5W_CONTROLLERS];
 
 	/** Motion states */
 	GamepadMotion MotionStates[MAX_NUM_DS5W_CONTROLLERS];
 
+	/** IMU samples of the reports consumed this frame, fused in one batch */
+	struct FMotionBatch
+	{
+		GamepadMotionHelpers::MotionSample Samples[DS5W_INPUT_QUEUE_SIZE];
+		int32 NumSamples;
+
+		/** Device time of the sample fused before the batch, negative to start without a delta time */
+		double PreviousTime;
+
+		void Reset(double InPreviousTime)
+		{
+			NumSamples = 0;
+			PreviousTime = InPreviousTime;
+		}
+
+		void Add(const DS5W::IMUState& IMU, double DeviceTime)
+		{
+			// A jump backwards or a long gap means the reader reconnected in between
+			if (NumSamples == 0 && !(DeviceTime - PreviousTime > 0.0 && DeviceTime - PreviousTime < 1.0))
+			{
+				PreviousTime = -1.0;
+			}
+
+			// The reader kept queueing while the frame drained it, drop the oldest half and continue from there
+			if (NumSamples == DS5W_INPUT_QUEUE_SIZE)
+			{
+				const int32 NumDropped = DS5W_INPUT_QUEUE_SIZE / 2;
+				PreviousTime = Samples[NumDropped - 1].Timestamp;
+				FMemory::Memmove(Samples, Samples + NumDropped, (NumSamples - NumDropped) * sizeof(GamepadMotionHelpers::MotionSample));
+				NumSamples -= NumDropped;
+			}
+
+			GamepadMotionHelpers::MotionSample& Sample = Samples[NumSamples++];
+			Sample.GyroX = IMU.gyroX;
+			Sample.GyroY = IMU.gyroY;
+			Sample.GyroZ = IMU.gyroZ;
+			Sample.AccelX = IMU.accelX;
+			Sample.AccelY = IMU.accelY;
+			Sample.AccelZ = IMU.accelZ;
+			Sample.Timestamp = DeviceTime;
+		}
+	};
+	FMotionBatch MotionBatches[MAX_NUM_DS5W_CONTROLLERS];
+
 	/** Delay before sending a repeat message after a button was first pressed */
 	float InitialButtonRepeatDelay;
 
 	/** Delay before sending a repeat message after a button has been pressed for a while */
 	float ButtonRepeatDelay;
 
+	/** Identifies our events. There's no hardware identifier, the scope would copy that FString for every event */
 	FName DS5WInterfaceName = "DS5WInterface";
-	FString DS5WControllerIdentifier = "DS5WController";
 
 	FGamepadKeyNames::Type Buttons[MAX_NUM_CONTROLLER_BUTTONS];
 
@@ -268,18 +546,19 @@ private:
 
     /* Message handler */
     TSharedRef<FGenericApplicationMessageHandler>  MessageHandler;
-    DS5W::DeviceContext con;
+
+	/** One reader thread per device, slot i reads the i-th enumerated device */
+	TUniquePtr<FDS5WDeviceReader> Readers[MAX_NUM_DS5W_CONTROLLERS];
+
+	/** Send the gestures recognised by the reader thread since the last frame */
+	void SendTouchEvents(FControllerState& ControllerState, FDS5WTouchTracker& Touch);
 
 	void reset_continuous_calibration(GamepadMotion& Motion) {
 		Motion.ResetContinuousCalibration();
 	}
 
-	void push_sensor_samples(GamepadMotion& Motion, const FControllerState& Controller) {
-		Motion.ProcessMotion(
-			Controller.Gyroscope.X, Controller.Gyroscope.Y, Controller.Gyroscope.Z,
-			Controller.Accelerometer.X, Controller.Accelerometer.Y, Controller.Accelerometer.Z,
-			Controller.DeltaTime
-		);
+	void push_sensor_samples(GamepadMotion& Motion, const FMotionBatch& Batch) {
+		Motion.ProcessMotionBatch(Batch.Samples, Batch.NumSamples, Batch.PreviousTime);
 	}
 
 	void get_calibrated_gyro(FControllerState& Controller, GamepadMotion& Motion)
@@ -0,0 +1,94 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Math/Quat.h"
+#include "Math/Vector.h"
+
+#include "DS5WSeqLock.h"
+
+#include <atomic>
+
+/** Recent reports whose integrated gyro can be asked for, ~128 ms at the USB report rate */
+#define DS5W_MOTION_LATCH_SLOTS 32
+
+/**
+ * Lets the render thread see controller motion newer than the game frame.
+ *
+ * The reader thread integrates the gyro of every report into a running rotation and publishes it with
+ * the report's capture time. The game thread publishes the orientation it fused together with the running
+ * rotation of the report it fused. The latest orientation is then the fused one turned by the rotation
+ * accumulated since, so a query just before rendering is at most one report interval old instead of
+ * a frame. Both sides go through sequence locks: no thread ever blocks another.
+ *
+ * The running rotation is gyro only. Over the few reports between a frame and its rendering, drift and
+ * the continuous calibration offset are negligible.
+ */
+class FDS5WMotionLatch
+{
+public:
+
+	FDS5WMotionLatch();
+
+	/**
+	 * Reader thread. Integrate the calibrated gyro (deg/s) of a report over the device time since the
+	 * previous one. @return the running rotation after the report
+	 */
+	FQuat AddReport(const FVector& Gyro, double DeviceTime, double CaptureTime);
+
+	/** Reader thread, the next report starts a new integration step (device clock restarted) */
+	void Restart() { bHasDeviceTime = false; }
+
+	/** Reader thread, running rotation after the last report */
+	const FQuat& GetAccumulator() const { return Accumulator; }
+
+	/** Game thread. Orientation fused from the report that returned Accumulator, captured at Time */
+	void SetBase(const FQuat& Orientation, const FQuat& Accumulator, double Time);
+
+	/**
+	 * Fused orientation advanced to the newest report. Any thread.
+	 * @param OutTime capture time of the newest report
+	 * @return false before the first fused orientation
+	 */
+	bool GetLatestOrientation(FQuat& OutOrientation, double& OutTime) const;
+
+	/**
+	 * Rotation in controller space between the report at or before Time and the newest report. Any thread.
+	 * @return false if Time is older than the reports held
+	 */
+	bool GetGyroDeltaSince(double Time, FQuat& OutDelta, double& OutTime) const;
+
+private:
+
+	/** Running rotation after a report */
+	struct FMark
+	{
+		uint64 Index;
+		double Time;
+		FQuat Accumulator;
+	};
+
+	struct FBase
+	{
+		double Time;
+		FQuat Orientation;
+		FQuat Accumulator;
+	};
+
+	/** @return false if the slot of report Index holds a newer report already */
+	bool ReadMark(uint64 Index, FMark& OutMark) const;
+
+	/** Newest report, retried if the writer laps its slot while reading */
+	bool ReadLatestMark(FMark& OutMark) const;
+
+	/** Only touched by the reader thread */
+	FQuat Accumulator;
+	double LastDeviceTime;
+	bool bHasDeviceTime;
+
+	TDS5WSeqLock<FMark> Marks[DS5W_MOTION_LATCH_SLOTS];
+	std::atomic<uint64> NumMarks;
+
+	TDS5WSeqLock<FBase> Base;
+};
@@ -0,0 +1,93 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Math/RandomStream.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+class FDS5WInterface;
+
+/** How an emulated pad produces reports and how they travel to the host */
+struct FDS5WPadEmulatorSettings
+{
+	bool bBluetooth;
+
+	/** Device seconds between two reports */
+	double ReportInterval;
+
+	/** Transport latency of the fastest report, and the most any report adds on top (uniformly) */
+	double MinLatency;
+	double MaxJitter;
+
+	/** The device clock runs fast by this fraction of the host clock, e.g. 50.e-6 for 50 ppm */
+	double ClockDrift;
+
+	int32 Seed;
+
+	/** Wired defaults */
+	FDS5WPadEmulatorSettings();
+
+	static FDS5WPadEmulatorSettings Usb();
+	static FDS5WPadEmulatorSettings Bluetooth();
+};
+
+/**
+ * Software DualSense for scripted latency tests on a simulated controller of an FDS5WInterface.
+ *
+ * The pad captures the state it holds every report interval on its own drifting clock and stamps the
+ * report with its sensor timestamp. Reports reach the host after a jittery transport latency, in order,
+ * and go through the reader's clock mapping like device reports. The input age the interface measures
+ * therefore reacts to report rate, transport, frame pacing and clock mapping the way it would on hardware,
+ * so changes to any of them can be judged by their effect on latency (see FDS5WHeadlessHarness::EmulatePad).
+ *
+ * The mapped capture time includes the fastest transport latency, which no host side estimate can
+ * separate from the clock offset. Measured ages are short of the true ones by MinLatency.
+ */
+class FDS5WPadEmulator
+{
+public:
+
+	/** The controller must have been added with FDS5WInterface::AddSimulatedController */
+	FDS5WPadEmulator(FDS5WInterface& InInterface, int32 InControllerId, const FDS5WPadEmulatorSettings& InSettings, double StartTime);
+
+	/** State captured by the reports from now on */
+	void SetState(const DS5W::DS5InputState& InState) { State = InState; }
+	const DS5W::DS5InputState& GetState() const { return State; }
+
+	/**
+	 * Deliver every report that reached the host by HostTime.
+	 * @return Number of reports delivered
+	 */
+	int32 Advance(double HostTime);
+
+	int32 GetControllerId() const { return ControllerId; }
+	const FDS5WPadEmulatorSettings& GetSettings() const { return Settings; }
+
+	/** True host capture time of the last delivered report, to check the mapped one against */
+	double GetLastCaptureTime() const { return LastCaptureTime; }
+
+private:
+
+	/** Capture and transport of the next report */
+	void ScheduleReport();
+
+	FDS5WInterface& Interface;
+	int32 ControllerId;
+	FDS5WPadEmulatorSettings Settings;
+	FRandomStream Random;
+
+	DS5W::DS5InputState State;
+
+	double StartTime;
+	uint32 TimestampBase;
+	uint64 NumReports;
+
+	/** Next report, captured at PendingCaptureTime and arriving at PendingArrivalTime */
+	double PendingCaptureTime;
+	double PendingArrivalTime;
+	uint32 PendingTimestamp;
+
+	double LastCaptureTime;
+};
@@ -0,0 +1,122 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Math/Quat.h"
+#include "Math/Vector.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+struct FDS5WInputHistoryEntry;
+
+/** Config section the prediction settings are read from (in the input ini) */
+#define DS5W_PREDICTION_CONFIG_SECTION TEXT("/Script/DS5W_UE4.DS5WPrediction")
+
+/** Predicted lanes: left x, left y, right x, right y, gyro x, y, z and one unused lane */
+#define DS5W_PREDICTION_LANES 8
+
+/** Longest horizon accepted, past this a linear model only adds noise */
+#define DS5W_PREDICTION_MAX_HORIZON 0.1f
+
+/** Reports further apart than this restart the filter */
+#define DS5W_PREDICTION_MAX_GAP 0.1
+
+struct FDS5WPredictionSettings
+{
+	/** Off by default, nothing is tracked then */
+	bool bEnabled;
+
+	/** Seconds past the newest report predicted by default */
+	float Horizon;
+
+	/**
+	 * Gains of the alpha-beta filters. Alpha is how much of a report's surprise moves the value, beta how
+	 * much moves the rate of change. Higher values follow faster and pass more noise into the prediction.
+	 */
+	float StickAlpha;
+	float StickBeta;
+	float GyroAlpha;
+	float GyroBeta;
+
+	FDS5WPredictionSettings();
+
+	/** Override the defaults with the values in DS5W_PREDICTION_CONFIG_SECTION of the input ini */
+	void LoadConfig();
+};
+
+/** Input expected a short time after the newest report */
+struct FDS5WPrediction
+{
+	/** Host time predicted for */
+	double Time;
+
+	/** Left x, left y, right x, right y in [-1, 1], before deadzones */
+	float Sticks[4];
+
+	/** Angular velocity in deg/s, calibrated axes */
+	FVector Gyro;
+
+	/** Orientation turned by the predicted angular velocity over the horizon */
+	FQuat Orientation;
+};
+
+/** Prediction error of a trace at one horizon, next to the error of simply holding the newest report */
+struct FDS5WPredictionError
+{
+	float Horizon;
+	int32 NumSamples;
+
+	/** RMS over the stick axes, in normalised units */
+	float StickError;
+	float StickHoldError;
+
+	/** RMS over the gyro axes, in deg/s */
+	float GyroError;
+	float GyroHoldError;
+};
+
+/**
+ * Short horizon predictor for sticks and gyro. One alpha-beta filter per lane tracks value and rate of
+ * change, updated once per report at constant cost, and predictions extrapolate linearly. The orientation
+ * is the GamepadMotion quaternion turned by the angular velocity predicted for the middle of the horizon.
+ */
+class FDS5WPredictor
+{
+public:
+
+	FDS5WPredictor();
+
+	void Init(const FDS5WPredictionSettings& Settings);
+
+	/** Forget the tracked state, the next report starts over */
+	void Reset();
+
+	/** Track one report captured at Time */
+	void AddSample(const DS5W::DS5InputState& State, double Time);
+
+	/**
+	 * Predict Horizon seconds past the newest report.
+	 * @param Orientation fused orientation at the newest report
+	 * @return false before the first report
+	 */
+	bool Predict(float Horizon, const FQuat& Orientation, FDS5WPrediction& OutPrediction) const;
+
+	/**
+	 * Replay a recorded trace (e.g. copied from FDS5WInputHistory) and measure the prediction error at each
+	 * horizon against the trace itself, for tuning the gains to a latency budget.
+	 */
+	static void MeasureError(const FDS5WPredictionSettings& Settings, const FDS5WInputHistoryEntry* Entries, int32 NumEntries,
+		const float* Horizons, int32 NumHorizons, FDS5WPredictionError* OutErrors);
+
+private:
+
+	alignas(16) float Alpha[DS5W_PREDICTION_LANES];
+	alignas(16) float Beta[DS5W_PREDICTION_LANES];
+
+	alignas(16) float Values[DS5W_PREDICTION_LANES];
+	alignas(16) float Rates[DS5W_PREDICTION_LANES];
+
+	double LastTime;
+	bool bHasSample;
+};
@@ -0,0 +1,77 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Math/Quat.h"
+
+class FArchive;
+
+/** Number of received orientations kept for interpolation */
+#define DS5W_ORIENTATION_STREAM_SIZE 32
+
+/**
+ * Smallest-three quaternion codec.
+ *
+ * The largest component is dropped (it follows from the unit length) and its sign folded into the others,
+ * which leaves three components in [-1/sqrt(2), 1/sqrt(2)]. Each is quantised to BitsPerComponent bits, so
+ * a quaternion takes 2 + 3 * BitsPerComponent bits: 32 bits at 10 bits per component (~0.25 degree worst case),
+ * 47 bits at 15.
+ */
+struct FDS5WQuatCodec
+{
+	static constexpr int32 MinBitsPerComponent = 4;
+	static constexpr int32 MaxBitsPerComponent = 20;
+
+	/** Pack into the low 2 + 3 * BitsPerComponent bits */
+	static uint64 Encode(const FQuat& Orientation, int32 BitsPerComponent);
+
+	/** Rebuild a normalised quaternion */
+	static FQuat Decode(uint64 Packed, int32 BitsPerComponent);
+
+	/** Write or read a quaternion bit-packed (with FBitWriter / FBitReader) */
+	static void Serialize(FArchive& Ar, FQuat& Orientation, int32 BitsPerComponent);
+
+	/** Number of bits one quaternion takes */
+	static int32 GetNumBits(int32 BitsPerComponent) { return 2 + 3 * BitsPerComponent; }
+};
+
+/**
+ * Receiving side of an orientation stream. Keeps the last decoded samples and reconstructs the
+ * orientation at any time between them by slerping the two samples around it.
+ */
+class FDS5WOrientationStream
+{
+public:
+
+	FDS5WOrientationStream(int32 InBitsPerComponent);
+
+	void Reset();
+
+	/** Add a received sample, samples must arrive in time order */
+	void AddSample(double Time, uint64 Packed);
+	void AddSample(double Time, const FQuat& Orientation);
+
+	/**
+	 * Orientation at Time. Times outside the kept samples clamp to the oldest / newest one.
+	 * @return false if no sample was received yet
+	 */
+	bool Sample(double Time, FQuat& OutOrientation) const;
+
+private:
+
+	struct FSample
+	{
+		double Time;
+		FQuat Orientation;
+	};
+
+	const FSample& GetSample(int32 Age) const { return Samples[(Head - Age + DS5W_ORIENTATION_STREAM_SIZE) % DS5W_ORIENTATION_STREAM_SIZE]; }
+
+	int32 BitsPerComponent;
+
+	/** Ring of samples, Head is the newest */
+	FSample Samples[DS5W_ORIENTATION_STREAM_SIZE];
+	int32 NumSamples;
+	int32 Head;
+};
@@ -0,0 +1,163 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Templates/Function.h"
+#include "Templates/UniquePtr.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+#include "DS5WEventQueue.h"
+
+#include <atomic>
+
+/** Subscribers that can be registered at once */
+#define DS5W_MAX_REPORT_SUBSCRIBERS 8
+
+/** Reports a queued subscriber can fall behind by before new ones are dropped (~1 s at the USB report rate) */
+#define DS5W_REPORT_SUBSCRIBER_QUEUE_SIZE 256
+
+/** Input report sizes including the report id */
+#define DS5W_RAW_REPORT_USB_BYTES 64
+#define DS5W_RAW_REPORT_BT_BYTES  78
+#define DS5W_RAW_REPORT_MAX_BYTES DS5W_RAW_REPORT_BT_BYTES
+
+/**
+ * One report as the reader thread sees it, handed to subscriber callbacks. Points into the reader's
+ * buffers, so it is only valid during the callback; copy what has to outlive it.
+ */
+struct FDS5WRawReportView
+{
+	int32 ControllerId;
+
+	/** Input report as read from the device, starting with the report id. Empty for simulated reports */
+	const uint8* Data;
+	int32 NumBytes;
+
+	bool bBluetooth;
+
+	/**
+	 * Decoded from Data with the decode flags in effect, optional fields nobody consumes are left out.
+	 * Reports that queued up behind another one carry the touch and status of the report before them.
+	 */
+	const DS5W::DS5InputState* State;
+
+	/** Host time the report was captured at */
+	double CaptureTime;
+
+	/** Unwrapped device time of the report in seconds */
+	double DeviceTime;
+};
+
+/** Copy of a report waiting in a subscriber's queue */
+struct FDS5WRawReport
+{
+	int32 ControllerId;
+	int32 NumBytes;
+	bool bBluetooth;
+	uint8 Data[DS5W_RAW_REPORT_MAX_BYTES];
+	DS5W::DS5InputState State;
+	double CaptureTime;
+	double DeviceTime;
+};
+
+/** Identifies a subscription, stays invalid once it is unsubscribed even if its slot is reused */
+struct FDS5WReportSubscription
+{
+	int32 Index;
+	uint32 Generation;
+
+	FDS5WReportSubscription() : Index(INDEX_NONE), Generation(0) {}
+	bool IsValid() const { return Index != INDEX_NONE; }
+};
+
+/**
+ * Delivers every report of every controller at full rate to analytics, gesture detection or cheat
+ * heuristics that shouldn't wait for the game thread.
+ *
+ * A subscriber gets a callback, a queue, or both. Callbacks run on the reader thread of the reporting
+ * controller right after the report is decoded, with a view of the raw report and its decoded state, and
+ * hold up that controller's reads for as long as they take; several controllers call them concurrently.
+ * Slow consumers take a queue instead and drain it from their own thread. A full queue drops new reports
+ * and counts them, the reader never waits.
+ *
+ * Subscribing and unsubscribing may happen on any thread at any time. The read path takes no locks and
+ * allocates nothing: subscribers live in a fixed array, each slot publishes itself with an atomic state
+ * and the readers count themselves in and out of a slot while they call it. Unsubscribe retires the slot
+ * and waits for the readers inside it to leave, so once it returns the callback is never called again.
+ */
+class FDS5WReportSubscribers
+{
+public:
+
+	typedef TFunction<void(const FDS5WRawReportView&)> FCallback;
+
+	FDS5WReportSubscribers();
+
+	/**
+	 * Register a subscriber, any thread.
+	 * @param Callback called on the reader threads, may be unset for a queue only subscriber
+	 * @param bQueue also copy every report into a queue drained with Dequeue
+	 * @return invalid if all DS5W_MAX_REPORT_SUBSCRIBERS slots are taken or there is nothing to deliver to
+	 */
+	FDS5WReportSubscription Subscribe(FCallback Callback, bool bQueue = false);
+
+	/**
+	 * Remove a subscriber and wait for callbacks in progress to return. Any thread but a reader thread, so
+	 * never from inside a callback. Resets Subscription.
+	 */
+	void Unsubscribe(FDS5WReportSubscription& Subscription);
+
+	/** Pop the oldest queued report. One consumer thread per subscription, which also unsubscribes it */
+	bool Dequeue(const FDS5WReportSubscription& Subscription, FDS5WRawReport& OutReport);
+
+	/** Reports dropped because the subscriber's queue was full */
+	uint64 GetNumDropped(const FDS5WReportSubscription& Subscription) const;
+
+	bool HasSubscribers() const { return NumSubscribers.load(std::memory_order_relaxed) > 0; }
+
+	/** Reader threads. Call every active subscriber with the report */
+	void Deliver(const FDS5WRawReportView& Report);
+
+private:
+
+	typedef TDS5WMpscQueue<FDS5WRawReport, DS5W_REPORT_SUBSCRIBER_QUEUE_SIZE> FQueue;
+
+	enum ESlotState : uint32
+	{
+		Slot_Free,
+
+		/** Taken by Subscribe, not filled in yet */
+		Slot_Claimed,
+
+		Slot_Active,
+
+		/** Being unsubscribed, readers stay out */
+		Slot_Retired,
+	};
+
+	struct alignas(PLATFORM_CACHE_LINE_SIZE) FSlot
+	{
+		std::atomic<uint32> State;
+
+		/** Readers inside Deliver for this slot */
+		std::atomic<uint32> NumInFlight;
+
+		std::atomic<uint64> NumDropped;
+
+		/** Bumped on unsubscribe, invalidates old handles */
+		uint32 Generation;
+
+		FCallback Callback;
+		TUniquePtr<FQueue> Queue;
+	};
+
+	/** Slot of a handle that is still subscribed, null otherwise */
+	FSlot* FindSlot(const FDS5WReportSubscription& Subscription) const;
+
+	FSlot Slots[DS5W_MAX_REPORT_SUBSCRIBERS];
+
+	/** Lets readers skip the slots while nobody subscribes */
+	std::atomic<int32> NumSubscribers;
+};
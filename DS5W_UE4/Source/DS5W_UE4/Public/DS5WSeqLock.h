@@ -0,0 +1,71 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "HAL/UnrealMemory.h"
+
+#include <atomic>
+#include <type_traits>
+
+/**
+ * Single writer sequence lock around a plain value.
+ * The sequence is odd while the writer copies a new value in, readers copy the value out and retry if
+ * the sequence was odd or changed meanwhile. The writer never waits, readers only wait for a copy in
+ * progress, so reads suit threads that must not block on a slower producer.
+ */
+template<typename T>
+class TDS5WSeqLock
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Values are copied as bytes");
+
+public:
+
+	TDS5WSeqLock()
+		: Sequence(0)
+	{
+		FMemory::Memzero(&Value, sizeof(T));
+	}
+
+	/** Writer thread only */
+	void Write(const T& InValue)
+	{
+		const uint32 Current = Sequence.load(std::memory_order_relaxed);
+		Sequence.store(Current + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		FMemory::Memcpy(&Value, &InValue, sizeof(T));
+
+		Sequence.store(Current + 2, std::memory_order_release);
+	}
+
+	/** @return false if the writer was copying at the same time, OutValue is undefined then */
+	bool TryRead(T& OutValue) const
+	{
+		const uint32 Before = Sequence.load(std::memory_order_acquire);
+		if (Before & 1)
+		{
+			return false;
+		}
+
+		FMemory::Memcpy(&OutValue, &Value, sizeof(T));
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return Sequence.load(std::memory_order_relaxed) == Before;
+	}
+
+	void Read(T& OutValue) const
+	{
+		while (!TryRead(OutValue))
+		{
+		}
+	}
+
+	/** Number of values written so far */
+	uint32 GetNumWrites() const { return Sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+
+	std::atomic<uint32> Sequence;
+	T Value;
+};
@@ -0,0 +1,54 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "HAL/PlatformMemory.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+#include "DS5WSharedStateLayout.h"
+
+struct FQuat;
+
+/** Section holding the bEnabled and Name entries */
+#define DS5W_SHARED_STATE_CONFIG_SECTION TEXT("/Script/DS5W_UE4.DS5WSharedState")
+
+/**
+ * Publishes the latest report and orientation of every controller into a named shared memory region,
+ * for overlays, telemetry and accessibility tools in other processes that can't open the device while
+ * the game holds it. Layout and protocol are in DS5WSharedStateLayout.h, readers outside the engine use
+ * the reader library in Extras/DS5WSharedStateReader.
+ *
+ * Every controller has its own slot behind a sequence lock written by its reader thread at report rate,
+ * so readers never block the writer and a reader that stops mid-read only costs itself a retry.
+ */
+class FDS5WSharedStateExport
+{
+public:
+
+	FDS5WSharedStateExport();
+	~FDS5WSharedStateExport();
+
+	/**
+	 * Create and map the region. A null Name reads bEnabled and Name from DS5W_SHARED_STATE_CONFIG_SECTION
+	 * of the input ini and does nothing unless enabled.
+	 * @return true if the region is mapped
+	 */
+	bool Open(const TCHAR* Name = nullptr);
+	void Close();
+
+	bool IsOpen() const { return Region != nullptr; }
+
+	/** Reader thread of ControllerId only */
+	void Publish(int32 ControllerId, const DS5W::DS5InputState& State, double CaptureTime, bool bBluetooth, const FQuat* Orientation);
+	void PublishDisconnect(int32 ControllerId);
+
+private:
+
+	FPlatformMemory::FSharedMemoryRegion* MappedRegion;
+	FDS5WSharedStateRegion* Region;
+
+	/** Only touched by the reader thread of each controller */
+	uint64 NumReports[DS5W_SHARED_STATE_MAX_CONTROLLERS];
+};
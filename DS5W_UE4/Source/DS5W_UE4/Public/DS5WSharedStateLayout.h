@@ -0,0 +1,128 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// Layout of the shared memory region the plugin publishes live controller state to (see
+// FDS5WSharedStateExport). Plain C++ without engine types, external readers include it as well.
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+/** Region name, "/" is prepended for shm_open on POSIX systems */
+#define DS5W_SHARED_STATE_NAME "DS5W_UE4_SharedState"
+
+#define DS5W_SHARED_STATE_MAGIC   0x57355344u
+#define DS5W_SHARED_STATE_VERSION 1
+
+#define DS5W_SHARED_STATE_MAX_CONTROLLERS 4
+
+#define DS5W_SHARED_STATE_FLAG_CONNECTED     0x01
+#define DS5W_SHARED_STATE_FLAG_BLUETOOTH     0x02
+#define DS5W_SHARED_STATE_FLAG_CHARGING      0x04
+#define DS5W_SHARED_STATE_FLAG_FULLY_CHARGED 0x08
+#define DS5W_SHARED_STATE_FLAG_HEADPHONES    0x10
+/** Orientation holds a fused value, it stays identity while nothing in the game consumes motion */
+#define DS5W_SHARED_STATE_FLAG_ORIENTATION   0x20
+
+/** Latest report of one controller. Fixed width fields only, so every compiler agrees on the layout */
+struct FDS5WSharedControllerState
+{
+	/** DS5W_SHARED_STATE_FLAG_* */
+	uint32_t Flags;
+
+	/** Device sensor timestamp, 1/3 microseconds */
+	uint32_t SensorTimestamp;
+
+	/** Reports of this controller published so far */
+	uint64_t NumReports;
+
+	/** Host time the report was captured at, seconds on the game's platform clock */
+	double CaptureTime;
+
+	/** Left x, left y, right x, right y as reported, -128..127 */
+	int8_t Sticks[4];
+
+	/** Left and right, 0..255 */
+	uint8_t Triggers[2];
+
+	uint8_t BatteryLevel;
+	uint8_t Pad0;
+
+	/** Raw button bytes, see DS5W_ISTATE_* in DualSenseWindows/DS5State.h */
+	uint8_t ButtonsAndDpad;
+	uint8_t ButtonsA;
+	uint8_t ButtonsB;
+	uint8_t Pad1;
+
+	/** Touch points: x, y, id and whether it is down */
+	uint16_t TouchX[2];
+	uint16_t TouchY[2];
+	uint8_t TouchId[2];
+	uint8_t TouchDown[2];
+
+	/** Calibrated gyro in deg/s and accelerometer in g */
+	float Gyro[3];
+	float Accel[3];
+
+	/** Fused orientation quaternion x, y, z, w advanced to this report */
+	float Orientation[4];
+};
+
+/** One controller behind a sequence lock: odd while the writer copies a new state in */
+struct alignas(64) FDS5WSharedControllerSlot
+{
+	std::atomic<uint32_t> Sequence;
+	uint32_t Pad;
+	FDS5WSharedControllerState State;
+};
+
+struct FDS5WSharedStateHeader
+{
+	/** DS5W_SHARED_STATE_MAGIC, stored last when the writer opens the region and cleared when it closes */
+	std::atomic<uint32_t> Magic;
+	uint32_t Version;
+
+	/** sizeof(FDS5WSharedStateRegion) and sizeof(FDS5WSharedControllerSlot) of the writer */
+	uint32_t RegionSize;
+	uint32_t SlotSize;
+
+	uint32_t NumControllers;
+	uint32_t WriterProcessId;
+};
+
+struct alignas(64) FDS5WSharedStateRegion
+{
+	FDS5WSharedStateHeader Header;
+	FDS5WSharedControllerSlot Controllers[DS5W_SHARED_STATE_MAX_CONTROLLERS];
+};
+
+// Always lock free, not just for some objects, or the sequence fails across processes (is_always_lock_free needs C++17)
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && sizeof(uint32_t) == sizeof(unsigned int), "The sequence must work across processes");
+
+/** Single writer per slot. Never waits */
+inline void DS5WWriteSharedControllerState(FDS5WSharedControllerSlot& Slot, const FDS5WSharedControllerState& State)
+{
+	const uint32_t Current = Slot.Sequence.load(std::memory_order_relaxed);
+	Slot.Sequence.store(Current + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	memcpy(&Slot.State, &State, sizeof(FDS5WSharedControllerState));
+
+	Slot.Sequence.store(Current + 2, std::memory_order_release);
+}
+
+/** Any number of readers. @return false if the writer was copying at the same time, OutState is undefined then */
+inline bool DS5WTryReadSharedControllerState(const FDS5WSharedControllerSlot& Slot, FDS5WSharedControllerState& OutState)
+{
+	const uint32_t Before = Slot.Sequence.load(std::memory_order_acquire);
+	if (Before & 1)
+	{
+		return false;
+	}
+
+	memcpy(&OutState, &Slot.State, sizeof(FDS5WSharedControllerState));
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return Slot.Sequence.load(std::memory_order_relaxed) == Before;
+}
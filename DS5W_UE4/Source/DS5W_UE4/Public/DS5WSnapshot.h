@@ -0,0 +1,63 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+class FArchive;
+
+/** Bits per quantised IMU axis, gyro covers +-2000 deg/s and the accelerometer +-4 g */
+#define DS5W_SNAPSHOT_GYRO_BITS  14
+#define DS5W_SNAPSHOT_ACCEL_BITS 12
+
+/**
+ * Compact controller state for replication and replays.
+ *
+ * Sticks and triggers keep their 8 bit resolution, all buttons share one 19 bit field, the calibrated IMU
+ * is quantised to DS5W_SNAPSHOT_*_BITS per axis and touch points to 11 bit positions. Serialized against
+ * a baseline only the field groups that changed are written and IMU axes go out as small deltas, so a
+ * frame where only sensor noise changed costs about 8 bytes instead of the ~80 bytes of DS5InputState.
+ */
+struct FDS5WSnapshot
+{
+	struct FTouchPoint
+	{
+		bool bDown;
+		uint8 Id;
+		uint16 X;
+		uint16 Y;
+	};
+
+	int8 LeftStick[2];
+	int8 RightStick[2];
+	uint8 Triggers[2];
+
+	/** buttonsAndDpad | (buttonsA << 8) | (buttonsB << 16) */
+	uint32 Buttons;
+
+	/** Quantised calibrated IMU */
+	int16 Gyro[3];
+	int16 Accel[3];
+
+	FTouchPoint Touch[2];
+
+	uint32 SensorTimestamp;
+
+	/** Quantise a decoded report */
+	void FromInputState(const DS5W::DS5InputState& State);
+
+	/** Expand into a report. Raw IMU fields are derived from the calibrated values with the nominal scale */
+	void ToInputState(DS5W::DS5InputState& OutState) const;
+
+	/** Calibrated gyro in deg/s, without expanding the whole report */
+	void GetGyro(float* OutGyro) const;
+
+	/**
+	 * Write or read the snapshot. With a baseline (which the reading side must have as well) unchanged
+	 * field groups are dropped and the timestamp is sent as a delta.
+	 * @return false if the archive errored or the data doesn't fit the baseline
+	 */
+	bool NetSerialize(FArchive& Ar, const FDS5WSnapshot* Baseline = nullptr);
+};
@@ -0,0 +1,107 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+#include <atomic>
+
+class FOutputDevice;
+
+/**
+ * Histogram buckets: values below 2 << SUB_BUCKET_BITS get a bucket each, every power of two above is
+ * split into 1 << SUB_BUCKET_BITS buckets (~12% wide), up to 2^MAX_EXPONENT (~34 s in nanoseconds).
+ */
+#define DS5W_HISTOGRAM_SUB_BUCKET_BITS 3
+#define DS5W_HISTOGRAM_MAX_EXPONENT    35
+#define DS5W_HISTOGRAM_BUCKETS         ((2 << DS5W_HISTOGRAM_SUB_BUCKET_BITS) + ((DS5W_HISTOGRAM_MAX_EXPONENT - DS5W_HISTOGRAM_SUB_BUCKET_BITS) << DS5W_HISTOGRAM_SUB_BUCKET_BITS))
+
+/**
+ * Log bucketed histogram of durations in nanoseconds (HDR style: constant relative precision over the
+ * whole range, fixed size, recording is a bucket index and a few relaxed atomics).
+ * Each histogram has one writing thread, reading and resetting from another thread is fine, a reset
+ * racing a record may just keep or lose that one value.
+ */
+class FDS5WHistogram
+{
+public:
+
+	FDS5WHistogram();
+
+	void Record(uint64 Nanoseconds);
+	void RecordCycles(uint64 Cycles);
+
+	void Reset();
+
+	uint64 GetCount() const { return Count.load(std::memory_order_relaxed); }
+	uint64 GetMin() const { return GetCount() ? Min.load(std::memory_order_relaxed) : 0; }
+	uint64 GetMax() const { return Max.load(std::memory_order_relaxed); }
+	double GetMean() const;
+
+	/** Upper bound of the bucket holding the given fraction of the values, 0.99 for the 99th percentile */
+	uint64 GetPercentile(double Fraction) const;
+
+	/** One line: count, mean, min, p50, p90, p99, p99.9 and max in microseconds */
+	void Dump(FOutputDevice& Ar, const TCHAR* Name) const;
+
+	static int32 GetBucket(uint64 Value);
+	static uint64 GetBucketUpperBound(int32 Bucket);
+
+private:
+
+	std::atomic<uint32> Buckets[DS5W_HISTOGRAM_BUCKETS];
+	std::atomic<uint64> Count;
+	std::atomic<uint64> Sum;
+	std::atomic<uint64> Min;
+	std::atomic<uint64> Max;
+};
+
+/**
+ * Always-on instrumentation of one controller's input path.
+ * The reader thread records reading, decoding and output writes, the game thread fusion, dispatch and
+ * output posting. Counters have one writer each as well.
+ */
+struct FDS5WControllerStats
+{
+	/** Reader thread: waiting for a report, decoding it, writing the output report */
+	FDS5WHistogram ReadWait;
+	FDS5WHistogram Parse;
+	FDS5WHistogram OutputWrite;
+
+	/** Game thread: motion fusion and sending the controller's events */
+	FDS5WHistogram Fusion;
+	FDS5WHistogram Dispatch;
+
+	/**
+	 * Game thread: age of the input the game sees each frame, from the report's capture (device time
+	 * mapped to host time) to its consumption. Kept per connection type, a controller may switch.
+	 */
+	FDS5WHistogram InputAgeUsb;
+	FDS5WHistogram InputAgeBluetooth;
+
+	/** Reader thread. Backlog reports were queued behind another one and decoded in a batch with it */
+	std::atomic<uint64> NumReports;
+	std::atomic<uint64> NumBacklogReports;
+	std::atomic<uint64> NumDroppedReports;
+	std::atomic<uint64> NumOutputsSent;
+
+	/** Game thread: output states handed to the reader, and frames whose output didn't change */
+	std::atomic<uint64> NumOutputsPosted;
+	std::atomic<uint64> NumOutputsSkipped;
+
+	FDS5WControllerStats();
+
+	void Reset();
+
+	/** Counters, rates over Seconds and one line per histogram */
+	void Dump(FOutputDevice& Ar, int32 ControllerId, double Seconds) const;
+
+	FDS5WHistogram& GetInputAge(bool bBluetooth) { return bBluetooth ? InputAgeBluetooth : InputAgeUsb; }
+	const FDS5WHistogram& GetInputAge(bool bBluetooth) const { return bBluetooth ? InputAgeBluetooth : InputAgeUsb; }
+
+	/** Counters have a single writer, a relaxed load and store is enough */
+	static void Increment(std::atomic<uint64>& Counter)
+	{
+		Counter.store(Counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+};
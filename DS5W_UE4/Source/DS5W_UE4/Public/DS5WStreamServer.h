@@ -0,0 +1,226 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Containers/Array.h"
+#include "HAL/Runnable.h"
+#include "Serialization/BitWriter.h"
+#include "Templates/SharedPointer.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+#include "DS5WEventQueue.h"
+#include "DS5WSnapshot.h"
+
+#include <atomic>
+
+class FDS5WInputHistory;
+struct FDS5WInputHistoryEntry;
+class FInternetAddr;
+class FRunnableThread;
+class FSocket;
+
+/** Section holding bEnabled, Port, MaxBatchDelay and CommandTimeout */
+#define DS5W_STREAM_CONFIG_SECTION TEXT("/Script/DS5W_UE4.DS5WStream")
+
+/** Loopback UDP port the server listens on unless configured otherwise */
+#define DS5W_STREAM_DEFAULT_PORT 7575
+
+/** First bytes of every datagram, both directions */
+#define DS5W_STREAM_MAGIC   0x53355344u
+#define DS5W_STREAM_VERSION 1
+
+/** Header: magic, version, type, number of records, datagram sequence */
+#define DS5W_STREAM_HEADER_BYTES 12
+
+/** Sample datagrams stay below the usual MTU, so loopback and LAN never fragment them */
+#define DS5W_STREAM_MAX_DATAGRAM_BYTES 1200
+
+/** Output commands waiting for the game thread */
+#define DS5W_STREAM_COMMAND_QUEUE_SIZE 64
+
+/** Bytes of one command record: controller, type, data */
+#define DS5W_STREAM_COMMAND_BYTES 10
+
+/** Longest the server thread sleeps between looking for new reports */
+#define DS5W_STREAM_POLL_INTERVAL 0.0005
+
+enum class EDS5WStreamDatagramType : uint8
+{
+	/** Server to client: batched reports */
+	Samples,
+
+	/** Client to server: start or keep streaming to the sending address, no records */
+	Subscribe,
+
+	/** Client to server: output commands, also subscribe */
+	Commands,
+};
+
+enum class EDS5WStreamCommandType : uint8
+{
+	/** Left and right motor, 0..255 */
+	Rumble,
+
+	/** Red, green, blue */
+	Lightbar,
+
+	/** Side (0 left, 1 right), then the 7 bytes of a DS5W::TriggerEffect */
+	TriggerEffect,
+
+	/** DS5W_OSTATE_PLAYER_LED_* bitmask, DS5W::LedBrightness, fade */
+	PlayerLeds,
+
+	/** Hand the outputs back to the game */
+	Release,
+};
+
+/** One output command from a client, decoded */
+struct FDS5WStreamCommand
+{
+	int32 ControllerId;
+	EDS5WStreamCommandType Type;
+	uint8 Data[8];
+};
+
+/** One report of a sample datagram, decoded */
+struct FDS5WStreamSample
+{
+	int32 ControllerId;
+
+	/** False for the record marking a disconnect, its snapshot is neutral */
+	bool bConnected;
+
+	/** Host time the report was captured at, the game's platform clock */
+	double CaptureTime;
+
+	FDS5WSnapshot Snapshot;
+};
+
+/**
+ * Outputs a remote client overrides on one controller. Game thread only.
+ * Overrides lapse after the configured command timeout without commands, so a client that went away
+ * doesn't leave the motors running.
+ */
+struct FDS5WRemoteOutput
+{
+	bool bRumble;
+	bool bLightbar;
+	bool bTriggerEffects[2];
+	bool bPlayerLeds;
+
+	uint8 Rumble[2];
+	DS5W::Color Lightbar;
+	DS5W::TriggerEffect TriggerEffects[2];
+	DS5W::PlayerLeds PlayerLeds;
+
+	double ExpireTime;
+
+	FDS5WRemoteOutput();
+
+	void Reset();
+
+	/** Take over what the command sets. @return false if it is malformed */
+	bool AddCommand(const FDS5WStreamCommand& Command, double Time, double Timeout);
+
+	/** Overwrite the outputs being overridden, if the overrides haven't lapsed */
+	void Apply(DS5W::DS5OutputState& OutputState, double Time);
+};
+
+/**
+ * Streams every decoded report of every controller to a client on the local machine, for remote test rigs
+ * and replay tooling, and takes output commands back.
+ *
+ * A client subscribes by sending any datagram to the server's loopback UDP port and keeps the
+ * subscription by sending at least one per command timeout. The server thread follows the input
+ * histories, so it sees every report rather than what the game frames saw, and batches them into
+ * datagrams of several records: controller, capture time and the report as an FDS5WSnapshot, delta coded
+ * against the previous record of the same controller within the datagram. A batch goes out when the next
+ * record wouldn't fit or its oldest record waited MaxBatchDelay. Every datagram decodes on its own.
+ *
+ * The socket is non-blocking. Datagrams the socket doesn't take and reports the server fell too far behind
+ * on are dropped and counted, neither the readers nor the game thread ever wait for a client.
+ */
+class FDS5WStreamServer : public FRunnable
+{
+public:
+
+	/** Histories of MAX_NUM_DS5W_CONTROLLERS controllers, they must outlive the server */
+	FDS5WStreamServer(const FDS5WInputHistory* InHistories, int32 InNumControllers);
+	virtual ~FDS5WStreamServer();
+
+	/**
+	 * Bind the socket and start the server thread. A Port of 0 reads bEnabled and the settings from
+	 * DS5W_STREAM_CONFIG_SECTION of the input ini and does nothing unless enabled.
+	 */
+	bool Start(int32 Port = 0);
+	void Shutdown();
+
+	/** Game thread, pop the next output command a client sent */
+	bool DequeueCommand(FDS5WStreamCommand& OutCommand) { return Commands.Dequeue(OutCommand); }
+
+	/** Seconds an override holds without new commands */
+	double GetCommandTimeout() const { return CommandTimeout; }
+
+	uint64 GetNumDatagramsSent() const { return NumDatagramsSent.load(std::memory_order_relaxed); }
+	uint64 GetNumDatagramsDropped() const { return NumDatagramsDropped.load(std::memory_order_relaxed); }
+	uint64 GetNumReportsDropped() const { return NumReportsDropped.load(std::memory_order_relaxed); }
+
+	/** Decode a sample datagram. @return false if it isn't one or is malformed */
+	static bool DecodeSamples(const uint8* Data, int32 NumBytes, TArray<FDS5WStreamSample>& OutSamples);
+
+	/** Decode a client datagram. @return false if it isn't one or is malformed */
+	static bool DecodeCommands(const uint8* Data, int32 NumBytes, EDS5WStreamDatagramType& OutType, TArray<FDS5WStreamCommand>& OutCommands);
+
+	/** Encode a client datagram, a Subscribe without commands */
+	static void EncodeCommands(const FDS5WStreamCommand* InCommands, int32 NumCommands, TArray<uint8>& OutData);
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+
+	/** Take what clients sent */
+	void ReceiveDatagrams();
+
+	/** Append the reports written since the last call, send batches that are full or waited long enough */
+	void StreamReports(double Now);
+
+	void BeginBatch();
+	void SendBatch();
+
+	/** Encode one report into RecordWriter, against the controller's baseline if the batch has one */
+	void EncodeRecord(int32 ControllerId, const FDS5WInputHistoryEntry& Entry);
+
+	const FDS5WInputHistory* Histories;
+	int32 NumControllers;
+
+	double MaxBatchDelay;
+	double CommandTimeout;
+
+	FSocket* Socket;
+	FRunnableThread* Thread;
+	std::atomic<bool> bStopRequested;
+
+	/** Only touched by the server thread */
+	TSharedPtr<FInternetAddr> ClientAddr;
+	double ClientExpireTime;
+	TArray<uint64> Cursors;
+	FBitWriter Writer;
+	FBitWriter RecordWriter;
+	int32 NumBatchRecords;
+	double BatchStartTime;
+	uint32 DatagramSequence;
+
+	/** Previous snapshot of each controller within the batch, the delta baseline */
+	TArray<FDS5WSnapshot> Baselines;
+	TArray<bool> bHasBaseline;
+
+	TDS5WMpscQueue<FDS5WStreamCommand, DS5W_STREAM_COMMAND_QUEUE_SIZE> Commands;
+
+	std::atomic<uint64> NumDatagramsSent;
+	std::atomic<uint64> NumDatagramsDropped;
+	std::atomic<uint64> NumReportsDropped;
+};
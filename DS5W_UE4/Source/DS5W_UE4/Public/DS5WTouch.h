@@ -0,0 +1,109 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Math/Vector2D.h"
+#include "Containers/CircularQueue.h"
+
+#include "DualSenseWindows/DS5State.h"
+
+#include <atomic>
+
+/** Number of touch samples kept per controller (~1 s at the 250 Hz report rate) */
+#define DS5W_TOUCH_HISTORY 256
+
+/** Number of recognised gestures that can wait for the game thread */
+#define DS5W_TOUCH_GESTURE_QUEUE 64
+
+/** One touchpad report. Positions are normalised to 0-1 */
+struct FDS5WTouchSample
+{
+	/** Host time the report was captured at */
+	double Time;
+
+	FVector2D Position[2];
+	uint8 FingerId[2];
+	bool bDown[2];
+};
+
+enum class EDS5WTouchGesture : uint8
+{
+	Tap,
+	SwipeLeft,
+	SwipeRight,
+	SwipeUp,
+	SwipeDown,
+	Pinch,
+	Scroll,
+};
+
+struct FDS5WTouchGestureEvent
+{
+	EDS5WTouchGesture Type;
+
+	/** Swipe: total travel, Pinch: change of the finger distance in X, Scroll: movement of the finger centroid */
+	FVector2D Value;
+
+	/** Host time of the report that completed the gesture */
+	double Time;
+};
+
+/**
+ * Keeps the touch trajectory of one controller and recognises gestures incrementally.
+ * AddSample is called for every report by the reader thread, the trajectory can be read from any thread
+ * and recognised gestures are queued for the game thread. Nothing allocates after construction.
+ */
+class FDS5WTouchTracker
+{
+public:
+
+	FDS5WTouchTracker();
+
+	/** Forget the trajectory and any gesture in progress (reader thread) */
+	void Reset();
+
+	/** Record a report and advance the recogniser (reader thread) */
+	void AddSample(const DS5W::DS5InputState& State, double CaptureTime);
+
+	/**
+	 * Copy the newest samples, oldest first. Safe to call from any thread.
+	 * @return Number of samples written to OutSamples
+	 */
+	int32 GetTrajectory(FDS5WTouchSample* OutSamples, int32 MaxSamples) const;
+
+	/** Pop the next recognised gesture (game thread) */
+	bool DequeueGesture(FDS5WTouchGestureEvent& OutGesture) { return Gestures.Dequeue(OutGesture); }
+
+private:
+
+	enum class EMode : uint8
+	{
+		Idle,
+		OneFinger,
+		TwoFingers,
+		Pinch,
+		Scroll,
+		/** A multi finger gesture ended while a finger is still down */
+		Finished,
+	};
+
+	void Recognise(const FDS5WTouchSample& Sample);
+	void Emit(EDS5WTouchGesture Type, const FVector2D& Value, double Time);
+
+	/** Trajectory ring, NumWritten counts every sample ever written */
+	FDS5WTouchSample Samples[DS5W_TOUCH_HISTORY];
+	std::atomic<uint64> NumWritten;
+	bool bWasTouching;
+
+	TCircularQueue<FDS5WTouchGestureEvent> Gestures;
+
+	/** Recogniser state */
+	EMode Mode;
+	bool bMoved;
+	double StartTime;
+	FVector2D StartCentroid;
+	FVector2D LastCentroid;
+	float StartDistance;
+	float LastDistance;
+};
@@ -0,0 +1,103 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Templates/UniquePtr.h"
+
+#include <atomic>
+
+/** Events kept unless configured otherwise, ~4 s of one controller at the USB report rate */
+#define DS5W_TRACE_CAPACITY 32768
+
+/** Capacity is clamped to this range and rounded up to a power of two, 0 turns tracing off for good */
+#define DS5W_TRACE_MIN_CAPACITY 1024
+#define DS5W_TRACE_MAX_CAPACITY 1048576
+
+/** Section holding the Capacity and bStartEnabled entries */
+#define DS5W_TRACE_CONFIG_SECTION TEXT("/Script/DS5W_UE4.DS5WTrace")
+
+/** Pipeline stages a report goes through, in order */
+enum class EDS5WTraceStage : uint8
+{
+	/** Reader thread: waiting for the HID read to complete */
+	Read,
+	/** Reader thread: decoding the report */
+	Parse,
+	/** Reader thread: button edges, touch, history, motion latch and queueing for the game thread */
+	Queue,
+	/** From the report's arrival until the game thread dequeued it */
+	Consume,
+	/** Game thread: motion fusion */
+	Fusion,
+	/** Game thread: sending the controller's events */
+	Dispatch,
+	/** Reader thread: writing the output report */
+	OutputWrite,
+
+	Num
+};
+
+/**
+ * Opt-in timeline of the input pipeline, written as Chrome trace-event JSON (chrome://tracing, Perfetto)
+ * to find out why one particular frame hitched.
+ *
+ * Every stage is one complete event with begin and end in cycles (FPlatformTime::Cycles64) on the thread
+ * that ran it. Events go to a ring that is allocated up front, the oldest are overwritten. The reader
+ * threads and the game thread all write to it, each event claims its slot with one atomic increment and
+ * publishes it with a sequence number, so a flush while recording skips torn slots rather than block.
+ *
+ * While stopped, recording sites cost a single branch on IsEnabled.
+ */
+class FDS5WTrace
+{
+public:
+
+	FDS5WTrace();
+
+	/** Allocate the ring. A Capacity of 0 or less reads it from DS5W_TRACE_CONFIG_SECTION of the input ini */
+	void Init(int32 InCapacity = 0);
+
+	/** Starting drops the events of earlier runs. @return false if tracing is off in the config */
+	bool Start();
+	void Stop();
+
+	bool IsEnabled() const { return bEnabled.load(std::memory_order_relaxed); }
+
+	/** Record a stage that ran from StartCycles to EndCycles. Only call while IsEnabled */
+	void Record(EDS5WTraceStage Stage, int32 ControllerId, uint64 StartCycles, uint64 EndCycles);
+
+	/**
+	 * Write the events held to a trace-event JSON file, oldest first. Any thread, recording may go on.
+	 * @return false if the file couldn't be written
+	 */
+	bool Flush(const TCHAR* Filename) const;
+
+	uint64 GetNumRecorded() const { return NumWritten.load(std::memory_order_relaxed); }
+	int32 GetCapacity() const { return Slots ? (int32)(Mask + 1) : 0; }
+
+	static const TCHAR* GetStageName(EDS5WTraceStage Stage);
+
+private:
+
+	struct FSlot
+	{
+		/** 2 * Index + 1 while event Index is being written, 2 * Index + 2 once done */
+		std::atomic<uint32> Sequence;
+
+		uint8 Stage;
+		int8 ControllerId;
+		uint32 ThreadId;
+		uint64 StartCycles;
+		uint64 EndCycles;
+	};
+
+	TUniquePtr<FSlot[]> Slots;
+	uint64 Mask;
+
+	std::atomic<uint64> NumWritten;
+	std::atomic<bool> bEnabled;
+
+	/** Events before this one belong to an earlier run */
+	std::atomic<uint64> FirstIndex;
+};
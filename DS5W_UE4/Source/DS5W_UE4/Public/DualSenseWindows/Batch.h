@@ -0,0 +1,78 @@
+/*
+	Batch.h is part of DualSenseWindows
+	https://github.com/Ohjurot/DualSense-Windows
+
+	Licensed under the MIT License (To be found in repository root directory)
+*/
+#pragma once
+
+#include <DualSenseWindows/DSW_Api.h>
+#include <DualSenseWindows/Device.h>
+#include <DualSenseWindows/DS5State.h>
+
+namespace DS5W {
+	/// <summary>
+	/// Structure of arrays receiving a batch of decoded input reports. All arrays are owned by the caller and must hold at least capacity elements
+	/// </summary>
+	typedef struct _InputBatch {
+		/// <summary>
+		/// Number of elements every array can hold
+		/// </summary>
+		unsigned int capacity;
+
+		/// <summary>
+		/// Number of reports decoded into the arrays (set by decodeInputReports)
+		/// </summary>
+		unsigned int count;
+
+		/// <summary>
+		/// Stick positions (0 = Center), same convention as DS5W::AnalogStick
+		/// </summary>
+		signed char* leftStickX;
+		signed char* leftStickY;
+		signed char* rightStickX;
+		signed char* rightStickY;
+
+		/// <summary>
+		/// Trigger positions
+		/// </summary>
+		unsigned char* leftTrigger;
+		unsigned char* rightTrigger;
+
+		/// <summary>
+		/// Packed buttons: buttonsAndDpad | (buttonsA << 8) | (buttonsB << 16)
+		/// </summary>
+		unsigned int* buttons;
+
+		/// <summary>
+		/// Gyroscope in degrees per second
+		/// </summary>
+		float* gyroX;
+		float* gyroY;
+		float* gyroZ;
+
+		/// <summary>
+		/// Accelerometer in g
+		/// </summary>
+		float* accelX;
+		float* accelY;
+		float* accelZ;
+
+		/// <summary>
+		/// Raw sensor timestamp of the report
+		/// </summary>
+		unsigned int* sensorTimestamp;
+	} InputBatch;
+
+	/// <summary>
+	/// Decode multiple raw input reports into a structure of arrays in one pass
+	/// </summary>
+	/// <param name="ptrReports">Pointer to the first report (including the report id)</param>
+	/// <param name="reportStride">Distance in bytes between two consecutive reports</param>
+	/// <param name="reportCount">Number of reports to decode</param>
+	/// <param name="connection">Connection the reports were read from</param>
+	/// <param name="ptrBatch">Batch to decode into</param>
+	/// <param name="ptrCalibration">(Optional) IMU conversion of the device the reports came from (DeviceContext::_internal.imuCalibration)</param>
+	/// <returns>Result of call</returns>
+	DS5W_API DS5W_ReturnValue decodeInputReports(const unsigned char* ptrReports, unsigned int reportStride, unsigned int reportCount, DS5W::DeviceConnection connection, DS5W::InputBatch* ptrBatch, const DS5W::IMUCalibration* ptrCalibration = nullptr);
+}
@@ -37,6 +37,12 @@
 #define DS5W_OSTATE_PLAYER_LED_MIDDLE_RIGHT 0x08
 #define DS5W_OSTATE_PLAYER_LED_RIGHT 0x10
 
+#define DS5W_DECODE_MOTION 0x01
+#define DS5W_DECODE_TOUCH 0x02
+#define DS5W_DECODE_TRIGGER_FEEDBACK 0x04
+#define DS5W_DECODE_STATUS 0x08
+#define DS5W_DECODE_ALL 0x0F
+
 namespace DS5W {
 
 	/// <summary>
@@ -85,6 +91,16 @@ namespace DS5W {
 		/// Y position of finger (~ 0 - 2048)
 		/// </summary>
 		unsigned int y;
+
+		/// <summary>
+		/// Indicates that a finger is currently touching at this point
+		/// </summary>
+		bool down;
+
+		/// <summary>
+		/// Id of the finger (incremented by the controller for every new contact)
+		/// </summary>
+		unsigned char id;
 	} Touch;
 
 	typedef struct _Battery {
@@ -349,6 +365,11 @@ namespace DS5W {
 
 		IMUState imuState;
 
+		/// <summary>
+		/// Sensor timestamp of the report (device clock in 1/3 microsecond ticks, wraps around every ~23 minutes)
+		/// </summary>
+		unsigned int sensorTimestamp;
+
 		/// <summary>
 		/// First touch point
 		/// </summary>
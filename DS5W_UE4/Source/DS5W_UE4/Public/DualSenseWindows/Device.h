@@ -45,6 +45,26 @@ namespace DS5W {
 		} _internal;
 	} DeviceEnumInfo;
 
+	/// <summary>
+	/// Conversion from raw IMU values to real units (value = raw * scale + offset)
+	/// </summary>
+	typedef struct _IMUCalibration {
+		/// <summary>
+		/// Scale per axis (gyro x, y, z in degrees per second and accelerometer x, y, z in g)
+		/// </summary>
+		float scale[6];
+
+		/// <summary>
+		/// Offset per axis added after scaling (negative bias times scale)
+		/// </summary>
+		float offset[6];
+
+		/// <summary>
+		/// Indicates that the values where read from the factory calibration report
+		/// </summary>
+		bool factoryCalibrated;
+	} IMUCalibration;
+
 	/// <summary>
 	/// Device context
 	/// </summary>
@@ -73,6 +93,26 @@ namespace DS5W {
 			/// </summary>
 			bool connected;
 
+			/// <summary>
+			/// IMU conversion of this device (will be filled by the context init function)
+			/// </summary>
+			IMUCalibration imuCalibration;
+
+			/// <summary>
+			/// Input fields decoded on every report (DS5W_DECODE_*, see DS5W::setDeviceInputDecodeFlags)
+			/// </summary>
+			unsigned int decodeFlags;
+
+			/// <summary>
+			/// Number of input reports read since the context was initialized
+			/// </summary>
+			unsigned int reportCounter;
+
+			/// <summary>
+			/// Performance counter value at which the last input report arrived, before it was decoded
+			/// </summary>
+			long long readCompletionTicks;
+
 			/// <summary>
 			/// HID Input buffer (will be allocated by the context init function)
 			/// </summary>
@@ -28,6 +28,7 @@
 #pragma once
 
 #include <DualSenseWindows/DSW_Api.h>
+#include <DualSenseWindows/Batch.h>
 #include <DualSenseWindows/Device.h>
 #include <DualSenseWindows/DS5State.h>
 
@@ -71,6 +72,35 @@ namespace DS5W {
 	/// <returns>Result of call</returns>
 	DS5W_API DS5W_ReturnValue getDeviceInputState(DS5W::DeviceContext* ptrContext, DS5W::DS5InputState* ptrInputState);
 
+	/// <summary>
+	/// Wait for the next device input report without dropping queued reports (for reading every report on a dedicated thread)
+	/// </summary>
+	/// <param name="ptrContext">Pointer to context</param>
+	/// <param name="ptrInputState">Pointer to input state</param>
+	/// <returns>Result of call</returns>
+	DS5W_API DS5W_ReturnValue readDeviceInputState(DS5W::DeviceContext* ptrContext, DS5W::DS5InputState* ptrInputState);
+
+	/// <summary>
+	/// Wait for the next device input report and take the reports queued behind it in the same read (for catching up after the reading thread stalled).
+	/// The reports before the newest one are decoded into a batch, the newest one into the input state like readDeviceInputState does
+	/// </summary>
+	/// <param name="ptrContext">Pointer to context</param>
+	/// <param name="ptrReports">Buffer receiving the raw reports, reportCapacity times the input report length of the connection</param>
+	/// <param name="reportCapacity">Number of reports the buffer can hold (the batch must hold one less)</param>
+	/// <param name="ptrBatch">Batch receiving the reports before the newest one (count is 0 if nothing was queued)</param>
+	/// <param name="ptrInputState">Pointer to input state receiving the newest report</param>
+	/// <returns>Result of call</returns>
+	DS5W_API DS5W_ReturnValue readDeviceInputReports(DS5W::DeviceContext* ptrContext, unsigned char* ptrReports, unsigned int reportCapacity, DS5W::InputBatch* ptrBatch, DS5W::DS5InputState* ptrInputState);
+
+	/// <summary>
+	/// Select the input fields decoded on every report. Sticks, buttons, triggers and the sensor timestamp are always decoded,
+	/// fields that are not selected keep their previous value (status is still refreshed at a low rate)
+	/// </summary>
+	/// <param name="ptrContext">Pointer to context</param>
+	/// <param name="decodeFlags">Combination of DS5W_DECODE_* flags</param>
+	/// <returns>Result of call</returns>
+	DS5W_API DS5W_ReturnValue setDeviceInputDecodeFlags(DS5W::DeviceContext* ptrContext, unsigned int decodeFlags);
+
 	/// <summary>
 	/// Set the device output state
 	/// </summary>
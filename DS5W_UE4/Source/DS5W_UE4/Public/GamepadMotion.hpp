@@ -102,6 +102,34 @@ namespace GamepadMotionHelpers
 		Vec GetMidGyro();
 	};
 
+	// One sensor report for GamepadMotion::ProcessMotionBatch. Timestamp is in seconds on any clock that
+	// increases, only the gaps between consecutive samples are used.
+	struct MotionSample
+	{
+		float GyroX;
+		float GyroY;
+		float GyroZ;
+		float AccelX;
+		float AccelY;
+		float AccelZ;
+		double Timestamp;
+	};
+
+	// The gravity correction settings Motion::Update reads, looked up once per batch instead of per sample
+	struct GravityCorrectionSettings
+	{
+		float ShakinessMinThreshold;
+		float ShakinessMaxThreshold;
+		float StillSpeed;
+		float ShakySpeed;
+		float GyroFactor;
+		float GyroMinThreshold;
+		float GyroMaxThreshold;
+		float MinimumSpeed;
+
+		void Load(const GamepadMotionSettings& settings);
+	};
+
 	struct AutoCalibration
 	{
 		SensorMinMaxWindow MinMaxWindow;
@@ -144,6 +172,8 @@ namespace GamepadMotionHelpers
 		Motion();
 		void Reset();
 		void Update(float inGyroX, float inGyroY, float inGyroZ, float inAccelX, float inAccelY, float inAccelZ, float gravityLength, float deltaTime);
+		void Update(const GravityCorrectionSettings& correction, float inGyroX, float inGyroY, float inGyroZ, float inAccelX, float inAccelY, float inAccelZ, float gravityLength, float deltaTime, float smoothFactor);
+		float GetSmoothFactor(float deltaTime) const;
 		void SetSettings(GamepadMotionSettings* settings);
 
 	private:
@@ -236,6 +266,12 @@ public:
 	void ProcessMotion(float gyroX, float gyroY, float gyroZ,
 		float accelX, float accelY, float accelZ, float deltaTime);
 
+	// Same as calling ProcessMotion for every sample in order, with each sample's delta time taken from the
+	// timestamps. previousTimestamp is the timestamp of the sample processed before the batch; pass a
+	// negative value to give the first sample no delta time. Settings, calibration mode and manual calibration
+	// state are looked up once for the whole batch, so don't change them from another thread meanwhile.
+	void ProcessMotionBatch(const GamepadMotionHelpers::MotionSample* samples, int numSamples, double previousTimestamp);
+
 	// reading the current state
 	void GetCalibratedGyro(float& x, float& y, float& z);
 	void GetGravity(float& x, float& y, float& z);
@@ -559,14 +595,30 @@ namespace GamepadMotionHelpers
 		}
 
 		// get settings
-		const float gravityCorrectionShakinessMinThreshold = Settings->GravityCorrectionShakinessMinThreshold;
-		const float gravityCorrectionShakinessMaxThreshold = Settings->GravityCorrectionShakinessMaxThreshold;
-		const float gravityCorrectionStillSpeed = Settings->GravityCorrectionStillSpeed;
-		const float gravityCorrectionShakySpeed = Settings->GravityCorrectionShakySpeed;
-		const float gravityCorrectionGyroFactor = Settings->GravityCorrectionGyroFactor;
-		const float gravityCorrectionGyroMinThreshold = Settings->GravityCorrectionGyroMinThreshold;
-		const float gravityCorrectionGyroMaxThreshold = Settings->GravityCorrectionGyroMaxThreshold;
-		const float gravityCorrectionMinimumSpeed = Settings->GravityCorrectionMinimumSpeed;
+		GravityCorrectionSettings correction;
+		correction.Load(*Settings);
+
+		Update(correction, inGyroX, inGyroY, inGyroZ, inAccelX, inAccelY, inAccelZ, gravityLength, deltaTime, GetSmoothFactor(deltaTime));
+	}
+
+	float Motion::GetSmoothFactor(float deltaTime) const
+	{
+		return ShortSteadinessHalfTime <= 0.f ? 0.f : exp2f(-deltaTime / ShortSteadinessHalfTime);
+	}
+
+	/// <summary>
+	/// Update with the settings already looked up and the smoothing factor for deltaTime already computed
+	/// </summary>
+	void Motion::Update(const GravityCorrectionSettings& correction, float inGyroX, float inGyroY, float inGyroZ, float inAccelX, float inAccelY, float inAccelZ, float gravityLength, float deltaTime, float smoothFactor)
+	{
+		const float gravityCorrectionShakinessMinThreshold = correction.ShakinessMinThreshold;
+		const float gravityCorrectionShakinessMaxThreshold = correction.ShakinessMaxThreshold;
+		const float gravityCorrectionStillSpeed = correction.StillSpeed;
+		const float gravityCorrectionShakySpeed = correction.ShakySpeed;
+		const float gravityCorrectionGyroFactor = correction.GyroFactor;
+		const float gravityCorrectionGyroMinThreshold = correction.GyroMinThreshold;
+		const float gravityCorrectionGyroMaxThreshold = correction.GyroMaxThreshold;
+		const float gravityCorrectionMinimumSpeed = correction.MinimumSpeed;
 
 		const Vec axis = Vec(inGyroX, inGyroY, inGyroZ);
 		const Vec accel = Vec(inAccelX, inAccelY, inAccelZ);
@@ -587,7 +639,6 @@ namespace GamepadMotionHelpers
 			SmoothAccel *= rotation.Inverse();
 			//printf("Absolute Accel: %.4f %.4f %.4f\n",
 			//	absoluteAccel.x, absoluteAccel.y, absoluteAccel.z);
-			const float smoothFactor = ShortSteadinessHalfTime <= 0.f ? 0.f : exp2f(-deltaTime / ShortSteadinessHalfTime);
 			Shakiness *= smoothFactor;
 			Shakiness = std::max(Shakiness, (accel - SmoothAccel).Length());
 			SmoothAccel = accel.Lerp(SmoothAccel, smoothFactor);
@@ -650,6 +701,18 @@ namespace GamepadMotionHelpers
 		Quaternion.Normalize();
 	}
 
+	void GravityCorrectionSettings::Load(const GamepadMotionSettings& settings)
+	{
+		ShakinessMinThreshold = settings.GravityCorrectionShakinessMinThreshold;
+		ShakinessMaxThreshold = settings.GravityCorrectionShakinessMaxThreshold;
+		StillSpeed = settings.GravityCorrectionStillSpeed;
+		ShakySpeed = settings.GravityCorrectionShakySpeed;
+		GyroFactor = settings.GravityCorrectionGyroFactor;
+		GyroMinThreshold = settings.GravityCorrectionGyroMinThreshold;
+		GyroMaxThreshold = settings.GravityCorrectionGyroMaxThreshold;
+		MinimumSpeed = settings.GravityCorrectionMinimumSpeed;
+	}
+
 	void Motion::SetSettings(GamepadMotionSettings* settings)
 	{
 		Settings = settings;
@@ -1097,6 +1160,105 @@ void GamepadMotion::ProcessMotion(float gyroX, float gyroY, float gyroZ,
 	RawAccel.z = accelZ;
 }
 
+void GamepadMotion::ProcessMotionBatch(const GamepadMotionHelpers::MotionSample* samples, int numSamples, double previousTimestamp)
+{
+	if (numSamples <= 0)
+	{
+		return;
+	}
+
+	// everything ProcessMotion looks up per call, once for the batch
+	GamepadMotionHelpers::GravityCorrectionSettings correction;
+	correction.Load(Settings);
+
+	const bool isCalibrating = IsCalibrating;
+	const bool stillness = !isCalibrating && (CurrentCalibrationMode & GamepadMotionHelpers::CalibrationMode::Stillness);
+	const bool sensorFusion = !isCalibrating && !stillness && (CurrentCalibrationMode & GamepadMotionHelpers::CalibrationMode::SensorFusion);
+	const bool stillnessWithSensorFusion = static_cast<bool>(CurrentCalibrationMode & GamepadMotionHelpers::CalibrationMode::SensorFusion);
+
+	// only calibration updates the offset, without it the offset is the same for every sample
+	const bool fixedOffset = !isCalibrating && !stillness && !sensorFusion;
+	float gyroOffsetX = 0.f, gyroOffsetY = 0.f, gyroOffsetZ = 0.f, gravityLength = 1.f;
+	if (fixedOffset)
+	{
+		GetCalibratedSensor(gyroOffsetX, gyroOffsetY, gyroOffsetZ, gravityLength);
+	}
+
+	// reports come at a fixed rate, so the smoothing factor rarely needs recomputing
+	float lastDeltaTime = -1.f;
+	float smoothFactor = 0.f;
+
+	bool idleCalibrationReset = false;
+	const GamepadMotionHelpers::MotionSample* lastSample = nullptr;
+	double lastTimestamp = previousTimestamp;
+
+	for (int sampleIndex = 0; sampleIndex < numSamples; ++sampleIndex)
+	{
+		const GamepadMotionHelpers::MotionSample& sample = samples[sampleIndex];
+		const float deltaTime = lastTimestamp < 0.0 ? 0.f : (float)std::max(sample.Timestamp - lastTimestamp, 0.0);
+		lastTimestamp = sample.Timestamp;
+
+		if (sample.GyroX == 0.f && sample.GyroY == 0.f && sample.GyroZ == 0.f &&
+			sample.AccelX == 0.f && sample.AccelY == 0.f && sample.AccelZ == 0.f)
+		{
+			// all zeroes are almost certainly not valid inputs
+			continue;
+		}
+
+		// the calibrations that aren't sampled only need resetting once, they don't share any state
+		if (!idleCalibrationReset)
+		{
+			if (!stillness)
+			{
+				AutoCalibration.NoSampleStillness();
+			}
+			if (!sensorFusion)
+			{
+				AutoCalibration.NoSampleSensorFusion();
+			}
+			idleCalibrationReset = true;
+		}
+
+		if (isCalibrating)
+		{
+			PushSensorSamples(sample.GyroX, sample.GyroY, sample.GyroZ, sqrtf(sample.AccelX * sample.AccelX + sample.AccelY * sample.AccelY + sample.AccelZ * sample.AccelZ));
+		}
+		else if (stillness)
+		{
+			AutoCalibration.AddSampleStillness(GamepadMotionHelpers::Vec(sample.GyroX, sample.GyroY, sample.GyroZ), GamepadMotionHelpers::Vec(sample.AccelX, sample.AccelY, sample.AccelZ), deltaTime, stillnessWithSensorFusion);
+		}
+		else if (sensorFusion)
+		{
+			AutoCalibration.AddSampleSensorFusion(GamepadMotionHelpers::Vec(sample.GyroX, sample.GyroY, sample.GyroZ), GamepadMotionHelpers::Vec(sample.AccelX, sample.AccelY, sample.AccelZ), deltaTime);
+		}
+
+		if (!fixedOffset)
+		{
+			GetCalibratedSensor(gyroOffsetX, gyroOffsetY, gyroOffsetZ, gravityLength);
+		}
+
+		if (deltaTime != lastDeltaTime)
+		{
+			smoothFactor = Motion.GetSmoothFactor(deltaTime);
+			lastDeltaTime = deltaTime;
+		}
+
+		Motion.Update(correction, sample.GyroX - gyroOffsetX, sample.GyroY - gyroOffsetY, sample.GyroZ - gyroOffsetZ,
+			sample.AccelX, sample.AccelY, sample.AccelZ, gravityLength, deltaTime, smoothFactor);
+		lastSample = &sample;
+	}
+
+	if (lastSample)
+	{
+		Gyro.x = lastSample->GyroX - gyroOffsetX;
+		Gyro.y = lastSample->GyroY - gyroOffsetY;
+		Gyro.z = lastSample->GyroZ - gyroOffsetZ;
+		RawAccel.x = lastSample->AccelX;
+		RawAccel.y = lastSample->AccelY;
+		RawAccel.z = lastSample->AccelZ;
+	}
+}
+
 // reading the current state
 void GamepadMotion::GetCalibratedGyro(float& x, float& y, float& z)
 {
@@ -8,6 +8,21 @@ struct FDS5WKey {
 	/* Gyroscope */
 	static const FKey DS5W_GyroAxis_X;
 	static const FKey DS5W_GyroAxis_Y;
+
+	/* Touchpad gestures */
+	static const FKey DS5W_Touch_Tap;
+	static const FKey DS5W_Touch_SwipeLeft;
+	static const FKey DS5W_Touch_SwipeRight;
+	static const FKey DS5W_Touch_SwipeUp;
+	static const FKey DS5W_Touch_SwipeDown;
+	static const FKey DS5W_Touch_Pinch;
+	static const FKey DS5W_Touch_ScrollX;
+	static const FKey DS5W_Touch_ScrollY;
+
+	/* Buttons without a generic gamepad key */
+	static const FKey DS5W_PS_Button;
+	static const FKey DS5W_Touchpad_Button;
+	static const FKey DS5W_Mic_Button;
 };
 
 struct FDS5WKeyNames {
@@ -16,6 +31,21 @@ struct FDS5WKeyNames {
 	/* Gyroscope axises */
 	static const FName DS5W_GyroAxis_X;
 	static const FName DS5W_GyroAxis_Y;
+
+	/* Touchpad gestures */
+	static const FName DS5W_Touch_Tap;
+	static const FName DS5W_Touch_SwipeLeft;
+	static const FName DS5W_Touch_SwipeRight;
+	static const FName DS5W_Touch_SwipeUp;
+	static const FName DS5W_Touch_SwipeDown;
+	static const FName DS5W_Touch_Pinch;
+	static const FName DS5W_Touch_ScrollX;
+	static const FName DS5W_Touch_ScrollY;
+
+	/* Buttons without a generic gamepad key */
+	static const FName DS5W_PS_Button;
+	static const FName DS5W_Touchpad_Button;
+	static const FName DS5W_Mic_Button;
 };
 
 class IDS5W_UE4 : public IInputDeviceModule